@@ -0,0 +1,140 @@
+#include "background_writer.h"
+#include "filesystem.h"
+#include "mapsharing.h"
+#include "options.h"
+
+#if (defined _WIN32 || defined WINDOWS)
+#   include "mingw.thread.h"
+#else
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+#include <exception>
+#include <fstream>
+
+background_writer &background_writer::get()
+{
+    // Never destroyed, the buffers holding on to it are globals that could outlive it.
+    // game::cleanup_at_end waits for the last jobs.
+    static background_writer *writer = new background_writer();
+    return *writer;
+}
+
+background_writer::background_writer()
+{
+    thread = std::thread( &background_writer::work, this );
+}
+
+background_writer::~background_writer()
+{
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+void background_writer::queue( std::function<void()> job )
+{
+    if( !OPTIONS["BACKGROUND_SAVING"] ) {
+        // Still after anything queued while the option was on.
+        wait();
+        job();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        jobs.push_back( std::move( job ) );
+    }
+    wake.notify_one();
+}
+
+void background_writer::wait()
+{
+    std::unique_lock<std::mutex> lock( mutex );
+    idle.wait( lock, [this] {
+        return jobs.empty() && !busy;
+    } );
+}
+
+std::string background_writer::take_error()
+{
+    std::lock_guard<std::mutex> lock( mutex );
+    std::string result;
+    result.swap( error );
+    return result;
+}
+
+bool background_writer::on_writer_thread() const
+{
+    return std::this_thread::get_id() == thread.get_id();
+}
+
+void background_writer::work()
+{
+    std::unique_lock<std::mutex> lock( mutex );
+    while( true ) {
+        wake.wait( lock, [this] {
+            return stopping || !jobs.empty();
+        } );
+        if( jobs.empty() ) {
+            // Only stopping once everything is written.
+            return;
+        }
+        std::function<void()> job = std::move( jobs.front() );
+        jobs.pop_front();
+        busy = true;
+        lock.unlock();
+        std::string message;
+        try {
+            job();
+        } catch( const std::exception &err ) {
+            message = err.what();
+        }
+        lock.lock();
+        busy = false;
+        if( error.empty() ) {
+            error = message;
+        }
+        if( jobs.empty() ) {
+            idle.notify_all();
+        }
+    }
+}
+
+bool write_file_replacing( const std::string &path, const std::string &data )
+{
+    const std::string temp_path = path + ".tmp";
+    std::ofstream fout;
+    fopen_exclusive( fout, temp_path.c_str(), std::ios_base::out | std::ios_base::binary );
+    if( !fout.is_open() ) {
+        return false;
+    }
+    fout << data;
+    const bool written = fout.good();
+    fclose_exclusive( fout, temp_path.c_str() );
+    if( !written ) {
+        remove_file( temp_path );
+        return false;
+    }
+    // So the rename can't expose an empty file after a crash.
+    sync_written_file( temp_path );
+    return rename_file( temp_path, path );
+}
+
+void sync_written_file( const std::string &path )
+{
+#if !(defined _WIN32 || defined WINDOWS)
+    if( background_writer::get().on_writer_thread() ) {
+        const int fd = open( path.c_str(), O_RDONLY );
+        if( fd >= 0 ) {
+            fsync( fd );
+            close( fd );
+        }
+    }
+#else
+    ( void )path;
+#endif
+}
@@ -0,0 +1,69 @@
+#ifndef BACKGROUND_WRITER_H
+#define BACKGROUND_WRITER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Writes save files on one background thread, so saving only stalls the game for as long
+ * as it takes to serialize everything into memory.
+ *
+ * Jobs run one after another in the order they were queued. Anything that reads files a
+ * queued job may still be writing has to @ref wait first, as do quitting and switching
+ * worlds.
+ */
+class background_writer
+{
+    public:
+        /** The shared writer, started on first use. */
+        static background_writer &get();
+
+        background_writer();
+        /** Finishes the queued jobs first. */
+        ~background_writer();
+        background_writer( const background_writer & ) = delete;
+        background_writer &operator=( const background_writer & ) = delete;
+
+        /**
+         * Runs the job on the writer thread if the BACKGROUND_SAVING option is set, right away
+         * otherwise. Exceptions thrown by jobs on the thread are kept for @ref take_error.
+         */
+        void queue( std::function<void()> job );
+        /** Blocks until every queued job has run. */
+        void wait();
+        /** The message of the first exception a job threw since the last call, or "". */
+        std::string take_error();
+        /** Whether this is the writer thread, where writes can afford to fsync. */
+        bool on_writer_thread() const;
+
+    private:
+        void work();
+
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable idle;
+        std::deque<std::function<void()>> jobs;
+        bool busy = false;
+        bool stopping = false;
+        std::string error;
+};
+
+/**
+ * Replaces the file with the data, never leaving a half written file behind: the data goes
+ * to a temporary file first, which is flushed to disk on the writer thread and renamed
+ * over the old file. Uses fopen_exclusive like all other save files.
+ * @return false if the file could not be written.
+ */
+bool write_file_replacing( const std::string &path, const std::string &data );
+/**
+ * Makes sure a file just written and closed is on disk, if this is the writer thread.
+ * On the main thread the player is waiting for the save anyway.
+ */
+void sync_written_file( const std::string &path );
+
+#endif
@@ -1639,6 +1639,7 @@ void player::add_bionic( std::string const &b )
     }
 
     my_bionics.push_back( bionic( b, newinv ) );
+    bionic_ids.set( bionic_id( b ) );
     if ( b == "bio_tools" || b == "bio_ears" ) {
         activate_bionic(my_bionics.size() -1);
     }
@@ -1662,6 +1663,10 @@ void player::remove_bionic(std::string const &b) {
         new_my_bionics.push_back(bionic(i.id, i.invlet));
     }
     my_bionics = new_my_bionics;
+    bionic_ids.clear();
+    for( auto &i : my_bionics ) {
+        bionic_ids.set( bionic_id( i.id ) );
+    }
     recalc_sight_limits();
 }
 
@@ -1766,6 +1771,8 @@ void load_bionic(JsonObject &jsobj)
     if (!result.second) {
         debugmsg("duplicate bionic id");
     }
+    // Installed bionics are tracked by interned id, see Character::has_bionic.
+    (void)bionic_id( result.first->first );
 }
 
 void bionic::serialize(JsonOut &json) const
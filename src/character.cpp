@@ -428,6 +428,11 @@ bool Character::has_bionic(const std::string & b) const
     return false;
 }
 
+bool Character::has_bionic( const bionic_id &b ) const
+{
+    return bionic_ids.test( b );
+}
+
 bool Character::has_active_bionic(const std::string & b) const
 {
     for (auto &i : my_bionics) {
@@ -438,6 +443,19 @@ bool Character::has_active_bionic(const std::string & b) const
     return false;
 }
 
+bool Character::has_active_bionic( const bionic_id &b ) const
+{
+    if( !bionic_ids.test( b ) ) {
+        return false;
+    }
+    for (auto &i : my_bionics) {
+        if (i.id == b.str()) {
+            return (i.powered);
+        }
+    }
+    return false;
+}
+
 item& Character::i_add(item it)
 {
  itype_id item_type_id = "null";
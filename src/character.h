@@ -170,6 +170,7 @@ class Character : public Creature
         // In mutation.cpp
         /** Returns true if the player has the entered trait */
         virtual bool has_trait(const std::string &flag) const override;
+        bool has_trait( const trait_id &flag ) const;
         /** Returns true if the player has the entered starting trait */
         bool has_base_trait(const std::string &flag) const;
         /** Returns the trait id with the given invlet, or an empty string if no trait has that invlet */
@@ -211,8 +212,10 @@ class Character : public Creature
         // --------------- Bionic Stuff ---------------
         /** Returns true if the player has the entered bionic id */
         bool has_bionic(const std::string &b) const;
+        bool has_bionic( const bionic_id &b ) const;
         /** Returns true if the player has the entered bionic id and it is powered on */
         bool has_active_bionic(const std::string &b) const;
+        bool has_active_bionic( const bionic_id &b ) const;
 
         // --------------- Generic Item Stuff ---------------
 
@@ -480,6 +483,8 @@ class Character : public Creature
         std::vector<bionic> my_bionics;
 
     protected:
+        /** The ids in @ref my_bionics, must be updated along with it. */
+        interned_set<bionic_data> bionic_ids;
         Character();
         Character(const Character &) = default;
         Character(Character &&) = default;
@@ -520,6 +525,8 @@ class Character : public Creature
          * contains the entry, the character has the mutation.
          */
         std::unordered_map<std::string, trait_data> my_mutations;
+        /** The keys of @ref my_mutations, updated wherever a mutation is added or removed. */
+        interned_set<mutation_branch> trait_ids;
         /**
          * Contains mutation ids of the base traits.
          */
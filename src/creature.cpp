@@ -853,6 +853,7 @@ void Creature::add_effect( efftype_id eff_id, int dur, body_part bp,
             new_eff.set_intensity(new_eff.get_max_intensity());
         }
         effects[eff_id][bp] = new_eff;
+        effect_ids.set( effect_id( eff_id ) );
         if (is_player()) {
             // Only print the message if we didn't already have it
             if(effect_types[eff_id].get_apply_message() != "") {
@@ -888,6 +889,7 @@ bool Creature::add_env_effect( efftype_id eff_id, body_part vector, int strength
 void Creature::clear_effects()
 {
     effects.clear();
+    effect_ids.clear();
 }
 bool Creature::remove_effect(efftype_id eff_id, body_part bp)
 {
@@ -911,11 +913,13 @@ bool Creature::remove_effect(efftype_id eff_id, body_part bp)
     // num_bp means remove all of a given effect id
     if (bp == num_bp) {
         effects.erase(eff_id);
+        effect_ids.reset( effect_id( eff_id ) );
     } else {
         effects[eff_id].erase(bp);
         // If there are no more effects of a given type remove the type map
         if (effects[eff_id].empty()) {
             effects.erase(eff_id);
+            effect_ids.reset( effect_id( eff_id ) );
         }
     }
     return true;
@@ -936,6 +940,23 @@ bool Creature::has_effect(efftype_id eff_id, body_part bp) const
         return false;
     }
 }
+bool Creature::has_effect( const effect_id &eff_id, body_part bp ) const
+{
+    if( !effect_ids.test( eff_id ) ) {
+        return false;
+    } else if( bp == num_bp ) {
+        return true;
+    } else {
+        auto got_outer = effects.find( eff_id.str() );
+        if(got_outer != effects.end()) {
+            auto got_inner = got_outer->second.find(bp);
+            if (got_inner != got_outer->second.end()) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
 
 effect &Creature::get_effect(efftype_id eff_id, body_part bp)
 {
@@ -293,6 +293,8 @@ class Creature
         /** Check if creature has the matching effect. bp = num_bp means to check if the Creature has any effect
          *  of the matching type, targeted or untargeted. */
         bool has_effect(efftype_id eff_id, body_part bp = num_bp) const;
+        /** Same as above, but a single bit test when the creature does not have the effect at all. */
+        bool has_effect( const effect_id &eff_id, body_part bp = num_bp ) const;
         /** Return the effect that matches the given arguments exactly. */
         const effect &get_effect(efftype_id eff_id, body_part bp = num_bp) const;
         effect &get_effect(efftype_id eff_id, body_part bp = num_bp);
@@ -462,6 +464,8 @@ class Creature
 
         // Storing body_part as an int to make things easier for hash and JSON
         std::unordered_map<std::string, std::unordered_map<body_part, effect, std::hash<int>>> effects;
+        /** The ids of all types in @ref effects, updated wherever an effect type is added or removed. */
+        interned_set<effect_type> effect_ids;
         // Miscellaneous key/value pairs.
         std::unordered_map<std::string, std::string> values;
 
@@ -3,6 +3,25 @@
 #include "mongroup.h"
 #include "debug.h"
 #include "mtype.h"
+#include "line.h"
+#include "game_constants.h"
+
+#include <algorithm>
+
+namespace
+{
+
+int divide_round_down( const int value, const int divisor )
+{
+    return value >= 0 ? value / divisor : ( value - divisor + 1 ) / divisor;
+}
+
+tripoint submap_of( const tripoint &p )
+{
+    return tripoint( divide_round_down( p.x, SEEX ), divide_round_down( p.y, SEEY ), p.z );
+}
+
+}
 
 Creature_tracker::Creature_tracker()
 {
@@ -68,7 +87,7 @@ bool Creature_tracker::add( monster &critter )
         return false;
     }
 
-    monsters_by_location[critter.pos()] = monsters_list.size();
+    set_location( critter.pos(), monsters_list.size() );
     monsters_list.push_back( new monster( critter ) );
     return true;
 }
@@ -104,8 +123,8 @@ bool Creature_tracker::update_pos( const monster &critter, const tripoint &new_p
 
     if( critter_id >= 0 ) {
         if( &critter == monsters_list[critter_id] ) {
-            monsters_by_location.erase( old_pos );
-            monsters_by_location[new_pos] = critter_id;
+            erase_location( old_pos );
+            set_location( new_pos, critter_id );
             return true;
         } else {
             const auto &othermon = *monsters_list[critter_id];
@@ -135,7 +154,7 @@ void Creature_tracker::remove_from_location_map( const monster &critter )
     if( pos_iter != monsters_by_location.end() ) {
         const auto &other = find( pos_iter->second );
         if( &other == &critter ) {
-            monsters_by_location.erase( pos_iter );
+            erase_location( loc );
         }
     }
 }
@@ -160,6 +179,13 @@ void Creature_tracker::remove( const int idx )
             --elem.second;
         }
     }
+    for( auto &bucket : monsters_by_submap ) {
+        for( auto &elem : bucket.second ) {
+            if( elem > ( size_t )idx ) {
+                --elem;
+            }
+        }
+    }
 }
 
 void Creature_tracker::clear()
@@ -169,14 +195,18 @@ void Creature_tracker::clear()
     }
     monsters_list.clear();
     monsters_by_location.clear();
+    monsters_by_submap.clear();
+    submaps_by_level.clear();
 }
 
 void Creature_tracker::rebuild_cache()
 {
     monsters_by_location.clear();
+    monsters_by_submap.clear();
+    submaps_by_level.clear();
     for( size_t i = 0; i < monsters_list.size(); i++ ) {
         monster &critter = *monsters_list[i];
-        monsters_by_location[critter.pos3()] = i;
+        set_location( critter.pos3(), i );
     }
 }
 
@@ -206,10 +236,120 @@ void Creature_tracker::swap_positions( monster &first, monster &second )
     second.spawn( first.pos() );
     first.spawn( temp );
     if( ok ) {
-        monsters_by_location[first.pos()] = first_mdex;
-        monsters_by_location[second.pos()] = second_mdex;
+        set_location( first.pos(), first_mdex );
+        set_location( second.pos(), second_mdex );
     } else {
         // Try to avoid spamming error messages if something weird happens
         rebuild_cache();
     }
 }
+
+void Creature_tracker::set_location( const tripoint &pos, const size_t index )
+{
+    const auto iter = monsters_by_location.find( pos );
+    if( iter != monsters_by_location.end() ) {
+        remove_from_submap( pos, iter->second );
+        iter->second = index;
+    } else {
+        monsters_by_location[pos] = index;
+    }
+    auto &indices = monsters_by_submap[submap_of( pos )];
+    if( indices.empty() ) {
+        submaps_by_level[pos.z]++;
+    }
+    indices.push_back( index );
+}
+
+void Creature_tracker::erase_location( const tripoint &pos )
+{
+    const auto iter = monsters_by_location.find( pos );
+    if( iter != monsters_by_location.end() ) {
+        remove_from_submap( pos, iter->second );
+        monsters_by_location.erase( iter );
+    }
+}
+
+void Creature_tracker::remove_from_submap( const tripoint &pos, const size_t index )
+{
+    const auto bucket = monsters_by_submap.find( submap_of( pos ) );
+    if( bucket == monsters_by_submap.end() ) {
+        return;
+    }
+    auto &indices = bucket->second;
+    const auto iter = std::find( indices.begin(), indices.end(), index );
+    if( iter != indices.end() ) {
+        *iter = indices.back();
+        indices.pop_back();
+    }
+    if( indices.empty() ) {
+        monsters_by_submap.erase( bucket );
+        if( --submaps_by_level[pos.z] == 0 ) {
+            submaps_by_level.erase( pos.z );
+        }
+    }
+}
+
+std::vector<int> Creature_tracker::in_rect( const tripoint &min, const tripoint &max ) const
+{
+    return find_in_rect( min, max, []( const tripoint & ) {
+        return true;
+    } );
+}
+
+std::vector<int> Creature_tracker::in_radius( const tripoint &center, const int radius ) const
+{
+    const tripoint offset( radius, radius, radius );
+    return find_in_rect( center - offset, center + offset, [&]( const tripoint & p ) {
+        return rl_dist( center, p ) <= radius;
+    } );
+}
+
+std::vector<int> Creature_tracker::find_in_rect( const tripoint &min, const tripoint &max,
+        const std::function<bool( const tripoint & )> &filter ) const
+{
+    std::vector<int> found;
+    if( min.x > max.x || min.y > max.y || min.z > max.z ) {
+        return found;
+    }
+    const auto collect = [&]( const std::vector<size_t> &indices ) {
+        for( const size_t i : indices ) {
+            const tripoint &p = monsters_list[i]->pos();
+            if( p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y &&
+                p.z >= min.z && p.z <= max.z && filter( p ) ) {
+                found.push_back( int( i ) );
+            }
+        }
+    };
+
+    const tripoint sm_min = submap_of( min );
+    const tripoint sm_max = submap_of( max );
+    const auto first_level = submaps_by_level.lower_bound( min.z );
+    const auto last_level = submaps_by_level.upper_bound( max.z );
+    const long levels = std::distance( first_level, last_level );
+    const long submaps = long( sm_max.x - sm_min.x + 1 ) * long( sm_max.y - sm_min.y + 1 ) * levels;
+    if( levels == 0 ) {
+        return found;
+    } else if( submaps > long( monsters_by_submap.size() ) ) {
+        // The box is bigger than the area that has any monsters, checking them all is faster.
+        for( const auto &bucket : monsters_by_submap ) {
+            collect( bucket.second );
+        }
+    } else {
+        tripoint sm;
+        for( auto level = first_level; level != last_level; ++level ) {
+            sm.z = level->first;
+            for( sm.x = sm_min.x; sm.x <= sm_max.x; sm.x++ ) {
+                for( sm.y = sm_min.y; sm.y <= sm_max.y; sm.y++ ) {
+                    const auto bucket = monsters_by_submap.find( sm );
+                    if( bucket != monsters_by_submap.end() ) {
+                        collect( bucket->second );
+                    }
+                }
+            }
+        }
+    }
+
+    // Through plain pointers, checked iterators make this the slowest part in debug builds.
+    std::sort( found.data(), found.data() + found.size() );
+    return found;
+}
@@ -4,6 +4,8 @@
 #include "enums.h"
 #include <vector>
 #include <unordered_map>
+#include <map>
+#include <functional>
 
 class monster;
 
@@ -31,11 +33,35 @@ class Creature_tracker
         /** Swaps the positions of two monsters */
         void swap_positions( monster &first, monster &second );
 
+        /**
+         * Indices of the monsters within the given distance (see @ref rl_dist) of the point, in
+         * ascending order. The same monsters a loop over all of them would find, in the same
+         * order, but only the submaps in range are looked at.
+         */
+        std::vector<int> in_radius( const tripoint &center, int radius ) const;
+        /** Indices of the monsters inside the given box (inclusive on all sides), ascending. */
+        std::vector<int> in_rect( const tripoint &min, const tripoint &max ) const;
+
     private:
         std::vector<monster *> monsters_list;
         std::unordered_map<tripoint, size_t> monsters_by_location;
+        /**
+         * The same monsters as @ref monsters_by_location, bucketed by the submap (in map
+         * coordinates divided by SEEX/SEEY) they are on.
+         */
+        std::unordered_map<tripoint, std::vector<size_t>> monsters_by_submap;
+        /** Number of entries in @ref monsters_by_submap for each z-level, empty levels are skipped. */
+        std::map<int, size_t> submaps_by_level;
         /** Remove the monsters entry in @ref monsters_by_location */
         void remove_from_location_map( const monster &critter );
+        /** Sets the monster at the given location, in both lookup tables. */
+        void set_location( const tripoint &pos, size_t index );
+        /** Removes whatever monster is at the given location from both lookup tables. */
+        void erase_location( const tripoint &pos );
+        void remove_from_submap( const tripoint &pos, size_t index );
+        /** Monsters in the box, for which filter returns true, see @ref in_rect. */
+        std::vector<int> find_in_rect( const tripoint &min, const tripoint &max,
+                                       const std::function<bool( const tripoint & )> &filter ) const;
 };
 
 #endif
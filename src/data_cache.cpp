@@ -0,0 +1,142 @@
+#include "data_cache.h"
+#include "background_writer.h"
+#include "get_version.h"
+
+#include <fstream>
+
+namespace
+{
+
+// "CDDC" in the first four bytes, followed by the format version and the key.
+const uint32_t cache_magic = 0x43444443;
+const uint32_t cache_version = 1;
+
+// 64 bit FNV-1a
+const uint64_t hash_basis = 14695981039346656037ULL;
+const uint64_t hash_prime = 1099511628211ULL;
+
+uint64_t hash_bytes( uint64_t hash, const char *data, size_t size )
+{
+    for( size_t i = 0; i < size; i++ ) {
+        hash ^= static_cast<unsigned char>( data[i] );
+        hash *= hash_prime;
+    }
+    return hash;
+}
+
+uint64_t hash_string( uint64_t hash, const std::string &str )
+{
+    // The terminating '\0' keeps "ab" + "c" apart from "a" + "bc".
+    return hash_bytes( hash, str.c_str(), str.size() + 1 );
+}
+
+template<typename T>
+void write_value( std::string &out, const T &value )
+{
+    out.append( reinterpret_cast<const char *>( &value ), sizeof( value ) );
+}
+
+template<typename T>
+bool read_value( std::istream &in, T &value )
+{
+    return static_cast<bool>( in.read( reinterpret_cast<char *>( &value ), sizeof( value ) ) );
+}
+
+bool read_string( std::istream &in, std::string &str, uint64_t size )
+{
+    str.resize( size );
+    return size == 0 || static_cast<bool>( in.read( &str[0], size ) );
+}
+
+}
+
+data_cache::data_cache()
+{
+    reset();
+}
+
+void data_cache::reset()
+{
+    key = hash_string( hash_basis, getVersionString() );
+    sections.clear();
+    loaded = false;
+    modified = false;
+}
+
+void data_cache::add_file( const std::string &path, const std::string &contents )
+{
+    key = hash_string( key, path );
+    key = hash_string( key, contents );
+    sections.clear();
+    loaded = false;
+    modified = false;
+}
+
+bool data_cache::load( const std::string &path )
+{
+    sections.clear();
+    loaded = true;
+    modified = false;
+    std::ifstream fin( path.c_str(), std::ios::binary );
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint64_t file_key = 0;
+    uint32_t count = 0;
+    if( !read_value( fin, magic ) || !read_value( fin, version ) || !read_value( fin, file_key ) ||
+        !read_value( fin, count ) || magic != cache_magic || version != cache_version ||
+        file_key != key ) {
+        return false;
+    }
+    for( uint32_t i = 0; i < count; i++ ) {
+        uint32_t name_size = 0;
+        uint64_t data_size = 0;
+        std::string name;
+        std::string data;
+        if( !read_value( fin, name_size ) || !read_string( fin, name, name_size ) ||
+            !read_value( fin, data_size ) || !read_string( fin, data, data_size ) ) {
+            // Cut short, rebuild everything.
+            sections.clear();
+            return false;
+        }
+        sections[name].swap( data );
+    }
+    return true;
+}
+
+bool data_cache::save( const std::string &path )
+{
+    if( !modified ) {
+        return true;
+    }
+    std::string out;
+    write_value( out, cache_magic );
+    write_value( out, cache_version );
+    write_value( out, key );
+    write_value( out, static_cast<uint32_t>( sections.size() ) );
+    for( auto &section : sections ) {
+        write_value( out, static_cast<uint32_t>( section.first.size() ) );
+        out += section.first;
+        write_value( out, static_cast<uint64_t>( section.second.size() ) );
+        out += section.second;
+    }
+    if( !write_file_replacing( path, out ) ) {
+        return false;
+    }
+    modified = false;
+    return true;
+}
+
+const std::string *data_cache::find( const std::string &section ) const
+{
+    const auto it = sections.find( section );
+    return it == sections.end() ? nullptr : &it->second;
+}
+
+void data_cache::store( const std::string &section, const std::string &data )
+{
+    if( !loaded ) {
+        return;
+    }
+    sections[section] = data;
+    modified = true;
+}
@@ -0,0 +1,54 @@
+#ifndef DATA_CACHE_H
+#define DATA_CACHE_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+/**
+ * Finalized game data that is slow to rebuild, kept in a binary file in the config directory
+ * so that starting the game again with the same data can skip rebuilding it.
+ *
+ * The cache is keyed by the game version and a hash of every json file loaded since the last
+ * @ref reset, in load order, which covers the core data as well as the mods and their order.
+ * A cache with any other key is ignored and replaced by the data built from scratch.
+ *
+ * Data is kept in named sections, owned by whoever builds it (see
+ * vehicle_prototype::finalize). It may only depend on the loaded json data, never on a save.
+ */
+class data_cache
+{
+    public:
+        data_cache();
+
+        /** Starts a new key, before the core data is loaded. */
+        void reset();
+        /** Adds a loaded file to the key. The sections of the old key are forgotten. */
+        void add_file( const std::string &path, const std::string &contents );
+
+        /**
+         * Reads the sections from the file, if it was written with the same key.
+         * Until this is called for the current key, nothing is found or stored, so
+         * the cache costs nothing when it is not used.
+         * @return false on a miss, which leaves no sections.
+         */
+        bool load( const std::string &path );
+        /** Replaces the file, if sections were stored since the last load. */
+        bool save( const std::string &path );
+
+        /** Whether @ref load was called for the current key. */
+        bool in_use() const {
+            return loaded;
+        }
+        /** @return nullptr if the section is not cached. */
+        const std::string *find( const std::string &section ) const;
+        void store( const std::string &section, const std::string &data );
+
+    private:
+        uint64_t key;
+        std::map<std::string, std::string> sections;
+        bool loaded;
+        bool modified;
+};
+
+#endif
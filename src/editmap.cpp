@@ -22,10 +22,12 @@
 #include "npc.h"
 #include "vehicle.h"
 #include "submap.h"
+#include "mapbuffer.h"
 #include "monster.h"
 #include "overmap.h"
 #include "field.h"
 #include "ui.h"
+#include "scent_map.h"
 
 #include <fstream>
 #include <sstream>
@@ -614,7 +616,7 @@ void editmap::update_view( bool update_info )
         const auto &map_cache = g->m.get_cache( target.z );
 
         mvwprintw(w_info, off++, 1, _("dist: %d u_see: %d v_in: %d scent: %d"),
-                  rl_dist( g->u.pos(), target ), g->u.sees( target ), veh_in, g->scent( target ));
+                  rl_dist( g->u.pos(), target ), g->u.sees( target ), veh_in, g->scent.get( target ));
         mvwprintw(w_info, off++, 1, _("sight_range: %d, daylight_sight_range: %d,"),
                   g->u.sight_range( g->light_level( g->u.posz() ) ), g->u.sight_range(DAYLIGHT_LEVEL) );
         mvwprintw(w_info, off++, 1, _("transparency: %.5f, visibility: %.5f,"),
@@ -1774,6 +1776,9 @@ int editmap::mapgen_preview( real_coords &tc, uimenu &gmenu )
                                 g->m.update_vehicle_cache( veh1, target.z );
                             }
                             srcsm->vehicles.clear();
+                            const tripoint abs_sub = g->m.get_abs_sub();
+                            MAPBUFFER.note_vehicles( tripoint( abs_sub.x + target_sub.x + x,
+                                                               abs_sub.y + target_sub.y + y, target.z ) );
                             g->m.update_vehicle_list( destsm, target.z ); // update real map's vcaches
 
                             int spawns_todo = 0;
@@ -1790,6 +1795,7 @@ int editmap::mapgen_preview( real_coords &tc, uimenu &gmenu )
                                 }
                             }
                             destsm->field_count = srcsm->field_count; // and count
+                            destsm->field_squares = srcsm->field_squares;
 
                             std::memcpy( *destsm->ter, srcsm->ter, sizeof( srcsm->ter ) ); // terrain
                             std::memcpy( *destsm->frn, srcsm->frn, sizeof( srcsm->frn ) ); // furniture
@@ -1810,6 +1816,7 @@ int editmap::mapgen_preview( real_coords &tc, uimenu &gmenu )
                             destsm->turn_last_touched = int( calendar::turn );
                             destsm->comp = srcsm->comp;
                             destsm->camp = srcsm->camp;
+                            destsm->set_modified();
 
                             if( spawns_todo > 0 ) {                               // trigger spawnpoints
                                 g->m.spawn_monsters( true );
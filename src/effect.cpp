@@ -1193,6 +1193,8 @@ void load_effect_type(JsonObject &jo)
     new_etype.load_mod_data(jo, "scaling_mods");
 
     effect_types[new_etype.id] = new_etype;
+    // Interned here so the ids of loaded effects are dense.
+    (void)effect_id( new_etype.id );
 }
 
 void reset_effect_types()
@@ -14,6 +14,11 @@
 #include "submap.h"
 #include "mapdata.h"
 #include "mtype.h"
+#include "scent_map.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
 
 const species_id FUNGUS( "FUNGUS" );
 
@@ -358,32 +363,35 @@ field_id field_from_ident(const std::string &field_ident)
     return fd_null;
 }
 
-bool map::process_fields()
+bool map::process_fields( const bool batch_gases )
 {
     bool dirty_transparency_cache = false;
     const int minz = zlevels ? -OVERMAP_DEPTH : abs_sub.z;
     const int maxz = zlevels ? OVERMAP_HEIGHT : abs_sub.z;
-    bool zlev_dirty;
+    // Gases falling and rising depend on the order the squares are processed in.
+    const bool batched = batch_gases && !zlevels;
     for( int z = minz; z <= maxz; z++ ) {
-        zlev_dirty = false;
         for( int x = 0; x < my_MAPSIZE; x++ ) {
             for( int y = 0; y < my_MAPSIZE; y++ ) {
                 submap * const current_submap = get_submap_at_grid( x, y, z );
                 if( current_submap->field_count > 0 ) {
-                    const bool cur_dirty = process_fields_in_submap( current_submap, x, y, z );
-                    zlev_dirty |= cur_dirty;
+                    // Fields age every turn.
+                    current_submap->set_modified();
+                }
+                if( current_submap->field_count > 0 &&
+                    process_fields_in_submap( current_submap, x, y, z, batched ) ) {
+                    // For now, just always dirty the transparency cache
+                    // when a field might possibly be changed.
+                    // TODO: check if there are any fields(mostly fire)
+                    //       that frequently change, if so set the dirty
+                    //       flag, otherwise only set the dirty flag if
+                    //       something actually changed
+                    set_transparency_cache_dirty( tripoint( x * SEEX, y * SEEY, z ) );
+                    dirty_transparency_cache = true;
                 }
             }
         }
-
-        if( zlev_dirty ) {
-            // For now, just always dirty the transparency cache
-            // when a field might possibly be changed.
-            // TODO: check if there are any fields(mostly fire)
-            //       that frequently change, if so set the dirty
-            //       flag, otherwise only set the dirty flag if
-            //       something actually changed
-            set_transparency_cache_dirty( z );
+        if( batched && process_gas_fields( z ) ) {
             dirty_transparency_cache = true;
         }
     }
@@ -409,6 +417,39 @@ int ter_furn_movecost( const ter_t &ter, const furn_t &furn )
     return ter.movecost + furn.movecost;
 }
 
+/**
+ * How a gas that does nothing but spreading spreads, these are processed by
+ * map::process_gas_fields. See spread_gas in map::process_fields_in_submap.
+ */
+struct gas_spread {
+    field_id type;
+    int percent_spread;
+    int outdoor_age_speedup;
+    bool changes_transparency;
+};
+
+static const std::array<gas_spread, 9> batched_gases = { {
+    { fd_smoke, 80, 50, true },
+    { fd_tear_gas, 33, 30, true },
+    { fd_relax_gas, 25, 50, true },
+    { fd_toxic_gas, 50, 30, true },
+    { fd_cigsmoke, 250, 65, true },
+    { fd_hot_air1, 100, 1000, false },
+    { fd_hot_air2, 100, 1000, false },
+    { fd_hot_air3, 100, 1000, false },
+    { fd_hot_air4, 100, 1000, false },
+} };
+
+static const gas_spread *find_batched_gas( const field_id type )
+{
+    for( auto &gas : batched_gases ) {
+        if( gas.type == type ) {
+            return &gas;
+        }
+    }
+    return nullptr;
+}
+
 // A helper to turn neighbor index back into a tripoint
 // Ugly, but can save time where it matters
 tripoint offset_by_index( const size_t index, const tripoint &base )
@@ -448,7 +489,8 @@ This is the general update function for field effects. This should only be calle
 If you need to insert a new field behavior per unit time add a case statement in the switch below.
 */
 bool map::process_fields_in_submap( submap *const current_submap,
-                                    const int submap_x, const int submap_y, const int submap_z )
+                                    const int submap_x, const int submap_y, const int submap_z,
+                                    const bool skip_batched_gases )
 {
     const auto get_neighbors = [this]( const tripoint &pt ) {
         // Wrapper to allow skipping bound checks except at the edges of the map
@@ -487,7 +529,7 @@ bool map::process_fields_in_submap( submap *const current_submap,
         tmp.z = p.z;
         for( tmp.x = p.x - 1; tmp.x <= p.x + 1; tmp.x++ ) {
             for( tmp.y = p.y - 1; tmp.y <= p.y + 1; tmp.y++ ) {
-                g->scent( tmp ) = 0;
+                g->scent.set( tmp, 0 );
             }
         }
 
@@ -615,9 +657,13 @@ bool map::process_fields_in_submap( submap *const current_submap,
     maptile map_tile( current_submap, 0, 0 );
     size_t &locx = map_tile.x;
     size_t &locy = map_tile.y;
-    //Loop through all tiles in this submap indicated by current_submap
+    //Loop through all tiles in this submap indicated by current_submap that have fields.
+    //Fields spreading to tiles further on are processed in this turn, like before.
     for( locx = 0; locx < SEEX; locx++ ) {
         for( locy = 0; locy < SEEY; locy++ ) {
+            if( !current_submap->field_squares.test( locx * SEEY + locy ) ) {
+                continue;
+            }
             // This is a translation from local coordinates to submap coords.
             // All submaps are in one long 1d array.
             thep.x = locx + submap_x * SEEX;
@@ -641,6 +687,11 @@ bool map::process_fields_in_submap( submap *const current_submap,
                 }
 
                 curtype = cur->getFieldType();
+                // Left to process_gas_fields, after all squares.
+                if( skip_batched_gases && find_batched_gas( curtype ) != nullptr ) {
+                    ++it;
+                    continue;
+                }
                 // Again, legacy support in the event someone Mods setFieldDensity to allow more values.
                 if (cur->getFieldDensity() > 3 || cur->getFieldDensity() < 1) {
                     debugmsg("Whoooooa density of %d", cur->getFieldDensity());
@@ -720,8 +771,8 @@ bool map::process_fields_in_submap( submap *const current_submap,
                     case fd_sludge:
                         break;
                     case fd_slime:
-                        if( g->scent( p ) < cur->getFieldDensity() * 10 ) {
-                            g->scent( p ) = cur->getFieldDensity() * 10;
+                        if( g->scent.get( p ) < cur->getFieldDensity() * 10 ) {
+                            g->scent.set( p, cur->getFieldDensity() * 10 );
                         }
                         break;
                     case fd_plasma:
@@ -1235,19 +1286,23 @@ bool map::process_fields_in_submap( submap *const current_submap,
                     break;
 
                     case fd_smoke:
-                        dirty_transparency_cache = true;
-                        spread_gas( cur, p, curtype, 80, 50 );
-                        break;
-
                     case fd_tear_gas:
-                        dirty_transparency_cache = true;
-                        spread_gas( cur, p, curtype, 33, 30 );
-                        break;
-
                     case fd_relax_gas:
-                        dirty_transparency_cache = true;
-                        spread_gas( cur, p, curtype, 25, 50 );
+                    case fd_toxic_gas:
+                    case fd_cigsmoke:
+                    case fd_hot_air1:
+                    case fd_hot_air2:
+                    case fd_hot_air3:
+                    case fd_hot_air4:
+                    {
+                        const gas_spread &gas = *find_batched_gas( curtype );
+                        // Hot air does no transparency cache wrecking.
+                        if( gas.changes_transparency ) {
+                            dirty_transparency_cache = true;
+                        }
+                        spread_gas( cur, p, curtype, gas.percent_spread, gas.outdoor_age_speedup );
                         break;
+                    }
 
                     case fd_fungal_haze:
                         dirty_transparency_cache = true;
@@ -1258,16 +1313,6 @@ bool map::process_fields_in_submap( submap *const current_submap,
 
                         break;
 
-                    case fd_toxic_gas:
-                        dirty_transparency_cache = true;
-                        spread_gas( cur, p, curtype, 50, 30 );
-                        break;
-
-                    case fd_cigsmoke:
-                        dirty_transparency_cache = true;
-                        spread_gas( cur, p, curtype, 250, 65 );
-                        break;
-
                     case fd_weedsmoke:
                     {
                         dirty_transparency_cache = true;
@@ -1329,14 +1374,6 @@ bool map::process_fields_in_submap( submap *const current_submap,
                         break;
                     }
 
-                    case fd_hot_air1:
-                    case fd_hot_air2:
-                    case fd_hot_air3:
-                    case fd_hot_air4:
-                        // No transparency cache wrecking here!
-                        spread_gas( cur, p, curtype, 100, 1000 );
-                        break;
-
                     case fd_gas_vent:
                     {
                         dirty_transparency_cache = true;
@@ -1684,7 +1721,191 @@ bool map::process_fields_in_submap( submap *const current_submap,
                     ++it;
                 }
             }
+            if( curfield.fieldCount() == 0 ) {
+                current_submap->field_squares.reset( locx * SEEY + locy );
+            }
+        }
+    }
+    return dirty_transparency_cache;
+}
+
+/*
+Function: process_gas_fields
+Spreads the gases that do nothing else, like spread_gas in process_fields_in_submap does square by
+square, but in one pass over the whole z-level for each gas. process_fields_in_submap leaves them
+alone when this runs after it.
+The densities and ages are copied into grids covering the map. Each gas square decides where to
+spread based on the grids of the previous turn and writes into a second pair of grids, so the
+result does not depend on the order of the squares: a gas square that just got some gas from a
+neighbour does not spread it again in the same turn, like it could when it came later in the
+square by square order. Only the squares that changed are written back.
+*/
+bool map::process_gas_fields( const int z )
+{
+    const int width = SEEX * my_MAPSIZE;
+    const int height = SEEY * my_MAPSIZE;
+    // Squares with each of the batched gases, as index x * height + y.
+    std::array<std::vector<int>, batched_gases.size()> gas_squares;
+    bool any_gas = false;
+    for( int smx = 0; smx < my_MAPSIZE; smx++ ) {
+        for( int smy = 0; smy < my_MAPSIZE; smy++ ) {
+            submap *const sm = get_submap_at_grid( smx, smy, z );
+            if( sm->field_count <= 0 ) {
+                continue;
+            }
+            for( int lx = 0; lx < SEEX; lx++ ) {
+                for( int ly = 0; ly < SEEY; ly++ ) {
+                    if( !sm->field_squares.test( lx * SEEY + ly ) ) {
+                        continue;
+                    }
+                    for( auto &fd : sm->fld[lx][ly] ) {
+                        const gas_spread *gas = find_batched_gas( fd.first );
+                        if( gas != nullptr ) {
+                            const int x = smx * SEEX + lx;
+                            const int y = smy * SEEY + ly;
+                            gas_squares[gas - batched_gases.data()].push_back( x * height + y );
+                            any_gas = true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    if( !any_gas ) {
+        return false;
+    }
+
+    // Whether gas can spread into the square: 1 yes, 0 no, -1 not checked yet.
+    std::vector<signed char> permeable( width * height, -1 );
+    const auto can_hold_gas = [&]( const int index ) {
+        if( permeable[index] < 0 ) {
+            const maptile tile = maptile_at_internal( tripoint( index / height, index % height, z ) );
+            const auto &ter = tile.get_ter_t();
+            const auto &frn = tile.get_furn_t();
+            permeable[index] = ter_furn_movecost( ter, frn ) > 0 ||
+                               ter_furn_has_flag( ter, frn, TFLAG_PERMEABLE );
+        }
+        return permeable[index] > 0;
+    };
+    static const int offsets[8][2] = {
+        { -1, -1 }, { 0, -1 }, { 1, -1 }, { -1, 0 }, { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 }
+    };
+
+    bool dirty_transparency_cache = false;
+    std::vector<int> density( width * height, 0 );
+    std::vector<int> age( width * height, 0 );
+    std::vector<int> next_density;
+    std::vector<int> next_age;
+    std::vector<int> new_squares;
+    for( size_t g_index = 0; g_index < batched_gases.size(); g_index++ ) {
+        const gas_spread &gas = batched_gases[g_index];
+        const std::vector<int> &squares = gas_squares[g_index];
+        if( squares.empty() ) {
+            continue;
+        }
+        for( const int index : squares ) {
+            const field_entry *fd = get_field( tripoint( index / height, index % height, z ), gas.type );
+            density[index] = fd->getFieldDensity();
+            age[index] = fd->getFieldAge();
+        }
+        next_density = density;
+        next_age = age;
+        new_squares.clear();
+
+        for( const int index : squares ) {
+            const int current_density = density[index];
+            const int current_age = age[index];
+            // Don't process "newborn" fields, they only age.
+            if( current_age == 0 ) {
+                continue;
+            }
+            const tripoint p( index / height, index % height, z );
+            // Reset nearby scents to zero
+            tripoint tmp;
+            tmp.z = p.z;
+            for( tmp.x = p.x - 1; tmp.x <= p.x + 1; tmp.x++ ) {
+                for( tmp.y = p.y - 1; tmp.y <= p.y + 1; tmp.y++ ) {
+                    g->scent.set( tmp, 0 );
+                }
+            }
+
+            // Dissipate faster outdoors.
+            const int outdoor_age_speedup = is_outside( p ) ? gas.outdoor_age_speedup : 0;
+            if( current_density <= 1 || rng( 1, 100 ) > gas.percent_spread ) {
+                next_age[index] += outdoor_age_speedup;
+                continue;
+            }
+
+            // Candidates are existing weaker fields or navigable/flagged squares with no field.
+            int candidates[8];
+            int candidate_count = 0;
+            for( auto &offset : offsets ) {
+                const int x = p.x + offset[0];
+                const int y = p.y + offset[1];
+                if( x < 0 || x >= width || y < 0 || y >= height ) {
+                    continue;
+                }
+                const int neighbour = x * height + y;
+                if( density[neighbour] < current_density && can_hold_gas( neighbour ) ) {
+                    candidates[candidate_count++] = neighbour;
+                }
+            }
+            if( candidate_count == 0 ) {
+                next_age[index] += outdoor_age_speedup;
+                continue;
+            }
+
+            // Nearby gas grows thicker, and ages are shared.
+            const int dst = candidates[rng( 0, candidate_count - 1 )];
+            int age_fraction = 0.5 + current_age / current_density;
+            if( next_density[dst] > 0 ) {
+                next_density[dst] = std::min( next_density[dst] + 1, 3 );
+                next_age[dst] += age_fraction;
+            } else {
+                // Or, just create a new field.
+                next_density[dst] = 1;
+                next_age[dst] = age_fraction;
+                new_squares.push_back( dst );
+            }
+            next_density[index]--;
+            next_age[index] -= age_fraction;
+        }
+
+        // Fields age every turn, the ones that were there before this turn.
+        const int halflife = fieldlist[gas.type].halflife;
+        for( const int index : squares ) {
+            next_age[index]++;
+            if( halflife > 0 && next_age[index] > 0 && dice( 2, next_age[index] ) > halflife ) {
+                next_age[index] = 0;
+                next_density[index]--;
+            }
+        }
+
+        for( const int index : squares ) {
+            const tripoint p( index / height, index % height, z );
+            if( next_density[index] < 1 ) {
+                remove_field( p, gas.type );
+            } else {
+                field_entry *fd = get_field( p, gas.type );
+                fd->setFieldDensity( next_density[index] );
+                fd->setFieldAge( next_age[index] );
+            }
+            if( gas.changes_transparency ) {
+                set_transparency_cache_dirty( p );
+            }
+            density[index] = 0;
+            age[index] = 0;
         }
+        for( const int index : new_squares ) {
+            const tripoint p( index / height, index % height, z );
+            maptile tile = maptile_at_internal( p );
+            tile.add_field( gas.type, next_density[index], 0 );
+            tile.find_field( gas.type )->setFieldAge( next_age[index] );
+            if( gas.changes_transparency ) {
+                set_transparency_cache_dirty( p );
+            }
+        }
+        dirty_transparency_cache |= gas.changes_transparency;
     }
     return dirty_transparency_cache;
 }
@@ -2493,15 +2714,49 @@ int field_entry::setFieldAge(const int new_age){
 }
 
 field::field()
-    : field_list()
+    : more_entries()
     , draw_symbol( fd_null )
 {
+    first_entries.fill( value_type( num_fields, field_entry() ) );
 }
 
 field::~field()
 {
 }
 
+const field::value_type *field::find_entry( const field_id type ) const
+{
+    for( auto &entry : first_entries ) {
+        if( entry.first == type ) {
+            return &entry;
+        }
+    }
+    for( auto &entry : more_entries ) {
+        if( entry.first == type ) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+const field::value_type *field::next_entry( const int after ) const
+{
+    const value_type *result = nullptr;
+    const auto consider = [&]( const value_type &entry ) {
+        if( entry.first > after && entry.first != num_fields &&
+            ( result == nullptr || entry.first < result->first ) ) {
+            result = &entry;
+        }
+    };
+    for( auto &entry : first_entries ) {
+        consider( entry );
+    }
+    for( auto &entry : more_entries ) {
+        consider( entry );
+    }
+    return result;
+}
+
 /*
 Function: findField
 Returns a field entry corresponding to the field_id parameter passed in. If no fields are found then returns NULL.
@@ -2509,20 +2764,13 @@ Good for checking for exitence of a field: if(myfield.findField(fd_fire)) would
 */
 field_entry *field::findField( const field_id field_to_find )
 {
-    const auto it = field_list.find( field_to_find );
-    if( it != field_list.end() ) {
-        return &it->second;
-    }
-    return nullptr;
+    return const_cast<field_entry *>( findFieldc( field_to_find ) );
 }
 
 const field_entry *field::findFieldc( const field_id field_to_find ) const
 {
-    const auto it = field_list.find( field_to_find );
-    if( it != field_list.end() ) {
-        return &it->second;
-    }
-    return nullptr;
+    const value_type *entry = find_entry( field_to_find );
+    return entry != nullptr ? &entry->second : nullptr;
 }
 
 const field_entry *field::findField( const field_id field_to_find ) const
@@ -2539,41 +2787,53 @@ If you wish to modify an already existing field use findField and modify the res
 Density defaults to 1, and age to 0 (permanent) if not specified.
 */
 bool field::addField(const field_id field_to_add, const int new_density, const int new_age){
-    auto it = field_list.find(field_to_add);
+    field_entry *existing = findField( field_to_add );
     if (fieldlist[field_to_add].priority >= fieldlist[draw_symbol].priority)
         draw_symbol = field_to_add;
-    if(it != field_list.end()) {
+    if( existing != nullptr ) {
         //Already exists, but lets update it. This is tentative.
-        it->second.setFieldDensity(it->second.getFieldDensity() + new_density);
+        existing->setFieldDensity( existing->getFieldDensity() + new_density );
         return false;
     }
-    field_list[field_to_add] = field_entry(field_to_add, new_density, new_age);
+    const value_type entry( field_to_add, field_entry( field_to_add, new_density, new_age ) );
+    for( auto &unused : first_entries ) {
+        if( unused.first == num_fields ) {
+            unused = entry;
+            return true;
+        }
+    }
+    more_entries.push_back( entry );
     return true;
 }
 
 bool field::removeField( field_id const field_to_remove )
 {
-    const auto it = field_list.find( field_to_remove );
-    if( it == field_list.end() ) {
+    const value_type *entry = find_entry( field_to_remove );
+    if( entry == nullptr ) {
         return false;
     }
-    removeField( it );
+    removeField( iterator( this, const_cast<value_type *>( entry ) ) );
     return true;
 }
 
-void field::removeField( std::map<field_id, field_entry>::iterator const it )
+void field::removeField( iterator const it )
 {
-        field_list.erase( it );
-        if( field_list.empty() ) {
-            draw_symbol = fd_null;
-        } else {
-            draw_symbol = fd_null;
-            for( auto &fld : field_list ) {
-                if (fieldlist[fld.first].priority >= fieldlist[draw_symbol].priority) {
-                    draw_symbol = fld.first;
-                }
+    if( it.entry >= first_entries.data() && it.entry < first_entries.data() + inline_entries ) {
+        *it.entry = value_type( num_fields, field_entry() );
+    } else {
+        for( auto list_it = more_entries.begin(); list_it != more_entries.end(); ++list_it ) {
+            if( &*list_it == it.entry ) {
+                more_entries.erase( list_it );
+                break;
             }
         }
+    }
+    draw_symbol = fd_null;
+    for( auto &fld : *this ) {
+        if (fieldlist[fld.first].priority >= fieldlist[draw_symbol].priority) {
+            draw_symbol = fld.first;
+        }
+    }
 }
 
 /*
@@ -2582,27 +2842,33 @@ Returns the number of fields existing on the current tile.
 */
 unsigned int field::fieldCount() const
 {
-    return field_list.size();
+    unsigned int count = more_entries.size();
+    for( auto &entry : first_entries ) {
+        if( entry.first != num_fields ) {
+            count++;
+        }
+    }
+    return count;
 }
 
-std::map<field_id, field_entry>::iterator field::begin()
+field::iterator field::begin()
 {
-    return field_list.begin();
+    return iterator( this, const_cast<value_type *>( next_entry( -1 ) ) );
 }
 
-std::map<field_id, field_entry>::const_iterator field::begin() const
+field::const_iterator field::begin() const
 {
-    return field_list.begin();
+    return const_iterator( this, next_entry( -1 ) );
 }
 
-std::map<field_id, field_entry>::iterator field::end()
+field::iterator field::end()
 {
-    return field_list.end();
+    return iterator( this, nullptr );
 }
 
-std::map<field_id, field_entry>::const_iterator field::end() const
+field::const_iterator field::end() const
 {
-    return field_list.end();
+    return const_iterator( this, nullptr );
 }
 
 /*
@@ -2617,7 +2883,7 @@ field_id field::fieldSymbol() const
 int field::move_cost() const
 {
     int current_cost = 0;
-    for( auto & fld : field_list ) {
+    for( auto & fld : *this ) {
         current_cost += fld.second.move_cost();
     }
     return current_cost;
@@ -3,10 +3,13 @@
 
 #include "color.h"
 
+#include <array>
 #include <vector>
 #include <string>
+#include <list>
 #include <map>
 #include <iosfwd>
+#include <utility>
 
 /*
 struct field_t
@@ -177,9 +180,58 @@ private:
  * Use @ref findField to get the field entry of a specific type, or iterate over
  * all entries via @ref begin and @ref end (allows range based iteration).
  * There is @ref fieldSymbol to specific which field should be drawn on the map.
+ *
+ * Most squares have no more than two entries, those are stored in the field itself, further
+ * ones in a list. Entries never move while they exist, pointers to them stay valid when other
+ * entries are added or removed.
 */
 class field{
 public:
+    typedef std::pair<field_id, field_entry> value_type;
+
+    /**
+     * Visits the entries ordered by their field_id, like the std::map that used to hold them.
+     * The iterator finds the next entry by the field_id of the current one, entries added or
+     * removed while iterating don't invalidate it. Only the entry it points to must not be
+     * removed before it is dereferenced or advanced, e.g. use `removeField( it++ )`.
+     * Entries added with a larger field_id than the current one are visited.
+     */
+    template<typename Entry>
+    class basic_iterator {
+    public:
+        basic_iterator( const field *owner, Entry *entry ) : owner( owner ), entry( entry ) {
+        }
+
+        Entry &operator*() const {
+            return *entry;
+        }
+        Entry *operator->() const {
+            return entry;
+        }
+        basic_iterator &operator++() {
+            entry = const_cast<Entry *>( owner->next_entry( entry->first ) );
+            return *this;
+        }
+        basic_iterator operator++( int ) {
+            basic_iterator result = *this;
+            ++*this;
+            return result;
+        }
+        bool operator==( const basic_iterator &rhs ) const {
+            return entry == rhs.entry;
+        }
+        bool operator!=( const basic_iterator &rhs ) const {
+            return entry != rhs.entry;
+        }
+
+    private:
+        friend class field;
+        const field *owner;
+        Entry *entry;
+    };
+    typedef basic_iterator<value_type> iterator;
+    typedef basic_iterator<const value_type> const_iterator;
+
     field();
     ~field();
 
@@ -217,9 +269,9 @@ public:
     bool removeField( field_id field_to_remove );
     /**
      * Make sure to decrement the field counter in the submap.
-     * Removes the field entry, the iterator must point into @ref field_list and must be valid.
+     * Removes the field entry, the iterator must point into this field and must be valid.
      */
-    void removeField( std::map<field_id, field_entry>::iterator );
+    void removeField( iterator );
 
     //Returns the number of fields existing on the current tile.
     unsigned int fieldCount() const;
@@ -229,13 +281,13 @@ public:
      */
     field_id fieldSymbol() const;
 
-    //Returns the vector iterator to begin searching through the list.
-    std::map<field_id, field_entry>::iterator begin();
-    std::map<field_id, field_entry>::const_iterator begin() const;
+    //Returns the iterator to begin searching through the list.
+    iterator begin();
+    const_iterator begin() const;
 
-    //Returns the vector iterator to end searching through the list.
-    std::map<field_id, field_entry>::iterator end();
-    std::map<field_id, field_entry>::const_iterator end() const;
+    //Returns the iterator to end searching through the list.
+    iterator end();
+    const_iterator end() const;
 
     /**
      * Returns the total move cost from all fields.
@@ -243,7 +295,15 @@ public:
     int move_cost() const;
 
 private:
-    std::map<field_id, field_entry> field_list; //A pointer lookup table of all field effects on the current tile.    //Draw_symbol currently is equal to the last field added to the square. You can modify this behavior in the class functions if you wish.
+    /** The entry with the smallest field_id larger than the given one, nullptr if none. */
+    const value_type *next_entry( int after ) const;
+    const value_type *find_entry( field_id type ) const;
+
+    static const size_t inline_entries = 2;
+    // Unused entries have the type num_fields.
+    std::array<value_type, inline_entries> first_entries;
+    std::list<value_type> more_entries;
+    //Draw_symbol currently is equal to the last field added to the square. You can modify this behavior in the class functions if you wish.
     field_id draw_symbol;
 };
 
@@ -37,6 +37,7 @@
 #include "path_info.h"
 #include "mapbuffer.h"
 #include "mapsharing.h"
+#include "background_writer.h"
 #include "messages.h"
 #include "pickup.h"
 #include "weather_gen.h"
@@ -66,6 +67,7 @@
 #include "event.h"
 #include "coordinates.h"
 #include "creature_tracker.h"
+#include "worker_pool.h"
 #include "vehicle.h"
 #include "submap.h"
 #include "mapgen_functions.h"
@@ -76,6 +78,7 @@
 #include "live_view.h"
 #include "recipe_dictionary.h"
 #include "cata_utility.h"
+#include "scent_map.h"
 
 #include <map>
 #include <set>
@@ -90,6 +93,7 @@
 #include <cassert>
 #include <iterator>
 #include <ctime>
+#include <chrono>
 #include <cstring>
 
 #if !(defined _WIN32 || defined WINDOWS || defined TILES)
@@ -114,6 +118,13 @@ const skill_id skill_firstaid( "firstaid" );
 const species_id ZOMBIE( "ZOMBIE" );
 const species_id PLANT( "PLANT" );
 
+const effect_id effect_controlled( "controlled" );
+
+const bionic_id bio_alarm( "bio_alarm" );
+
+// Turns between the power and fuel updates of vehicles outside of the reality bubble.
+static const int off_map_vehicle_turns = 10;
+
 void advanced_inv(); // player_activity.cpp
 void intro();
 nc_color sev(int a); // Right now, ONLY used for scent debugging....
@@ -134,12 +145,14 @@ bool is_valid_in_w_terrain(int x, int y)
 game::game() :
     map_ptr( new map() ),
     u_ptr( new player() ),
+    scent_ptr( new scent_map() ),
     liveview_ptr( new live_view() ),
     liveview( *liveview_ptr ),
     new_game(false),
     uquit(QUIT_NO),
     m( *map_ptr ),
     u( *u_ptr ),
+    scent( *scent_ptr ),
     critter_tracker( new Creature_tracker() ),
     weather_gen( new weather_generator() ),
     weather_precise( new w_point() ),
@@ -641,11 +654,7 @@ void game::setup()
     // reset kill counts
     kills.clear();
     // Set the scent map to 0
-    for( auto &elem : grscent ) {
-        for( auto &elem_j : elem ) {
-            elem_j = 0;
-        }
-    }
+    scent.reset();
 
     remoteveh_cache_turn = INT_MIN;
     remoteveh_cache = nullptr;
@@ -1139,6 +1148,11 @@ bool game::cleanup_at_end()
     sfx::fade_audio_group(3, 300);
     sfx::fade_audio_group(4, 300);
 
+    // The last save may still be written in the background.
+    background_writer::get().wait();
+    if( !background_writer::get().take_error().empty() ) {
+        popup(_("Failed to save the maps"));
+    }
     MAPBUFFER.reset();
     overmap_buffer.clear();
     return true;
@@ -1375,17 +1389,20 @@ bool game::do_turn()
 
     // Process power and fuel consumption for all vehicles, including off-map ones.
     // m.vehmove used to do this, but now it only give them moves instead.
-    for( auto &elem : MAPBUFFER ) {
-        tripoint sm_loc = elem.first;
+    // Vehicles outside of the reality bubble are caught up every few turns.
+    const bool process_off_map = calendar::once_every( off_map_vehicle_turns );
+    for( auto &elem : MAPBUFFER.get_vehicles() ) {
+        const tripoint &sm_loc = elem.first;
         point sm_topleft = overmapbuffer::sm_to_ms_copy(sm_loc.x, sm_loc.y);
         point in_reality = m.getlocal(sm_topleft);
 
-        submap *sm = elem.second;
-
+        vehicle *veh = elem.second;
         const bool in_bubble_z = m.has_zlevels() || sm_loc.z == get_levz();
-        for( auto &veh : sm->vehicles ) {
+        if( in_bubble_z && m.inbounds( in_reality.x, in_reality.y ) ) {
             veh->power_parts();
-            veh->idle( in_bubble_z && m.inbounds(in_reality.x, in_reality.y) );
+            veh->idle( true );
+        } else if( process_off_map ) {
+            veh->idle_off_map( off_map_vehicle_turns );
         }
     }
     m.process_fields();
@@ -3094,23 +3111,6 @@ bool game::handle_action()
     return (!u.is_dead_state());
 }
 
-#define SCENT_RADIUS 40
-
-// TODO: Unify this and scent area used in update_scent to fix "scent pocket" bug
-bool outside_scent_radius( const tripoint &p ) {
-    return p.x < (SEEX * MAPSIZE / 2) - SCENT_RADIUS || p.x >= (SEEX * MAPSIZE / 2) + SCENT_RADIUS ||
-           p.y < (SEEY * MAPSIZE / 2) - SCENT_RADIUS || p.y >= (SEEY * MAPSIZE / 2) + SCENT_RADIUS;
-}
-
-int &game::scent( const tripoint &p )
-{
-    if( outside_scent_radius( p ) ) {
-        nulscent = 0;
-        return nulscent; // Out-of-bounds - null scent
-    }
-    return grscent[p.x][p.y];
-}
-
 void game::update_scent()
 {
     static tripoint player_last_position = tripoint_min;
@@ -3126,104 +3126,12 @@ void game::update_scent()
         player_last_moved = calendar::turn;
     }
 
-    // note: the next four intermediate matrices need to be at least
-    // [2*SCENT_RADIUS+3][2*SCENT_RADIUS+1] in size to hold enough data
-    // The code I'm modifying used [SEEX * MAPSIZE]. I'm staying with that to avoid new bugs.
-
-    // These two matrices are transposed so that x addresses are contiguous in memory
-    int sum_3_scent_y[SEEY * MAPSIZE][SEEX * MAPSIZE];  //intermediate variable
-    int squares_used_y[SEEY * MAPSIZE][SEEX * MAPSIZE]; //intermediate variable
-
-    // these are for caching flag lookups
-    bool blocks_scent[SEEX * MAPSIZE][SEEY * MAPSIZE]; // currently only TFLAG_WALL blocks scent
-    bool reduces_scent[SEEX * MAPSIZE][SEEY * MAPSIZE];
-
-
-    // for loop constants
-    const int scentmap_minx = u.posx() - SCENT_RADIUS;
-    const int scentmap_maxx = u.posx() + SCENT_RADIUS;
-    const int scentmap_miny = u.posy() - SCENT_RADIUS;
-    const int scentmap_maxy = u.posy() + SCENT_RADIUS;
-
-    const int diffusivity = 100; // decrease this to reduce gas spread. Keep it under 125 for
-    // stability. This is essentially a decimal number * 1000.
-
     // No-scent debug mutation has to be processed here or else it takes time to start working
     if( !u.has_active_bionic("bio_scent_mask") && !u.has_trait("DEBUG_NOSCENT") ) {
-        grscent[u.posx()][u.posy()] = u.scent;
-    }
-
-    // The new scent flag searching function. Should be wayyy faster than the old one.
-    m.scent_blockers( blocks_scent, reduces_scent,
-                      scentmap_minx, scentmap_miny, scentmap_maxx, scentmap_maxy );
-    // Sum neighbors in the y direction.  This way, each square gets called 3 times instead of 9
-    // times. This cost us an extra loop here, but it also eliminated a loop at the end, so there
-    // is a net performance improvement over the old code. Could probably still be better.
-    // note: this method needs an array that is one square larger on each side in the x direction
-    // than the final scent matrix. I think this is fine since SCENT_RADIUS is less than
-    // SEEX*MAPSIZE, but if that changes, this may need tweaking.
-    for (int x = scentmap_minx - 1; x <= scentmap_maxx + 1; ++x) {
-        for (int y = scentmap_miny; y <= scentmap_maxy; ++y) {
-            // remember the sum of the scent val for the 3 neighboring squares that can defuse into
-            sum_3_scent_y[y][x] = 0;
-            squares_used_y[y][x] = 0;
-            for (int i = y - 1; i <= y + 1; ++i) {
-                if (! blocks_scent[x][i]) {
-                    if (reduces_scent[x][i]) {
-                        // only 20% of scent can diffuse on REDUCE_SCENT squares
-                        sum_3_scent_y[y][x] += 2 * grscent[x][i];
-                        squares_used_y[y][x] += 2;
-                    } else {
-                        sum_3_scent_y[y][x] += 10 * grscent[x][i];
-                        squares_used_y[y][x] += 10;
-                    }
-                }
-            }
-        }
+        scent.set( u.pos(), u.scent );
     }
 
-    // Rest of the scent map
-    for (int x = scentmap_minx; x <= scentmap_maxx; ++x) {
-        for (int y = scentmap_miny; y <= scentmap_maxy; ++y) {
-            if (! blocks_scent[x][y]) {
-                // to how many neighboring squares do we diffuse out? (include our own square
-                // since we also include our own square when diffusing in)
-                int squares_used = squares_used_y[y][x - 1]
-                                   + squares_used_y[y][x]
-                                   + squares_used_y[y][x + 1];
-
-                int this_diffusivity;
-                if (! reduces_scent[x][y]) {
-                    this_diffusivity = diffusivity;
-                } else {
-                    this_diffusivity = diffusivity / 5; //less air movement for REDUCE_SCENT square
-                }
-                int temp_scent;
-                // take the old scent and subtract what diffuses out
-                temp_scent = grscent[x][y] * (10 * 1000 - squares_used * this_diffusivity);
-                // neighboring walls and reduce_scent squares absorb some scent
-                temp_scent -= grscent[x][y] * this_diffusivity * (90 - squares_used) / 5;
-                // we've already summed neighboring scent values in the y direction in the previous
-                // loop. Now we do it for the x direction, multiply by diffusion, and this is what
-                // diffuses into our current square.
-                grscent[x][y] =
-                    (temp_scent
-                     + this_diffusivity * (sum_3_scent_y[y][x - 1]
-                                           + sum_3_scent_y[y][x]
-                                           + sum_3_scent_y[y][x + 1])
-                    ) / (1000 * 10);
-
-                if (grscent[x][y] > 10000) {
-                    dbg(D_ERROR) << "game:update_scent: Wacky scent at " << x << ","
-                                 << y << " (" << grscent[x][y] << ")";
-                    debugmsg("Wacky scent at %d, %d (%d)", x, y, grscent[x][y]);
-                    grscent[x][y] = 0; // Scent should never be higher
-                }
-            } else { // this cell blocks scent
-                grscent[x][y] = 0;
-            }
-        }
-    }
+    scent.update( u.pos(), m );
 }
 
 bool game::is_game_over()
@@ -3495,11 +3403,16 @@ bool game::save_maps()
         m.save();
         overmap_buffer.save(); // can throw std::ios::failure
         MAPBUFFER.save(); // can throw std::ios::failure
-        return true;
     } catch (std::ios::failure &) {
         popup(_("Failed to save the maps"));
         return false;
     }
+    // With background saving, failures show up at the next save, or when quitting.
+    if( !background_writer::get().take_error().empty() ) {
+        popup(_("Failed to save the maps"));
+        return false;
+    }
+    return true;
 }
 
 bool game::save_uistate()
@@ -3581,6 +3494,8 @@ static bool isForbidden(std::string candidate)
 // If it's false, just avoid deleting the two config files and the directory itself.
 void game::delete_world(std::string worldname, bool delete_folder)
 {
+    // Nothing may be written into the world while it is deleted.
+    background_writer::get().wait();
     std::string worldpath = world_generator->all_worlds[worldname]->world_path;
     std::set<std::string> directory_paths;
 
@@ -3766,6 +3681,7 @@ void game::debug()
                       _("Set automove route"), // 27
                       _("Show mutation category levels"), // 28
                       _("Overmap editor"), // 29
+                      _("Map shift times"), // 30
                       _("Cancel"),
                       NULL);
     int veh_num;
@@ -3839,7 +3755,7 @@ void game::debug()
         for (int i = 0; i < OMAPX; i++) {
             for (int j = 0; j < OMAPY; j++) {
                 for (int k = -OVERMAP_DEPTH; k <= OVERMAP_HEIGHT; k++) {
-                    cur_om.seen(i, j, k) = true;
+                    cur_om.set_seen( i, j, k, true );
                 }
             }
         }
@@ -4481,6 +4397,12 @@ void game::debug()
         overmap::draw_editor();
     }
     break;
+
+    case 30:
+        popup( _("Map shifts, by how long they stalled the game:\n%s\n\nPrefetched quads used: %d, requested too late: %d"),
+               map_shift_stalls.to_string().c_str(), MAPBUFFER.prefetch_hits,
+               MAPBUFFER.prefetch_misses );
+        break;
     }
     erase();
     refresh_all();
@@ -5234,7 +5156,7 @@ void game::draw_ter( const tripoint &center, const bool looking, const bool draw
         int &realy = tmp.y;
         for (realx = posx - POSX; realx <= posx + POSX; realx++) {
             for (realy = posy - POSY; realy <= posy + POSY; realy++) {
-                if (scent(tmp) != 0) {
+                if (scent.get(tmp) != 0) {
                     int tempx = posx - realx;
                     int tempy = posy - realy;
                     if (!(isBetween(tempx, -2, 2) && isBetween(tempy, -2, 2))) {
@@ -6082,6 +6004,34 @@ void game::cleanup_dead()
     }
 }
 
+// Runs monster::plan for the first move of every monster that will make its own plan this turn,
+// on all threads. Outcomes are stored to be applied one by one in game::monmove.
+static void plan_monsters_ahead( const monster_targets &targets,
+                                 std::vector<monster::plan_result> &plans, std::vector<bool> &planned )
+{
+    const size_t count = g->num_zombies();
+    plans.assign( count, monster::plan_result() );
+    planned.assign( count, false );
+    for( size_t i = 0; i < count; i++ ) {
+        const monster &critter = g->zombie( i );
+        planned[i] = !critter.is_dead() && !critter.has_effect( effect_controlled );
+    }
+    // Computed on first use otherwise, which would be a race.
+    for( int z = 0; z <= OVERMAP_HEIGHT; z++ ) {
+        g->natural_light_level( z );
+    }
+
+    // One random stream per monster, so the plans don't depend on the number of threads or
+    // which thread got which monster.
+    const unsigned int seed = rng( 0, RAND_MAX );
+    worker_pool::get().run( count, [&]( const size_t i, size_t ) {
+        if( planned[i] ) {
+            rng_stream stream( seed + i );
+            plans[i] = g->zombie( i ).decide_plan( targets );
+        }
+    } );
+}
+
 void game::monmove()
 {
     cleanup_dead();
@@ -6089,24 +6039,23 @@ void game::monmove()
     // Make sure these don't match the first time around.
     tripoint cached_lev = m.get_abs_sub() + tripoint( 1, 0, 0 );
 
-    mfactions monster_factions;
-    const auto &playerfaction = mfaction_str_id( "player" );
+    monster_targets targets;
+    // Plans made ahead for the first move of each monster.
+    std::vector<monster::plan_result> plans;
+    std::vector<bool> planned;
+    if( OPTIONS["PARALLEL_MONSTER_PLANNING"] ) {
+        targets.build();
+        cached_lev = m.get_abs_sub();
+        plan_monsters_ahead( targets, plans, planned );
+    }
     for (size_t i = 0; i < num_zombies(); i++) {
         // The first time through, and any time the map has been shifted,
-        // recalculate monster factions.
+        // take a new snapshot of the monsters for monster::plan().
         if( cached_lev != m.get_abs_sub() ) {
-            // monster::plan() needs to know about all monsters on the same team as the monster.
-            monster_factions.clear();
-            for( int i = 0, numz = num_zombies(); i < numz; i++ ) {
-                monster &critter = zombie( i );
-                if( critter.friendly == 0 ) {
-                    // Only 1 faction per mon at the moment.
-                    monster_factions[ critter.faction ].insert( i );
-                } else {
-                    monster_factions[ playerfaction ].insert( i );
-                }
-            }
+            targets.build();
             cached_lev = m.get_abs_sub();
+            // Planned against a map that is gone now.
+            planned.clear();
         }
 
         monster &critter = critter_tracker->find(i);
@@ -6147,9 +6096,12 @@ void game::monmove()
         while (critter.moves > 0 && !critter.is_dead()) {
             critter.made_footstep = false;
             // Controlled critters don't make their own plans
-            if (!critter.has_effect("controlled")) {
+            if( i < planned.size() && planned[i] ) {
+                critter.apply_plan( plans[i] );
+                planned[i] = false;
+            } else if( !critter.has_effect( effect_controlled ) ) {
                 // Formulate a path to follow
-                critter.plan( monster_factions );
+                critter.plan( targets );
             }
             critter.move(); // Move one square, possibly hit u
             critter.process_triggers();
@@ -6157,7 +6109,7 @@ void game::monmove()
         }
 
         if (!critter.is_dead() &&
-            u.has_active_bionic("bio_alarm") &&
+            u.has_active_bionic( bio_alarm ) &&
             u.power_level >= 25 &&
             rl_dist( u.pos(), critter.pos() ) <= 5) {
                 u.charge_power(-25);
@@ -6518,19 +6470,17 @@ void game::flashbang( const tripoint &p, bool player_immune)
             u.add_env_effect("blind", bp_eyes, (12 - flash_mod - dist) / 2, 10 - dist);
         }
     }
-    for( size_t i = 0; i < num_zombies(); i++ ) {
+    for( const int i : critter_tracker->in_radius( p, 8 ) ) {
         monster &critter = critter_tracker->find(i);
         dist = rl_dist( critter.pos3(), p );
-        if( dist <= 8 ) {
-            if( dist <= 4 ) {
-                critter.add_effect("stunned", 10 - dist);
-            }
-            if( critter.has_flag(MF_SEES) && m.sees( critter.pos3(), p, 8 ) ) {
-                critter.add_effect("blind", 18 - dist);
-            }
-            if( critter.has_flag(MF_HEARS) ) {
-                critter.add_effect("deaf", 60 - dist * 4);
-            }
+        if( dist <= 4 ) {
+            critter.add_effect("stunned", 10 - dist);
+        }
+        if( critter.has_flag(MF_SEES) && m.sees( critter.pos3(), p, 8 ) ) {
+            critter.add_effect("blind", 18 - dist);
+        }
+        if( critter.has_flag(MF_HEARS) ) {
+            critter.add_effect("deaf", 60 - dist * 4);
         }
     }
     sounds::sound( p, 12, _("a huge boom!"));
@@ -6543,12 +6493,11 @@ void game::shockwave( const tripoint &p, int radius, int force, int stun, int da
     draw_explosion( p, radius, c_blue );
 
     sounds::sound( p, force * force * dam_mult / 2, _("Crack!") );
-    for (size_t i = 0; i < num_zombies(); i++) {
+    // Knockback only pushes away from p, nobody ends up in the radius who wasn't there before.
+    for( const int i : critter_tracker->in_radius( p, radius ) ) {
         monster &critter = critter_tracker->find(i);
-        if( rl_dist( critter.pos3(), p ) <= radius ) {
-            add_msg(_("%s is caught in the shockwave!"), critter.name().c_str());
-            knockback( p, critter.pos3(), force, stun, dam_mult);
-        }
+        add_msg(_("%s is caught in the shockwave!"), critter.name().c_str());
+        knockback( p, critter.pos3(), force, stun, dam_mult);
     }
     for( auto &elem : active_npc ) {
         if( rl_dist( ( elem )->pos3(), p ) <= radius ) {
@@ -13495,11 +13444,7 @@ void game::vertical_shift( const int z_after )
     u.grab_type = OBJECT_NONE;
 
     // Clear current scents.
-    for( auto &elem : grscent ) {
-        for( auto &elem_j : elem ) {
-            elem_j = 0;
-        }
-    }
+    scent.reset();
 
     u.setz( z_after );
     const int z_before = get_levz();
@@ -13577,6 +13522,7 @@ void game::update_map( player *p )
 
 void game::update_map(int &x, int &y)
 {
+    const auto start = std::chrono::steady_clock::now();
     int shiftx = 0, shifty = 0;
 
     while (x < SEEX * int(MAPSIZE / 2)) {
@@ -13631,27 +13577,40 @@ void game::update_map(int &x, int &y)
     }
 
     // Shift scent
-    const int sm_shift_x = (shiftx * SEEX);
-    const int sm_shift_y = (shifty * SEEY);
-    unsigned int newscent[SEEX * MAPSIZE][SEEY * MAPSIZE];
-    std::fill_n( &newscent[0][0], SEEX * MAPSIZE * SEEY * MAPSIZE, 0 );
-    tripoint tmp = u.pos();
-    for( tmp.x = sm_shift_x; tmp.x < SEEX * MAPSIZE + sm_shift_x; tmp.x++ ) {
-        for( tmp.y = sm_shift_y; tmp.y < SEEY * MAPSIZE + sm_shift_y; tmp.y++ ) {
-            newscent[tmp.x - sm_shift_x][tmp.y - sm_shift_y] = scent(tmp);
-        }
-    }
-    for( tmp.x = 0; tmp.x < SEEX * MAPSIZE; tmp.x++ ) {
-        for( tmp.y = 0; tmp.y < SEEY * MAPSIZE; tmp.y++ ) {
-            scent(tmp) = newscent[tmp.x][tmp.y];
-        }
-    }
+    scent.shift( shiftx, shifty );
 
     // Make sure map cache is consistent since it may have shifted.
     m.build_map_cache( get_levz() );
 
     // Update what parts of the world map we can see
     update_overmap_seen();
+
+    const auto end = std::chrono::steady_clock::now();
+    map_shift_stalls.add( std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count() );
+
+    if( OPTIONS["PREFETCH_MAPS"] ) {
+        prefetch_map( shiftx, shifty );
+    }
+}
+
+void game::prefetch_map( const int shiftx, const int shifty )
+{
+    // Keep going the way the map just shifted, a vehicle knows better.
+    int dx = sgn( shiftx );
+    int dy = sgn( shifty );
+    int distance = 1;
+    vehicle *veh = u.in_vehicle ? m.veh_at( u.pos() ) : nullptr;
+    if( veh != nullptr && veh->velocity != 0 ) {
+        const double angle = veh->move.dir() * M_PI / 180.0;
+        const int direction = veh->velocity > 0 ? 1 : -1;
+        dx = direction * int( round( cos( angle ) ) );
+        dy = direction * int( round( sin( angle ) ) );
+        // About one shift per turn at 60 mph.
+        distance = std::min( 3, 1 + abs( veh->velocity ) / 6000 );
+    }
+    if( dx != 0 || dy != 0 ) {
+        m.prefetch( dx, dy, distance );
+    }
 }
 
 void game::update_overmap_seen()
@@ -14448,7 +14407,7 @@ void game::display_scent()
     draw_ter();
     for (int x = u.posx() - getmaxx(w_terrain) / 2; x <= u.posx() + getmaxx(w_terrain) / 2; x++) {
         for (int y = u.posy() - getmaxy(w_terrain) / 2; y <= u.posy() + getmaxy(w_terrain) / 2; y++) {
-            int sn = scent({x, y, u.posz()}) / (div * 2);
+            int sn = scent.get({x, y, u.posz()}) / (div * 2);
             mvwprintz(w_terrain, getmaxy(w_terrain) / 2 + y - u.posy(), getmaxx(w_terrain) / 2 + x - u.posx(),
                       sev(sn / 10), "%d",
                       sn % 10);
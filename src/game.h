@@ -8,6 +8,7 @@
 #include "int_id.h"
 #include "item_location.h"
 #include "cursesdef.h"
+#include "timing_histogram.h"
 
 #include <vector>
 #include <map>
@@ -102,6 +103,7 @@ class weather_generator;
 struct weather_printable;
 class faction;
 class live_view;
+class scent_map;
 typedef int nc_color;
 struct w_point;
 
@@ -137,6 +139,7 @@ class game
         // May be a bit hacky, but it's probably better than the header spaghetti
         std::unique_ptr<map> map_ptr;
         std::unique_ptr<player> u_ptr;
+        std::unique_ptr<scent_map> scent_ptr;
         std::unique_ptr<live_view> liveview_ptr;
         live_view& liveview;
     public:
@@ -186,6 +189,7 @@ class game
         /** Make map a reference here, to avoid map.h in game.h */
         map &m;
         player &u;
+        scent_map &scent;
 
         std::unique_ptr<Creature_tracker> critter_tracker;
         /**
@@ -345,7 +349,6 @@ class game
         void nuke( const tripoint &p );
         bool spread_fungus( const tripoint &p );
         std::vector<faction *> factions_at( const tripoint &p );
-        int &scent( const tripoint &p );
         float natural_light_level( int zlev ) const;
         /** Returns coarse number-of-squares of visibility at the current light level.
          * Used by monster and NPC AI.
@@ -362,6 +365,10 @@ class game
         // Helper to make calling with a player pointer less verbose.
         void update_map(player *p);
         void update_map(int &x, int &y);
+        /** How long update_map took whenever it shifted the map, shown in the debug menu. */
+        timing_histogram map_shift_stalls;
+        /** Has the map read ahead what the next shifts are likely to load, see PREFETCH_MAPS. */
+        void prefetch_map( int shiftx, int shifty );
         void update_overmap_seen(); // Update which overmap tiles we can see
 
         void process_artifact(item *it, player *p);
@@ -780,8 +787,6 @@ class game
         calendar nextspawn; // The turn on which monsters will spawn next.
         calendar nextweather; // The turn on which weather will shift next.
         int next_npc_id, next_faction_id, next_mission_id; // Keep track of UIDs
-        int grscent[SEEX *MAPSIZE][SEEY *MAPSIZE];   // The scent map
-        int nulscent;    // Returned for OOB scent checks
         std::list<event> events;         // Game events to be processed
         std::map<mtype_id, int> kills;         // Player's kill count
         int moves_since_last_save;
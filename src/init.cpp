@@ -48,13 +48,21 @@
 #include "veh_type.h"
 #include "clzones.h"
 #include "sounds.h"
+#include "worker_pool.h"
 
+#include <chrono>
 #include <string>
 #include <vector>
 #include <fstream>
 #include <sstream> // for throwing errors
 #include <locale> // for loading names
 
+static double seconds_between(const std::chrono::steady_clock::time_point &start,
+                              const std::chrono::steady_clock::time_point &end)
+{
+    return std::chrono::duration<double>(end - start).count();
+}
+
 DynamicDataLoader::DynamicDataLoader()
 {
 }
@@ -242,61 +250,106 @@ void DynamicDataLoader::load_data_from_path(const std::string &path)
             files.push_back(path);
         }
     }
-    // iterate over each file
-    for( auto &files_i : files ) {
-        const std::string &file = files_i;
-        // open the file as a stream
-        std::ifstream infile(file.c_str(), std::ifstream::in | std::ifstream::binary);
-        // and stuff it into ram
-        std::istringstream iss(
-            std::string(
-                (std::istreambuf_iterator<char>(infile)),
-                std::istreambuf_iterator<char>()
-            )
-        );
+    const auto start = std::chrono::steady_clock::now();
+    const auto parsed = parse_json_files(files);
+    const auto parsed_at = std::chrono::steady_clock::now();
+    loading_times.parse += seconds_between(start, parsed_at);
+    for( auto &file : parsed ) {
+        cache.add_file( file->path, file->contents );
+    }
+    load_parsed_files(parsed);
+    loading_times.dispatch += seconds_between(parsed_at, std::chrono::steady_clock::now());
+}
+
+void DynamicDataLoader::load_parsed_files(const std::vector<std::unique_ptr<parsed_json_file>> &files)
+{
+    for( auto &file : files ) {
+        if( !file->error.empty() ) {
+            throw std::runtime_error( file->path + ": " + file->error );
+        }
         try {
-            // parse it
-            JsonIn jsin(iss);
-            load_all_from_json(jsin);
+            for( auto &jo : file->objects ) {
+                load_object(jo);
+            }
         } catch( const JsonError &err ) {
-            throw std::runtime_error( file + ": " + err.what() );
+            throw std::runtime_error( file->path + ": " + err.what() );
         }
     }
 }
 
-void DynamicDataLoader::load_all_from_json(JsonIn &jsin)
+static void parse_json_file(parsed_json_file &file)
 {
-    char ch;
-    jsin.eat_whitespace();
-    // examine first non-whitespace char
-    ch = jsin.peek();
-    if (ch == '{') {
-        // find type and dispatch single object
-        JsonObject jo = jsin.get_object();
-        load_object(jo);
-        jo.finish();
-        // if there's anything else in the file, it's an error.
+    // read the whole file into ram at once
+    std::ifstream infile(file.path.c_str(), std::ifstream::in | std::ifstream::binary);
+    infile.seekg(0, std::ifstream::end);
+    const std::streamoff size = infile.tellg();
+    if (size > 0) {
+        file.contents.resize(size);
+        infile.seekg(0, std::ifstream::beg);
+        infile.read(&file.contents[0], size);
+        file.contents.resize(infile.gcount());
+    }
+    // and index it straight from there
+    file.jsin.reset(new JsonIn(file.contents.data(), file.contents.size()));
+    JsonIn &jsin = *file.jsin;
+    try {
         jsin.eat_whitespace();
-        if (jsin.good()) {
-            jsin.error( string_format( "expected single-object file but found '%c'", jsin.peek() ) );
-        }
-    } else if (ch == '[') {
-        jsin.start_array();
-        // find type and dispatch each object until array close
-        while (!jsin.end_array()) {
+        // examine first non-whitespace char
+        char ch = jsin.peek();
+        if (ch == '{') {
+            // a single object
+            file.objects.push_back(jsin.get_object());
+            // if there's anything else in the file, it's an error.
             jsin.eat_whitespace();
-            ch = jsin.peek();
-            if (ch != '{') {
-                jsin.error( string_format( "expected array of objects but found '%c', not '{'", ch ) );
+            if (jsin.good()) {
+                jsin.error( string_format( "expected single-object file but found '%c'", jsin.peek() ) );
+            }
+        } else if (ch == '[') {
+            jsin.start_array();
+            // index each object until array close
+            while (!jsin.end_array()) {
+                jsin.eat_whitespace();
+                ch = jsin.peek();
+                if (ch != '{') {
+                    jsin.error( string_format( "expected array of objects but found '%c', not '{'", ch ) );
+                }
+                file.objects.push_back(jsin.get_object());
             }
-            JsonObject jo = jsin.get_object();
-            load_object(jo);
-            jo.finish();
+        } else {
+            // not an object or an array?
+            jsin.error( string_format( "expected object or array, but found '%c'", ch ) );
+        }
+    } catch( const std::exception &err ) {
+        file.objects.clear();
+        file.error = err.what();
+    }
+}
+
+std::vector<std::unique_ptr<parsed_json_file>> parse_json_files(const std::vector<std::string> &files)
+{
+    std::vector<std::unique_ptr<parsed_json_file>> parsed;
+    for( auto &path : files ) {
+        parsed.emplace_back( new parsed_json_file() );
+        parsed.back()->path = path;
+    }
+    worker_pool &pool = worker_pool::get();
+    if( !OPTIONS["PARALLEL_DATA_LOADING"] || pool.size() == 1 || parsed.size() < 2 ) {
+        for( auto &file : parsed ) {
+            parse_json_file( *file );
         }
     } else {
-        // not an object or an array?
-        jsin.error( string_format( "expected object or array, but found '%c'", ch ) );
+        // Files don't depend on each other until they are loaded.
+        pool.run( parsed.size(), [&parsed]( const size_t i, size_t ) {
+            parse_json_file( *parsed[i] );
+        } );
     }
+    return parsed;
+}
+
+std::string data_loading_times::to_string() const
+{
+    return string_format( "parse %.0f ms, dispatch %.0f ms, finalize %.0f ms, check_consistency %.0f ms",
+                          parse * 1000, dispatch * 1000, finalize * 1000, check_consistency * 1000 );
 }
 
 void init_names()
@@ -345,6 +398,7 @@ void DynamicDataLoader::unload_data()
     clear_overmap_specials();
     ammunition_type::reset();
     unload_talk_topics();
+    cache.reset();
 
     // TODO:
     //    NameGenerator::generator().clear_names();
@@ -353,13 +407,18 @@ void DynamicDataLoader::unload_data()
 extern void calculate_mapgen_weights();
 void DynamicDataLoader::finalize_loaded_data()
 {
+    const auto start = std::chrono::steady_clock::now();
+    const bool use_cache = OPTIONS["DATA_CACHE"];
+    if( use_cache ) {
+        cache.load( FILENAMES["data_cache"] );
+    }
     mission_type::initialize(); // Needs overmap terrain.
     set_ter_ids();
     set_furn_ids();
     set_oter_ids();
     trap::finalize();
     finalize_overmap_terrain();
-    vehicle_prototype::finalize();
+    vehicle_prototype::finalize( cache );
     calculate_mapgen_weights();
     MonsterGenerator::generator().finalize_mtypes();
     MonsterGroupManager::FinalizeMonsterGroups();
@@ -367,7 +426,13 @@ void DynamicDataLoader::finalize_loaded_data()
     item_controller->finialize_item_blacklist();
     finalize_recipes();
     finialize_martial_arts();
+    if( use_cache && !cache.save( FILENAMES["data_cache"] ) ) {
+        debugmsg( "Could not write the data cache %s", FILENAMES["data_cache"].c_str() );
+    }
+    const auto finalized = std::chrono::steady_clock::now();
+    loading_times.finalize += seconds_between(start, finalized);
     check_consistency();
+    loading_times.check_consistency += seconds_between(finalized, std::chrono::steady_clock::now());
 }
 
 void DynamicDataLoader::check_consistency()
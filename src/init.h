@@ -2,10 +2,12 @@
 #define INIT_H
 
 #include "json.h"
+#include "data_cache.h"
 
+#include <deque>
+#include <memory>
 #include <string>
 #include <vector>
-#include <memory>
 
 //********** Functor Base, Static and Class member accessors
 class TFunctor
@@ -76,6 +78,43 @@ template <class TClass> class ClassFunctionAccessor : public TFunctor
 };
 //********** END - Functor Base, Static and Class member accessors
 
+/**
+ * A json data file read into memory, with the top level objects indexed,
+ * but not yet loaded. See @ref parse_json_files.
+ */
+struct parsed_json_file {
+    std::string path;
+    std::string contents;
+    // reads from contents, so this struct must never be moved
+    std::unique_ptr<JsonIn> jsin;
+    // not a vector: growing it would destroy copies, which seek the JsonIn
+    std::deque<JsonObject> objects;
+    // why the file could not be parsed, empty if it could
+    std::string error;
+
+    parsed_json_file() = default;
+    parsed_json_file(const parsed_json_file &) = delete;
+    parsed_json_file &operator=(const parsed_json_file &) = delete;
+};
+
+/**
+ * Reads and indexes the files, on all processor cores if the
+ * PARALLEL_DATA_LOADING option is set.
+ * Nothing is loaded, so this does not depend on the data loaded so far.
+ * @return The parsed files in the same order as the paths.
+ */
+std::vector<std::unique_ptr<parsed_json_file>> parse_json_files(const std::vector<std::string> &files);
+
+/** Wall clock time spent on the stages of loading data, in seconds. */
+struct data_loading_times {
+    double parse = 0.0;
+    double dispatch = 0.0;
+    double finalize = 0.0;
+    double check_consistency = 0.0;
+
+    std::string to_string() const;
+};
+
 /**
  * This class is used to load (and unload) the dynamic
  * (and modable) data from json files.
@@ -88,7 +127,9 @@ template <class TClass> class ClassFunctionAccessor : public TFunctor
  * previously loaded world, if any)
  * - Call @ref load_data_from_path(...) repeatedly with
  * different pathes for the core data and all the mods
- * of the current world.
+ * of the current world. The files of each path are
+ * parsed first (see @ref parse_json_files), then their
+ * objects are loaded in the order of the files.
  * - Call @ref finalize_loaded_data when all mods have been
  * loaded.
  * - Play.
@@ -129,13 +170,11 @@ class DynamicDataLoader
          */
         t_type_function_map type_function_map;
         /**
-         * Load all the types from that json data.
-         * @param jsin Might contain single object,
-         * or an array of objects. Each object must have a
-         * "type", that is part of the @ref type_function_map
-         * @throws std::exception on all kind of errors.
+         * Loads the objects of the files in order.
+         * @throws std::exception for the first file that could not be parsed,
+         * or on all kind of errors.
          */
-        void load_all_from_json(JsonIn &jsin);
+        void load_parsed_files(const std::vector<std::unique_ptr<parsed_json_file>> &files);
         /**
          * Load a single object from a json object.
          * @param jo The json object to load the C++-object from.
@@ -187,6 +226,11 @@ class DynamicDataLoader
          * @ref check_consistency
          */
         void finalize_loaded_data();
+
+        /** Time spent loading data since the program started. */
+        data_loading_times loading_times;
+        /** Keyed by the files loaded since @ref unload_data, used if the DATA_CACHE option is set. */
+        data_cache cache;
 };
 
 void init_names();
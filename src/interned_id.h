@@ -0,0 +1,138 @@
+#ifndef INTERNED_ID_H
+#define INTERNED_ID_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * A string identifier that is mapped to a small integer when it is constructed, so comparing
+ * ids and testing them in an @ref interned_set are integer operations.
+ * The template parameter T separates the kinds of ids, like it does for @ref string_id, each
+ * kind numbers its strings from 0 (the empty string) upwards without gaps.
+ *
+ * Constructing an id looks the string up in a table shared by all threads, which is about as
+ * expensive as a lookup in a std::unordered_map. Ids used on hot paths should be constructed
+ * once, usually as constants at file scope:
+ * \code
+ * const effect_id effect_controlled( "controlled" );
+ * ...
+ * if( critter.has_effect( effect_controlled ) ) {
+ * \endcode
+ * The ids of loaded objects are constructed as they are loaded, so they stay dense.
+ */
+template<typename T>
+class interned_id
+{
+    public:
+        typedef interned_id<T> This;
+
+        /** Constructs the id of the empty string, which is always 0. */
+        interned_id() : interned_id( std::string() ) {
+        }
+        /** Explicit, like the constructor of @ref string_id, to make the lookup stand out. */
+        explicit interned_id( const std::string &id ) {
+            table &t = get_table();
+            std::lock_guard<std::mutex> lock( t.mutex );
+            auto iter = t.ids.find( id );
+            if( iter == t.ids.end() ) {
+                iter = t.ids.emplace( id, static_cast<int>( t.ids.size() ) ).first;
+            }
+            _id = iter->second;
+            // Nodes of an unordered_map never move, the key stays valid after the lock is gone.
+            _name = &iter->first;
+        }
+
+        bool operator==( const This &rhs ) const {
+            return _id == rhs._id;
+        }
+        bool operator!=( const This &rhs ) const {
+            return _id != rhs._id;
+        }
+        /** Orders by the time the strings were first seen, not alphabetically. */
+        bool operator<( const This &rhs ) const {
+            return _id < rhs._id;
+        }
+
+        int to_i() const {
+            return _id;
+        }
+        const std::string &str() const {
+            return *_name;
+        }
+        const char *c_str() const {
+            return _name->c_str();
+        }
+
+        /** Number of different strings of this kind seen so far. */
+        static size_t count() {
+            table &t = get_table();
+            std::lock_guard<std::mutex> lock( t.mutex );
+            return t.ids.size();
+        }
+
+    private:
+        struct table {
+            std::mutex mutex;
+            std::unordered_map<std::string, int> ids;
+
+            table() {
+                ids.emplace( std::string(), 0 );
+            }
+        };
+        static table &get_table() {
+            static table t;
+            return t;
+        }
+
+        int _id;
+        const std::string *_name;
+};
+
+/**
+ * A set of @ref interned_id, stored as one bit per id. Tests are a shift and a mask, ids
+ * of strings seen after the set was last modified are simply not in it.
+ */
+template<typename T>
+class interned_set
+{
+    public:
+        typedef interned_id<T> id_type;
+
+        bool test( const id_type &id ) const {
+            const size_t word = id.to_i() / bits_per_word;
+            return word < words.size() && ( words[word] >> ( id.to_i() % bits_per_word ) & 1 ) != 0;
+        }
+        void set( const id_type &id ) {
+            const size_t word = id.to_i() / bits_per_word;
+            if( word >= words.size() ) {
+                words.resize( word + 1, 0 );
+            }
+            words[word] |= uint64_t( 1 ) << ( id.to_i() % bits_per_word );
+        }
+        void reset( const id_type &id ) {
+            const size_t word = id.to_i() / bits_per_word;
+            if( word < words.size() ) {
+                words[word] &= ~( uint64_t( 1 ) << ( id.to_i() % bits_per_word ) );
+            }
+        }
+        void clear() {
+            words.clear();
+        }
+        bool empty() const {
+            for( auto word : words ) {
+                if( word != 0 ) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+        static const size_t bits_per_word = 64;
+        std::vector<uint64_t> words;
+};
+
+#endif
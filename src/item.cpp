@@ -2541,6 +2541,29 @@ bool item::has_flag( const std::string &f ) const
     return ret;
 }
 
+bool item::has_flag( const item_flag_id &f ) const
+{
+    // Same as above, without building and hashing strings for the type flags.
+    if( is_gun() ) {
+        if( is_in_auxiliary_mode() ) {
+            const item *gunmod = active_gunmod();
+            if( gunmod != nullptr && gunmod->has_flag( f ) ) {
+                return true;
+            }
+        } else {
+            for( auto &elem : contents ) {
+                if( elem.has_flag( f ) && !elem.is_auxiliary_gunmod() ) {
+                    return true;
+                }
+            }
+        }
+    }
+    if( type->flag_ids.test( f ) ) {
+        return true;
+    }
+    return !item_tags.empty() && item_tags.count( f.str() ) > 0;
+}
+
 bool item::has_property( const std::string& prop ) const {
    return type->properties.find(prop) != type->properties.end();
 }
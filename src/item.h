@@ -14,6 +14,7 @@
 #include "bodypart.h"
 #include "string_id.h"
 #include "line.h"
+#include "interned_id.h"
 
 class game;
 class Character;
@@ -32,6 +33,8 @@ class ma_technique;
 using matec_id = string_id<ma_technique>;
 class Skill;
 using skill_id = string_id<Skill>;
+struct item_flag;
+using item_flag_id = interned_id<item_flag>;
 
 std::string const& rad_badge_color(int rad);
 
@@ -795,6 +798,7 @@ public:
          */
         /*@{*/
         bool has_flag( const std::string& flag ) const;
+        bool has_flag( const item_flag_id &flag ) const;
         /** Removes all item specific flags. */
         void unset_flags();
         /*@}*/
@@ -41,6 +41,14 @@ static t_string_set item_whitelist;
 
 std::unique_ptr<Item_factory> item_controller( new Item_factory() );
 
+static void set_flag_ids( itype &type )
+{
+    type.flag_ids.clear();
+    for( auto &tag : type.item_tags ) {
+        type.flag_ids.set( item_flag_id( tag ) );
+    }
+}
+
 bool item_is_blacklisted(const std::string &id)
 {
     if (item_whitelist.count(id) > 0) {
@@ -560,6 +568,7 @@ void Item_factory::add_item_type(itype *new_type)
         debugmsg( "called Item_factory::add_item_type with nullptr" );
         return;
     }
+    set_flag_ids( *new_type );
     auto &entry = m_templates[new_type->id];
     delete entry;
     entry = new_type;
@@ -1030,6 +1039,7 @@ void Item_factory::load_basic_info(JsonObject &jo, itype *new_item_template)
             set_intvar(std::string(*it), new_item_template->light_emission, 1, 10000);
         }
     }
+    set_flag_ids( *new_item_template );
 
     if (jo.has_member("qualities")) {
         set_qualities_from_json(jo, "qualities", new_item_template);
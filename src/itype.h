@@ -7,6 +7,7 @@
 #include "pldata.h" // add_type
 #include "bodypart.h" // body_part::num_bp
 #include "string_id.h"
+#include "interned_id.h"
 
 #include <string>
 #include <vector>
@@ -25,6 +26,8 @@ class player;
 class item;
 class ma_technique;
 using matec_id = string_id<ma_technique>;
+struct item_flag;
+using item_flag_id = interned_id<item_flag>;
 enum art_effect_active : int;
 enum art_charge : int;
 enum art_effect_passive : int;
@@ -492,6 +495,8 @@ public:
     std::vector<use_function> use_methods; // Special effects of use
 
     std::set<std::string> item_tags;
+    /** @ref item_tags as ids, set by the @ref Item_factory when the type is loaded or added. */
+    interned_set<item_flag> flag_ids;
     std::set<matec_id> techniques;
 
     // Explosion that happens when the item is set on fire
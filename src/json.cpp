@@ -1,6 +1,8 @@
 #include "json.h"
 
+#include <algorithm> // min
 #include <cmath> // pow
+#include <cstdio> // EOF
 #include <cstdlib> // strtoul
 #include <cstring> // strcmp
 #include <fstream>
@@ -74,12 +76,22 @@ JsonObject::JsonObject(JsonIn &j) : positions()
     while (!jsin->end_object()) {
         std::string n = jsin->get_member_name();
         int p = jsin->tell();
-        if (n != "//" && n != "comment" && positions.count(n) > 0) {
-            // members with name "//" or "comment" are used for comments and
-            // should be ignored anyway.
-            j.error("duplicate entry in json object");
+        bool found = false;
+        for( auto &elem : positions ) {
+            if( elem.first == n ) {
+                if (n != "//" && n != "comment") {
+                    // members with name "//" or "comment" are used for comments and
+                    // should be ignored anyway.
+                    j.error("duplicate entry in json object");
+                }
+                elem.second = p;
+                found = true;
+                break;
+            }
+        }
+        if( !found ) {
+            positions.emplace_back( std::move( n ), p );
         }
-        positions[n] = p;
         jsin->skip_value();
     }
     end = jsin->tell();
@@ -112,10 +124,20 @@ bool JsonObject::empty()
     return positions.empty();
 }
 
+int JsonObject::find_position(const std::string &name) const
+{
+    for( auto &elem : positions ) {
+        if( elem.first == name ) {
+            return elem.second;
+        }
+    }
+    return 0;
+}
+
 int JsonObject::verify_position(const std::string &name,
                                 const bool throw_exception)
 {
-    int pos = positions[name]; // initialized to 0 if it doesn't exist
+    int pos = find_position(name);
     if (pos > start) {
         return pos;
     } else if (throw_exception && !jsin) {
@@ -202,7 +224,7 @@ bool JsonObject::get_bool(const std::string &name)
 
 bool JsonObject::get_bool(const std::string &name, const bool fallback)
 {
-    int pos = positions[name];
+    int pos = find_position(name);
     if (pos <= start) {
         return fallback;
     }
@@ -219,7 +241,7 @@ int JsonObject::get_int(const std::string &name)
 
 int JsonObject::get_int(const std::string &name, const int fallback)
 {
-    int pos = positions[name];
+    int pos = find_position(name);
     if (pos <= start) {
         return fallback;
     }
@@ -236,7 +258,7 @@ long JsonObject::get_long(const std::string &name)
 
 long JsonObject::get_long(const std::string &name, const long fallback)
 {
-    long pos = positions[name];
+    long pos = find_position(name);
     if (pos <= start) {
         return fallback;
     }
@@ -253,7 +275,7 @@ double JsonObject::get_float(const std::string &name)
 
 double JsonObject::get_float(const std::string &name, const double fallback)
 {
-    int pos = positions[name];
+    int pos = find_position(name);
     if (pos <= start) {
         return fallback;
     }
@@ -270,7 +292,7 @@ std::string JsonObject::get_string(const std::string &name)
 
 std::string JsonObject::get_string(const std::string &name, const std::string &fallback)
 {
-    int pos = positions[name];
+    int pos = find_position(name);
     if (pos <= start) {
         return fallback;
     }
@@ -282,7 +304,7 @@ std::string JsonObject::get_string(const std::string &name, const std::string &f
 
 JsonArray JsonObject::get_array(const std::string &name)
 {
-    int pos = positions[name];
+    int pos = find_position(name);
     if (pos <= start) {
         return JsonArray(); // empty array
     }
@@ -312,7 +334,7 @@ std::vector<std::string> JsonObject::get_string_array(const std::string &name)
 
 JsonObject JsonObject::get_object(const std::string &name)
 {
-    int pos = positions[name];
+    int pos = find_position(name);
     if (pos <= start) {
         return JsonObject(); // empty object
     }
@@ -323,7 +345,7 @@ JsonObject JsonObject::get_object(const std::string &name)
 std::set<std::string> JsonObject::get_tags(const std::string &name)
 {
     std::set<std::string> ret;
-    int pos = positions[name];
+    int pos = find_position(name);
     if (pos <= start) {
         return ret; // empty set
     }
@@ -717,41 +739,156 @@ bool JsonArray::has_object(int i)
  * allowing easy extraction into c++ datatypes.
  */
 JsonIn::JsonIn(std::istream &s, bool strict) :
-    stream(&s), strict(strict), ate_separator(false)
+    stream(&s), buffer(NULL), buffer_size(0), buffer_pos(0),
+    buffer_eof(false), buffer_fail(false), strict(strict), ate_separator(false)
+{
+}
+
+JsonIn::JsonIn(const char *data, size_t size, bool strict) :
+    stream(NULL), buffer(data), buffer_size(size), buffer_pos(0),
+    buffer_eof(false), buffer_fail(false), strict(strict), ate_separator(false)
+{
+}
+
+bool JsonIn::get_char(char &ch)
+{
+    if (stream) {
+        if (!stream->get(ch)) {
+            ch = '\0';
+            return false;
+        }
+        return true;
+    }
+    if (buffer_pos < buffer_size) {
+        ch = buffer[buffer_pos++];
+        return true;
+    }
+    buffer_eof = true;
+    buffer_fail = true;
+    ch = '\0';
+    return false;
+}
+
+int JsonIn::get_char()
+{
+    if (stream) {
+        return stream->get();
+    }
+    if (buffer_pos < buffer_size) {
+        return (unsigned char)buffer[buffer_pos++];
+    }
+    buffer_eof = true;
+    buffer_fail = true;
+    return EOF;
+}
+
+void JsonIn::get_chars(char *text, int count)
+{
+    if (stream) {
+        stream->get(text, count);
+        return;
+    }
+    int i = 0;
+    while (i < count - 1 && buffer_pos < buffer_size && buffer[buffer_pos] != '\n') {
+        text[i++] = buffer[buffer_pos++];
+    }
+    text[i] = '\0';
+    if (buffer_pos >= buffer_size && i < count - 1) {
+        buffer_eof = true;
+    }
+    if (i == 0) {
+        buffer_fail = true;
+    }
+}
+
+void JsonIn::unget_char()
+{
+    if (stream) {
+        stream->unget();
+    } else if (buffer_fail || buffer_pos == 0) {
+        buffer_fail = true;
+    } else {
+        buffer_eof = false;
+        --buffer_pos;
+    }
+}
+
+void JsonIn::seek_relative(int offset)
 {
+    if (stream) {
+        stream->seekg(offset, std::istream::cur);
+    } else if (offset < 0 && size_t(-offset) > buffer_pos) {
+        buffer_fail = true;
+    } else {
+        buffer_pos = std::min(buffer_pos + offset, buffer_size);
+    }
+}
+
+bool JsonIn::eof()
+{
+    return stream ? stream->eof() : buffer_eof;
+}
+
+bool JsonIn::fail()
+{
+    return stream ? stream->fail() : buffer_fail;
 }
 
 int JsonIn::tell()
 {
-    return stream->tellg();
+    if (stream) {
+        return stream->tellg();
+    }
+    return buffer_fail ? -1 : int(buffer_pos);
 }
 char JsonIn::peek()
 {
-    return (char)stream->peek();
+    if (stream) {
+        return (char)stream->peek();
+    }
+    if (buffer_pos < buffer_size) {
+        return buffer[buffer_pos];
+    }
+    buffer_eof = true;
+    return (char)EOF;
 }
 bool JsonIn::good()
 {
-    return stream->good();
+    if (stream) {
+        return stream->good();
+    }
+    return !buffer_eof && !buffer_fail;
 }
 
 void JsonIn::seek(int pos)
 {
-    stream->clear();
-    stream->seekg(pos);
+    if (stream) {
+        stream->clear();
+        stream->seekg(pos);
+    } else {
+        buffer_eof = false;
+        buffer_fail = pos < 0 || size_t(pos) > buffer_size;
+        buffer_pos = buffer_fail ? buffer_size : size_t(pos);
+    }
     ate_separator = false;
 }
 
 void JsonIn::eat_whitespace()
 {
+    if (!stream) {
+        while (buffer_pos < buffer_size && is_whitespace(buffer[buffer_pos])) {
+            ++buffer_pos;
+        }
+    }
     while (is_whitespace(peek())) {
-        stream->get();
+        get_char();
     }
 }
 
 void JsonIn::uneat_whitespace()
 {
     while (tell() > 0) {
-        stream->seekg(-1, std::istream::cur);
+        seek_relative(-1);
         if (!is_whitespace(peek())) {
             break;
         }
@@ -780,7 +917,7 @@ void JsonIn::skip_separator()
         if (strict && ate_separator) {
             error("duplicate separator");
         }
-        stream->get();
+        get_char();
         ate_separator = true;
     } else if (ch == ']' || ch == '}' || ch == ':') {
         // okay
@@ -809,7 +946,7 @@ void JsonIn::skip_pair_separator()
 {
     char ch;
     eat_whitespace();
-    stream->get(ch);
+    get_char(ch);
     if (ch != ':') {
         std::stringstream err;
         err << "expected pair separator ':', not '" << ch << "'";
@@ -824,16 +961,24 @@ void JsonIn::skip_string()
 {
     char ch;
     eat_whitespace();
-    stream->get(ch);
+    get_char(ch);
     if (ch != '"') {
         std::stringstream err;
         err << "expecting string but found '" << ch << "'";
         error(err.str(), -1);
     }
-    while (stream->good()) {
-        stream->get(ch);
+    while (good()) {
+        if (!stream) {
+            // skip the plain characters in one go
+            while (buffer_pos < buffer_size && buffer[buffer_pos] != '"' &&
+                   buffer[buffer_pos] != '\\' && buffer[buffer_pos] != '\r' &&
+                   buffer[buffer_pos] != '\n') {
+                ++buffer_pos;
+            }
+        }
+        get_char(ch);
         if (ch == '\\') {
-            stream->get(ch);
+            get_char(ch);
             continue;
         } else if (ch == '"') {
             break;
@@ -899,7 +1044,7 @@ void JsonIn::skip_true()
 {
     char text[5];
     eat_whitespace();
-    stream->get(text, 5);
+    get_chars(text, 5);
     if (strcmp(text, "true") != 0) {
         std::stringstream err;
         err << "expected \"true\", but found \"" << text << "\"";
@@ -912,7 +1057,7 @@ void JsonIn::skip_false()
 {
     char text[6];
     eat_whitespace();
-    stream->get(text, 6);
+    get_chars(text, 6);
     if (strcmp(text, "false") != 0) {
         std::stringstream err;
         err << "expected \"false\", but found \"" << text << "\"";
@@ -925,7 +1070,7 @@ void JsonIn::skip_null()
 {
     char text[5];
     eat_whitespace();
-    stream->get(text, 5);
+    get_chars(text, 5);
     if (strcmp(text, "null") != 0) {
         std::stringstream err;
         err << "expected \"null\", but found \"" << text << "\"";
@@ -939,11 +1084,11 @@ void JsonIn::skip_number()
     char ch;
     eat_whitespace();
     // skip all of (+-0123456789.eE)
-    while (stream->good()) {
-        stream->get(ch);
+    while (good()) {
+        get_char(ch);
         if (ch != '+' && ch != '-' && (ch < '0' || ch > '9') &&
             ch != 'e' && ch != 'E' && ch != '.') {
-            stream->unget();
+            unget_char();
             break;
         }
     }
@@ -966,7 +1111,7 @@ std::string JsonIn::get_string()
     eat_whitespace();
     int startpos = tell();
     // the first character had better be a '"'
-    stream->get(ch);
+    get_char(ch);
     if (ch != '"') {
         std::stringstream err;
         err << "expecting string but got '" << ch << "'";
@@ -974,8 +1119,19 @@ std::string JsonIn::get_string()
     }
     // add chars to the string, one at a time, converting:
     // \", \\, \/, \b, \f, \n, \r, \t and \uxxxx according to JSON spec.
-    while (stream->good()) {
-        stream->get(ch);
+    while (good()) {
+        if (!stream && !backslash) {
+            // copy plain characters straight from the buffer, up to the next special one
+            const size_t run_start = buffer_pos;
+            while (buffer_pos < buffer_size && buffer[buffer_pos] != '"' &&
+                   buffer[buffer_pos] != '\\' && (unsigned char)buffer[buffer_pos] >= 0x20) {
+                ++buffer_pos;
+            }
+            s.append(buffer + run_start, buffer_pos - run_start);
+        }
+        if (!get_char(ch)) {
+            break;
+        }
         if (ch == '\\') {
             if (backslash) {
                 s += '\\';
@@ -1002,7 +1158,7 @@ std::string JsonIn::get_string()
                 s += '\t';
             } else if (ch == 'u') {
                 // get the next four characters as hexadecimal
-                stream->get(unihex, 5);
+                get_chars(unihex, 5);
                 // insert the appropriate unicode character in utf8
                 // TODO: verify that unihex is in fact 4 hex digits.
                 char **endptr = 0;
@@ -1029,11 +1185,10 @@ std::string JsonIn::get_string()
         }
     }
     // if we get to here, probably hit a premature EOF?
-    if (stream->eof()) {
-        stream->clear();
+    if (eof()) {
         seek(startpos);
         error("couldn't find end of string, reached EOF.");
-    } else if (stream->fail()) {
+    } else if (fail()) {
         throw JsonError( "stream failure while reading string." );
     }
     throw JsonError( "something went wrong D:" );
@@ -1062,10 +1217,10 @@ double JsonIn::get_float()
     int e = 0;
     int mod_e = 0;
     eat_whitespace();
-    stream->get(ch);
+    get_char(ch);
     if (ch == '-') {
         neg = true;
-        stream->get(ch);
+        get_char(ch);
     } else if (ch != '.' && (ch < '0' || ch > '9')) {
         // not a valid float
         std::stringstream err;
@@ -1074,7 +1229,7 @@ double JsonIn::get_float()
     }
     if (strict && ch == '0') {
         // allow a single leading zero in front of a '.' or 'e'/'E'
-        stream->get(ch);
+        get_char(ch);
         if (ch >= '0' && ch <= '9') {
             error("leading zeros not strictly allowed", -1);
         }
@@ -1082,40 +1237,40 @@ double JsonIn::get_float()
     while (ch >= '0' && ch <= '9') {
         i *= 10;
         i += (ch - '0');
-        stream->get(ch);
+        get_char(ch);
     }
     if (ch == '.') {
-        stream->get(ch);
+        get_char(ch);
         while (ch >= '0' && ch <= '9') {
             i *= 10;
             i += (ch - '0');
             mod_e -= 1;
-            stream->get(ch);
+            get_char(ch);
         }
     }
     if (neg) {
         i *= -1;
     }
     if (ch == 'e' || ch == 'E') {
-        stream->get(ch);
+        get_char(ch);
         neg = false;
         if (ch == '-') {
             neg = true;
-            stream->get(ch);
+            get_char(ch);
         } else if (ch == '+') {
-            stream->get(ch);
+            get_char(ch);
         }
         while (ch >= '0' && ch <= '9') {
             e *= 10;
             e += (ch - '0');
-            stream->get(ch);
+            get_char(ch);
         }
         if (neg) {
             e *= -1;
         }
     }
     // unget the final non-number character (probably a separator)
-    stream->unget();
+    unget_char();
     end_value();
     // now put it all together!
     return i * std::pow(10.0f, e + mod_e);
@@ -1127,9 +1282,9 @@ bool JsonIn::get_bool()
     char text[5];
     std::stringstream err;
     eat_whitespace();
-    stream->get(ch);
+    get_char(ch);
     if (ch == 't') {
-        stream->get(text, 4);
+        get_chars(text, 4);
         if (strcmp(text, "rue") == 0) {
             end_value();
             return true;
@@ -1139,7 +1294,7 @@ bool JsonIn::get_bool()
             error(err.str(), -4);
         }
     } else if (ch == 'f') {
-        stream->get(text, 5);
+        get_chars(text, 5);
         if (strcmp(text, "alse") == 0) {
             end_value();
             return false;
@@ -1167,7 +1322,7 @@ void JsonIn::start_array()
 {
     eat_whitespace();
     if (peek() == '[') {
-        stream->get();
+        get_char();
         ate_separator = false;
         return;
     } else {
@@ -1187,7 +1342,7 @@ bool JsonIn::end_array()
             uneat_whitespace();
             error("separator not strictly allowed at end of array");
         }
-        stream->get();
+        get_char();
         end_value();
         return true;
     } else {
@@ -1200,7 +1355,7 @@ void JsonIn::start_object()
 {
     eat_whitespace();
     if (peek() == '{') {
-        stream->get();
+        get_char();
         ate_separator = false; // not that we want to
         return;
     } else {
@@ -1220,7 +1375,7 @@ bool JsonIn::end_object()
             uneat_whitespace();
             error("separator not strictly allowed at end of object");
         }
-        stream->get();
+        get_char();
         end_value();
         return true;
     } else {
@@ -1440,9 +1595,9 @@ bool JsonIn::read(JsonDeserializer &j)
 // WARNING: for occasional use only.
 std::string JsonIn::line_number(int offset_modifier)
 {
-    if (stream->eof()) {
+    if (eof()) {
         return "EOF";
-    } else if (stream->fail()) {
+    } else if (fail()) {
         return "???";
     } // else stream is fine
     int pos = tell();
@@ -1451,12 +1606,12 @@ std::string JsonIn::line_number(int offset_modifier)
     char ch;
     seek(0);
     for (int i = 0; i < pos; ++i) {
-        stream->get(ch);
+        get_char(ch);
         if (ch == '\r') {
             offset = 1;
             ++line;
             if (peek() == '\n') {
-                stream->get();
+                get_char();
                 ++i;
             }
         } else if (ch == '\n') {
@@ -1476,19 +1631,16 @@ void JsonIn::error(std::string message, int offset)
     std::ostringstream err;
     err << line_number(offset) << ": " << message;
     // if we can't get more info from the stream don't try
-    if (!stream->good()) {
+    if (!good()) {
         throw JsonError( err.str() );
     }
     // also print surrounding few lines of context, if not too large
     err << "\n\n";
-    stream->seekg(offset, std::istream::cur);
+    seek_relative(offset);
     size_t pos = tell();
     rewind(3, 240);
     size_t startpos = tell();
-    char buffer[241];
-    stream->read(&buffer[0], pos - startpos);
-    buffer[pos - startpos] = '\0';
-    err << buffer;
+    err << substr(startpos, pos - startpos);
     if (!is_whitespace(peek())) {
         err << peek();
     }
@@ -1502,10 +1654,10 @@ void JsonIn::error(std::string message, int offset)
     err << "^\n";
     seek(pos);
     // if that wasn't the end of the line, continue underneath pointer
-    char ch = stream->get();
+    char ch = get_char();
     if (ch == '\r') {
         if (peek() == '\n') {
-            stream->get();
+            get_char();
         }
     } else if (ch == '\n') {
         // pass
@@ -1517,12 +1669,12 @@ void JsonIn::error(std::string message, int offset)
     // print the next couple lines as well
     int line_count = 0;
     for (int i = 0; i < 240; ++i) {
-        stream->get(ch);
+        get_char(ch);
         err << ch;
         if (ch == '\r') {
             ++line_count;
             if (peek() == '\n') {
-                err << stream->get();
+                err << get_char();
             }
         } else if (ch == '\n') {
             ++line_count;
@@ -1545,13 +1697,13 @@ void JsonIn::rewind(int max_lines, int max_chars)
         return;
     }
     int lines_found = 0;
-    stream->seekg(-1, std::istream::cur);
+    seek_relative(-1);
     for (int i = 0; i < max_chars; ++i) {
         size_t tellpos = tell();
         if (peek() == '\n') {
             ++lines_found;
             if (tellpos > 0) {
-                stream->seekg(-1, std::istream::cur);
+                seek_relative(-1);
                 // note: does not update tellpos or count a character
                 if (peek() != '\r') {
                     continue;
@@ -1564,15 +1716,21 @@ void JsonIn::rewind(int max_lines, int max_chars)
             break;
         } else if (lines_found == max_lines) {
             // don't include the last \n or \r
-            stream->seekg(1, std::istream::cur);
+            seek_relative(1);
             break;
         }
-        stream->seekg(-1, std::istream::cur);
+        seek_relative(-1);
     }
 }
 
 std::string JsonIn::substr(size_t pos, size_t len)
 {
+    if (!stream) {
+        pos = std::min(pos, buffer_size);
+        len = std::min(len, buffer_size - pos);
+        buffer_pos = pos + len;
+        return std::string(buffer + pos, len);
+    }
     std::string ret;
     if (len == std::string::npos) {
         stream->seekg(0, std::istream::end);
@@ -1850,8 +2008,8 @@ void JsonSerializer::serialize(std::ostream &o) const
 
 void JsonDeserializer::deserialize(const std::string &json_string)
 {
-    std::istringstream s(json_string);
-    deserialize(s);
+    JsonIn jin(json_string.data(), json_string.size());
+    deserialize(jin);
 }
 
 void JsonDeserializer::deserialize(std::istream &i)
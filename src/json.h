@@ -82,6 +82,12 @@ inline E string_to_enum_look_up( const C &container, const std::string &data )
  *
  * The JsonIn class provides a wrapper around a std::istream,
  * with methods for reading JSON data directly from the stream.
+ * It can also read straight from a buffer in memory, such as a whole file
+ * read in at once, which is a lot faster than going through a stream:
+ *
+ *     JsonIn jsin(contents.data(), contents.size());
+ *
+ * The buffer is not copied and has to outlive the JsonIn.
  *
  * JsonObject and JsonArray provide higher-level wrappers,
  * and are a little easier to use in most cases,
@@ -161,6 +167,12 @@ class JsonIn
 {
     private:
         std::istream *stream;
+        // used in stead of the stream when reading from memory
+        const char *buffer;
+        size_t buffer_size;
+        size_t buffer_pos;
+        bool buffer_eof; // like the eofbit of a stream
+        bool buffer_fail; // like the failbit of a stream
         bool strict; // throw errors on non-RFC-4627-compliant input
         bool ate_separator;
 
@@ -168,8 +180,18 @@ class JsonIn
         void skip_pair_separator();
         void end_value();
 
+        // character access, from the stream or the buffer
+        bool get_char(char &ch); // sets ch to '\0' at the end
+        int get_char();
+        void get_chars(char *text, int count); // like std::istream::get(text, count)
+        void unget_char();
+        void seek_relative(int offset);
+        bool eof();
+        bool fail();
+
     public:
         JsonIn(std::istream &stream, bool strict = true);
+        JsonIn(const char *data, size_t size, bool strict = true);
 
         bool get_ate_separator()
         {
@@ -598,11 +620,13 @@ class JsonOut
 class JsonObject
 {
     private:
-        std::map<std::string, int> positions;
+        // objects have few members, a flat list is faster to build and search than a map
+        std::vector<std::pair<std::string, int>> positions;
         int start;
         int end;
         bool final_separator;
         JsonIn *jsin;
+        int find_position(const std::string &name) const; // 0 if not found
         int verify_position(const std::string &name,
                             const bool throw_exception = true);
 
@@ -689,7 +713,7 @@ class JsonObject
         // return false if the member is not found.
         template <typename T> bool read(const std::string &name, T &t)
         {
-            int pos = positions[name];
+            int pos = find_position(name);
             if (pos <= start) {
                 return false;
             }
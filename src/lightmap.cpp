@@ -11,7 +11,9 @@
 #include "submap.h"
 #include "mtype.h"
 #include "weather.h"
+#include "worker_pool.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 
@@ -48,17 +50,24 @@ void map::build_transparency_cache( const int zlev )
     auto &transparency_cache = map_cache.transparency_cache;
     auto &outside_cache = map_cache.outside_cache;
 
-    if( !map_cache.transparency_cache_dirty ) {
-        return;
+    auto &stats = map_cache.rebuild_stats;
+    if( stats.turn != calendar::turn ) {
+        stats = cache_rebuild_stats();
+        stats.turn = calendar::turn;
     }
 
-    // Default to just barely not transparent.
-    std::uninitialized_fill_n(
-        &transparency_cache[0][0], MAPSIZE*SEEX * MAPSIZE*SEEY, LIGHT_TRANSPARENCY_OPEN_AIR);
+    auto &dirty = map_cache.transparency_cache_dirty;
+    if( dirty.none() ) {
+        return;
+    }
 
-    // Traverse the submaps in order
+    // Traverse the submaps in order, only those that changed
     for( int smx = 0; smx < my_MAPSIZE; ++smx ) {
         for( int smy = 0; smy < my_MAPSIZE; ++smy ) {
+            if( !dirty[smx * MAPSIZE + smy] ) {
+                continue;
+            }
+            stats.transparency_submaps++;
             auto const cur_submap = get_submap_at_grid( smx, smy, zlev );
 
             for( int sx = 0; sx < SEEX; ++sx ) {
@@ -67,6 +76,8 @@ void map::build_transparency_cache( const int zlev )
                     const int y = sy + smy * SEEY;
 
                     auto &value = transparency_cache[x][y];
+                    // Default to just barely not transparent.
+                    value = LIGHT_TRANSPARENCY_OPEN_AIR;
 
                     if( !(cur_submap->ter[sx][sy].obj().transparent &&
                           cur_submap->frn[sx][sy].obj().transparent) ) {
@@ -122,7 +133,7 @@ void map::build_transparency_cache( const int zlev )
             }
         }
     }
-    map_cache.transparency_cache_dirty = false;
+    dirty.reset();
 }
 
 void map::apply_character_light( const player &p )
@@ -133,14 +144,107 @@ void map::apply_character_light( const player &p )
     }
 }
 
+namespace
+{
+
+// Inclusive rectangle in map coordinates
+struct light_area {
+    int minx;
+    int miny;
+    int maxx;
+    int maxy;
+
+    bool intersects( const light_area &other ) const {
+        return minx <= other.maxx && other.minx <= maxx && miny <= other.maxy && other.miny <= maxy;
+    }
+};
+
+light_area footprint( const light_source &source )
+{
+    const int radius = source.radius();
+    return light_area{ source.p.x - radius, source.p.y - radius,
+                       source.p.x + radius, source.p.y + radius };
+}
+
+}
+
+light_source light_source::point( const tripoint &p, const float luminance )
+{
+    return light_source{ POINT, p, luminance, 0, 0, NORTH | EAST | SOUTH | WEST };
+}
+
+light_source light_source::arc( const tripoint &p, const int angle, const float luminance,
+                                const int width )
+{
+    return light_source{ ARC, p, luminance, angle, width, 0 };
+}
+
+light_source light_source::directional( const tripoint &p, const int angle, const float luminance )
+{
+    return light_source{ DIRECTIONAL, p, luminance, angle, 0, 0 };
+}
+
+int light_source::radius() const
+{
+    if( type == ARC ) {
+        // Every ray ends at this distance.
+        return LIGHT_RANGE( luminance ) + 1;
+    }
+    // castLight goes on while the light is above LIGHT_AMBIENT_LOW, and at distance d it is
+    // luminance / ( exp( transparency * d ) * d ), which can't be more than luminance / d.
+    // Casting stops at 60 squares regardless.
+    if( type == POINT && luminance <= 1 ) {
+        return 0;
+    }
+    return std::min( 60, static_cast<int>( luminance / LIGHT_AMBIENT_LOW ) + 2 );
+}
+
+bool light_source::operator==( const light_source &rhs ) const
+{
+    return type == rhs.type && p == rhs.p && luminance == rhs.luminance && angle == rhs.angle &&
+           width == rhs.width && directions == rhs.directions;
+}
+
+bool light_source::operator<( const light_source &rhs ) const
+{
+    if( type != rhs.type ) {
+        return type < rhs.type;
+    }
+    if( p != rhs.p ) {
+        return p < rhs.p;
+    }
+    if( luminance != rhs.luminance ) {
+        return luminance < rhs.luminance;
+    }
+    if( angle != rhs.angle ) {
+        return angle < rhs.angle;
+    }
+    if( width != rhs.width ) {
+        return width < rhs.width;
+    }
+    return directions < rhs.directions;
+}
+
+/**
+ * Lights are combined with max(), so the lightmap doesn't depend on the order in which the
+ * light sources are applied. This allows to only recompute the parts of it where something
+ * changed: the light sources are collected first, and compared with the ones the previous
+ * lightmap was built from. The area any added or removed source can reach is reset to the
+ * ambient light, and all the sources that can reach into that area are cast again. Other
+ * sources can't change anything there, and casting one again changes nothing outside of it.
+ * Changes of the ambient light are handled the same way, while any change of the transparency
+ * within reach of a light source rebuilds everything.
+ */
 void map::generate_lightmap( const int zlev )
 {
     auto &map_cache = get_cache( zlev );
     auto &lm = map_cache.lm;
     auto &sm = map_cache.sm;
     auto &outside_cache = map_cache.outside_cache;
-    std::memset(lm, 0, sizeof(lm));
-    std::memset(sm, 0, sizeof(sm));
+    auto &transparency_cache = map_cache.transparency_cache;
+    auto &ambient = map_cache.lightmap_ambient;
+    auto &sources = map_cache.pending_light_sources;
+    sources.clear();
 
     /* Bulk light sources wastefully cast rays into neighbors; a burning hospital can produce
          significant slowdown, so for stuff like fire and lava:
@@ -160,17 +264,42 @@ void map::generate_lightmap( const int zlev )
     const float natural_light  = g->natural_light_level( zlev );
     const float inside_light = (natural_light > LIGHT_SOURCE_BRIGHT) ?
         LIGHT_AMBIENT_LOW + 1.0 : LIGHT_AMBIENT_MINIMAL;
-    // Apply sunlight, first light source so just assign
+
+    std::vector<light_area> dirty_areas;
+    bool rebuild = map_cache.lightmap_dirty;
+
+    // Apply sunlight, the ambient light everything else adds to
+    light_area ambient_changed{ LIGHTMAP_CACHE_X, LIGHTMAP_CACHE_Y, -1, -1 };
     for( int sx = 0; sx < LIGHTMAP_CACHE_X; ++sx ) {
         for( int sy = 0; sy < LIGHTMAP_CACHE_Y; ++sy ) {
             // In bright light indoor light exists to some degree
-            if( !outside_cache[sx][sy] ) {
-                lm[sx][sy] = inside_light;
-            } else {
-                lm[sx][sy] = natural_light;
+            float light = outside_cache[sx][sy] ? natural_light : inside_light;
+            // Project light into any openings into buildings.
+            if( natural_light > LIGHT_SOURCE_BRIGHT && !outside_cache[sx][sy] ) {
+                // Apply light sources for external/internal divide
+                for( int i = 0; i < 4; ++i ) {
+                    if( INBOUNDS( sx + dir_x[i], sy + dir_y[i] ) &&
+                        outside_cache[sx + dir_x[i]][sy + dir_y[i]] ) {
+                        light = natural_light;
+
+                        if( transparency_cache[sx][sy] > LIGHT_TRANSPARENCY_SOLID ) {
+                            apply_directional_light( tripoint( sx, sy, zlev ), dir_d[i], natural_light );
+                        }
+                    }
+                }
+            }
+            if( ambient[sx][sy] != light ) {
+                ambient[sx][sy] = light;
+                ambient_changed.minx = std::min( ambient_changed.minx, sx );
+                ambient_changed.miny = std::min( ambient_changed.miny, sy );
+                ambient_changed.maxx = std::max( ambient_changed.maxx, sx );
+                ambient_changed.maxy = std::max( ambient_changed.maxy, sy );
             }
         }
     }
+    if( ambient_changed.minx <= ambient_changed.maxx ) {
+        dirty_areas.push_back( ambient_changed );
+    }
 
     apply_character_light( g->u );
     for( auto &n : g->active_npc ) {
@@ -187,20 +316,6 @@ void map::generate_lightmap( const int zlev )
                     const int x = sx + smx * SEEX;
                     const int y = sy + smy * SEEY;
                     const tripoint p( x, y, zlev );
-                    // Project light into any openings into buildings.
-                    if (natural_light > LIGHT_SOURCE_BRIGHT && !outside_cache[p.x][p.y]) {
-                        // Apply light sources for external/internal divide
-                        for(int i = 0; i < 4; ++i) {
-                            if (INBOUNDS(p.x + dir_x[i], p.y + dir_y[i]) &&
-                                outside_cache[p.x + dir_x[i]][p.y + dir_y[i]]) {
-                                lm[p.x][p.y] = natural_light;
-
-                                if (light_transparency( p ) > LIGHT_TRANSPARENCY_SOLID) {
-                                    apply_directional_light( p, dir_d[i], natural_light );
-                                }
-                            }
-                        }
-                    }
 
                     if( cur_submap->lum[sx][sy] && has_items( p ) ) {
                         auto items = i_at( p );
@@ -271,7 +386,6 @@ void map::generate_lightmap( const int zlev )
             }
         }
     }
-
     for (size_t i = 0; i < g->num_zombies(); ++i) {
         auto &critter = g->zombie(i);
         if(critter.is_hallucination()) {
@@ -382,21 +496,134 @@ void map::generate_lightmap( const int zlev )
         unbuffered: (12^2)*(160*4) = apply_light_ray x 92160
         buffered:   (12*4)*(160)   = apply_light_ray x 7680
     */
-    const tripoint cache_start( 0, 0, zlev );
-    const tripoint cache_end( LIGHTMAP_CACHE_X, LIGHTMAP_CACHE_Y, zlev );
-    for( const tripoint &p : points_in_rectangle( cache_start, cache_end ) ) {
-        if( light_source_buffer[p.x][p.y] > 0.0 ) {
-            apply_light_source( p, light_source_buffer[p.x][p.y] );
+    for( int x = 0; x < LIGHTMAP_CACHE_X; ++x ) {
+        for( int y = 0; y < LIGHTMAP_CACHE_Y; ++y ) {
+            if( light_source_buffer[x][y] > 0.0 ) {
+                apply_light_source( tripoint( x, y, zlev ), light_source_buffer[x][y] );
+            }
         }
     }
 
+    /* If we're a 5 luminance fire , we skip casting rays into ey && sx if we have
+         neighboring fires to the north and west that were applied via light_source_buffer
+       If there's a 1 luminance candle east in buffer, we still cast rays into ex since it's smaller
+       If there's a 100 luminance magnesium flare south added via apply_light_source instead od
+         add_light_source, it's unbuffered so we'll still cast rays into sy.
+
+          ey
+        nnnNnnn
+        w     e
+        w  5 +e
+     sx W 5*1+E ex
+        w ++++e
+        w+++++e
+        sssSsss
+           sy
+    */
+    const int peer_inbounds = LIGHTMAP_CACHE_X - 1;
+    for( auto &source : sources ) {
+        const int x = source.p.x;
+        const int y = source.p.y;
+        if( source.type != light_source::POINT || !INBOUNDS( x, y ) ) {
+            continue;
+        }
+        const float luminance = source.luminance <= 2 ? 1.49f : source.luminance;
+        source.directions = 0;
+        if( y != 0 && light_source_buffer[x][y - 1] < luminance ) {
+            source.directions |= light_source::NORTH;
+        }
+        if( y != peer_inbounds && light_source_buffer[x][y + 1] < luminance ) {
+            source.directions |= light_source::SOUTH;
+        }
+        if( x != peer_inbounds && light_source_buffer[x + 1][y] < luminance ) {
+            source.directions |= light_source::EAST;
+        }
+        if( x != 0 && light_source_buffer[x - 1][y] < luminance ) {
+            source.directions |= light_source::WEST;
+        }
+    }
+    std::sort( sources.begin(), sources.end() );
+
+    auto &previous_sources = map_cache.light_sources;
+    // The light of all sources depends on the transparency of the tiles it passes.
+    auto &light_transparency = map_cache.lightmap_transparency;
+    light_area transparency_changed{ LIGHTMAP_CACHE_X, LIGHTMAP_CACHE_Y, -1, -1 };
+    for( int x = 0; x < LIGHTMAP_CACHE_X; ++x ) {
+        for( int y = 0; y < LIGHTMAP_CACHE_Y; ++y ) {
+            if( light_transparency[x][y] != transparency_cache[x][y] ) {
+                light_transparency[x][y] = transparency_cache[x][y];
+                transparency_changed.minx = std::min( transparency_changed.minx, x );
+                transparency_changed.miny = std::min( transparency_changed.miny, y );
+                transparency_changed.maxx = std::max( transparency_changed.maxx, x );
+                transparency_changed.maxy = std::max( transparency_changed.maxy, y );
+            }
+        }
+    }
+    if( transparency_changed.minx <= transparency_changed.maxx ) {
+        for( const auto &source : previous_sources ) {
+            rebuild = rebuild || footprint( source ).intersects( transparency_changed );
+        }
+        for( const auto &source : sources ) {
+            rebuild = rebuild || footprint( source ).intersects( transparency_changed );
+        }
+    }
+
+    if( rebuild ) {
+        dirty_areas.assign( 1, light_area{ 0, 0, LIGHTMAP_CACHE_X - 1, LIGHTMAP_CACHE_Y - 1 } );
+    } else {
+        // Both lists are sorted, so the sources that were added or removed are easy to find.
+        auto prev = previous_sources.begin();
+        auto cur = sources.begin();
+        while( prev != previous_sources.end() || cur != sources.end() ) {
+            if( cur == sources.end() || ( prev != previous_sources.end() && *prev < *cur ) ) {
+                dirty_areas.push_back( footprint( *prev ) );
+                ++prev;
+            } else if( prev == previous_sources.end() || *cur < *prev ) {
+                dirty_areas.push_back( footprint( *cur ) );
+                ++cur;
+            } else {
+                ++prev;
+                ++cur;
+            }
+        }
+    }
+
+    for( const auto &area : dirty_areas ) {
+        const int minx = std::max( area.minx, 0 );
+        const int miny = std::max( area.miny, 0 );
+        const int maxx = std::min( area.maxx, LIGHTMAP_CACHE_X - 1 );
+        const int maxy = std::min( area.maxy, LIGHTMAP_CACHE_Y - 1 );
+        for( int x = minx; x <= maxx; ++x ) {
+            std::copy( &ambient[x][miny], &ambient[x][maxy] + 1, &lm[x][miny] );
+            std::fill( &sm[x][miny], &sm[x][maxy] + 1, 0.0f );
+        }
+    }
+    if( !dirty_areas.empty() ) {
+        std::vector<const light_source *> to_cast;
+        for( const auto &source : sources ) {
+            const light_area area = footprint( source );
+            for( const auto &dirty : dirty_areas ) {
+                if( area.intersects( dirty ) ) {
+                    to_cast.push_back( &source );
+                    break;
+                }
+            }
+        }
+        cast_lights( to_cast, zlev );
+    }
+    previous_sources.swap( sources );
+    map_cache.lightmap_dirty = false;
 
     if (g->u.has_active_bionic("bio_night") ) {
+        const tripoint cache_start( 0, 0, zlev );
+        const tripoint cache_end( LIGHTMAP_CACHE_X, LIGHTMAP_CACHE_Y, zlev );
         for( const tripoint &p : points_in_rectangle( cache_start, cache_end ) ) {
             if( rl_dist( p, g->u.pos() ) < 15 ) {
                 lm[p.x][p.y] = LIGHT_AMBIENT_MINIMAL;
             }
         }
+        // This isn't a light source, the next lightmap has to start from scratch.
+        map_cache.lightmap_dirty = true;
     }
 }
 
@@ -670,14 +897,165 @@ static bool light_check( const float &transparency, const float &intensity ) {
 
 void map::apply_light_source( const tripoint &p, float luminance )
 {
-    auto &cache = get_cache( p.z );
-    float (&lm)[MAPSIZE*SEEX][MAPSIZE*SEEY] = cache.lm;
-    float (&sm)[MAPSIZE*SEEX][MAPSIZE*SEEY] = cache.sm;
-    float (&transparency_cache)[MAPSIZE*SEEX][MAPSIZE*SEEY] = cache.transparency_cache;
-    float (&light_source_buffer)[MAPSIZE*SEEX][MAPSIZE*SEEY] = cache.light_source_buffer;
+    get_cache( p.z ).pending_light_sources.push_back( light_source::point( p, luminance ) );
+}
+
+void map::apply_directional_light( const tripoint &p, int direction, float luminance )
+{
+    get_cache( p.z ).pending_light_sources.push_back(
+        light_source::directional( p, direction, luminance ) );
+}
+
+void map::apply_light_arc( const tripoint &p, int angle, float luminance, int wideangle )
+{
+    if (luminance <= LIGHT_SOURCE_LOCAL) {
+        return;
+    }
+    get_cache( p.z ).pending_light_sources.push_back(
+        light_source::arc( p, angle, luminance, wideangle ) );
+}
+
+void map::cast_lights( const std::vector<const light_source *> &sources, const int zlev )
+{
+    auto &map_cache = get_cache( zlev );
+    float (&lm)[MAPSIZE*SEEX][MAPSIZE*SEEY] = map_cache.lm;
+    float (&sm)[MAPSIZE*SEEX][MAPSIZE*SEEY] = map_cache.sm;
+
+    worker_pool &pool = worker_pool::get();
+    // With fewer sources, waking the other threads and merging their output costs more than it saves.
+    static const size_t min_parallel_sources = 4;
+    if( !OPTIONS["PARALLEL_LIGHTMAP"] || pool.size() == 1 || sources.size() < min_parallel_sources ) {
+        for( const light_source *source : sources ) {
+            cast_light( *source, lm, sm );
+        }
+        return;
+    }
+
+    while( lightmap_buffers.size() < pool.size() ) {
+        std::unique_ptr<lightmap_buffer> buffer( new lightmap_buffer() );
+        buffer->minx = LIGHTMAP_CACHE_X;
+        buffer->miny = LIGHTMAP_CACHE_Y;
+        buffer->maxx = -1;
+        buffer->maxy = -1;
+        lightmap_buffers.push_back( std::move( buffer ) );
+    }
+
+    pool.run( sources.size(), [&]( const size_t index, const size_t worker ) {
+        const light_source &source = *sources[index];
+        lightmap_buffer &buffer = *lightmap_buffers[worker];
+        cast_light( source, buffer.lm, buffer.sm );
+        const light_area area = footprint( source );
+        buffer.minx = std::min( buffer.minx, std::max( area.minx, 0 ) );
+        buffer.miny = std::min( buffer.miny, std::max( area.miny, 0 ) );
+        buffer.maxx = std::max( buffer.maxx, std::min( area.maxx, LIGHTMAP_CACHE_X - 1 ) );
+        buffer.maxy = std::max( buffer.maxy, std::min( area.maxy, LIGHTMAP_CACHE_Y - 1 ) );
+    } );
+
+    // Light is combined by taking the maximum, so the result is the same no matter which worker
+    // cast which source. Every worker merges (and clears) a stripe of columns of all buffers.
+    const size_t stripes = pool.size();
+    pool.run( stripes, [&]( const size_t stripe, size_t ) {
+        const int stripe_minx = LIGHTMAP_CACHE_X * stripe / stripes;
+        const int stripe_maxx = LIGHTMAP_CACHE_X * ( stripe + 1 ) / stripes - 1;
+        for( auto &buffer : lightmap_buffers ) {
+            const int minx = std::max( stripe_minx, buffer->minx );
+            const int maxx = std::min( stripe_maxx, buffer->maxx );
+            const int miny = buffer->miny;
+            const int maxy = buffer->maxy;
+            for( int x = minx; x <= maxx; ++x ) {
+                for( int y = miny; y <= maxy; ++y ) {
+                    lm[x][y] = std::max( lm[x][y], buffer->lm[x][y] );
+                    sm[x][y] = std::max( sm[x][y], buffer->sm[x][y] );
+                }
+                std::fill( &buffer->lm[x][miny], &buffer->lm[x][maxy] + 1, 0.0f );
+                std::fill( &buffer->sm[x][miny], &buffer->sm[x][maxy] + 1, 0.0f );
+            }
+        }
+    } );
+    for( auto &buffer : lightmap_buffers ) {
+        buffer->minx = LIGHTMAP_CACHE_X;
+        buffer->miny = LIGHTMAP_CACHE_Y;
+        buffer->maxx = -1;
+        buffer->maxy = -1;
+    }
+}
+
+void map::cast_light( const light_source &source, float (&lm)[MAPSIZE*SEEX][MAPSIZE*SEEY],
+                      float (&sm)[MAPSIZE*SEEX][MAPSIZE*SEEY] )
+{
+    const tripoint &p = source.p;
+    const float (&transparency_cache)[MAPSIZE*SEEX][MAPSIZE*SEEY] =
+        get_cache_ref( p.z ).transparency_cache;
 
     const int x = p.x;
     const int y = p.y;
+    float luminance = source.luminance;
+
+    if( source.type == light_source::DIRECTIONAL ) {
+        const int direction = source.angle;
+        if( direction == 90 ) {
+            castLight<1, 0, 0, -1, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
+            castLight<-1, 0, 0, -1, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
+        } else if( direction == 0 ) {
+            castLight<0, -1, 1, 0, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
+            castLight<0, -1, -1, 0, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
+        } else if( direction == 270 ) {
+            castLight<1, 0, 0, 1, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
+            castLight<-1, 0, 0, 1, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
+        } else if( direction == 180 ) {
+            castLight<0, 1, 1, 0, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
+            castLight<0, 1, -1, 0, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
+        }
+        return;
+    }
+
+    if( source.type == light_source::ARC ) {
+        bool lit[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y] {};
+
+        cast_light( light_source::point( p, LIGHT_SOURCE_LOCAL ), lm, sm );
+
+        // Normalise (should work with negative values too)
+        const double wangle = source.width / 2.0;
+
+        int nangle = source.angle % 360;
+
+        tripoint end;
+        double rad = PI * (double)nangle / 180;
+        int range = LIGHT_RANGE(luminance);
+        calc_ray_end( nangle, range, p, end );
+        apply_light_ray( lit, lm, p, end, luminance );
+
+        tripoint test;
+        calc_ray_end(wangle + nangle, range, p, test );
+
+        const float wdist = hypot( end.x - test.x, end.y - test.y );
+        if (wdist <= 0.5) {
+            return;
+        }
+
+        // attempt to determine beam density required to cover all squares
+        const double wstep = ( wangle / ( wdist * SQRT_2 ) );
+
+        for( double ao = wstep; ao <= wangle; ao += wstep ) {
+            if( trigdist ) {
+                double fdist = (ao * HALFPI) / wangle;
+                double orad = ( PI * ao / 180.0 );
+                end.x = int( p.x + ( (double)range - fdist * 2.0) * cos(rad + orad) );
+                end.y = int( p.y + ( (double)range - fdist * 2.0) * sin(rad + orad) );
+                apply_light_ray( lit, lm, p, end, luminance );
+
+                end.x = int( p.x + ( (double)range - fdist * 2.0) * cos(rad - orad) );
+                end.y = int( p.y + ( (double)range - fdist * 2.0) * sin(rad - orad) );
+                apply_light_ray( lit, lm, p, end, luminance );
+            } else {
+                calc_ray_end( nangle + ao, range, p, end );
+                apply_light_ray( lit, lm, p, end, luminance );
+                calc_ray_end( nangle - ao, range, p, end );
+                apply_light_ray( lit, lm, p, end, luminance );
+            }
+        }
+        return;
+    }
 
     if( inbounds( p ) ) {
         lm[x][y] = std::max(lm[x][y], static_cast<float>(LL_LOW));
@@ -692,126 +1070,29 @@ void map::apply_light_source( const tripoint &p, float luminance )
         return;
     }
 
-    /* If we're a 5 luminance fire , we skip casting rays into ey && sx if we have
-         neighboring fires to the north and west that were applied via light_source_buffer
-       If there's a 1 luminance candle east in buffer, we still cast rays into ex since it's smaller
-       If there's a 100 luminance magnesium flare south added via apply_light_source instead od
-         add_light_source, it's unbuffered so we'll still cast rays into sy.
-
-          ey
-        nnnNnnn
-        w     e
-        w  5 +e
-     sx W 5*1+E ex
-        w ++++e
-        w+++++e
-        sssSsss
-           sy
-    */
-    const int peer_inbounds = LIGHTMAP_CACHE_X - 1;
-    bool north = (y != 0 && light_source_buffer[x][y - 1] < luminance );
-    bool south = (y != peer_inbounds && light_source_buffer[x][y + 1] < luminance );
-    bool east = (x != peer_inbounds && light_source_buffer[x + 1][y] < luminance );
-    bool west = (x != 0 && light_source_buffer[x - 1][y] < luminance );
-
-    if( north ) {
+    // The directions were chosen in generate_lightmap, based on the neighbouring bulk light sources.
+    if( source.directions & light_source::NORTH ) {
         castLight<1, 0, 0, -1, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
         castLight<-1, 0, 0, -1, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
     }
 
-    if( east ) {
+    if( source.directions & light_source::EAST ) {
         castLight<0, -1, 1, 0, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
         castLight<0, -1, -1, 0, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
     }
 
 
-    if( south ) {
+    if( source.directions & light_source::SOUTH ) {
         castLight<1, 0, 0, 1, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
         castLight<-1, 0, 0, 1, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
     }
 
-    if( west ) {
+    if( source.directions & light_source::WEST ) {
         castLight<0, 1, 1, 0, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
         castLight<0, 1, -1, 0, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
     }
 }
 
-void map::apply_directional_light( const tripoint &p, int direction, float luminance )
-{
-    const int x = p.x;
-    const int y = p.y;
-
-    auto &cache = get_cache( p.z );
-    float (&lm)[MAPSIZE*SEEX][MAPSIZE*SEEY] = cache.lm;
-    float (&transparency_cache)[MAPSIZE*SEEX][MAPSIZE*SEEY] = cache.transparency_cache;
-
-    if( direction == 90 ) {
-        castLight<1, 0, 0, -1, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
-        castLight<-1, 0, 0, -1, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
-    } else if( direction == 0 ) {
-        castLight<0, -1, 1, 0, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
-        castLight<0, -1, -1, 0, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
-    } else if( direction == 270 ) {
-        castLight<1, 0, 0, 1, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
-        castLight<-1, 0, 0, 1, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
-    } else if( direction == 180 ) {
-        castLight<0, 1, 1, 0, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
-        castLight<0, 1, -1, 0, light_calc, light_check>( lm, transparency_cache, x, y, 0, luminance );
-    }
-}
-
-void map::apply_light_arc( const tripoint &p, int angle, float luminance, int wideangle )
-{
-    if (luminance <= LIGHT_SOURCE_LOCAL) {
-        return;
-    }
-
-    bool lit[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y] {};
-
-    apply_light_source( p, LIGHT_SOURCE_LOCAL );
-
-    // Normalise (should work with negative values too)
-    const double wangle = wideangle / 2.0;
-
-    int nangle = angle % 360;
-
-    tripoint end;
-    double rad = PI * (double)nangle / 180;
-    int range = LIGHT_RANGE(luminance);
-    calc_ray_end( nangle, range, p, end );
-    apply_light_ray(lit, p, end , luminance);
-
-    tripoint test;
-    calc_ray_end(wangle + nangle, range, p, test );
-
-    const float wdist = hypot( end.x - test.x, end.y - test.y );
-    if (wdist <= 0.5) {
-        return;
-    }
-
-    // attempt to determine beam density required to cover all squares
-    const double wstep = ( wangle / ( wdist * SQRT_2 ) );
-
-    for( double ao = wstep; ao <= wangle; ao += wstep ) {
-        if( trigdist ) {
-            double fdist = (ao * HALFPI) / wangle;
-            double orad = ( PI * ao / 180.0 );
-            end.x = int( p.x + ( (double)range - fdist * 2.0) * cos(rad + orad) );
-            end.y = int( p.y + ( (double)range - fdist * 2.0) * sin(rad + orad) );
-            apply_light_ray( lit, p, end, luminance );
-
-            end.x = int( p.x + ( (double)range - fdist * 2.0) * cos(rad - orad) );
-            end.y = int( p.y + ( (double)range - fdist * 2.0) * sin(rad - orad) );
-            apply_light_ray( lit, p, end, luminance );
-        } else {
-            calc_ray_end( nangle + ao, range, p, end );
-            apply_light_ray( lit, p, end, luminance );
-            calc_ray_end( nangle - ao, range, p, end );
-            apply_light_ray( lit, p, end, luminance );
-        }
-    }
-}
-
 void map::calc_ray_end(int angle, int range, const tripoint &p, tripoint &out ) const
 {
     double rad = (PI * angle) / 180;
@@ -837,6 +1118,7 @@ void map::calc_ray_end(int angle, int range, const tripoint &p, tripoint &out )
 }
 
 void map::apply_light_ray(bool lit[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y],
+                          float (&lm)[MAPSIZE*SEEX][MAPSIZE*SEEY],
                           const tripoint &s, const tripoint &e, float luminance)
 {
     int ax = abs(e.x - s.x) * 2;
@@ -851,8 +1133,7 @@ void map::apply_light_ray(bool lit[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y],
         return;
     }
 
-    auto &lm = get_cache( s.z ).lm;
-    auto &transparency_cache = get_cache( s.z ).transparency_cache;
+    const auto &transparency_cache = get_cache_ref( s.z ).transparency_cache;
 
     float distance = 1.0;
     float transparency = LIGHT_TRANSPARENCY_OPEN_AIR;
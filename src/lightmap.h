@@ -1,6 +1,9 @@
 #ifndef LIGHTMAP_H
 #define LIGHTMAP_H
 
+#include "enums.h"
+#include "game_constants.h"
+
 #define LIGHT_SOURCE_LOCAL  0.1f
 #define LIGHT_SOURCE_BRIGHT 10
 
@@ -32,4 +35,62 @@ enum lit_level {
     LL_BLANK // blank space, not an actual light level
 };
 
+/**
+ * A single light source as applied by map::generate_lightmap.
+ *
+ * The sources of one lightmap are kept around, so the next one only needs to recompute the
+ * area lit by the sources that were added, removed or changed in between.
+ */
+struct light_source {
+    enum source_type : int {
+        /** Circular light, rays are only cast in the cardinal @ref directions that are set. */
+        POINT,
+        /** A cone of light, @ref width degrees wide, pointing at @ref angle. */
+        ARC,
+        /** Light falling in through an opening, cast toward @ref angle (a multiple of 90). */
+        DIRECTIONAL
+    };
+    enum : int {
+        NORTH = 1,
+        EAST = 2,
+        SOUTH = 4,
+        WEST = 8
+    };
+
+    source_type type;
+    tripoint p;
+    float luminance;
+    int angle;
+    int width;
+    int directions;
+
+    static light_source point( const tripoint &p, float luminance );
+    static light_source arc( const tripoint &p, int angle, float luminance, int width );
+    static light_source directional( const tripoint &p, int angle, float luminance );
+
+    /** No tile farther away than this (in either axis) can receive any light from the source. */
+    int radius() const;
+
+    bool operator==( const light_source &rhs ) const;
+    bool operator!=( const light_source &rhs ) const {
+        return !( *this == rhs );
+    }
+    bool operator<( const light_source &rhs ) const;
+};
+
+/**
+ * Private output of one worker when light sources are cast in parallel, merged into the
+ * lightmap afterwards. See map::cast_lights.
+ */
+struct lightmap_buffer {
+    float lm[MAPSIZE * SEEX][MAPSIZE * SEEY];
+    float sm[MAPSIZE * SEEX][MAPSIZE * SEEY];
+    // Bounding box of everything written since the last merge (inclusive), empty if min > max.
+    // Outside of it, both arrays are 0.
+    int minx;
+    int miny;
+    int maxx;
+    int maxy;
+};
+
 #endif
@@ -14,6 +14,7 @@
 #include "path_info.h"
 #include "mapsharing.h"
 #include "output.h"
+#include "init.h"
 
 #include <cstring>
 #include <ctime>
@@ -28,6 +29,8 @@ void exit_handler(int s);
 
 namespace {
 
+bool print_loading_times = false;
+
 struct arg_handler {
   //! Handler function to be invoked when this argument is encountered. The handler will be
   //! called with the number of parameters after the flag was encountered, along with the array
@@ -110,6 +113,15 @@ int main(int argc, char *argv[])
                     return 0;
                 }
             },
+            {
+                "--loading-times", nullptr,
+                "Prints how long loading the game data took when the game exits",
+                section_default,
+                [](int, const char **) -> int {
+                    print_loading_times = true;
+                    return 0;
+                }
+            },
             {
                 "--basepath", "<path>",
                 "Base path for all game data subdirectories",
@@ -516,6 +528,11 @@ void exit_handler(int s)
 
         endwin();
 
+        if( print_loading_times ) {
+            printf( "Loading times: %s\n",
+                    DynamicDataLoader::get_instance().loading_times.to_string().c_str() );
+        }
+
         exit( exit_status );
     }
 }
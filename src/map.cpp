@@ -7,6 +7,7 @@
 #include "options.h"
 #include "item_factory.h"
 #include "mapbuffer.h"
+#include "vehicle_scheduler.h"
 #include "translations.h"
 #include "sounds.h"
 #include "debug.h"
@@ -24,10 +25,12 @@
 #include "omdata.h"
 #include "submap.h"
 #include "map_iterator.h"
+#include "pathfinding.h"
 #include "mapdata.h"
 #include "mtype.h"
 #include "weather.h"
 #include "item_group.h"
+#include "scent_map.h"
 
 #include <cmath>
 #include <stdlib.h>
@@ -152,6 +155,7 @@ map::map( int mapsize, bool zlev )
     for( auto &ptr : caches ) {
         ptr = std::unique_ptr<level_cache>( new level_cache() );
     }
+    vehicle_schedule = std::unique_ptr<vehicle_scheduler>( new vehicle_scheduler() );
 
     dbg(D_INFO) << "map::map(): my_MAPSIZE: " << my_MAPSIZE << " zlevels enabled:" << zlevels;
     traplocs.resize( trap::count() );
@@ -161,6 +165,8 @@ map::~map()
 {
 }
 
+map &map::operator=( map && ) = default;
+
 static submap null_submap;
 
 const maptile map::maptile_at( const tripoint &p ) const
@@ -244,6 +250,7 @@ void map::add_vehicle_to_cache( vehicle *veh )
         if( inbounds( p.x, p.y ) ) {
             ch.veh_exists_at[p.x][p.y] = true;
         }
+        set_pathfinding_cache_dirty( p );
     }
 }
 
@@ -264,6 +271,7 @@ void map::update_vehicle_cache( vehicle *veh, const int old_zlevel )
             if( inbounds( p.x, p.y ) ) {
                 ch.veh_exists_at[p.x][p.y] = false;
             }
+            set_pathfinding_cache_dirty( p );
             ch.veh_cached_parts.erase( it++ );
             // If something was resting on veh, drop it
             support_dirty( tripoint( p.x, p.y, old_zlevel + 1 ) );
@@ -284,6 +292,7 @@ void map::clear_vehicle_cache( const int zlev )
         if( inbounds( p ) ) {
             ch.veh_exists_at[p.x][p.y] = false;
         }
+        set_pathfinding_cache_dirty( p );
         ch.veh_cached_parts.erase( part );
     }
 }
@@ -292,10 +301,12 @@ void map::clear_vehicle_list( const int zlev )
 {
     auto &ch = get_cache( zlev );
     ch.vehicle_list.clear();
+    vehicle_schedule->invalidate();
 }
 
 void map::update_vehicle_list( submap *const to, const int zlev )
 {
+    vehicle_schedule->invalidate();
     // Update vehicle data
     auto &ch = get_cache( zlev );
     for( auto & elem : to->vehicles ) {
@@ -322,9 +333,11 @@ void map::destroy_vehicle (vehicle *veh)
     for (size_t i = 0; i < current_submap->vehicles.size(); i++) {
         if (current_submap->vehicles[i] == veh) {
             const int zlev = veh->smz;
+            vehicle_schedule->invalidate();
             ch.vehicle_list.erase(veh);
             reset_vehicle_cache( zlev );
             current_submap->vehicles.erase (current_submap->vehicles.begin() + i);
+            current_submap->set_modified();
             if( veh->tracking_on ) {
                 overmap_buffer.remove_vehicle( veh );
             }
@@ -340,17 +353,24 @@ void map::on_vehicle_moved( const int smz ) {
     set_transparency_cache_dirty( smz );
 }
 
+void map::schedule_vehicles()
+{
+    std::vector<vehicle *> vehs;
+    for( auto &vehs_v : get_vehicles() ) {
+        vehs.push_back( vehs_v.v );
+    }
+    vehicle_schedule->start( vehs );
+}
+
 void map::vehmove()
 {
     // give vehicles movement points
-    {
-        VehicleList vehs = get_vehicles();
-        for( auto &vehs_v : vehs ) {
-            vehicle *veh = vehs_v.v;
-            veh->gain_moves();
-            veh->slow_leak();
-        }
+    schedule_vehicles();
+    for( vehicle *veh : vehicle_schedule->get_vehicles() ) {
+        veh->gain_moves();
+        veh->slow_leak();
     }
+    vehicle_schedule->restart();
 
     // 15 equals 3 >50mph vehicles, or up to 15 slow (1 square move) ones
     // But 15 is too low for V12 deathbikes, let's put 100 here
@@ -364,33 +384,20 @@ void map::vehmove()
         ( elem )->part_removal_cleanup();
     }
     dirty_vehicle_list.clear();
+    // The vehicles may be gone by the next turn.
+    vehicle_schedule->invalidate();
 }
 
 bool map::vehproceed()
 {
-    VehicleList vehs = get_vehicles();
-    vehicle* cur_veh = nullptr;
-    float max_of_turn = 0;
-    tripoint pt;
-    // First horizontal movement
-    for( auto &vehs_v : vehs ) {
-        if( vehs_v.v->of_turn > max_of_turn ) {
-            cur_veh = vehs_v.v;
-            pt = tripoint( vehs_v.x, vehs_v.y, vehs_v.z );
-            max_of_turn = cur_veh->of_turn;
-        }
+    if( !vehicle_schedule->is_valid() ) {
+        schedule_vehicles();
     }
-
+    // First horizontal movement
+    vehicle *cur_veh = vehicle_schedule->next();
     // Then vertical-only movement
     if( cur_veh == nullptr ) {
-        for( auto &vehs_v : vehs ) {
-            vehicle &cveh = *vehs_v.v;
-            if( cveh.falling ) {
-                cur_veh = vehs_v.v;
-                pt = tripoint( vehs_v.x, vehs_v.y, vehs_v.z );
-                break;
-            }
-        }
+        cur_veh = vehicle_schedule->next_falling();
     }
 
     if( cur_veh == nullptr ) {
@@ -398,6 +405,7 @@ bool map::vehproceed()
     }
 
     vehicle &veh = *cur_veh;
+    const tripoint pt = veh.global_pos3();
     if( !inbounds( pt ) ) {
         dbg( D_INFO ) << "stopping out-of-map vehicle. (x,y,z)=(" << pt.x << "," << pt.y << "," << pt.z << ")";
         veh.stop();
@@ -1008,6 +1016,8 @@ float map::vehicle_vehicle_collision( vehicle &veh, vehicle &veh2,
 
         veh.of_turn = avg_of_turn * .9;
         veh2.of_turn = avg_of_turn * 1.1;
+        vehicle_schedule->update( &veh );
+        vehicle_schedule->update( &veh2 );
 
         //Energy after collision
         float E_a = 0.5 * m1 * final1.norm() * final1.norm() +
@@ -1210,6 +1220,7 @@ void map::board_vehicle( const tripoint &pos, player *p )
         unboard_vehicle( pos );
     }
     veh->parts[seat_part].set_flag(vehicle_part::passenger_flag);
+    veh->invalidate_physics();
     veh->parts[seat_part].passenger_id = p->getID();
 
     p->setpos( pos );
@@ -1257,6 +1268,7 @@ void map::unboard_vehicle( const tripoint &p )
     passenger->driving_recoil = 0;
     passenger->controlling_vehicle = false;
     veh->parts[seat_part].remove_flag(vehicle_part::passenger_flag);
+    veh->invalidate_physics();
     veh->skidding = true;
 }
 
@@ -1338,6 +1350,7 @@ void map::displace_vehicle( tripoint &p, const tripoint &dp )
                 part_pos.x, part_pos.y, part_pos.z,
                 g->u.posx(), g->u.posy(), g->u.posz() );
             veh->parts[prt].remove_flag(vehicle_part::passenger_flag);
+            veh->invalidate_physics();
             continue;
         }
 
@@ -1347,6 +1360,7 @@ void map::displace_vehicle( tripoint &p, const tripoint &dp )
                 prt,
                 part_pos.x, part_pos.y, part_pos.z );
             veh->parts[prt].remove_flag(vehicle_part::passenger_flag);
+            veh->invalidate_physics();
             continue;
         }
 
@@ -1381,10 +1395,15 @@ void map::displace_vehicle( tripoint &p, const tripoint &dp )
     // Invalidate vehicle's point cache
     veh->occupied_cache_turn = -1;
     if( src_submap != dst_submap ) {
+        // Listed in the order of their submaps.
+        vehicle_schedule->invalidate();
         veh->set_submap_moved( int( p2.x / SEEX ), int( p2.y / SEEY ) );
         dst_submap->vehicles.push_back( veh );
         src_submap->vehicles.erase( src_submap->vehicles.begin() + our_i );
+        MAPBUFFER.note_vehicles( tripoint( abs_sub.x + p2.x / SEEX, abs_sub.y + p2.y / SEEY, p2.z ) );
         dst_submap->is_uniform = false;
+        src_submap->set_modified();
+        dst_submap->set_modified();
     }
 
     p = p2;
@@ -1580,17 +1599,18 @@ void map::furn_set( const tripoint &p, const furn_id new_furniture )
     }
 
     current_submap->set_furn( lx, ly, new_furniture );
+    set_pathfinding_cache_dirty( p );
 
     // Set the dirty flags
     const furn_t &old_t = old_id.obj();
     const furn_t &new_t = new_furniture.obj();
 
     if( old_t.transparent != new_t.transparent ) {
-        set_transparency_cache_dirty( p.z );
+        set_transparency_cache_dirty( p );
     }
 
     if( old_t.has_flag( TFLAG_INDOORS ) != new_t.has_flag( TFLAG_INDOORS ) ) {
-        set_outside_cache_dirty( p.z );
+        set_outside_cache_dirty( p );
     }
 
     // Make sure the furniture falls if it needs to
@@ -1772,6 +1792,7 @@ void map::ter_set( const tripoint &p, const ter_id new_terrain )
     }
 
     current_submap->set_ter( lx, ly, new_terrain );
+    set_pathfinding_cache_dirty( p );
 
     // Set the dirty flags
     const ter_t &old_t = old_id.obj();
@@ -1790,11 +1811,11 @@ void map::ter_set( const tripoint &p, const ter_id new_terrain )
     }
 
     if( old_t.transparent != new_t.transparent ) {
-        set_transparency_cache_dirty( p.z );
+        set_transparency_cache_dirty( p );
     }
 
     if( old_t.has_flag( TFLAG_INDOORS ) != new_t.has_flag( TFLAG_INDOORS ) ) {
-        set_outside_cache_dirty( p.z );
+        set_outside_cache_dirty( p );
     }
 
     if( new_t.has_flag( TFLAG_NO_FLOOR ) && !old_t.has_flag( TFLAG_NO_FLOOR ) ) {
@@ -2858,15 +2879,8 @@ bool map::moppable_items_at( const tripoint &p )
 void map::decay_fields_and_scent( const int amount )
 {
     // Decay scent separately, so that later we can use field count to skip empty submaps
-    tripoint tmp;
-    tmp.z = abs_sub.z; // TODO: Make this happen on all z-levels
-    for( tmp.x = 0; tmp.x < my_MAPSIZE * SEEX; tmp.x++ ) {
-        for( tmp.y = 0; tmp.y < my_MAPSIZE * SEEY; tmp.y++ ) {
-            if( g->scent( tmp ) > 0 ) {
-                g->scent( tmp )--;
-            }
-        }
-    }
+    // TODO: Make this happen on all z-levels
+    g->scent.decay();
 
     const int amount_fire = amount / 3; // Decay fire by this much
     const int amount_liquid = amount / 2; // Decay washable fields (blood, guts etc.) by this
@@ -2889,6 +2903,7 @@ void map::decay_fields_and_scent( const int amount )
                 // This submap has no fields
                 continue;
             }
+            cur_submap->set_modified();
 
             for( int sx = 0; sx < SEEX; ++sx ) {
                 if( to_proc < 1 ) {
@@ -4240,7 +4255,9 @@ int& map::temperature( const tripoint &p )
         return null_temperature;
     }
 
-    return get_submap_at( p )->temperature;
+    submap *const current_submap = get_submap_at( p );
+    current_submap->set_modified();
+    return current_submap->temperature;
 }
 
 void map::set_temperature( const tripoint &p, int new_temperature )
@@ -4266,6 +4283,8 @@ map_stack map::i_at( const int x, const int y )
 
     int lx, ly;
     submap *const current_submap = get_submap_at( x, y, lx, ly );
+    // The items can be changed through the stack.
+    current_submap->set_modified();
 
     return map_stack{ &current_submap->itm[lx][ly], tripoint( x, y, abs_sub.z ), this };
 }
@@ -4349,6 +4368,8 @@ map_stack map::i_at( const tripoint &p )
 
     int lx, ly;
     submap *const current_submap = get_submap_at( p, lx, ly );
+    // The items can be changed through the stack.
+    current_submap->set_modified();
 
     return map_stack{ &current_submap->itm[lx][ly], p, this };
 }
@@ -4412,6 +4433,7 @@ void map::i_clear(const tripoint &p)
 
     current_submap->lum[lx][ly] = 0;
     current_submap->itm[lx][ly].clear();
+    current_submap->set_modified();
 }
 
 item &map::spawn_an_item(const tripoint &p, item new_item,
@@ -4827,6 +4849,8 @@ void map::process_items_in_vehicle( vehicle *const cur_veh, submap *const curren
         } else if( !cur_veh->active_items.has( active_item ) ) {
             continue;
         }
+        // It may turn into an item of a different weight.
+        cur_veh->invalidate_physics();
 
         auto const it = std::find_if(begin(cargo_parts), end(cargo_parts), [&](int const part) {
             return active_item.location == cur_veh->parts[static_cast<size_t>(part)].mount;
@@ -5397,6 +5421,7 @@ field &map::field_at( const tripoint &p )
 
     int lx, ly;
     submap *const current_submap = get_submap_at( p, lx, ly );
+    current_submap->set_modified();
 
     return current_submap->fld[lx][ly];
 }
@@ -5466,7 +5491,11 @@ field_entry *map::get_field( const tripoint &p, const field_id t ) {
     int lx, ly;
     submap *const current_submap = get_submap_at( p, lx, ly );
 
-    return current_submap->fld[lx][ly].findField( t );
+    field_entry *const result = current_submap->fld[lx][ly].findField( t );
+    if( result != nullptr ) {
+        current_submap->set_modified();
+    }
+    return result;
 }
 
 bool map::add_field(const tripoint &p, const field_id t, int density, const int age)
@@ -5490,7 +5519,9 @@ bool map::add_field(const tripoint &p, const field_id t, int density, const int
     if( current_submap->fld[lx][ly].addField( t, density, age ) ) {
         //Only adding it to the count if it doesn't exist.
         current_submap->field_count++;
+        current_submap->note_field( lx, ly );
     }
+    current_submap->set_modified();
 
     if( g != nullptr && this == &g->m && p == g->u.pos3() ) {
         creature_in_field( g->u ); //Hit the player with the field if it spawned on top of them.
@@ -5498,7 +5529,7 @@ bool map::add_field(const tripoint &p, const field_id t, int density, const int
 
     // Dirty the transparency cache now that field processing doesn't always do it
     // TODO: Make it skip transparent fields
-    set_transparency_cache_dirty( p.z );
+    set_transparency_cache_dirty( p );
     return true;
 }
 
@@ -5514,10 +5545,14 @@ void map::remove_field( const tripoint &p, const field_id field_to_remove )
     if( current_submap->fld[lx][ly].removeField( field_to_remove ) ) {
         // Only adjust the count if the field actually existed.
         current_submap->field_count--;
+        if( current_submap->fld[lx][ly].fieldCount() == 0 ) {
+            current_submap->field_squares.reset( lx * SEEY + ly );
+        }
+        current_submap->set_modified();
         const auto &fdata = fieldlist[ field_to_remove ];
         for( int i = 0; i < 3; ++i ) {
             if( !fdata.transparent[i] ) {
-                set_transparency_cache_dirty( p.z );
+                set_transparency_cache_dirty( p );
                 break;
             }
         }
@@ -5536,6 +5571,7 @@ computer* map::computer_at( const tripoint &p )
         return nullptr;
     }
 
+    current_submap->set_modified();
     return &(current_submap->comp);
 }
 
@@ -5561,6 +5597,7 @@ basecamp* map::camp_at( const tripoint &p, const int radius)
             submap * const current_submap = get_submap_at( p );
             if( current_submap->camp.is_valid() ) {
                 // we only allow on camp per size radius, kinda
+                current_submap->set_modified();
                 return &(current_submap->camp);
             }
         }
@@ -5576,7 +5613,9 @@ void map::add_camp( const tripoint &p, const std::string& name )
         return;
     }
 
-    get_submap_at( p )->camp = basecamp( name, p.x, p.y );
+    submap *const current_submap = get_submap_at( p );
+    current_submap->camp = basecamp( name, p.x, p.y );
+    current_submap->set_modified();
 }
 
 void map::debug()
@@ -6290,6 +6329,12 @@ void map::load(const int wx, const int wy, const int wz, const bool update_vehic
     for( auto & traps : traplocs ) {
         traps.clear();
     }
+    if( portal_graph_cache != nullptr ) {
+        portal_graph_cache->set_all_dirty();
+    }
+    for( auto &field : flow_fields ) {
+        field->dirty = true;
+    }
     set_abs_sub( wx, wy, wz );
     for (int gridx = 0; gridx < my_MAPSIZE; gridx++) {
         for (int gridy = 0; gridy < my_MAPSIZE; gridy++) {
@@ -6318,6 +6363,29 @@ void map::shift_traps( const tripoint &shift )
     }
 }
 
+void map::prefetch( const int sx, const int sy, const int distance )
+{
+    const int zmin = zlevels ? -OVERMAP_DEPTH : abs_sub.z;
+    const int zmax = zlevels ? OVERMAP_HEIGHT : abs_sub.z;
+    std::vector<tripoint> upcoming;
+    for( int n = 1; n <= distance; n++ ) {
+        for( int gridx = 0; gridx < my_MAPSIZE; gridx++ ) {
+            for( int gridy = 0; gridy < my_MAPSIZE; gridy++ ) {
+                const int x = gridx + sx * n;
+                const int y = gridy + sy * n;
+                if( x >= 0 && x < my_MAPSIZE && y >= 0 && y < my_MAPSIZE ) {
+                    // Already loaded.
+                    continue;
+                }
+                for( int z = zmin; z <= zmax; z++ ) {
+                    upcoming.push_back( tripoint( abs_sub.x + x, abs_sub.y + y, z ) );
+                }
+            }
+        }
+    }
+    MAPBUFFER.prefetch( upcoming );
+}
+
 void map::shift( const int sx, const int sy )
 {
 // Special case of 0-shift; refresh the map
@@ -6338,6 +6406,13 @@ void map::shift( const int sx, const int sy )
 
     shift_traps( tripoint( sx, sy, 0 ) );
 
+    if( portal_graph_cache != nullptr ) {
+        portal_graph_cache->shift( sx, sy );
+    }
+    for( auto &field : flow_fields ) {
+        field->dirty = true;
+    }
+
     vehicle *remoteveh = g->remoteveh();
 
     const int zmin = zlevels ? -OVERMAP_DEPTH : wz;
@@ -6352,6 +6427,7 @@ void map::shift( const int sx, const int sy )
 // Shift the map sx submaps to the right and sy submaps down.
 // sx and sy should never be bigger than +/-1.
 // absx and absy are our position in the world, for saving/loading purposes.
+    vehicle_schedule->invalidate();
     for( int gridz = zmin; gridz <= zmax; gridz++ ) {
         // Clear vehicle list and rebuild after shift
         clear_vehicle_cache( gridz );
@@ -6588,6 +6664,7 @@ void map::loadn( const int gridx, const int gridy, const int gridz, const bool u
     }
 
     // Update vehicle data
+    vehicle_schedule->invalidate();
     if( update_vehicles ) {
         auto &map_cache = get_cache( gridz );
         for( auto it : tmpsub->vehicles ) {
@@ -6942,7 +7019,10 @@ void map::spawn_monsters_submap( const tripoint &gp, bool ignore_sight )
             }
         }
     }
-    current_submap->spawns.clear();
+    if( !current_submap->spawns.empty() ) {
+        current_submap->spawns.clear();
+        current_submap->set_modified();
+    }
     overmap_buffer.spawn_monster( abs_sub.x + gp.x, abs_sub.y + gp.y, gp.z );
 }
 
@@ -6966,7 +7046,10 @@ void map::spawn_monsters(bool ignore_sight)
 void map::clear_spawns()
 {
     for( auto & smap : grid ) {
-        smap->spawns.clear();
+        if( !smap->spawns.empty() ) {
+            smap->spawns.clear();
+            smap->set_modified();
+        }
     }
 }
 
@@ -7091,60 +7174,88 @@ long map::determine_wall_corner( const tripoint &p ) const
     }
 }
 
+void map::set_transparency_cache_dirty( const tripoint &p )
+{
+    if( inbounds( p ) ) {
+        get_cache( p.z ).transparency_cache_dirty.set( p.x / SEEX * MAPSIZE + p.y / SEEY );
+    }
+}
+
+void map::set_outside_cache_dirty( const tripoint &p )
+{
+    if( !inbounds( p ) ) {
+        return;
+    }
+    auto &outside_cache_dirty = get_cache( p.z ).outside_cache_dirty;
+    const int mapsize = my_MAPSIZE * SEEX;
+    for( int x = std::max( p.x - 1, 0 ); x <= std::min( p.x + 1, mapsize - 1 ); x++ ) {
+        for( int y = std::max( p.y - 1, 0 ); y <= std::min( p.y + 1, mapsize - 1 ); y++ ) {
+            outside_cache_dirty.set( x / SEEX * MAPSIZE + y / SEEY );
+        }
+    }
+}
+
 void map::build_outside_cache( const int zlev )
 {
     auto &ch = get_cache( zlev );
-    if( !ch.outside_cache_dirty ) {
-        return;
+    auto &stats = ch.rebuild_stats;
+    if( stats.turn != calendar::turn ) {
+        stats = cache_rebuild_stats();
+        stats.turn = calendar::turn;
     }
 
-    // Make a bigger cache to avoid bounds checking
-    // We will later copy it to our regular cache
-    const size_t padded_w = ( MAPSIZE * SEEX ) + 2;
-    const size_t padded_h = ( MAPSIZE * SEEY ) + 2;
-    bool padded_cache[padded_w][padded_h];
+    auto &dirty = ch.outside_cache_dirty;
+    if( dirty.none() ) {
+        return;
+    }
 
     auto &outside_cache = ch.outside_cache;
     if( zlev < 0 )
     {
         std::uninitialized_fill_n(
             &outside_cache[0][0], ( MAPSIZE * SEEX ) * ( MAPSIZE * SEEY ), false );
+        dirty.reset();
         return;
     }
 
-    std::uninitialized_fill_n(
-            &padded_cache[0][0], padded_w * padded_h, true );
-
+    const int mapsize = my_MAPSIZE * SEEX;
     for( int smx = 0; smx < my_MAPSIZE; ++smx ) {
         for( int smy = 0; smy < my_MAPSIZE; ++smy ) {
-            auto const cur_submap = get_submap_at_grid( smx, smy, zlev );
-
-            for( int sx = 0; sx < SEEX; ++sx ) {
-                for( int sy = 0; sy < SEEY; ++sy ) {
+            if( !dirty[smx * MAPSIZE + smy] ) {
+                continue;
+            }
+            stats.outside_submaps++;
+
+            const int minx = smx * SEEX;
+            const int miny = smy * SEEY;
+            const int maxx = minx + SEEX - 1;
+            const int maxy = miny + SEEY - 1;
+            for( int x = minx; x <= maxx; x++ ) {
+                std::fill( &outside_cache[x][miny], &outside_cache[x][maxy] + 1, true );
+            }
+            // Indoor tiles make their neighbours indoors too, so the border of the
+            // adjacent submaps has to be looked at as well.
+            for( int x = std::max( minx - 1, 0 ); x <= std::min( maxx + 1, mapsize - 1 ); x++ ) {
+                for( int y = std::max( miny - 1, 0 ); y <= std::min( maxy + 1, mapsize - 1 ); y++ ) {
+                    auto const cur_submap = get_submap_at_grid( x / SEEX, y / SEEY, zlev );
+                    const int sx = x % SEEX;
+                    const int sy = y % SEEY;
                     if( cur_submap->get_ter( sx, sy ).obj().has_flag( TFLAG_INDOORS ) ||
                         cur_submap->get_furn( sx, sy ).obj().has_flag( TFLAG_INDOORS ) ) {
-                        const int x = sx + ( smx * SEEX );
-                        const int y = sy + ( smy * SEEY );
-                        // Add 1 to both coords, because we're operating on the padded cache
-                        for( int dx = 0; dx <= 2; dx++ )
-                        {
-                            for( int dy = 0; dy <= 2; dy++ )
-                            {
-                                padded_cache[x + dx][y + dy] = false;
+                        for( int dx = std::max( x - 1, minx ); dx <= std::min( x + 1, maxx ); dx++ ) {
+                            for( int dy = std::max( y - 1, miny ); dy <= std::min( y + 1, maxy ); dy++ ) {
+                                outside_cache[dx][dy] = false;
                             }
                         }
                     }
                 }
             }
+            // The transparency of outdoor tiles depends on the weather.
+            ch.transparency_cache_dirty.set( smx * MAPSIZE + smy );
         }
     }
 
-    // Copy the padded cache back to the proper one, but with no padding
-    for( int x = 0; x < my_MAPSIZE * SEEX; x++ ) {
-        std::copy_n( &padded_cache[x + 1][1], my_MAPSIZE * SEEX, &outside_cache[x][0] );
-    }
-
-    ch.outside_cache_dirty = false;
+    dirty.reset();
 }
 
 void map::build_map_cache( const int zlev, bool skip_lightmap )
@@ -7437,6 +7548,7 @@ void map::draw_fill_background(ter_id type) {
         for( int gridy = 0; gridy < my_MAPSIZE; gridy++ ) {
             auto sm = get_submap_at_grid( gridx, gridy );
             sm->is_uniform = true;
+            sm->set_modified();
             std::uninitialized_fill_n( &sm->ter[0][0], block_size, type );
         }
     }
@@ -7730,10 +7842,15 @@ const level_cache &map::access_cache( int zlev ) const
 
 level_cache::level_cache()
 {
-    transparency_cache_dirty = true;
-    outside_cache_dirty = true;
+    transparency_cache_dirty.set();
+    outside_cache_dirty.set();
+    lightmap_dirty = true;
     veh_in_active_range = false;
     std::fill_n( &veh_exists_at[0][0], SEEX * MAPSIZE * SEEY * MAPSIZE, false );
+    // Caches are only ever rebuilt for the part of it a map uses (see tinymap)
+    std::fill_n( &outside_cache[0][0], SEEX * MAPSIZE * SEEY * MAPSIZE, false );
+    std::fill_n( &transparency_cache[0][0], SEEX * MAPSIZE * SEEY * MAPSIZE,
+                 static_cast<float>( LIGHT_TRANSPARENCY_OPEN_AIR ) );
 }
 
 void map::clip_to_bounds( tripoint &p ) const
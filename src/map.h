@@ -1,6 +1,7 @@
 #ifndef MAP_H
 #define MAP_H
 
+#include <bitset>
 #include <vector>
 #include <string>
 #include <set>
@@ -69,6 +70,11 @@ using vgroup_id = string_id<VehicleGroup>;
 struct MonsterGroup;
 using mongroup_id = string_id<MonsterGroup>;
 class map;
+class pathfinder;
+class portal_graph;
+struct path_cluster;
+class flow_field;
+class vehicle_scheduler;
 enum ter_bitflags : int;
 template<typename T>
 struct id_or_id;
@@ -137,18 +143,37 @@ enum visibility_type {
   VIS_BOOMER_DARK
 };
 
+/** How many submaps the caches of a z-level had to be rebuilt for, during one turn. */
+struct cache_rebuild_stats {
+    int turn = -1;
+    int transparency_submaps = 0;
+    int outside_submaps = 0;
+};
+
 struct level_cache {
     level_cache(); // Zeroes all relevant values
     level_cache( const level_cache &other ) = default;
 
-    bool transparency_cache_dirty;
-    bool outside_cache_dirty;
+    // One bit per submap of the grid (indexed gridx * MAPSIZE + gridy), set if that part
+    // of the cache has to be rebuilt.
+    std::bitset<MAPSIZE * MAPSIZE> transparency_cache_dirty;
+    std::bitset<MAPSIZE * MAPSIZE> outside_cache_dirty;
+    // Of the turn the caches were last built on.
+    cache_rebuild_stats rebuild_stats;
 
     float lm[MAPSIZE*SEEX][MAPSIZE*SEEY];
     float sm[MAPSIZE*SEEX][MAPSIZE*SEEY];
     // To prevent redundant ray casting into neighbors: precalculate bulk light source positions.
     // This is only valid for the duration of generate_lightmap
     float light_source_buffer[MAPSIZE*SEEX][MAPSIZE*SEEY];
+    // What lm and sm were last built from: the ambient light (before any light source was
+    // applied), the transparency and the sorted light sources. See generate_lightmap.
+    bool lightmap_dirty;
+    float lightmap_ambient[MAPSIZE*SEEX][MAPSIZE*SEEY];
+    float lightmap_transparency[MAPSIZE*SEEX][MAPSIZE*SEEY];
+    std::vector<light_source> light_sources;
+    // Light sources collected by the current generate_lightmap
+    std::vector<light_source> pending_light_sources;
     bool outside_cache[MAPSIZE*SEEX][MAPSIZE*SEEY];
     float transparency_cache[MAPSIZE*SEEX][MAPSIZE*SEEY];
     float seen_cache[MAPSIZE*SEEX][MAPSIZE*SEEY];
@@ -190,7 +215,7 @@ class map
  map( bool zlev ) : map( MAPSIZE, zlev ) { }
  ~map();
 
- map &operator=( map&& ) = default;
+ map &operator=( map&& );
 
 // Visual Output
  void debug();
@@ -206,9 +231,11 @@ class map
      */
     void set_transparency_cache_dirty( const int zlev ) {
         if( inbounds_z( zlev ) ) {
-            get_cache( zlev ).transparency_cache_dirty = true;
+            get_cache( zlev ).transparency_cache_dirty.set();
         }
     }
+    /** Like the above, but only for the submap containing the given point. */
+    void set_transparency_cache_dirty( const tripoint &p );
 
     /**
      * Sets a dirty flag on the outside cache.
@@ -219,9 +246,35 @@ class map
      */
     void set_outside_cache_dirty( const int zlev ) {
         if( inbounds_z( zlev ) ) {
-            get_cache( zlev ).outside_cache_dirty = true;
+            get_cache( zlev ).outside_cache_dirty.set();
         }
     }
+    /**
+     * Like the above, but only for the submaps around the given point. Indoor tiles make
+     * their neighbours indoors as well, so this can include the adjacent submaps.
+     */
+    void set_outside_cache_dirty( const tripoint &p );
+
+    /**
+     * Makes the next lightmap of the z-level a full rebuild.
+     *
+     * Normally only the area around light sources that changed is recomputed, changes of the
+     * ambient light or the transparency are noticed without this.
+     */
+    void set_lightmap_dirty( const int zlev ) {
+        if( inbounds_z( zlev ) ) {
+            get_cache( zlev ).lightmap_dirty = true;
+        }
+    }
+
+    /**
+     * Marks the pathfinding data of the submap containing the given tile as outdated.
+     *
+     * Must be called whenever the move cost of a tile may have changed,
+     * otherwise long routes may lead through stale portals and monsters may
+     * follow outdated flow fields.
+     */
+    void set_pathfinding_cache_dirty( const tripoint &p );
 
     /**
      * Callback invoked when a vehicle has moved.
@@ -298,6 +351,11 @@ class map
      * Note: the map must have been loaded before this can be called.
      */
     void shift( const int sx, const int sy );
+    /**
+     * Has the mapbuffer read the submaps ahead of time that the next shifts along (sx,sy)
+     * would load, up to distance shifts away.
+     */
+    void prefetch( const int sx, const int sy, const int distance );
     /**
      * Moves the map vertically to (not by!) newz.
      * Does not actually shift anything, only forces cache updates.
@@ -433,6 +491,17 @@ public:
  std::vector<tripoint> route( const tripoint &f, const tripoint &t,
                               const int bash, const int maxdist ) const;
 
+    /** Working storage of @ref route, created on first use and reused by every later call. */
+    pathfinder &get_pathfinder() const;
+    /** Submap-level graph used by @ref route for long distances, created on first use. */
+    portal_graph &get_portal_graph() const;
+    /**
+     * Returns the distances to the target from every tile of its z-level, see @ref flow_field.
+     * Fields are cached and only rebuilt when the target moved or the terrain changed,
+     * a field stays valid until the end of the turn it was requested on.
+     */
+    const flow_field &get_flow_field( const tripoint &target ) const;
+
  int coord_to_angle(const int x, const int y, const int tgtx, const int tgty) const;
 // Vehicles: Common to 2D and 3D
     VehicleList get_vehicles();
@@ -446,6 +515,8 @@ public:
     void destroy_vehicle (vehicle *veh);
     void vehmove();          // Vehicle movement
     bool vehproceed(); // Returns true if a vehicle moved, false otherwise
+    /** Lists the vehicles of the reality bubble for @ref vehproceed. */
+    void schedule_vehicles();
 
 // 3D vehicles
     VehicleList get_vehicles( const tripoint &start, const tripoint &end );
@@ -877,9 +948,23 @@ void add_corpse( const tripoint &p );
  void remove_trap( const tripoint &p );
  const std::vector<tripoint> &trap_locations(trap_id t) const;
 
- bool process_fields(); // See fields.cpp
+ /**
+  * Processes all fields of the map for one turn. See fields.cpp
+  * @param batch_gases Spread the gases that do nothing but spreading in one pass over the
+  * whole map (@ref process_gas_fields) instead of square by square. Only used without z-levels.
+  * @return Whether the transparency cache got dirty.
+  */
+ bool process_fields( bool batch_gases = true );
  bool process_fields_in_submap( submap * const current_submap,
-                                const int submap_x, const int submap_y, const int submap_z); // See fields.cpp
+                                const int submap_x, const int submap_y, const int submap_z,
+                                bool skip_batched_gases = false ); // See fields.cpp
+ /**
+  * Spreads and decays the gases on the z-level that do nothing else (like smoke and tear gas)
+  * for one turn, see fields.cpp. The densities and ages of each gas are copied into grids
+  * covering the map, updated from the copy of the previous turn and written back.
+  * @return Whether the transparency cache got dirty.
+  */
+ bool process_gas_fields( int z );
         /**
          * Apply field effects to the creature when it's on a square with fields.
          */
@@ -1249,6 +1334,21 @@ private:
          */
         void setsubmap( size_t grididx, submap *smap );
 
+    /** Plain A* search of @ref route, both points must be inbounds. */
+    std::vector<tripoint> route_local( const tripoint &f, const tripoint &t,
+                                       const int bash, const int maxdist ) const;
+    /**
+     * Searches the @ref portal_graph for a sequence of submap portals and then connects them
+     * with @ref route_local. Returns an empty route if that fails.
+     */
+    std::vector<tripoint> route_hierarchical( const tripoint &f, const tripoint &t,
+                                              const int bash, const int maxdist ) const;
+    /** Returns the pathfinding data of the submap at the grid position, rebuilding it if outdated. */
+    const path_cluster &get_path_cluster( const tripoint &gridp ) const;
+    /** Like @ref get_path_cluster, but only refreshes the move costs and leaves the portals alone. */
+    path_cluster &get_path_cluster_costs( const tripoint &gridp ) const;
+    void build_flow_field( flow_field &field ) const;
+
     /**
      * Internal versions of public functions to avoid checking same variables multiple times.
      * They lack safety checks, because their callers already do those.
@@ -1278,15 +1378,23 @@ private:
 
  long determine_wall_corner( const tripoint &p ) const;
  void cache_seen(const int fx, const int fy, const int tx, const int ty, const int max_range);
- // apply a circular light pattern immediately, however it's best to use...
+ // The following add light sources to the lightmap being generated, they are only cast at the
+ // end of generate_lightmap, and only if they changed since the last one.
+ // A circular light pattern, however it's best to use...
  void apply_light_source( const tripoint &p, float luminance);
- // ...this, which will apply the light after at the end of generate_lightmap, and prevent redundant
- // light rays from causing massive slowdowns, if there's a huge amount of light.
+ // ...this, which prevents redundant light rays from causing massive slowdowns, if there's
+ // a huge amount of light.
  void add_light_source( const tripoint &p, float luminance);
  // Handle just cardinal directions and 45 deg angles.
  void apply_directional_light( const tripoint &p, int direction, float luminance );
  void apply_light_arc( const tripoint &p, int angle, float luminance, int wideangle = 30 );
- void apply_light_ray(bool lit[MAPSIZE*SEEX][MAPSIZE*SEEY],
+ // Casts the given sources into the lightmap of zlev, on all worker threads if the
+ // PARALLEL_LIGHTMAP option is set.
+ void cast_lights( const std::vector<const light_source *> &sources, int zlev );
+ // Actually casts the light of a source into the given lightmap
+ void cast_light( const light_source &source, float (&lm)[MAPSIZE*SEEX][MAPSIZE*SEEY],
+                  float (&sm)[MAPSIZE*SEEX][MAPSIZE*SEEY] );
+ void apply_light_ray(bool lit[MAPSIZE*SEEX][MAPSIZE*SEEY], float (&lm)[MAPSIZE*SEEX][MAPSIZE*SEEY],
                       const tripoint &s, const tripoint &e, float luminance);
  void add_light_from_items( const tripoint &p, std::list<item>::iterator begin,
                             std::list<item>::iterator end );
@@ -1355,6 +1463,16 @@ private:
      * Holds caches for visibility, light, transparency and vehicles
      */
     std::array< std::unique_ptr<level_cache>, OVERMAP_LAYERS > caches;
+    mutable std::unique_ptr<pathfinder> pathfinder_arena;
+    mutable std::unique_ptr<portal_graph> portal_graph_cache;
+    mutable std::vector< std::unique_ptr<flow_field> > flow_fields;
+    // One per worker thread, allocated the first time lights are cast in parallel.
+    std::vector< std::unique_ptr<lightmap_buffer> > lightmap_buffers;
+    /**
+     * Order in which vehicles move during @ref vehmove, must be invalidated whenever
+     * vehicles are added to or removed from the map, or change their submap.
+     */
+    std::unique_ptr<vehicle_scheduler> vehicle_schedule;
 
     // Note: no bounds check
     level_cache &get_cache( const int zlev ) {
@@ -0,0 +1,427 @@
+#include "map_storage.h"
+#include "background_writer.h"
+#include "debug.h"
+#include "filesystem.h"
+#include "mapsharing.h"
+#include "overmapbuffer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#if !(defined _WIN32 || defined WINDOWS)
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace
+{
+
+/** A whole file in memory, mapped where the platform allows it, copied otherwise. */
+class mapped_file : public quad_data
+{
+    public:
+        mapped_file( const std::string &path ) {
+#if !(defined _WIN32 || defined WINDOWS)
+            const int fd = open( path.c_str(), O_RDONLY );
+            if( fd < 0 ) {
+                return;
+            }
+            struct stat info;
+            if( fstat( fd, &info ) == 0 && info.st_size > 0 ) {
+                void *mapped = mmap( nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+                if( mapped != MAP_FAILED ) {
+                    data_ = static_cast<const char *>( mapped );
+                    size_ = info.st_size;
+                    mapped_ = true;
+                }
+            }
+            close( fd );
+#else
+            std::ifstream fin( path.c_str(), std::ios::binary );
+            if( fin.is_open() ) {
+                copy.assign( std::istreambuf_iterator<char>( fin ), std::istreambuf_iterator<char>() );
+                data_ = copy.data();
+                size_ = copy.size();
+            }
+#endif
+        }
+        ~mapped_file() override {
+#if !(defined _WIN32 || defined WINDOWS)
+            if( mapped_ ) {
+                munmap( const_cast<char *>( data_ ), size_ );
+            }
+#endif
+        }
+        mapped_file( const mapped_file & ) = delete;
+        mapped_file &operator=( const mapped_file & ) = delete;
+
+        bool is_open() const {
+            return data_ != nullptr;
+        }
+        const char *data() const override {
+            return data_;
+        }
+        size_t size() const override {
+            return size_;
+        }
+
+    private:
+        const char *data_ = nullptr;
+        size_t size_ = 0;
+        bool mapped_ = false;
+        std::string copy;
+};
+
+class string_data : public quad_data
+{
+    public:
+        const char *data() const override {
+            return contents.data();
+        }
+        size_t size() const override {
+            return contents.size();
+        }
+
+        std::string contents;
+};
+
+// "CDPK" in the first four bytes of pack files, followed by the version.
+const uint32_t pack_magic = 0x4b504443;
+const uint32_t pack_version = 1;
+const size_t pack_header_size = 2 * sizeof( uint32_t );
+
+// Before every record: the quad as three int32, one byte each for binary and removed,
+// then the uint32 size of the data that follows. In the byte order of this machine.
+const size_t record_header_size = 3 * sizeof( int32_t ) + 2 + sizeof( uint32_t );
+
+void write_record_header( char *out, const tripoint &om_addr, bool binary, bool removed,
+                          uint32_t size )
+{
+    const int32_t coordinates[3] = { om_addr.x, om_addr.y, om_addr.z };
+    std::memcpy( out, coordinates, sizeof( coordinates ) );
+    out[12] = binary ? 1 : 0;
+    out[13] = removed ? 1 : 0;
+    std::memcpy( out + 14, &size, sizeof( size ) );
+}
+
+void read_record_header( const char *in, tripoint &om_addr, bool &binary, bool &removed,
+                         uint32_t &size )
+{
+    int32_t coordinates[3];
+    std::memcpy( coordinates, in, sizeof( coordinates ) );
+    om_addr = tripoint( coordinates[0], coordinates[1], coordinates[2] );
+    binary = in[12] != 0;
+    removed = in[13] != 0;
+    std::memcpy( &size, in + 14, sizeof( size ) );
+}
+
+// Compaction only pays off once a pack is mostly dead records.
+const uint64_t min_dead_bytes_to_compact = 64 * 1024;
+
+}
+
+file_map_storage::file_map_storage( const std::string &map_directory )
+    : map_directory( map_directory )
+{
+}
+
+std::string file_map_storage::segment_directory( const tripoint &om_addr ) const
+{
+    // We're breaking the quads into subdirectories so there aren't too many files per directory.
+    const tripoint segment_addr = overmapbuffer::omt_to_seg_copy( om_addr );
+    std::stringstream dirname;
+    dirname << map_directory << "/" << segment_addr.x << "." << segment_addr.y << "." <<
+            segment_addr.z;
+    return dirname.str();
+}
+
+std::string file_map_storage::quad_file_name( const tripoint &om_addr, const bool binary ) const
+{
+    std::stringstream quad_path;
+    quad_path << segment_directory( om_addr ) << "/" << om_addr.x << "." << om_addr.y << "." <<
+              om_addr.z << ( binary ? ".bmap" : ".map" );
+    return quad_path.str();
+}
+
+std::unique_ptr<quad_data> file_map_storage::read( const tripoint &om_addr, const bool binary )
+{
+    std::unique_ptr<mapped_file> file( new mapped_file( quad_file_name( om_addr, binary ) ) );
+    if( !file->is_open() ) {
+        return nullptr;
+    }
+    return std::unique_ptr<quad_data>( file.release() );
+}
+
+bool file_map_storage::write( const tripoint &om_addr, const bool binary, const std::string &data )
+{
+    // Don't create the directory if it would be empty
+    assure_dir_exist( segment_directory( om_addr ) );
+    return write_file_replacing( quad_file_name( om_addr, binary ), data );
+}
+
+void file_map_storage::remove( const tripoint &om_addr, const bool binary )
+{
+    const std::string filename = quad_file_name( om_addr, binary );
+    if( file_exist( filename ) ) {
+        remove_file( filename );
+    }
+}
+
+std::vector<std::pair<tripoint, bool>> file_map_storage::stored_quads()
+{
+    std::vector<std::pair<tripoint, bool>> result;
+    for( const bool binary : { false, true } ) {
+        for( const std::string &path : get_files_from_path( binary ? ".bmap" : ".map", map_directory,
+                true, true ) ) {
+            // The file name is the location of the quad.
+            const std::string name = path.substr( path.find_last_of( "/\\" ) + 1 );
+            tripoint om_addr;
+            if( sscanf( name.c_str(), "%d.%d.%d.", &om_addr.x, &om_addr.y, &om_addr.z ) == 3 ) {
+                result.emplace_back( om_addr, binary );
+            }
+        }
+    }
+    return result;
+}
+
+int file_map_storage::file_count()
+{
+    return get_files_from_path( ".map", map_directory, true, true ).size() +
+           get_files_from_path( ".bmap", map_directory, true, true ).size();
+}
+
+pack_map_storage::pack_map_storage( const std::string &map_directory )
+    : map_directory( map_directory )
+{
+}
+
+std::string pack_map_storage::pack_path( const tripoint &segment_addr ) const
+{
+    std::stringstream path;
+    path << map_directory << "/" << segment_addr.x << "." << segment_addr.y << "." <<
+         segment_addr.z << ".pack";
+    return path.str();
+}
+
+pack_map_storage::segment_index &pack_map_storage::index( const tripoint &segment_addr )
+{
+    const auto iter = segments.find( segment_addr );
+    if( iter != segments.end() ) {
+        return iter->second;
+    }
+    segment_index &result = segments[segment_addr];
+
+    std::ifstream fin( pack_path( segment_addr ).c_str(), std::ios::binary );
+    if( !fin.is_open() ) {
+        return result;
+    }
+    fin.seekg( 0, std::ios::end );
+    const uint64_t file_size = fin.tellg();
+    fin.seekg( 0, std::ios::beg );
+    uint32_t header[2];
+    if( !fin.read( reinterpret_cast<char *>( header ), sizeof( header ) ) ||
+        header[0] != pack_magic || header[1] != pack_version ) {
+        debugmsg( "%s is not a map pack of this version", pack_path( segment_addr ).c_str() );
+        return result;
+    }
+    uint64_t offset = pack_header_size;
+    char record_header[record_header_size];
+    // A record cut short by a crash while saving is dropped along with anything after it.
+    while( fin.read( record_header, record_header_size ) ) {
+        quad_key key;
+        bool removed;
+        uint32_t size;
+        read_record_header( record_header, key.first, key.second, removed, size );
+        if( offset + record_header_size + size > file_size ) {
+            break;
+        }
+        const auto old = result.records.find( key );
+        if( old != result.records.end() ) {
+            result.dead_bytes += record_header_size + old->second.size;
+            result.records.erase( old );
+        }
+        if( removed ) {
+            result.dead_bytes += record_header_size + size;
+        } else {
+            result.records[key] = record{ offset + record_header_size, size };
+        }
+        offset += record_header_size + size;
+        fin.seekg( offset );
+    }
+    fin.close();
+    result.end = offset;
+    if( offset != file_size ) {
+        // Appending would go after the broken tail, get rid of it first.
+        compact( segment_addr );
+    }
+    return result;
+}
+
+bool pack_map_storage::append( const tripoint &segment_addr, const quad_key &key,
+                               const bool removed, const std::string &data )
+{
+    segment_index &segment = index( segment_addr );
+    const std::string path = pack_path( segment_addr );
+    std::ofstream fout;
+    if( segment.end == 0 ) {
+        // New pack, or one that lost its header, start over.
+        assure_dir_exist( map_directory );
+        fopen_exclusive( fout, path.c_str(), std::ios_base::out | std::ios_base::binary );
+        if( !fout.is_open() ) {
+            return false;
+        }
+        const uint32_t header[2] = { pack_magic, pack_version };
+        fout.write( reinterpret_cast<const char *>( header ), sizeof( header ) );
+        segment.end = pack_header_size;
+    } else {
+        fopen_exclusive( fout, path.c_str(),
+                         std::ios_base::out | std::ios_base::app | std::ios_base::binary );
+        if( !fout.is_open() ) {
+            return false;
+        }
+    }
+    char record_header[record_header_size];
+    write_record_header( record_header, key.first, key.second, removed, data.size() );
+    fout.write( record_header, record_header_size );
+    fout.write( data.data(), data.size() );
+    const bool written = fout.good();
+    fclose_exclusive( fout, path.c_str() );
+    if( !written ) {
+        // Whatever made it to the file is a torn record, reading the pack again drops it.
+        segments.erase( segment_addr );
+        return false;
+    }
+    sync_written_file( path );
+
+    const auto old = segment.records.find( key );
+    if( old != segment.records.end() ) {
+        segment.dead_bytes += record_header_size + old->second.size;
+        segment.records.erase( old );
+    }
+    if( removed ) {
+        segment.dead_bytes += record_header_size + data.size();
+    } else {
+        segment.records[key] = record{ segment.end + record_header_size, uint32_t( data.size() ) };
+    }
+    segment.end += record_header_size + data.size();
+    return true;
+}
+
+std::unique_ptr<quad_data> pack_map_storage::read( const tripoint &om_addr, const bool binary )
+{
+    const tripoint segment_addr = overmapbuffer::omt_to_seg_copy( om_addr );
+    const segment_index &segment = index( segment_addr );
+    const auto iter = segment.records.find( quad_key( om_addr, binary ) );
+    if( iter == segment.records.end() ) {
+        return nullptr;
+    }
+    std::ifstream fin( pack_path( segment_addr ).c_str(), std::ios::binary );
+    std::unique_ptr<string_data> result( new string_data() );
+    result->contents.resize( iter->second.size );
+    fin.seekg( iter->second.offset );
+    if( !fin.read( &result->contents[0], iter->second.size ) ) {
+        return nullptr;
+    }
+    return std::unique_ptr<quad_data>( result.release() );
+}
+
+bool pack_map_storage::write( const tripoint &om_addr, const bool binary, const std::string &data )
+{
+    return append( overmapbuffer::omt_to_seg_copy( om_addr ), quad_key( om_addr, binary ), false,
+                   data );
+}
+
+void pack_map_storage::remove( const tripoint &om_addr, const bool binary )
+{
+    const tripoint segment_addr = overmapbuffer::omt_to_seg_copy( om_addr );
+    const quad_key key( om_addr, binary );
+    if( index( segment_addr ).records.count( key ) != 0 ) {
+        append( segment_addr, key, true, std::string() );
+    }
+}
+
+std::vector<std::pair<tripoint, bool>> pack_map_storage::stored_quads()
+{
+    std::vector<std::pair<tripoint, bool>> result;
+    for( const std::string &path : get_files_from_path( ".pack", map_directory, false, true ) ) {
+        const std::string name = path.substr( path.find_last_of( "/\\" ) + 1 );
+        tripoint segment_addr;
+        if( sscanf( name.c_str(), "%d.%d.%d.", &segment_addr.x, &segment_addr.y,
+                    &segment_addr.z ) != 3 ) {
+            continue;
+        }
+        for( auto &elem : index( segment_addr ).records ) {
+            result.push_back( elem.first );
+        }
+    }
+    return result;
+}
+
+void pack_map_storage::flush()
+{
+    for( auto &elem : segments ) {
+        const segment_index &segment = elem.second;
+        if( segment.dead_bytes >= min_dead_bytes_to_compact &&
+            segment.dead_bytes * 2 > segment.end ) {
+            compact( elem.first );
+        }
+    }
+}
+
+void pack_map_storage::compact( const tripoint &segment_addr )
+{
+    segment_index &segment = index( segment_addr );
+    const std::string path = pack_path( segment_addr );
+    std::ifstream fin( path.c_str(), std::ios::binary );
+    if( !fin.is_open() ) {
+        return;
+    }
+    const std::string temp_path = path + ".tmp";
+    std::ofstream fout;
+    fopen_exclusive( fout, temp_path.c_str(), std::ios_base::out | std::ios_base::binary );
+    if( !fout.is_open() ) {
+        return;
+    }
+    const uint32_t header[2] = { pack_magic, pack_version };
+    fout.write( reinterpret_cast<const char *>( header ), sizeof( header ) );
+
+    segment_index compacted;
+    compacted.end = pack_header_size;
+    std::string data;
+    for( auto &elem : segment.records ) {
+        data.resize( elem.second.size );
+        fin.seekg( elem.second.offset );
+        if( elem.second.size > 0 && !fin.read( &data[0], elem.second.size ) ) {
+            debugmsg( "failed to read %s while compacting it", path.c_str() );
+            fclose_exclusive( fout, temp_path.c_str() );
+            remove_file( temp_path );
+            return;
+        }
+        char record_header[record_header_size];
+        write_record_header( record_header, elem.first.first, elem.first.second, false, data.size() );
+        fout.write( record_header, record_header_size );
+        fout.write( data.data(), data.size() );
+        compacted.records[elem.first] = record{ compacted.end + record_header_size, elem.second.size };
+        compacted.end += record_header_size + data.size();
+    }
+    fin.close();
+    fclose_exclusive( fout, temp_path.c_str() );
+    sync_written_file( temp_path );
+    if( rename_file( temp_path, path ) ) {
+        segment = compacted;
+    }
+}
+
+uint64_t pack_map_storage::pack_size( const tripoint &segment_addr )
+{
+    return index( segment_addr ).end;
+}
+
+int pack_map_storage::file_count()
+{
+    return get_files_from_path( ".pack", map_directory, false, true ).size();
+}
@@ -0,0 +1,115 @@
+#ifndef MAP_STORAGE_H
+#define MAP_STORAGE_H
+
+#include "enums.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** The saved submaps of one overmap terrain quad, owned by this object. */
+class quad_data
+{
+    public:
+        virtual ~quad_data() = default;
+        virtual const char *data() const = 0;
+        virtual size_t size() const = 0;
+};
+
+/**
+ * Where @ref mapbuffer keeps the saved quads of a world, addressed by overmap terrain
+ * coordinates. A quad can be stored as JSON and in the binary format, see
+ * @ref mapbuffer::save_quad.
+ */
+class map_storage
+{
+    public:
+        virtual ~map_storage() = default;
+
+        /** @return nullptr if the quad is not stored in that format. */
+        virtual std::unique_ptr<quad_data> read( const tripoint &om_addr, bool binary ) = 0;
+        /** @return false if the data could not be written. */
+        virtual bool write( const tripoint &om_addr, bool binary, const std::string &data ) = 0;
+        /** Does nothing if the quad is not stored in that format. */
+        virtual void remove( const tripoint &om_addr, bool binary ) = 0;
+        /** Every stored quad and whether it is stored in the binary format. */
+        virtual std::vector<std::pair<tripoint, bool>> stored_quads() = 0;
+        /** Called once at the end of saving the map. */
+        virtual void flush() {
+        }
+        /** The number of files the stored quads take up. */
+        virtual int file_count() = 0;
+};
+
+/**
+ * One file per quad, maps/X.Y.Z/x.y.z.map (or .bmap), where X.Y.Z is the segment of
+ * 32x32 quads it belongs to.
+ */
+class file_map_storage : public map_storage
+{
+    public:
+        file_map_storage( const std::string &map_directory );
+
+        std::unique_ptr<quad_data> read( const tripoint &om_addr, bool binary ) override;
+        bool write( const tripoint &om_addr, bool binary, const std::string &data ) override;
+        void remove( const tripoint &om_addr, bool binary ) override;
+        std::vector<std::pair<tripoint, bool>> stored_quads() override;
+        int file_count() override;
+
+    private:
+        std::string segment_directory( const tripoint &om_addr ) const;
+        std::string quad_file_name( const tripoint &om_addr, bool binary ) const;
+
+        std::string map_directory;
+};
+
+/**
+ * One file per segment, maps/X.Y.Z.pack. Quads are only ever appended to it, a quad
+ * saved again or removed makes the older record dead. The offsets of the live records
+ * are found by skimming the record headers the first time a pack is used.
+ * @ref flush rewrites packs that are mostly dead records.
+ */
+class pack_map_storage : public map_storage
+{
+    public:
+        pack_map_storage( const std::string &map_directory );
+
+        std::unique_ptr<quad_data> read( const tripoint &om_addr, bool binary ) override;
+        bool write( const tripoint &om_addr, bool binary, const std::string &data ) override;
+        void remove( const tripoint &om_addr, bool binary ) override;
+        std::vector<std::pair<tripoint, bool>> stored_quads() override;
+        void flush() override;
+        int file_count() override;
+
+        /** Rewrites the pack of the segment with only its live records. */
+        void compact( const tripoint &segment_addr );
+        /** Size in bytes of the pack of the segment, including dead records. */
+        uint64_t pack_size( const tripoint &segment_addr );
+
+    private:
+        typedef std::pair<tripoint, bool> quad_key;
+        struct record {
+            uint64_t offset;
+            uint32_t size;
+        };
+        struct segment_index {
+            std::map<quad_key, record> records;
+            /** Size of the pack file, where the next record goes. */
+            uint64_t end = 0;
+            /** Bytes taken up by records that have been superseded. */
+            uint64_t dead_bytes = 0;
+        };
+
+        segment_index &index( const tripoint &segment_addr );
+        std::string pack_path( const tripoint &segment_addr ) const;
+        bool append( const tripoint &segment_addr, const quad_key &key, bool removed,
+                     const std::string &data );
+
+        std::string map_directory;
+        std::map<tripoint, segment_index> segments;
+};
+
+#endif
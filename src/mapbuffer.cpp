@@ -12,14 +12,272 @@
 #include "trap.h"
 #include "vehicle.h"
 #include "submap.h"
+#include "options.h"
+#include "map_storage.h"
+#include "background_writer.h"
+
+#if (defined _WIN32 || defined WINDOWS)
+#   include "mingw.thread.h"
+#endif
 
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
 
 #define dbg(x) DebugLog((DebugLevel)(x),D_MAP) << __FILE__ << ":" << __LINE__ << ": "
 
 mapbuffer MAPBUFFER;
 
+namespace
+{
+
+// "CDSM" in the first four bytes of binary quad files.
+const uint32_t binary_quad_magic = 0x4d534443;
+const uint32_t binary_quad_version = 1;
+
+/** A quad that is still waiting to be written. */
+class shared_quad_data : public quad_data
+{
+    public:
+        shared_quad_data( const std::shared_ptr<const std::string> &contents ) : contents( contents ) {
+        }
+        const char *data() const override {
+            return contents->data();
+        }
+        size_t size() const override {
+            return contents->size();
+        }
+
+    private:
+        std::shared_ptr<const std::string> contents;
+};
+
+/** Appends plain values to a byte buffer, in the byte order of this machine. */
+class binary_writer
+{
+    public:
+        template<typename T>
+        void write( const T value ) {
+            buffer.append( reinterpret_cast<const char *>( &value ), sizeof( value ) );
+        }
+        /** Length-prefixed bytes. */
+        void write_blob( const std::string &blob ) {
+            write<uint32_t>( blob.size() );
+            buffer.append( blob );
+        }
+
+        std::string buffer;
+};
+
+/** Reads what binary_writer wrote, throws if the data ends early. */
+class binary_reader
+{
+    public:
+        binary_reader( const char *data, size_t size ) : pos( data ), end( data + size ) {
+        }
+
+        template<typename T>
+        T read() {
+            T value;
+            std::memcpy( &value, take( sizeof( value ) ), sizeof( value ) );
+            return value;
+        }
+        /** Length-prefixed bytes, still owned by the caller of the constructor. */
+        const char *read_blob( size_t &size ) {
+            size = read<uint32_t>();
+            return take( size );
+        }
+
+    private:
+        const char *take( const size_t size ) {
+            if( size_t( end - pos ) < size ) {
+                throw std::runtime_error( "binary map data ends unexpectedly" );
+            }
+            const char *result = pos;
+            pos += size;
+            return result;
+        }
+
+        const char *pos;
+        const char *end;
+};
+
+// Per tile in row order like the JSON terrain array: the number of runs, then length and
+// value of each.
+template<typename T, typename F>
+void write_rle( binary_writer &out, F value_at )
+{
+    std::vector<std::pair<uint16_t, T>> runs;
+    for( int j = 0; j < SEEY; j++ ) {
+        for( int i = 0; i < SEEX; i++ ) {
+            const T value = value_at( i, j );
+            if( !runs.empty() && runs.back().second == value ) {
+                runs.back().first++;
+            } else {
+                runs.emplace_back( 1, value );
+            }
+        }
+    }
+    out.write<uint16_t>( runs.size() );
+    for( const auto &run : runs ) {
+        out.write( run.first );
+        out.write( run.second );
+    }
+}
+
+template<typename T, typename F>
+void read_rle( binary_reader &in, F set_at )
+{
+    const uint16_t runs = in.read<uint16_t>();
+    int cell = 0;
+    for( uint16_t r = 0; r < runs; r++ ) {
+        const uint16_t length = in.read<uint16_t>();
+        const T value = in.read<T>();
+        if( cell + length > SEEX * SEEY ) {
+            throw std::runtime_error( "binary map data has too many tiles" );
+        }
+        for( uint16_t n = 0; n < length; n++, cell++ ) {
+            set_at( cell % SEEX, cell / SEEX, value );
+        }
+    }
+    if( cell != SEEX * SEEY ) {
+        throw std::runtime_error( "binary map data has too few tiles" );
+    }
+}
+
+// The items on one tile, the same in both formats.
+void read_tile_items( JsonIn &jsin, submap &sm, const int i, const int j )
+{
+    jsin.start_array();
+    while( !jsin.end_array() ) {
+        item tmp;
+        jsin.read( tmp );
+        if( tmp.is_emissive() ) {
+            sm.update_lum_add(tmp, i, j);
+        }
+
+        sm.itm[i][j].push_back( tmp );
+        if( tmp.needs_processing() ) {
+            sm.active_items.add( std::prev(sm.itm[i][j].end()), point( i, j ) );
+        }
+    }
+}
+
+// Members that the binary format stores as JSON too.
+void write_submap_extras( JsonOut &jsout, submap &sm )
+{
+    jsout.member("cosmetics");
+    jsout.start_array();
+    for (int j = 0; j < SEEY; j++) {
+        for (int i = 0; i < SEEX; i++) {
+            if (sm.cosmetics[i][j].size() > 0) {
+                jsout.start_array();
+                jsout.write(i);
+                jsout.write(j);
+                jsout.write(sm.cosmetics[i][j]);
+                jsout.end_array();
+            }
+        }
+    }
+    jsout.end_array();
+
+    // Output the spawn points
+    jsout.member( "spawns" );
+    jsout.start_array();
+    for( auto &elem : sm.spawns ) {
+        jsout.start_array();
+        jsout.write( elem.type.str() ); // TODO: json should know how to write string_ids
+        jsout.write( elem.count );
+        jsout.write( elem.posx );
+        jsout.write( elem.posy );
+        jsout.write( elem.faction_id );
+        jsout.write( elem.mission_id );
+        jsout.write( elem.friendly );
+        jsout.write( elem.name );
+        jsout.end_array();
+    }
+    jsout.end_array();
+
+    jsout.member( "vehicles" );
+    jsout.start_array();
+    for( auto &elem : sm.vehicles ) {
+        // json lib doesn't know how to turn a vehicle * into a vehicle,
+        // so we have to iterate manually.
+        jsout.write( *elem );
+    }
+    jsout.end_array();
+
+    // Output the computer
+    if (sm.comp.name != "") {
+        jsout.member( "computers", sm.comp.save_data() );
+    }
+
+    // Output base camp if any
+    if (sm.camp.is_valid()) {
+        jsout.member( "camp" );
+        jsout.write( sm.camp.save_data() );
+    }
+}
+
+// Counterpart of write_submap_extras, also reads members only older saves have.
+void read_submap_extra( JsonIn &jsin, const std::string &submap_member_name, submap &sm )
+{
+    if( submap_member_name == "graffiti" ) {
+        jsin.start_array();
+        while( !jsin.end_array() ) {
+            jsin.start_array();
+            int i = jsin.get_int();
+            int j = jsin.get_int();
+            sm.set_graffiti( i, j, jsin.get_string() );
+            jsin.end_array();
+        }
+    } else if(submap_member_name == "cosmetics") {
+        jsin.start_array();
+        while (!jsin.end_array()) {
+            jsin.start_array();
+            int i = jsin.get_int();
+            int j = jsin.get_int();
+            jsin.read(sm.cosmetics[i][j]);
+            jsin.end_array();
+        }
+    } else if( submap_member_name == "spawns" ) {
+        jsin.start_array();
+        while( !jsin.end_array() ) {
+            jsin.start_array();
+            const mtype_id type = mtype_id( jsin.get_string() ); // TODO: json should know how to read an string_id
+            int count = jsin.get_int();
+            int i = jsin.get_int();
+            int j = jsin.get_int();
+            int faction_id = jsin.get_int();
+            int mission_id = jsin.get_int();
+            bool friendly = jsin.get_bool();
+            std::string name = jsin.get_string();
+            jsin.end_array();
+            spawn_point tmp( type, count, i, j, faction_id, mission_id, friendly, name );
+            sm.spawns.push_back( tmp );
+        }
+    } else if( submap_member_name == "vehicles" ) {
+        jsin.start_array();
+        while( !jsin.end_array() ) {
+            vehicle *tmp = new vehicle();
+            jsin.read( *tmp );
+            sm.vehicles.push_back( tmp );
+        }
+    } else if( submap_member_name == "computers" ) {
+        std::string computer_data = jsin.get_string();
+        sm.comp.load_data( computer_data );
+    } else if( submap_member_name == "camp" ) {
+        std::string camp_data = jsin.get_string();
+        sm.camp.load_data( camp_data );
+    } else {
+        jsin.skip_value();
+    }
+}
+
+}
+
 mapbuffer::mapbuffer()
 {
 }
@@ -31,10 +289,26 @@ mapbuffer::~mapbuffer()
 
 void mapbuffer::reset()
 {
+    // Queued writes and reads refer to the storage of this world.
+    stop_prefetching();
+    wait_for_writes();
+    pending_quads.clear();
     for( auto &elem : submaps ) {
         delete elem.second;
     }
     submaps.clear();
+    vehicle_submaps.clear();
+    binary_ids.clear();
+    binary_id_indices.clear();
+    binary_ids_loaded = false;
+    binary_ids_changed = false;
+    binary_ter.clear();
+    binary_furn.clear();
+    binary_trap.clear();
+    file_storage.reset();
+    pack_storage.reset();
+    storage_options_known = false;
+    rewrite_all_quads = false;
 }
 
 bool mapbuffer::add_submap(const tripoint &p, submap *sm)
@@ -44,6 +318,9 @@ bool mapbuffer::add_submap(const tripoint &p, submap *sm)
     }
 
     submaps[p] = sm;
+    if( !sm->vehicles.empty() ) {
+        vehicle_submaps.insert( p );
+    }
 
     return true;
 }
@@ -74,6 +351,7 @@ void mapbuffer::remove_submap( tripoint addr )
     }
     delete m_target->second;
     submaps.erase( m_target );
+    vehicle_submaps.erase( addr );
 }
 
 submap *mapbuffer::lookup_submap(int x, int y, int z)
@@ -98,6 +376,30 @@ submap *mapbuffer::lookup_submap( const tripoint &p )
     return iter->second;
 }
 
+std::vector<std::pair<tripoint, vehicle *>> mapbuffer::get_vehicles()
+{
+    std::vector<std::pair<tripoint, vehicle *>> result;
+    for( auto it = vehicle_submaps.begin(); it != vehicle_submaps.end(); ) {
+        const auto sm = submaps.find( *it );
+        if( sm == submaps.end() || sm->second->vehicles.empty() ) {
+            it = vehicle_submaps.erase( it );
+            continue;
+        }
+        for( vehicle *veh : sm->second->vehicles ) {
+            result.emplace_back( *it, veh );
+        }
+        ++it;
+    }
+    return result;
+}
+
+void mapbuffer::note_vehicles( const tripoint &p )
+{
+    if( submaps.count( p ) != 0 ) {
+        vehicle_submaps.insert( p );
+    }
+}
+
 void mapbuffer::save( bool delete_after_save )
 {
     std::stringstream map_directory;
@@ -105,7 +407,12 @@ void mapbuffer::save( bool delete_after_save )
     assure_dir_exist( map_directory.str().c_str() );
 
     int num_saved_submaps = 0;
+    int num_written_submaps = 0;
     int num_total_submaps = submaps.size();
+    const bool binary = binary_maps_enabled();
+    check_storage_options();
+    const bool only_modified = !rewrite_all_quads;
+    rewrite_all_quads = false;
 
     const tripoint map_origin = overmapbuffer::sm_to_omt_copy( g->m.get_abs_sub() );
     const bool map_has_zlevels = g != nullptr && g->m.has_zlevels();
@@ -115,8 +422,9 @@ void mapbuffer::save( bool delete_after_save )
     std::list<tripoint> submaps_to_delete;
     for( auto &elem : submaps ) {
         if (num_total_submaps > 100 && num_saved_submaps % 100 == 0) {
-            popup_nowait(_("Please wait as the map saves [%d/%d]"),
-                         num_saved_submaps, num_total_submaps);
+            popup_nowait(_("Please wait as the map saves [%d/%d], %d written, %d unchanged"),
+                         num_saved_submaps, num_total_submaps, num_written_submaps,
+                         num_saved_submaps - num_written_submaps);
         }
         // Whatever the coordinates of the current submap are,
         // we're saving a 2x2 quad of submaps at a time.
@@ -129,36 +437,261 @@ void mapbuffer::save( bool delete_after_save )
         }
         saved_submaps.insert( om_addr );
 
-        // A segment is a chunk of 32x32 submap quads.
-        // We're breaking them into subdirectories so there aren't too many files per directory.
-        // Might want to make a set for this one too so it's only checked once per save().
-        std::stringstream dirname;
-        tripoint segment_addr = overmapbuffer::omt_to_seg_copy( om_addr );
-        dirname << map_directory.str() << "/" << segment_addr.x << "." <<
-                     segment_addr.y << "." << segment_addr.z;
-
-        std::stringstream quad_path;
-        quad_path << dirname.str() << "/" << om_addr.x << "." <<
-                  om_addr.y << "." << om_addr.z << ".map";
-
         // delete_on_save deletes everything, otherwise delete submaps
         // outside the current map.
         const bool zlev_del = !map_has_zlevels && om_addr.z != g->get_levz();
-        save_quad( dirname.str(), quad_path.str(), om_addr, submaps_to_delete,
-                   delete_after_save || zlev_del ||
-                   om_addr.x < map_origin.x || om_addr.y < map_origin.y ||
-                   om_addr.x > map_origin.x + (MAPSIZE / 2) ||
-                   om_addr.y > map_origin.y + (MAPSIZE / 2) );
+        if( save_quad( om_addr, submaps_to_delete,
+                       delete_after_save || zlev_del ||
+                       om_addr.x < map_origin.x || om_addr.y < map_origin.y ||
+                       om_addr.x > map_origin.x + (MAPSIZE / 2) ||
+                       om_addr.y > map_origin.y + (MAPSIZE / 2), binary, only_modified ) ) {
+            num_written_submaps += 4;
+        }
         num_saved_submaps += 4;
     }
     for( auto &elem : submaps_to_delete ) {
         remove_submap( elem );
     }
+    flush_storage();
+    save_binary_ids();
+}
+
+bool mapbuffer::binary_maps_enabled()
+{
+    return !ACTIVE_WORLD_OPTIONS.empty() && static_cast<bool>( ACTIVE_WORLD_OPTIONS["BINARY_MAPS"] );
+}
+
+bool mapbuffer::pack_files_enabled()
+{
+    return !ACTIVE_WORLD_OPTIONS.empty() && static_cast<bool>( ACTIVE_WORLD_OPTIONS["PACK_MAPS"] );
+}
+
+map_storage &mapbuffer::storage( const bool packed )
+{
+    std::unique_ptr<map_storage> &result = packed ? pack_storage : file_storage;
+    if( !result ) {
+        const std::string map_directory = world_generator->active_world->world_path + "/maps";
+        if( packed ) {
+            result.reset( new pack_map_storage( map_directory ) );
+        } else {
+            result.reset( new file_map_storage( map_directory ) );
+        }
+    }
+    return *result;
+}
+
+std::unique_ptr<quad_data> mapbuffer::read_quad( const tripoint &om_addr, bool &binary,
+                                                 bool &current )
+{
+    return read_quad( om_addr, pack_files_enabled(), binary_maps_enabled(), binary, current );
+}
+
+std::unique_ptr<quad_data> mapbuffer::read_quad( const tripoint &om_addr, const bool packed,
+                                                 const bool binary_maps, bool &binary, bool &current )
+{
+    {
+        std::lock_guard<std::mutex> lock( pending_mutex );
+        const auto iter = pending_quads.find( om_addr );
+        if( iter != pending_quads.end() ) {
+            binary = iter->second.binary;
+            current = binary == binary_maps;
+            return std::unique_ptr<quad_data>( new shared_quad_data( iter->second.data ) );
+        }
+    }
+    std::lock_guard<std::mutex> lock( storage_mutex );
+    // Worlds can have quads from before the options were changed, in any combination.
+    for( const bool in_pack : { packed, !packed } ) {
+        for( const bool in_binary : { true, false } ) {
+            std::unique_ptr<quad_data> data = storage( in_pack ).read( om_addr, in_binary );
+            if( data ) {
+                binary = in_binary;
+                current = in_pack == packed && in_binary == binary_maps;
+                return data;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void mapbuffer::prefetch( const std::vector<tripoint> &submap_addrs )
+{
+    const bool packed = pack_files_enabled();
+    const bool binary_maps = binary_maps_enabled();
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock( prefetch_mutex );
+        for( const tripoint &submap_addr : submap_addrs ) {
+            const tripoint om_addr = overmapbuffer::sm_to_omt_copy( submap_addr );
+            if( submaps.count( submap_addr ) != 0 || prefetched_quads.count( om_addr ) != 0 ) {
+                continue;
+            }
+            prefetched_quad &quad = prefetched_quads[om_addr];
+            quad.ticket = ++last_prefetch_ticket;
+            prefetch_queue.push_back( prefetch_request{ om_addr, quad.ticket, packed, binary_maps } );
+            queued = true;
+        }
+        if( queued && !prefetch_thread.joinable() ) {
+            prefetch_stopping = false;
+            prefetch_thread = std::thread( &mapbuffer::prefetch_work, this );
+        }
+    }
+    if( queued ) {
+        prefetch_wake.notify_one();
+    }
+}
+
+void mapbuffer::prefetch_work()
+{
+    std::unique_lock<std::mutex> lock( prefetch_mutex );
+    while( true ) {
+        prefetch_wake.wait( lock, [this] {
+            return prefetch_stopping || !prefetch_queue.empty();
+        } );
+        if( prefetch_stopping ) {
+            return;
+        }
+        const prefetch_request request = prefetch_queue.front();
+        prefetch_queue.pop_front();
+        if( prefetched_quads.count( request.om_addr ) == 0 ) {
+            // Already looked up, or saved since it was requested.
+            if( prefetch_queue.empty() ) {
+                prefetch_idle.notify_all();
+            }
+            continue;
+        }
+        prefetch_busy = true;
+        lock.unlock();
+        bool binary = false;
+        bool current = false;
+        std::unique_ptr<quad_data> data;
+        try {
+            data = read_quad( request.om_addr, request.packed, request.binary_maps, binary, current );
+        } catch( const std::exception & ) {
+            // Reading it again on the main thread reports the error.
+        }
+        lock.lock();
+        const auto iter = prefetched_quads.find( request.om_addr );
+        if( iter != prefetched_quads.end() && iter->second.ticket == request.ticket ) {
+            iter->second.done = true;
+            iter->second.binary = binary;
+            iter->second.current = current;
+            iter->second.data = std::move( data );
+        }
+        prefetch_busy = false;
+        if( prefetch_queue.empty() ) {
+            prefetch_idle.notify_all();
+        }
+    }
+}
+
+void mapbuffer::wait_for_prefetch()
+{
+    std::unique_lock<std::mutex> lock( prefetch_mutex );
+    prefetch_idle.wait( lock, [this] {
+        return prefetch_queue.empty() && !prefetch_busy;
+    } );
+}
+
+bool mapbuffer::take_prefetched_quad( const tripoint &om_addr, std::unique_ptr<quad_data> &data,
+                                      bool &binary, bool &current )
+{
+    std::lock_guard<std::mutex> lock( prefetch_mutex );
+    const auto iter = prefetched_quads.find( om_addr );
+    if( iter == prefetched_quads.end() ) {
+        return false;
+    }
+    const bool done = iter->second.done;
+    if( done ) {
+        data = std::move( iter->second.data );
+        binary = iter->second.binary;
+        current = iter->second.current;
+        prefetch_hits++;
+    } else {
+        // Reading it right away beats waiting for everything queued before it.
+        prefetch_misses++;
+    }
+    prefetched_quads.erase( iter );
+    return done;
+}
+
+void mapbuffer::forget_prefetched_quad( const tripoint &om_addr )
+{
+    std::lock_guard<std::mutex> lock( prefetch_mutex );
+    prefetched_quads.erase( om_addr );
+}
+
+void mapbuffer::stop_prefetching()
+{
+    {
+        std::lock_guard<std::mutex> lock( prefetch_mutex );
+        prefetch_stopping = true;
+        prefetch_queue.clear();
+        prefetched_quads.clear();
+    }
+    prefetch_wake.notify_one();
+    prefetch_idle.notify_all();
+    if( prefetch_thread.joinable() ) {
+        prefetch_thread.join();
+    }
+}
+
+void mapbuffer::unserialize_quad( const quad_data &data, const bool binary )
+{
+    if( binary ) {
+        unserialize_binary_quad( data.data(), data.size() );
+    } else {
+        unserialize_json_quad( data.data(), data.size() );
+    }
+}
+
+int mapbuffer::convert_saved_quads( const bool binary )
+{
+    // Everything has to be in the storage to be found there.
+    wait_for_writes();
+    const bool packed = pack_files_enabled();
+    int converted = 0;
+    for( const bool in_pack : { packed, !packed } ) {
+        std::vector<std::pair<tripoint, bool>> stored_quads;
+        {
+            std::lock_guard<std::mutex> lock( storage_mutex );
+            stored_quads = storage( in_pack ).stored_quads();
+        }
+        for( auto &quad : stored_quads ) {
+            const tripoint &om_addr = quad.first;
+            if( ( in_pack == packed && quad.second == binary ) ||
+                submaps.count( overmapbuffer::omt_to_sm_copy( om_addr ) ) != 0 ) {
+                // Loaded ones are written in the world's format by the next save anyway.
+                continue;
+            }
+            try {
+                std::unique_ptr<quad_data> data;
+                {
+                    std::lock_guard<std::mutex> lock( storage_mutex );
+                    data = storage( in_pack ).read( om_addr, quad.second );
+                }
+                if( !data ) {
+                    continue;
+                }
+                unserialize_quad( *data, quad.second );
+            } catch( const std::exception &err ) {
+                debugmsg( "Failed to convert quad %d,%d,%d: %s", om_addr.x, om_addr.y, om_addr.z,
+                          err.what() );
+                continue;
+            }
+            std::list<tripoint> submaps_to_delete;
+            save_quad( om_addr, submaps_to_delete, true, binary, false );
+            for( auto &elem : submaps_to_delete ) {
+                remove_submap( elem );
+            }
+            converted++;
+        }
+    }
+    flush_storage();
+    save_binary_ids();
+    return converted;
 }
 
-void mapbuffer::save_quad( const std::string &dirname, const std::string &filename, 
-                           const tripoint &om_addr, std::list<tripoint> &submaps_to_delete, 
-                           bool delete_after_save )
+std::vector<tripoint> mapbuffer::quad_submap_addrs( const tripoint &om_addr )
 {
     std::vector<point> offsets;
     std::vector<tripoint> submap_addrs;
@@ -167,20 +700,48 @@ void mapbuffer::save_quad( const std::string &dirname, const std::string &filena
     offsets.push_back( point(1, 0) );
     offsets.push_back( point(1, 1) );
 
-    bool all_uniform = true;
     for( auto &offsets_offset : offsets ) {
         tripoint submap_addr = overmapbuffer::omt_to_sm_copy( om_addr );
         submap_addr.x += offsets_offset.x;
         submap_addr.y += offsets_offset.y;
         submap_addrs.push_back( submap_addr );
+    }
+    return submap_addrs;
+}
+
+void mapbuffer::check_storage_options()
+{
+    const bool binary = binary_maps_enabled();
+    const bool packed = pack_files_enabled();
+    if( storage_options_known && ( binary != stored_binary || packed != stored_packed ) ) {
+        // Quads saved or loaded before are stored the old way.
+        rewrite_all_quads = true;
+    }
+    storage_options_known = true;
+    stored_binary = binary;
+    stored_packed = packed;
+}
+
+bool mapbuffer::save_quad( const tripoint &om_addr, std::list<tripoint> &submaps_to_delete,
+                           bool delete_after_save, bool binary, bool only_modified )
+{
+    const std::vector<tripoint> submap_addrs = quad_submap_addrs( om_addr );
+
+    bool all_uniform = true;
+    bool modified = false;
+    for( auto &submap_addr : submap_addrs ) {
         submap *sm = submaps[submap_addr];
         if( sm != nullptr && !sm->is_uniform ) {
             all_uniform = false;
         }
+        if( sm != nullptr && sm->is_modified() ) {
+            modified = true;
+        }
     }
 
-    if( all_uniform ) {
-        // Nothing to save - this quad will be regenerated faster than it would be re-read
+    if( all_uniform || ( only_modified && !modified ) ) {
+        // Nothing to save - this quad will be regenerated faster than it would be re-read,
+        // or the saved quad is still up to date.
         if( delete_after_save ) {
             for( auto &submap_addr : submap_addrs ) {
                 if( submaps.count( submap_addr ) > 0 && submaps[submap_addr] != nullptr ) {
@@ -189,17 +750,19 @@ void mapbuffer::save_quad( const std::string &dirname, const std::string &filena
             }
         }
 
-        return;
+        return false;
     }
 
-    // Don't create the directory if it would be empty
-    assure_dir_exist( dirname.c_str() );
-    std::ofstream fout;
-    fopen_exclusive( fout, filename.c_str() );
-    if( !fout.is_open() ) {
-        return;
+    // Only deleted once the quad made it to the storage.
+    std::list<tripoint> saved_submaps;
+    if( binary ) {
+        write_quad( om_addr, binary, serialize_binary_quad( submap_addrs, saved_submaps,
+                    delete_after_save ), saved_submaps, submaps_to_delete );
+        mark_quad_saved( submap_addrs );
+        return true;
     }
 
+    std::ostringstream fout;
     JsonOut jsout( fout );
     jsout.start_array();
     for( auto &submap_addr : submap_addrs ) {
@@ -330,65 +893,338 @@ void mapbuffer::save_quad( const std::string &dirname, const std::string &filena
         }
         jsout.end_array();
 
-        jsout.member("cosmetics");
-        jsout.start_array();
-        for (int j = 0; j < SEEY; j++) {
-            for (int i = 0; i < SEEX; i++) {
-                if (sm->cosmetics[i][j].size() > 0) {
-                    jsout.start_array();
-                    jsout.write(i);
-                    jsout.write(j);
-                    jsout.write(sm->cosmetics[i][j]);
-                    jsout.end_array();
-                }
+        write_submap_extras( jsout, *sm );
+
+        if( delete_after_save ) {
+            saved_submaps.push_back( submap_addr );
+        }
+        jsout.end_object();
+    }
+
+    jsout.end_array();
+    write_quad( om_addr, binary, fout.str(), saved_submaps, submaps_to_delete );
+    mark_quad_saved( submap_addrs );
+    return true;
+}
+
+void mapbuffer::mark_quad_saved( const std::vector<tripoint> &submap_addrs )
+{
+    for( auto &submap_addr : submap_addrs ) {
+        const auto iter = submaps.find( submap_addr );
+        if( iter != submaps.end() && iter->second != nullptr ) {
+            iter->second->set_saved();
+        }
+    }
+}
+
+void mapbuffer::write_quad( const tripoint &om_addr, const bool binary, std::string data,
+                            std::list<tripoint> &saved_submaps, std::list<tripoint> &submaps_to_delete )
+{
+    const bool packed = pack_files_enabled();
+    const std::shared_ptr<const std::string> shared_data =
+        std::make_shared<const std::string>( std::move( data ) );
+    // A copy read ahead of time may be older.
+    forget_prefetched_quad( om_addr );
+    {
+        std::lock_guard<std::mutex> lock( pending_mutex );
+        pending_quads[om_addr] = pending_quad{ binary, shared_data };
+    }
+    // Loading the quad again finds it in pending_quads until it's written.
+    submaps_to_delete.splice( submaps_to_delete.end(), saved_submaps );
+    queue_write( [this, om_addr, binary, packed, shared_data]() {
+        {
+            std::lock_guard<std::mutex> lock( storage_mutex );
+            if( !storage( packed ).write( om_addr, binary, *shared_data ) ) {
+                // Stays pending, it's not lost before the game ends at least.
+                throw std::ios::failure( "failed to write a map file" );
             }
+            // The quad may still be around in another format or storage.
+            storage( packed ).remove( om_addr, !binary );
+            storage( !packed ).remove( om_addr, binary );
+            storage( !packed ).remove( om_addr, !binary );
         }
-        jsout.end_array();
+        std::lock_guard<std::mutex> lock( pending_mutex );
+        const auto iter = pending_quads.find( om_addr );
+        if( iter != pending_quads.end() && iter->second.data == shared_data ) {
+            pending_quads.erase( iter );
+        }
+    } );
+}
 
-        // Output the spawn points
-        jsout.member( "spawns" );
-        jsout.start_array();
-        for( auto &elem : sm->spawns ) {
-            jsout.start_array();
-            jsout.write( elem.type.str() ); // TODO: json should know how to write string_ids
-            jsout.write( elem.count );
-            jsout.write( elem.posx );
-            jsout.write( elem.posy );
-            jsout.write( elem.faction_id );
-            jsout.write( elem.mission_id );
-            jsout.write( elem.friendly );
-            jsout.write( elem.name );
-            jsout.end_array();
+void mapbuffer::queue_write( std::function<void()> job )
+{
+    writes_queued = true;
+    background_writer::get().queue( std::move( job ) );
+}
+
+void mapbuffer::wait_for_writes()
+{
+    if( writes_queued ) {
+        background_writer::get().wait();
+        writes_queued = false;
+    }
+}
+
+void mapbuffer::flush_storage()
+{
+    const bool packed = pack_files_enabled();
+    queue_write( [this, packed]() {
+        std::lock_guard<std::mutex> lock( storage_mutex );
+        storage( packed ).flush();
+    } );
+}
+
+std::string mapbuffer::binary_ids_path()
+{
+    return world_generator->active_world->world_path + "/maps/binary_ids.txt";
+}
+
+void mapbuffer::load_binary_ids()
+{
+    if( binary_ids_loaded ) {
+        return;
+    }
+    binary_ids_loaded = true;
+    std::ifstream fin( binary_ids_path().c_str() );
+    std::string id;
+    while( std::getline( fin, id ) ) {
+        binary_id_indices[id] = binary_ids.size();
+        binary_ids.push_back( id );
+    }
+}
+
+void mapbuffer::save_binary_ids()
+{
+    if( !binary_ids_changed ) {
+        return;
+    }
+    std::ostringstream ids;
+    for( const std::string &id : binary_ids ) {
+        ids << id << "\n";
+    }
+    const std::string path = binary_ids_path();
+    const std::string data = ids.str();
+    // Goes after the quads using the new ids, a crash in between loses those quads
+    // instead of making them read the wrong ids.
+    queue_write( [path, data]() {
+        write_file_replacing( path, data );
+    } );
+    binary_ids_changed = false;
+}
+
+uint32_t mapbuffer::binary_id_index( const std::string &id )
+{
+    load_binary_ids();
+    const auto iter = binary_id_indices.find( id );
+    if( iter != binary_id_indices.end() ) {
+        return iter->second;
+    }
+    binary_id_indices[id] = binary_ids.size();
+    binary_ids.push_back( id );
+    binary_ids_changed = true;
+    return binary_ids.size() - 1;
+}
+
+const std::string &mapbuffer::binary_id( const uint32_t index )
+{
+    load_binary_ids();
+    if( index >= binary_ids.size() ) {
+        throw std::runtime_error( "binary map data refers to an unknown id" );
+    }
+    return binary_ids[index];
+}
+
+// The ids are resolved once per table entry, lookups by string are what makes the JSON slow.
+template<typename F>
+int mapbuffer::resolve_binary_id( std::vector<int> &resolved, const uint32_t index, F resolve )
+{
+    if( index >= resolved.size() ) {
+        // Throws for indices past the table before it can grow out of bounds.
+        const std::string &id = binary_id( index );
+        resolved.resize( index + 1, -1 );
+        resolved[index] = resolve( id );
+    } else if( resolved[index] < 0 ) {
+        resolved[index] = resolve( binary_id( index ) );
+    }
+    return resolved[index];
+}
+
+std::string mapbuffer::serialize_binary_quad( const std::vector<tripoint> &submap_addrs,
+        std::list<tripoint> &submaps_to_delete, bool delete_after_save )
+{
+    binary_writer out;
+    out.write( binary_quad_magic );
+    out.write( binary_quad_version );
+    uint32_t count = 0;
+    for( auto &submap_addr : submap_addrs ) {
+        if( submaps.count( submap_addr ) != 0 && submaps[submap_addr] != nullptr ) {
+            count++;
         }
-        jsout.end_array();
+    }
+    out.write( count );
 
-        jsout.member( "vehicles" );
-        jsout.start_array();
-        for( auto &elem : sm->vehicles ) {
-            // json lib doesn't know how to turn a vehicle * into a vehicle,
-            // so we have to iterate manually.
-            jsout.write( *elem );
+    for( auto &submap_addr : submap_addrs ) {
+        if( submaps.count( submap_addr ) == 0 ) {
+            continue;
+        }
+        submap *sm = submaps[submap_addr];
+        if( sm == nullptr ) {
+            continue;
         }
-        jsout.end_array();
 
-        // Output the computer
-        if (sm->comp.name != "") {
-            jsout.member( "computers", sm->comp.save_data() );
+        out.write<int32_t>( submap_addr.x );
+        out.write<int32_t>( submap_addr.y );
+        out.write<int32_t>( submap_addr.z );
+        out.write<int32_t>( savegame_version );
+        out.write<int32_t>( sm->turn_last_touched );
+        out.write<int32_t>( sm->temperature );
+
+        write_rle<uint32_t>( out, [&]( int i, int j ) {
+            return binary_id_index( sm->ter[i][j].obj().id );
+        } );
+        write_rle<uint32_t>( out, [&]( int i, int j ) {
+            return binary_id_index( sm->get_furn( i, j ).obj().id );
+        } );
+        write_rle<uint32_t>( out, [&]( int i, int j ) {
+            return binary_id_index( sm->get_trap( i, j ).id().str() );
+        } );
+        write_rle<int32_t>( out, [&]( int i, int j ) {
+            return sm->get_radiation( i, j );
+        } );
+
+        binary_writer fields;
+        uint32_t field_tiles = 0;
+        for( int j = 0; j < SEEY; j++ ) {
+            for( int i = 0; i < SEEX; i++ ) {
+                if( sm->fld[i][j].fieldCount() == 0 ) {
+                    continue;
+                }
+                field_tiles++;
+                fields.write<uint8_t>( i );
+                fields.write<uint8_t>( j );
+                fields.write<uint8_t>( sm->fld[i][j].fieldCount() );
+                for( auto &fld : sm->fld[i][j] ) {
+                    const field_entry &cur = fld.second;
+                    fields.write<int32_t>( cur.getFieldType() );
+                    fields.write<int32_t>( cur.getFieldDensity() );
+                    fields.write<int32_t>( cur.getFieldAge() );
+                }
+            }
         }
+        out.write( field_tiles );
+        out.buffer.append( fields.buffer );
 
-        // Output base camp if any
-        if (sm->camp.is_valid()) {
-            jsout.member( "camp" );
-            jsout.write( sm->camp.save_data() );
+        // Items and the rest are rare and complex enough that the JSON is fine for them.
+        binary_writer items;
+        uint32_t item_tiles = 0;
+        for( int j = 0; j < SEEY; j++ ) {
+            for( int i = 0; i < SEEX; i++ ) {
+                if( sm->itm[i][j].empty() ) {
+                    continue;
+                }
+                item_tiles++;
+                items.write<uint8_t>( i );
+                items.write<uint8_t>( j );
+                std::ostringstream tile_items;
+                JsonOut jsout( tile_items );
+                jsout.write( sm->itm[i][j] );
+                items.write_blob( tile_items.str() );
+            }
         }
+        out.write( item_tiles );
+        out.buffer.append( items.buffer );
+
+        std::ostringstream extras;
+        JsonOut jsout( extras );
+        jsout.start_object();
+        write_submap_extras( jsout, *sm );
+        jsout.end_object();
+        out.write_blob( extras.str() );
+
         if( delete_after_save ) {
             submaps_to_delete.push_back( submap_addr );
         }
-        jsout.end_object();
     }
+    return out.buffer;
+}
 
-    jsout.end_array();
-    fclose_exclusive( fout, filename.c_str() );
+void mapbuffer::unserialize_binary_quad( const char *data, size_t size )
+{
+    binary_reader in( data, size );
+    if( in.read<uint32_t>() != binary_quad_magic || in.read<uint32_t>() != binary_quad_version ) {
+        throw std::runtime_error( "not a binary map file of this version" );
+    }
+    const uint32_t count = in.read<uint32_t>();
+    for( uint32_t n = 0; n < count; n++ ) {
+        std::unique_ptr<submap> sm( new submap() );
+        tripoint submap_coordinates;
+        submap_coordinates.x = in.read<int32_t>();
+        submap_coordinates.y = in.read<int32_t>();
+        submap_coordinates.z = in.read<int32_t>();
+        // Only written by versions that need no migration, kept for future ones.
+        in.read<int32_t>();
+        sm->turn_last_touched = in.read<int32_t>();
+        sm->temperature = in.read<int32_t>();
+
+        read_rle<uint32_t>( in, [&]( int i, int j, uint32_t index ) {
+            sm->ter[i][j] = ter_id( resolve_binary_id( binary_ter, index, []( const std::string & id ) {
+                return terfind( id ).to_i();
+            } ) );
+        } );
+        read_rle<uint32_t>( in, [&]( int i, int j, uint32_t index ) {
+            sm->frn[i][j] = furn_id( resolve_binary_id( binary_furn, index, []( const std::string & id ) {
+                return furnmap[id].loadid.to_i();
+            } ) );
+        } );
+        read_rle<uint32_t>( in, [&]( int i, int j, uint32_t index ) {
+            sm->trp[i][j] = trap_id( resolve_binary_id( binary_trap, index, []( const std::string & id ) {
+                return trap_str_id( id ).id().to_i();
+            } ) );
+        } );
+        read_rle<int32_t>( in, [&]( int i, int j, int32_t radiation ) {
+            sm->set_radiation( i, j, radiation );
+        } );
+
+        const uint32_t field_tiles = in.read<uint32_t>();
+        for( uint32_t t = 0; t < field_tiles; t++ ) {
+            const int i = in.read<uint8_t>();
+            const int j = in.read<uint8_t>();
+            const int fields = in.read<uint8_t>();
+            for( int f = 0; f < fields; f++ ) {
+                const int type = in.read<int32_t>();
+                const int density = in.read<int32_t>();
+                const int age = in.read<int32_t>();
+                if( sm->fld[i][j].findField( field_id( type ) ) == NULL ) {
+                    sm->field_count++;
+                }
+                sm->fld[i][j].addField( field_id( type ), density, age );
+                sm->note_field( i, j );
+            }
+        }
+
+        const uint32_t item_tiles = in.read<uint32_t>();
+        for( uint32_t t = 0; t < item_tiles; t++ ) {
+            const int i = in.read<uint8_t>();
+            const int j = in.read<uint8_t>();
+            size_t blob_size;
+            const char *blob = in.read_blob( blob_size );
+            JsonIn jsin( blob, blob_size );
+            read_tile_items( jsin, *sm, i, j );
+        }
+
+        size_t blob_size;
+        const char *blob = in.read_blob( blob_size );
+        JsonIn jsin( blob, blob_size );
+        jsin.start_object();
+        while( !jsin.end_object() ) {
+            read_submap_extra( jsin, jsin.get_member_name(), *sm );
+        }
+
+        if( !add_submap( submap_coordinates, sm ) ) {
+            debugmsg( "submap %d,%d,%d was already loaded", submap_coordinates.x, submap_coordinates.y,
+                      submap_coordinates.z );
+        }
+    }
 }
 
 // We're reading in way too many entities here to mess around with creating sub-objects and
@@ -397,19 +1233,33 @@ submap *mapbuffer::unserialize_submaps( const tripoint &p )
 {
     // Map the tripoint to the submap quad that stores it.
     const tripoint om_addr = overmapbuffer::sm_to_omt_copy( p );
-    const tripoint segment_addr = overmapbuffer::omt_to_seg_copy( om_addr );
-    std::stringstream quad_path;
-    quad_path << world_generator->active_world->world_path << "/maps/" <<
-              segment_addr.x << "." << segment_addr.y << "." << segment_addr.z << "/" <<
-              om_addr.x << "." << om_addr.y << "." << om_addr.z << ".map";
-
-    std::ifstream fin( quad_path.str().c_str() );
-    if( !fin.is_open() ) {
+    bool binary = false;
+    bool current = false;
+    std::unique_ptr<quad_data> data;
+    if( !take_prefetched_quad( om_addr, data, binary, current ) ) {
+        data = read_quad( om_addr, binary, current );
+    }
+    if( !data ) {
         // If it doesn't exist, trigger generating it.
         return NULL;
     }
+    unserialize_quad( *data, binary );
+    check_storage_options();
+    if( current ) {
+        // Otherwise the next save moves it to the format and storage of the world's options.
+        mark_quad_saved( quad_submap_addrs( om_addr ) );
+    }
+    if( submaps.count( p ) == 0 ) {
+        debugmsg("quad %d,%d,%d did not contain the expected submap %d,%d,%d", om_addr.x, om_addr.y,
+                 om_addr.z, p.x, p.y, p.z);
+        return NULL;
+    }
+    return submaps[ p ];
+}
 
-    JsonIn jsin( fin );
+void mapbuffer::unserialize_json_quad( const char *data, size_t size )
+{
+    JsonIn jsin( data, size );
     jsin.start_array();
     while( !jsin.end_array() ) {
         std::unique_ptr<submap> sm(new submap());
@@ -503,19 +1353,7 @@ submap *mapbuffer::unserialize_submaps( const tripoint &p )
                 while( !jsin.end_array() ) {
                     int i = jsin.get_int();
                     int j = jsin.get_int();
-                    jsin.start_array();
-                    while( !jsin.end_array() ) {
-                        item tmp;
-                        jsin.read( tmp );
-                        if( tmp.is_emissive() ) {
-                            sm->update_lum_add(tmp, i, j);
-                        }
-
-                        sm->itm[i][j].push_back( tmp );
-                        if( tmp.needs_processing() ) {
-                            sm->active_items.add( std::prev(sm->itm[i][j].end()), point( i, j ) );
-                        }
-                    }
+                    read_tile_items( jsin, *sm, i, j );
                 }
             } else if( submap_member_name == "traps" ) {
                 jsin.start_array();
@@ -542,57 +1380,11 @@ submap *mapbuffer::unserialize_submaps( const tripoint &p )
                             sm->field_count++;
                         }
                         sm->fld[i][j].addField(field_id(type), density, age);
+                        sm->note_field( i, j );
                     }
                 }
-            } else if( submap_member_name == "graffiti" ) {
-                jsin.start_array();
-                while( !jsin.end_array() ) {
-                    jsin.start_array();
-                    int i = jsin.get_int();
-                    int j = jsin.get_int();
-                    sm->set_graffiti( i, j, jsin.get_string() );
-                    jsin.end_array();
-                }
-            } else if(submap_member_name == "cosmetics") {
-                jsin.start_array();
-                while (!jsin.end_array()) {
-                    jsin.start_array();
-                    int i = jsin.get_int();
-                    int j = jsin.get_int();
-                    jsin.read(sm->cosmetics[i][j]);
-                    jsin.end_array();
-                }
-            } else if( submap_member_name == "spawns" ) {
-                jsin.start_array();
-                while( !jsin.end_array() ) {
-                    jsin.start_array();
-                    const mtype_id type = mtype_id( jsin.get_string() ); // TODO: json should know how to read an string_id
-                    int count = jsin.get_int();
-                    int i = jsin.get_int();
-                    int j = jsin.get_int();
-                    int faction_id = jsin.get_int();
-                    int mission_id = jsin.get_int();
-                    bool friendly = jsin.get_bool();
-                    std::string name = jsin.get_string();
-                    jsin.end_array();
-                    spawn_point tmp( type, count, i, j, faction_id, mission_id, friendly, name );
-                    sm->spawns.push_back( tmp );
-                }
-            } else if( submap_member_name == "vehicles" ) {
-                jsin.start_array();
-                while( !jsin.end_array() ) {
-                    vehicle *tmp = new vehicle();
-                    jsin.read( *tmp );
-                    sm->vehicles.push_back( tmp );
-                }
-            } else if( submap_member_name == "computers" ) {
-                std::string computer_data = jsin.get_string();
-                sm->comp.load_data( computer_data );
-            } else if( submap_member_name == "camp" ) {
-                std::string camp_data = jsin.get_string();
-                sm->camp.load_data( camp_data );
             } else {
-                jsin.skip_value();
+                read_submap_extra( jsin, submap_member_name, *sm );
             }
         }
         if( !add_submap( submap_coordinates, sm ) ) {
@@ -600,10 +1392,4 @@ submap *mapbuffer::unserialize_submaps( const tripoint &p )
                       submap_coordinates.z );
         }
     }
-    if( submaps.count( p ) == 0 ) {
-        debugmsg("file %s did not contain the expected submap %d,%d,%d", quad_path.str().c_str(), p.x, p.y,
-                 p.z);
-        return NULL;
-    }
-    return submaps[ p ];
 }
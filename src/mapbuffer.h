@@ -2,13 +2,26 @@
 #define MAPBUFFER_H
 
 #include <map>
+#include <set>
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
+#include <unordered_map>
+#include <iosfwd>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
 #include "enums.h"
 struct point;
 struct tripoint;
 struct submap;
+class vehicle;
+class map_storage;
+class quad_data;
 
 /**
  * Store, buffer, save and load the entire world map.
@@ -24,12 +37,39 @@ class mapbuffer
         /** Store all submaps in this instance into savefiles.
          * @ref delete_after_save If true, the saved submaps are removed
          * from the mapbuffer (and deleted).
+         * Only quads with submaps modified since they were last loaded or saved
+         * are written, see @ref submap::is_modified.
+         * With the BACKGROUND_SAVING option the files are written by the
+         * @ref background_writer after this returns, submaps saved but not
+         * yet written are loaded from memory.
          **/
         void save( bool delete_after_save = false );
 
         /** Delete all buffered submaps. **/
         void reset();
 
+        /**
+         * Starts reading the quads holding these submaps on a background thread, so that
+         * @ref lookup_submap only has to parse them. Quads already loaded or requested are
+         * skipped, quads that were never saved are generated on lookup as usual.
+         */
+        void prefetch( const std::vector<tripoint> &submap_addrs );
+        /** Blocks until everything requested from @ref prefetch has been read. */
+        void wait_for_prefetch();
+        /** Lookups that found their quad read ahead. */
+        int prefetch_hits = 0;
+        /** Lookups that came before the quad they requested was read. */
+        int prefetch_misses = 0;
+
+        /**
+         * Rewrites all quads saved in the other format into the binary format or JSON,
+         * and moves all quads into the storage the world's PACK_MAPS option asks for.
+         * Quads already in this buffer are skipped, @ref save writes those in the format
+         * and storage the world's options ask for.
+         * @return The number of quads converted.
+         */
+        int convert_saved_quads( bool binary );
+
         /** Add a new submap to the buffer.
          *
          * @param x, y, z The absolute world position in submap coordinates.
@@ -57,6 +97,17 @@ class mapbuffer
         submap *lookup_submap( int x, int y, int z );
         submap *lookup_submap( const tripoint &p );
 
+        /**
+         * All vehicles on submaps in this buffer, along with the absolute position of their
+         * submap. Only submaps known to hold vehicles are looked at, not the whole buffer.
+         */
+        std::vector<std::pair<tripoint, vehicle *>> get_vehicles();
+        /**
+         * Notes that vehicles were placed on the submap at this absolute position, if it is
+         * in the buffer. Vehicles on a submap when it is added are noted by @ref add_submap.
+         */
+        void note_vehicles( const tripoint &p );
+
     private:
         typedef std::map<tripoint, submap *> submap_map_t;
 
@@ -73,10 +124,127 @@ class mapbuffer
         // if not handled carefully, this can erase in-use submaps and crash the game.
         void remove_submap( tripoint addr );
         submap *unserialize_submaps( const tripoint &p );
-        void save_quad( const std::string &dirname, const std::string &filename,
-                        const tripoint &om_addr, std::list<tripoint> &submaps_to_delete,
-                        bool delete_after_save );
+        /**
+         * The quad from whichever storage and format has it.
+         * @param current Set to whether it is stored the way the world's options ask for.
+         */
+        std::unique_ptr<quad_data> read_quad( const tripoint &om_addr, bool &binary, bool &current );
+        /** As above, with the world's options passed in, as the prefetch thread can't read them. */
+        std::unique_ptr<quad_data> read_quad( const tripoint &om_addr, bool packed, bool binary_maps,
+                                              bool &binary, bool &current );
+        void prefetch_work();
+        /** Hands over a quad read ahead, false if it wasn't (completely) read. */
+        bool take_prefetched_quad( const tripoint &om_addr, std::unique_ptr<quad_data> &data,
+                                   bool &binary, bool &current );
+        void forget_prefetched_quad( const tripoint &om_addr );
+        void stop_prefetching();
+        void unserialize_quad( const quad_data &data, bool binary );
+        void unserialize_json_quad( const char *data, size_t size );
+        /** Throws std::runtime_error on malformed data. */
+        void unserialize_binary_quad( const char *data, size_t size );
+        /** The four submaps of the quad, in the order they are saved. */
+        static std::vector<tripoint> quad_submap_addrs( const tripoint &om_addr );
+        /**
+         * @param only_modified Skip the quad if none of its submaps changed.
+         * @return Whether the quad was written.
+         */
+        bool save_quad( const tripoint &om_addr, std::list<tripoint> &submaps_to_delete,
+                        bool delete_after_save, bool binary, bool only_modified );
+        void mark_quad_saved( const std::vector<tripoint> &submap_addrs );
+        /**
+         * Notices the world's BINARY_MAPS and PACK_MAPS options changing, the next save then
+         * rewrites unmodified quads too.
+         */
+        void check_storage_options();
+        /**
+         * Queues storing the quad and removing it from the other storage and format. The
+         * saved submaps are moved to submaps_to_delete, the data is kept in
+         * @ref pending_quads until it has been written.
+         */
+        void write_quad( const tripoint &om_addr, bool binary, std::string data,
+                         std::list<tripoint> &saved_submaps, std::list<tripoint> &submaps_to_delete );
+        void queue_write( std::function<void()> job );
+        void wait_for_writes();
+        /** Queues @ref map_storage::flush for the end of a save. */
+        void flush_storage();
+        std::string serialize_binary_quad( const std::vector<tripoint> &submap_addrs,
+                                           std::list<tripoint> &submaps_to_delete,
+                                           bool delete_after_save );
+
+        static bool binary_maps_enabled();
+        static bool pack_files_enabled();
+        /** The pack or the one file per quad storage of the active world. */
+        map_storage &storage( bool packed );
+
+        /**
+         * Binary quads store terrain, furniture and traps as indices into a per world
+         * table of string ids, kept in one text file next to the map segments.
+         */
+        static std::string binary_ids_path();
+        void load_binary_ids();
+        void save_binary_ids();
+        uint32_t binary_id_index( const std::string &id );
+        const std::string &binary_id( uint32_t index );
+        template<typename F>
+        int resolve_binary_id( std::vector<int> &resolved, uint32_t index, F resolve );
+
         submap_map_t submaps;
+        /**
+         * Submaps that had vehicles placed on them, see @ref get_vehicles. Those that
+         * lost all their vehicles since are dropped when they are next looked at.
+         */
+        std::set<tripoint> vehicle_submaps;
+        bool storage_options_known = false;
+        bool stored_binary = false;
+        bool stored_packed = false;
+        bool rewrite_all_quads = false;
+        /** Used by queued writes, guarded by storage_mutex. */
+        std::unique_ptr<map_storage> file_storage;
+        std::unique_ptr<map_storage> pack_storage;
+        std::mutex storage_mutex;
+        bool writes_queued = false;
+
+        struct pending_quad {
+            bool binary;
+            std::shared_ptr<const std::string> data;
+        };
+        /** Quads saved but not written yet, guarded by pending_mutex. */
+        std::map<tripoint, pending_quad> pending_quads;
+        std::mutex pending_mutex;
+
+        struct prefetched_quad {
+            /** Results of requests that were dropped in the meantime are ignored. */
+            unsigned int ticket = 0;
+            bool done = false;
+            bool binary = false;
+            bool current = false;
+            std::unique_ptr<quad_data> data;
+        };
+        struct prefetch_request {
+            tripoint om_addr;
+            unsigned int ticket;
+            bool packed;
+            bool binary_maps;
+        };
+        /** Everything below is guarded by prefetch_mutex, requested quads are dropped when saved. */
+        std::map<tripoint, prefetched_quad> prefetched_quads;
+        std::deque<prefetch_request> prefetch_queue;
+        unsigned int last_prefetch_ticket = 0;
+        bool prefetch_stopping = false;
+        bool prefetch_busy = false;
+        std::mutex prefetch_mutex;
+        std::condition_variable prefetch_wake;
+        std::condition_variable prefetch_idle;
+        std::thread prefetch_thread;
+
+        std::vector<std::string> binary_ids;
+        std::unordered_map<std::string, uint32_t> binary_id_indices;
+        bool binary_ids_loaded = false;
+        bool binary_ids_changed = false;
+        /** Table index to int id of the type, -1 until first used. */
+        std::vector<int> binary_ter;
+        std::vector<int> binary_furn;
+        std::vector<int> binary_trap;
 };
 
 extern mapbuffer MAPBUFFER;
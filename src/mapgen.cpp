@@ -10,6 +10,7 @@
 #include "mapgen_functions.h"
 #include "mapgenformat.h"
 #include "mapbuffer.h"
+#include "vehicle_scheduler.h"
 #include "overmapbuffer.h"
 #include "enums.h"
 #include "monstergenerator.h"
@@ -11668,6 +11669,7 @@ void map::add_spawn(const mtype_id& type, int count, int x, int y, bool friendly
     }
     spawn_point tmp(type, count, offset_x, offset_y, faction_id, mission_id, friendly, name);
     place_on_submap->spawns.push_back(tmp);
+    place_on_submap->set_modified();
 }
 
 vehicle *map::add_vehicle(const vproto_id &type, const int x, const int y, const int dir,
@@ -11725,9 +11727,13 @@ vehicle *map::add_vehicle(const vproto_id &type, const tripoint &p, const int di
         submap *place_on_submap = get_submap_at_grid( placed_vehicle->smx, placed_vehicle->smy, placed_vehicle->smz );
         place_on_submap->vehicles.push_back(placed_vehicle);
         place_on_submap->is_uniform = false;
+        place_on_submap->set_modified();
+        MAPBUFFER.note_vehicles( tripoint( abs_sub.x + placed_vehicle->smx,
+                                           abs_sub.y + placed_vehicle->smy, placed_vehicle->smz ) );
 
         auto &ch = get_cache( placed_vehicle->smz );
         ch.vehicle_list.insert(placed_vehicle);
+        vehicle_schedule->invalidate();
         add_vehicle_to_cache( placed_vehicle );
 
         //debugmsg ("grid[%d]->vehicles.size=%d veh.parts.size=%d", nonant, grid[nonant]->vehicles.size(),veh.parts.size());
@@ -11858,6 +11864,7 @@ computer *map::add_computer( const tripoint &p, std::string name, int security )
     ter_set( p, t_console ); // TODO: Turn this off?
     submap *place_on_submap = get_submap_at( p );
     place_on_submap->comp = computer(name, security);
+    place_on_submap->set_modified();
     return &(place_on_submap->comp);
 }
 
@@ -11948,6 +11955,7 @@ void map::rotate(int turns)
             int new_lx, new_ly;
             const auto new_sm = get_submap_at( new_x, new_y, new_lx, new_ly );
             new_sm->is_uniform = false;
+            new_sm->set_modified();
             std::swap( rotated[old_x][old_y], new_sm->ter[new_lx][new_ly] );
             std::swap( furnrot[old_x][old_y], new_sm->frn[new_lx][new_ly] );
             std::swap( traprot[old_x][old_y], new_sm->trp[new_lx][new_ly] );
@@ -12077,10 +12085,14 @@ void map::rotate(int turns)
             int lx, ly;
             const auto sm = get_submap_at( i, j, lx, ly );
             sm->is_uniform = false;
+            sm->set_modified();
             std::swap( rotated[i][j], sm->ter[lx][ly] );
             std::swap( furnrot[i][j], sm->frn[lx][ly] );
             std::swap( traprot[i][j], sm->trp[lx][ly] );
             std::swap( fldrot[i][j], sm->fld[lx][ly] );
+            if( sm->fld[lx][ly].fieldCount() > 0 ) {
+                sm->note_field( lx, ly );
+            }
             std::swap( radrot[i][j], sm->rad[lx][ly] );
             std::swap( cosmetics_rot[i][j], sm->cosmetics[lx][ly] );
             for( auto &itm : itrot[i][j] ) {
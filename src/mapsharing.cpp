@@ -1,5 +1,7 @@
 #include "mapsharing.h"
 
+#include <mutex>
+
 bool MAP_SHARING::sharing;
 bool MAP_SHARING::competitive;
 bool MAP_SHARING::worldmenu;
@@ -130,13 +132,19 @@ void releaseLock( int fd, char const *lockName )
 #endif // __linux__
 
 std::map<std::string, int> lockFiles;
+// Save files are also written by the background_writer thread.
+static std::mutex lockFilesMutex;
 
 void fopen_exclusive(std::ofstream &fout, const char *filename,
                      std::ios_base::openmode mode)   //TODO: put this in an ofstream_exclusive class?
 {
     std::string lockfile = std::string(filename) + ".lock";
-    lockFiles[lockfile] = getLock(lockfile.c_str());
-    if(lockFiles[lockfile] != -1) {
+    const int lock = getLock(lockfile.c_str());
+    {
+        std::lock_guard<std::mutex> guard( lockFilesMutex );
+        lockFiles[lockfile] = lock;
+    }
+    if(lock != -1) {
         fout.open(filename, mode);
     }
 }
@@ -155,6 +163,11 @@ void fclose_exclusive(std::ofstream &fout, const char *filename)
 {
     std::string lockFile = std::string(filename) + ".lock";
     fout.close();
-    releaseLock(lockFiles[lockFile], lockFile.c_str());
-    lockFiles[lockFile] = -1;
+    int lock;
+    {
+        std::lock_guard<std::mutex> guard( lockFilesMutex );
+        lock = lockFiles[lockFile];
+        lockFiles[lockFile] = -1;
+    }
+    releaseLock(lock, lockFile.c_str());
 }
@@ -18,11 +18,22 @@
 #include "mapdata.h"
 #include "mtype.h"
 #include "field.h"
+#include "pathfinding.h"
+#include "scent_map.h"
+#include "creature_tracker.h"
+#include "calendar.h"
 
 #include <stdlib.h>
 //Used for e^(x) functions
 #include <stdio.h>
 #include <math.h>
+#include <algorithm>
+
+const effect_id effect_bouldering( "bouldering" );
+const effect_id effect_docile( "docile" );
+const effect_id effect_pacified( "pacified" );
+const effect_id effect_pushed( "pushed" );
+const effect_id effect_stunned( "stunned" );
 
 #define MONSTER_FOLLOW_DIST 8
 
@@ -102,19 +113,29 @@ void monster::wander_to( const tripoint &p, int f )
     wandf = f;
 }
 
-float monster::rate_target( Creature &c, float best, bool smart ) const
+int monster::target_distance( const Creature &c, float best, bool smart ) const
 {
     const int d = rl_dist( pos3(), c.pos3() );
     if( d <= 0 ) {
-        return INT_MAX;
+        return -1;
     }
 
     // Check a very common and cheap case first
     if( !smart && d >= best ) {
-        return INT_MAX;
+        return -1;
     }
 
     if( !sees( c ) ) {
+        return -1;
+    }
+
+    return d;
+}
+
+float monster::rate_target( Creature &c, float best, bool smart ) const
+{
+    const int d = target_distance( c, best, smart );
+    if( d < 0 ) {
         return INT_MAX;
     }
 
@@ -132,7 +153,78 @@ float monster::rate_target( Creature &c, float best, bool smart ) const
     return INT_MAX;
 }
 
-void monster::plan( const mfactions &factions )
+float monster::rate_target( monster &mon, const monster_targets::candidate &cand, float best,
+                            bool smart ) const
+{
+    const int d = target_distance( mon, best, smart );
+    if( d < 0 ) {
+        return INT_MAX;
+    }
+
+    // Same as mon.attitude_to( *this ) == A_HOSTILE, from the snapshot.
+    bool hostile = false;
+    if( &mon != this && cand.aggressive ) {
+        if( cand.friendly || friendly != 0 ) {
+            // Friendly (to player) monsters are friendly to each other
+            hostile = !cand.friendly || friendly == 0;
+        } else {
+            const auto faction_att = cand.faction.obj().attitude( faction );
+            hostile = faction_att != MFA_FRIENDLY && faction_att != MFA_NEUTRAL;
+        }
+    }
+
+    const float power = cand.power + ( hostile ? 2 : 0 );
+    if( power > 0 ) {
+        return d / power;
+    }
+
+    return INT_MAX;
+}
+
+void monster_targets::build()
+{
+    const mfaction_id playerfaction = mfaction_str_id( "player" );
+    std::map<mfaction_id, std::vector<int>> by_team;
+    candidates.clear();
+    for( int i = 0, numz = g->num_zombies(); i < numz; i++ ) {
+        const monster &critter = g->zombie( i );
+        candidate cand;
+        cand.team = 0;
+        cand.faction = critter.faction;
+        cand.friendly = critter.friendly != 0;
+        cand.aggressive = critter.morale >= 0 && critter.anger >= 10;
+        cand.power = critter.power_rating();
+        candidates.push_back( cand );
+        // Only 1 faction per mon at the moment.
+        by_team[ cand.friendly ? playerfaction : critter.faction ].push_back( i );
+    }
+
+    teams.clear();
+    members.clear();
+    for( const auto &elem : by_team ) {
+        team t;
+        t.faction = elem.first;
+        t.begin = members.size();
+        for( const int i : elem.second ) {
+            candidates[i].team = teams.size();
+            members.push_back( i );
+        }
+        t.end = members.size();
+        teams.push_back( t );
+    }
+}
+
+int monster_targets::find_team( const mfaction_id &faction ) const
+{
+    for( size_t i = 0; i < teams.size(); i++ ) {
+        if( teams[i].faction == faction ) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void monster::plan( const monster_targets &targets )
 {
     // Bots are more intelligent than most living stuff
     bool electronic = has_flag( MF_ELECTRONIC );
@@ -140,13 +232,19 @@ void monster::plan( const mfactions &factions )
     // 8.6f is rating for tank drone 60 tiles away, moose 16 or boomer 33
     float dist = !electronic ? 1000 : 8.6f;
     bool fleeing = false;
-    bool docile = has_flag( MF_VERMIN ) || ( friendly != 0 && has_effect( "docile" ) );
-    bool angers_hostile_weak = type->anger.find( MTRIG_HOSTILE_WEAK ) != type->anger.end();
-    int angers_hostile_near = ( type->anger.find( MTRIG_HOSTILE_CLOSE ) != type->anger.end() ) ? 5 : 0;
-    int fears_hostile_near = ( type->fear.find( MTRIG_HOSTILE_CLOSE ) != type->fear.end() ) ? 5 : 0;
+    bool docile = has_flag( MF_VERMIN ) || ( friendly != 0 && has_effect( effect_docile ) );
+    bool angers_hostile_weak = type->has_anger_trigger( MTRIG_HOSTILE_WEAK );
+    int angers_hostile_near = type->has_anger_trigger( MTRIG_HOSTILE_CLOSE ) ? 5 : 0;
+    int fears_hostile_near = type->has_fear_trigger( MTRIG_HOSTILE_CLOSE ) ? 5 : 0;
     bool group_morale = has_flag( MF_GROUP_MORALE ) && morale < type->morale;
     bool swarms = has_flag( MF_SWARMS );
     auto mood = attitude();
+    // rate_target ignores what we can't see, and nothing farther away than this can be seen.
+    const int max_sight = std::max( 1, sight_range( DAYLIGHT_LEVEL ) );
+    std::vector<int> nearby = g->critter_tracker->in_radius( pos(), max_sight );
+    // Those that weren't around for the snapshot aren't targets yet.
+    nearby.erase( std::lower_bound( nearby.begin(), nearby.end(), int( targets.candidates.size() ) ),
+                  nearby.end() );
 
     // If we can see the player, move toward them or flee.
     if( friendly == 0 && sees( g->u ) ) {
@@ -159,10 +257,11 @@ void monster::plan( const mfactions &factions )
         }
     } else if( friendly != 0 && !docile ) {
         // Target unfriendly monsters, only if we aren't interacting with the player.
-        for( int i = 0, numz = g->num_zombies(); i < numz; i++ ) {
+        for( const int i : nearby ) {
             monster &tmp = g->zombie( i );
-            if( tmp.friendly == 0 ) {
-                float rating = rate_target( tmp, dist, electronic );
+            const auto &cand = targets.candidates[i];
+            if( !cand.friendly ) {
+                float rating = rate_target( tmp, cand, dist, electronic );
                 if( rating < dist ) {
                     target = &tmp;
                     dist = rating;
@@ -199,15 +298,19 @@ void monster::plan( const mfactions &factions )
 
     fleeing = fleeing || ( mood == MATT_FLEE );
     if( friendly == 0 ) {
-        for( const auto &fac : factions ) {
-            auto faction_att = faction.obj().attitude( fac.first );
+        for( size_t t = 0; t < targets.teams.size(); t++ ) {
+            auto faction_att = faction.obj().attitude( targets.teams[t].faction );
             if( faction_att == MFA_NEUTRAL || faction_att == MFA_FRIENDLY ) {
                 continue;
             }
 
-            for( int i : fac.second ) { // mon indices
+            for( const int i : nearby ) {
+                const auto &cand = targets.candidates[i];
+                if( cand.team != t ) {
+                    continue;
+                }
                 monster &mon = g->zombie( i );
-                float rating = rate_target( mon, dist, electronic );
+                float rating = rate_target( mon, cand, dist, electronic );
                 if( rating < dist ) {
                     target = &mon;
                     dist = rating;
@@ -223,8 +326,8 @@ void monster::plan( const mfactions &factions )
     // Friendly monsters here
     // Avoid for hordes of same-faction stuff or it could get expensive
     const auto actual_faction = friendly == 0 ? faction : mfaction_str_id( "player" );
-    auto const &myfaction_iter = factions.find( actual_faction );
-    if( myfaction_iter == factions.end() ) {
+    const int myteam = targets.find_team( actual_faction );
+    if( myteam < 0 ) {
         DebugLog( D_ERROR, D_GAME ) << disp_name() << " tried to find faction "
                                     << actual_faction.id().str() << " which wasn't loaded in game::monmove";
         swarms = false;
@@ -232,9 +335,13 @@ void monster::plan( const mfactions &factions )
     }
     swarms = swarms && target == nullptr; // Only swarm if we have no target
     if( group_morale || swarms ) {
-        for( const int i : myfaction_iter->second ) {
+        for( const int i : nearby ) {
+            const auto &cand = targets.candidates[i];
+            if( int( cand.team ) != myteam ) {
+                continue;
+            }
             monster &mon = g->zombie( i );
-            float rating = rate_target( mon, dist, electronic );
+            float rating = rate_target( mon, cand, dist, electronic );
             if( group_morale && rating <= 10 ) {
                 morale += 10 - rating;
             }
@@ -280,6 +387,39 @@ void monster::plan( const mfactions &factions )
     }
 }
 
+monster::plan_result monster::decide_plan( const monster_targets &targets )
+{
+    plan_result before;
+    before.goal = goal;
+    before.wander_pos = wander_pos;
+    before.wandf = wandf;
+    before.anger = anger;
+    before.morale = morale;
+    before.friendly = friendly;
+
+    plan( targets );
+    plan_result result;
+    result.goal = goal;
+    result.wander_pos = wander_pos;
+    result.wandf = wandf;
+    result.anger = anger;
+    result.morale = morale;
+    result.friendly = friendly;
+
+    apply_plan( before );
+    return result;
+}
+
+void monster::apply_plan( const plan_result &result )
+{
+    goal = result.goal;
+    wander_pos = result.wander_pos;
+    wandf = result.wandf;
+    anger = result.anger;
+    morale = result.morale;
+    friendly = result.friendly;
+}
+
 // This is a table of moves spent to stagger in different directions.
 // It was empirically derived by spawning monsters and having them proceed
 // to a destination and recording the moves required. See tests/monster_test.cpp for details.
@@ -480,8 +620,7 @@ void monster::move()
         }
     }
 
-    static const std::string pacified_string = "pacified";
-    const bool pacified = has_effect( pacified_string );
+    const bool pacified = has_effect( effect_pacified );
 
     // First, use the special attack, if we can!
     for( size_t i = 0; i < sp_timeout.size(); ++i ) {
@@ -514,8 +653,7 @@ void monster::move()
         moves = 0;
         return;
     }
-    static const std::string stun_string = "stunned";
-    if( has_effect( stun_string ) ) {
+    if( has_effect( effect_stunned ) ) {
         stumble();
         moves = 0;
         return;
@@ -526,13 +664,17 @@ void monster::move()
 
     // Set attitude to attitude to our current target
     monster_attitude current_attitude = attitude( nullptr );
+    // Heading for the player or an NPC, who have flow fields to walk around obstacles
+    bool chasing = false;
     if( !wander() ) {
         if( goal == g->u.pos3() ) {
             current_attitude = attitude( &( g->u ) );
+            chasing = true;
         } else {
             for( auto &i : g->active_npc ) {
                 if( goal == i->pos3() ) {
                     current_attitude = attitude( i );
+                    chasing = true;
                 }
             }
         }
@@ -582,37 +724,60 @@ void monster::move()
         // This is a float and using trig_dist() because that Does the Right Thing(tm)
         // in both circular and roguelike distance modes.
         const float distance_to_target = trig_dist( pos(), destination );
-        for( const tripoint &candidate : squares_closer_to( pos(), destination ) ) {
-            const Creature *target = g->critter_at( candidate, is_hallucination() );
-            // When attacking an adjacent enemy, we're direct.
-            if( target != nullptr && attitude_to( *target ) == A_HOSTILE ) {
-                moved = true;
-                next_step = candidate;
-                break;
-            }
-            // Bail out if we can't move there and we can't bash.
-            if( !can_move_to( candidate ) &&
-                !(can_bash && g->m.bash_rating( bash_estimate(), candidate ) >= 0 ) ) {
-                continue;
-            }
-            // Bail out if there's a non-hostile monster in the way and we're not pushy.
-            if( target != nullptr && attitude_to( *target ) != A_HOSTILE &&
-                !has_flag( MF_ATTACKMON ) && !has_flag( MF_PUSH_MON ) ) {
-                continue;
+        const std::vector<tripoint> candidates = squares_closer_to( pos(), destination );
+        // Next to something we can't get through, walk around it if there is a way to the target.
+        // Following the field until clear of the obstacle keeps us from backtracking along it.
+        const auto obstacle = [&]( const tripoint &candidate ) {
+            return !can_move_to( candidate ) &&
+                   g->critter_at( candidate, is_hallucination() ) == nullptr &&
+                   !( can_bash && g->m.bash_rating( bash_estimate(), candidate ) > 0 );
+        };
+        if( chasing && std::any_of( candidates.begin(), candidates.end(), obstacle ) ) {
+            const flow_field &field = g->m.get_flow_field( destination );
+            uint16_t best = field.distance( pos() );
+            for( const tripoint &candidate : g->m.points_in_radius( pos(), 1 ) ) {
+                const uint16_t dist = field.distance( candidate );
+                if( dist < best && can_move_to( candidate ) &&
+                    g->critter_at( candidate, is_hallucination() ) == nullptr ) {
+                    best = dist;
+                    moved = true;
+                    next_step = candidate;
+                }
             }
-            const float progress = distance_to_target - trig_dist( candidate, destination );
-            // The x2 makes the first (and most direct) path twice as likely,
-            // since the chance of switching is 1/1, 1/4, 1/6, 1/8
-            switch_chance += progress * 2;
-            // Randomly pick one of the viable squares to move to weighted by distance.
-            if( moved == false || x_in_y( progress, switch_chance ) ) {
-                moved = true;
-                next_step = candidate;
-                // If we stumble, pick a random square, otherwise take the first one,
-                // which is the most direct path.
-                if( !staggers ) {
+        }
+        if( !moved ) {
+            for( const tripoint &candidate : candidates ) {
+                const Creature *target = g->critter_at( candidate, is_hallucination() );
+                // When attacking an adjacent enemy, we're direct.
+                if( target != nullptr && attitude_to( *target ) == A_HOSTILE ) {
+                    moved = true;
+                    next_step = candidate;
                     break;
                 }
+                // Bail out if we can't move there and we can't bash.
+                if( !can_move_to( candidate ) &&
+                    !(can_bash && g->m.bash_rating( bash_estimate(), candidate ) >= 0 ) ) {
+                    continue;
+                }
+                // Bail out if there's a non-hostile monster in the way and we're not pushy.
+                if( target != nullptr && attitude_to( *target ) != A_HOSTILE &&
+                    !has_flag( MF_ATTACKMON ) && !has_flag( MF_PUSH_MON ) ) {
+                    continue;
+                }
+                const float progress = distance_to_target - trig_dist( candidate, destination );
+                // The x2 makes the first (and most direct) path twice as likely,
+                // since the chance of switching is 1/1, 1/4, 1/6, 1/8
+                switch_chance += progress * 2;
+                // Randomly pick one of the viable squares to move to weighted by distance.
+                if( moved == false || x_in_y( progress, switch_chance ) ) {
+                    moved = true;
+                    next_step = candidate;
+                    // If we stumble, pick a random square, otherwise take the first one,
+                    // which is the most direct path.
+                    if( !staggers ) {
+                        break;
+                    }
+                }
             }
         }
     }
@@ -683,17 +848,17 @@ tripoint monster::scent_move()
 
     const bool fleeing = is_fleeing( g->u );
     if( fleeing ) {
-        bestsmell = g->scent( pos() );
+        bestsmell = g->scent.get( pos() );
     }
 
     tripoint next( -1, -1, posz() );
-    if( ( !fleeing && g->scent( pos() ) > smell_threshold ) ||
+    if( ( !fleeing && g->scent.get( pos() ) > smell_threshold ) ||
         ( fleeing && bestsmell == 0 ) ) {
         return next;
     }
     const bool can_bash = has_flag( MF_BASHES ) || has_flag( MF_BORES );
     for( const auto &dest : g->m.points_in_radius( pos(), 1 ) ) {
-        int smell = g->scent( dest );
+        int smell = g->scent.get( dest );
         if( ( can_move_to( dest ) || ( dest == g->u.pos3() ) ||
               ( can_bash && g->m.bash_rating( bash_estimate(), dest ) > 0 ) ) ) {
             if( ( !fleeing && smell > bestsmell ) || ( fleeing && smell < bestsmell ) ) {
@@ -1139,7 +1304,7 @@ bool monster::move_to( const tripoint &p, bool force, const float stagger_adjust
 
     if( g->m.has_flag( "UNSTABLE", p ) && on_ground ) {
         add_effect( "bouldering", 1, num_bp, true );
-    } else if( has_effect( "bouldering" ) ) {
+    } else if( has_effect( effect_bouldering ) ) {
         remove_effect( "bouldering" );
     }
     g->m.creature_on_trap( *this );
@@ -1203,7 +1368,7 @@ bool monster::push_to( const tripoint &p, const int boost, const size_t depth )
         return false;
     }
 
-    if( !has_flag( MF_PUSH_MON ) || depth > 2 || has_effect( "pushed" ) ) {
+    if( !has_flag( MF_PUSH_MON ) || depth > 2 || has_effect( effect_pushed ) ) {
         return false;
     }
 
@@ -1512,8 +1677,8 @@ bool monster::will_reach( int x, int y )
         return false;
     }
 
-    if( has_flag( MF_SMELLS ) && g->scent( pos3() ) > 0 &&
-        g->scent( { x, y, posz() } ) > g->scent( pos3() ) ) {
+    if( has_flag( MF_SMELLS ) && g->scent.get( pos3() ) > 0 &&
+        g->scent.get( { x, y, posz() } ) > g->scent.get( pos3() ) ) {
         return true;
     }
 
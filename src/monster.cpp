@@ -83,6 +83,25 @@ const species_id FUNGUS( "FUNGUS" );
 const species_id INSECT( "INSECT" );
 const species_id MAMMAL( "MAMMAL" );
 
+const effect_id effect_beartrap( "beartrap" );
+const effect_id effect_blind( "blind" );
+const effect_id effect_bouldering( "bouldering" );
+const effect_id effect_crushed( "crushed" );
+const effect_id effect_deaf( "deaf" );
+const effect_id effect_docile( "docile" );
+const effect_id effect_downed( "downed" );
+const effect_id effect_grabbed( "grabbed" );
+const effect_id effect_heavysnare( "heavysnare" );
+const effect_id effect_in_pit( "in_pit" );
+const effect_id effect_lightsnare( "lightsnare" );
+const effect_id effect_onfire( "onfire" );
+const effect_id effect_pacified( "pacified" );
+const effect_id effect_run( "run" );
+const effect_id effect_shrieking( "shrieking" );
+const effect_id effect_stunned( "stunned" );
+const effect_id effect_tied( "tied" );
+const effect_id effect_webbed( "webbed" );
+
 monster::monster()
 {
     position.x = 20;
@@ -404,15 +423,15 @@ int monster::print_info(WINDOW* w, int vStart, int vLines, int column) const
     get_Attitude(color, attitude);
     wprintz(w, color, "%s", attitude.c_str());
 
-    if (has_effect("downed")) {
+    if (has_effect( effect_downed )) {
         wprintz(w, h_white, _("On ground"));
-    } else if (has_effect("stunned")) {
+    } else if (has_effect( effect_stunned )) {
         wprintz(w, h_white, _("Stunned"));
-    } else if (has_effect("lightsnare") || has_effect("heavysnare") || has_effect("beartrap")) {
+    } else if (has_effect( effect_lightsnare ) || has_effect( effect_heavysnare ) || has_effect( effect_beartrap )) {
         wprintz(w, h_white, _("Trapped"));
-    } else if (has_effect("tied")) {
+    } else if (has_effect( effect_tied )) {
         wprintz(w, h_white, _("Tied"));
-    } else if (has_effect("shrieking")) {
+    } else if (has_effect( effect_shrieking )) {
         wprintz(w, h_white, _("Shrieking"));
     }
     std::string damage_info;
@@ -473,14 +492,14 @@ bool monster::is_symbol_highlighted() const
 nc_color monster::color_with_effects() const
 {
     nc_color ret = type->color;
-    if (has_effect("beartrap") || has_effect("stunned") || has_effect("downed") || has_effect("tied") ||
-          has_effect("lightsnare") || has_effect("heavysnare")) {
+    if (has_effect( effect_beartrap ) || has_effect( effect_stunned ) || has_effect( effect_downed ) || has_effect( effect_tied ) ||
+          has_effect( effect_lightsnare ) || has_effect( effect_heavysnare )) {
         ret = hilite(ret);
     }
-    if (has_effect("pacified")) {
+    if (has_effect( effect_pacified )) {
         ret = invert_color(ret);
     }
-    if (has_effect("onfire")) {
+    if (has_effect( effect_onfire )) {
         ret = red_background(ret);
     }
     return ret;
@@ -504,12 +523,12 @@ bool monster::has_flag(const m_flag f) const
 
 bool monster::can_see() const
 {
- return has_flag(MF_SEES) && !has_effect("blind");
+ return has_flag(MF_SEES) && !has_effect( effect_blind );
 }
 
 bool monster::can_hear() const
 {
- return has_flag(MF_HEARS) && !has_effect("deaf");
+ return has_flag(MF_HEARS) && !has_effect( effect_deaf );
 }
 
 bool monster::can_submerge() const
@@ -533,7 +552,7 @@ bool monster::can_act() const
 {
     return moves > 0 &&
         ( effects.empty() ||
-          ( !has_effect("stunned") && !has_effect("downed") && !has_effect("webbed") ) );
+          ( !has_effect( effect_stunned ) && !has_effect( effect_downed ) && !has_effect( effect_webbed ) ) );
 }
 
 
@@ -609,7 +628,7 @@ Creature *monster::attack_target()
 
 bool monster::is_fleeing(player &u) const
 {
-    if( has_effect("run") ) {
+    if( has_effect( effect_run ) ) {
         return true;
     }
     monster_attitude att = attitude(&u);
@@ -662,7 +681,7 @@ Creature::Attitude monster::attitude_to( const Creature &other ) const
 monster_attitude monster::attitude(player *u) const
 {
     if( friendly != 0 ) {
-        if( has_effect( "docile" ) ) {
+        if( has_effect( effect_docile ) ) {
             return MATT_FPASSIVE;
         }
         if( u == &g->u ) {
@@ -674,10 +693,10 @@ monster_attitude monster::attitude(player *u) const
             return MATT_FRIEND;
         }
     }
-    if (has_effect("run")) {
+    if (has_effect( effect_run )) {
         return MATT_FLEE;
     }
-    if (has_effect("pacified")) {
+    if (has_effect( effect_pacified )) {
         return MATT_ZLAVE;
     }
 
@@ -1224,17 +1243,17 @@ void monster::die_by_bfg9000(Creature* source)
 bool monster::move_effects(bool attacking)
 {
     bool u_see_me = g->u.sees(*this);
-    if (has_effect("tied")) {
+    if (has_effect( effect_tied )) {
         return false;
     }
-    if (has_effect("downed")) {
+    if (has_effect( effect_downed )) {
         remove_effect("downed");
         if (u_see_me) {
             add_msg(_("The %s climbs to its feet!"), name().c_str());
         }
         return false;
     }
-    if (has_effect("webbed")) {
+    if (has_effect( effect_webbed )) {
         if (x_in_y(type->melee_dice * type->melee_sides, 6 * get_effect_int("webbed"))) {
             if (u_see_me) {
                 add_msg(_("The %s breaks free of the webs!"), name().c_str());
@@ -1243,7 +1262,7 @@ bool monster::move_effects(bool attacking)
         }
         return false;
     }
-    if (has_effect("lightsnare")) {
+    if (has_effect( effect_lightsnare )) {
         if(x_in_y(type->melee_dice * type->melee_sides, 12)) {
             remove_effect("lightsnare");
             g->m.spawn_item(posx(), posy(), "string_36");
@@ -1254,7 +1273,7 @@ bool monster::move_effects(bool attacking)
         }
         return false;
     }
-    if (has_effect("heavysnare")) {
+    if (has_effect( effect_heavysnare )) {
         if (type->melee_dice * type->melee_sides >= 7) {
             if(x_in_y(type->melee_dice * type->melee_sides, 32)) {
                 remove_effect("heavysnare");
@@ -1267,7 +1286,7 @@ bool monster::move_effects(bool attacking)
         }
         return false;
     }
-    if (has_effect("beartrap")) {
+    if (has_effect( effect_beartrap )) {
         if (type->melee_dice * type->melee_sides >= 18) {
             if(x_in_y(type->melee_dice * type->melee_sides, 200)) {
                 remove_effect("beartrap");
@@ -1279,7 +1298,7 @@ bool monster::move_effects(bool attacking)
         }
         return false;
     }
-    if (has_effect("crushed")) {
+    if (has_effect( effect_crushed )) {
         // Strength helps in getting free, but dex also helps you worm your way out of the rubble
         if(x_in_y(type->melee_dice * type->melee_sides, 100)) {
             remove_effect("crushed");
@@ -1292,7 +1311,7 @@ bool monster::move_effects(bool attacking)
 
     // If we ever get more effects that force movement on success this will need to be reworked to
     // only trigger success effects if /all/ rolls succeed
-    if (has_effect("in_pit")) {
+    if (has_effect( effect_in_pit )) {
         if (rng(0, 40) > type->melee_dice * type->melee_sides) {
             return false;
         } else {
@@ -1302,7 +1321,7 @@ bool monster::move_effects(bool attacking)
             remove_effect("in_pit");
         }
     }
-    if (has_effect("grabbed")){
+    if (has_effect( effect_grabbed )){
         if ( (dice(type->melee_dice + type->melee_sides, 3) < get_effect_int("grabbed")) || !one_in(4) ){
             return false;
         } else {
@@ -1347,7 +1366,7 @@ int monster::get_armor_bash(body_part bp) const
 
 int monster::hit_roll() const {
     //Unstable ground chance of failure
-    if (has_effect("bouldering")) {
+    if (has_effect( effect_bouldering )) {
         if(one_in(type->melee_skill)) {
             return 0;
         }
@@ -1382,7 +1401,7 @@ int monster::stability_roll() const
     }
 
     int stability = dice(type->melee_sides, type->melee_dice) + size_bonus;
-    if( has_effect( "stunned" ) ) {
+    if( has_effect( effect_stunned ) ) {
         stability -= rng( 1, 5 );
     }
     return stability;
@@ -1390,11 +1409,11 @@ int monster::stability_roll() const
 
 int monster::get_dodge() const
 {
-    if (has_effect("downed")) {
+    if (has_effect( effect_downed )) {
         return 0;
     }
     int ret = type->sk_dodge;
-    if (has_effect("lightsnare") || has_effect("heavysnare") || has_effect("beartrap") || has_effect("tied")) {
+    if (has_effect( effect_lightsnare ) || has_effect( effect_heavysnare ) || has_effect( effect_beartrap ) || has_effect( effect_tied )) {
         ret /= 2;
     }
     if (moves <= 0 - 100 - get_speed()) {
@@ -1410,7 +1429,7 @@ int monster::get_melee() const
 
 int monster::dodge_roll()
 {
-    if (has_effect("bouldering")) {
+    if (has_effect( effect_bouldering )) {
         if(one_in(type->sk_dodge)) {
             return 0;
         }
@@ -1631,19 +1650,19 @@ void monster::die(Creature* nkiller) {
         }
     }
     // We were tied up at the moment of death, add a short rope to inventory
-    if ( has_effect("tied") ) {
+    if ( has_effect( effect_tied ) ) {
         item rope_6("rope_6", 0);
         add_item(rope_6);
     }
-    if( has_effect( "lightsnare" ) ) {
+    if( has_effect( effect_lightsnare ) ) {
         add_item( item( "string_36", 0 ) );
         add_item( item( "snare_trigger", 0 ) );
     }
-    if( has_effect( "heavysnare" ) ) {
+    if( has_effect( effect_heavysnare ) ) {
         add_item( item( "rope_6", 0 ) );
         add_item( item( "snare_trigger", 0 ) );
     }
-    if( has_effect( "beartrap" ) ) {
+    if( has_effect( effect_beartrap ) ) {
         add_item( item( "beartrap", 0 ) );
     }
 
@@ -17,8 +17,6 @@ enum monster_trigger : int;
 using mfaction_id = int_id<monfaction>;
 using mtype_id = string_id<mtype>;
 
-typedef std::map< mfaction_id, std::set< int > > mfactions;
-
 enum monster_attitude {
     MATT_NULL = 0,
     MATT_FRIEND,
@@ -31,6 +29,48 @@ enum monster_attitude {
     NUM_MONSTER_ATTITUDES
 };
 
+/**
+ * What @ref monster::plan needs to know about the other monsters, collected once by
+ * game::monmove instead of every monster looking it up again.
+ *
+ * Monsters that are friendly to the player are all on the player's team, the others are on
+ * the team of their faction. Monsters spawned after @ref build are not in here and are not
+ * considered as targets until the next build.
+ */
+class monster_targets
+{
+    public:
+        struct candidate {
+            /** Index into @ref teams. */
+            size_t team;
+            /** The monsters own faction, even if it's on the player's team. */
+            mfaction_id faction;
+            bool friendly;
+            /** Not too scared or calm to attack, see @ref monster::attitude_to. */
+            bool aggressive;
+            /** See @ref Creature::power_rating. */
+            float power;
+        };
+        struct team {
+            mfaction_id faction;
+            /** The team members are members[begin] to members[end - 1]. */
+            size_t begin;
+            size_t end;
+        };
+
+        /** Takes the snapshot of all monsters in the game. */
+        void build();
+        /** Returns the index of the faction's team in @ref teams or -1 if it has no members. */
+        int find_team( const mfaction_id &faction ) const;
+
+        /** Indexed like game::zombie. */
+        std::vector<candidate> candidates;
+        /** Ordered by faction. */
+        std::vector<team> teams;
+        /** Monster indices, grouped by team and ascending within a team. */
+        std::vector<int> members;
+};
+
 class monster : public Creature, public JsonSerializer, public JsonDeserializer
 {
         friend class editmap;
@@ -147,9 +187,29 @@ class monster : public Creature, public JsonSerializer, public JsonDeserializer
 
         // How good of a target is given creature (checks for visibility)
         float rate_target( Creature &c, float best, bool smart = false ) const;
-        // Pass all factions to mon, so that hordes of same-faction mons
+        // Same as above, using what's known about the monster from the targeting snapshot
+        float rate_target( monster &mon, const monster_targets::candidate &cand, float best,
+                           bool smart = false ) const;
+        // Pass the snapshot of all monsters, so that hordes of same-faction mons
         // do not iterate over each other
-        void plan(const mfactions &factions);
+        void plan( const monster_targets &targets );
+        /** The part of the monster that @ref plan changes. */
+        struct plan_result {
+            tripoint goal;
+            tripoint wander_pos;
+            int wandf;
+            int anger;
+            int morale;
+            int friendly;
+        };
+        /**
+         * Runs @ref plan without changing the monster and returns what it would have changed.
+         * Reads nothing that plan() of other monsters writes, so it can run for several
+         * monsters at the same time.
+         */
+        plan_result decide_plan( const monster_targets &targets );
+        /** Applies the outcome of @ref decide_plan. */
+        void apply_plan( const plan_result &result );
         void move(); // Actual movement
         void footsteps( const tripoint &p ); // noise made by movement
 
@@ -404,6 +464,8 @@ class monster : public Creature, public JsonSerializer, public JsonDeserializer
         bool dead;
         /** Attack another monster */
         void hit_monster(monster &other);
+        /** Distance to c if it could be a target at all, see @ref rate_target, -1 otherwise. */
+        int target_distance( const Creature &c, float best, bool smart ) const;
         /** Legacy loading logic for monsters that are packing ammo. **/
         void normalize_ammo( const int old_ammo );
         /** Normal upgrades **/
@@ -27,6 +27,11 @@ bool Character::has_trait(const std::string &b) const
     return my_mutations.count( b ) > 0;
 }
 
+bool Character::has_trait( const trait_id &b ) const
+{
+    return trait_ids.test( b );
+}
+
 bool Character::has_base_trait(const std::string &b) const
 {
     // Look only at base traits
@@ -44,9 +49,11 @@ void Character::toggle_trait(const std::string &flag)
     const auto miter = my_mutations.find( flag );
     if( miter == my_mutations.end() ) {
         my_mutations[flag]; // Creates a new entry with default values
+        trait_ids.set( trait_id( flag ) );
         mutation_effect(flag);
     } else {
         my_mutations.erase( miter );
+        trait_ids.reset( trait_id( flag ) );
         mutation_loss_effect(flag);
     }
     recalc_sight_limits();
@@ -57,6 +64,7 @@ void Character::set_mutation(const std::string &flag)
     const auto iter = my_mutations.find( flag );
     if( iter == my_mutations.end() ) {
         my_mutations[flag]; // Creates a new entry with default values
+        trait_ids.set( trait_id( flag ) );
     } else {
         debugmsg("Trying to set %s mutation, but the character already has it.", flag.c_str());
     }
@@ -70,6 +78,7 @@ void Character::unset_mutation(const std::string &flag)
         debugmsg("Trying to unset %s mutation, but the character does not have it.", flag.c_str());
     } else {
         my_mutations.erase( iter );
+        trait_ids.reset( trait_id( flag ) );
     }
     recalc_sight_limits();
 }
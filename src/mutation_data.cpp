@@ -78,6 +78,8 @@ void mutation_branch::load( JsonObject &jsobj )
 {
     const std::string id = jsobj.get_string( "id" );
     mutation_branch &new_mut = mutation_data[id];
+    // Loaded traits take the first trait ids.
+    (void)trait_id( id );
 
     JsonArray jsarr;
     new_mut.name = _(jsobj.get_string("name").c_str());
@@ -2163,6 +2163,7 @@ void Character::empty_traits()
 {
     my_traits.clear();
     my_mutations.clear();
+    trait_ids.clear();
 }
 void Character::empty_skills()
 {
@@ -1,4 +1,6 @@
 #include <sstream>
+#include <numeric>
+#include <algorithm>
 #include "npc.h"
 #include "rng.h"
 #include "game.h"
@@ -16,6 +18,7 @@
 #include "mtype.h"
 #include "field.h"
 #include "sounds.h"
+#include "creature_tracker.h"
 
 #define dbg(x) DebugLog((DebugLevel)(x),D_NPC) << __FILE__ << ":" << __LINE__ << ": "
 #define TARGET_NONE INT_MIN
@@ -589,7 +592,18 @@ void npc::choose_monster_target(int &enemy, int &danger,
     int highest_priority = 0;
     total_danger = 0;
 
-    for (size_t i = 0; i < g->num_zombies(); i++) {
+    std::vector<int> candidates;
+    if( has_active_bionic( "bio_ground_sonar" ) ) {
+        // Sonar finds digging monsters at any distance.
+        candidates.resize( g->num_zombies() );
+        std::iota( candidates.begin(), candidates.end(), 0 );
+    } else {
+        // Nothing beyond these ranges can be seen, see player::sees.
+        const int max_range = std::max( { unimpaired_range(), clairvoyance(), 3 } );
+        candidates = g->critter_tracker->in_radius( pos(), max_range );
+    }
+
+    for( const int i : candidates ) {
         monster *mon = &(g->zombie(i));
         if( !sees( *mon ) ) {
             continue;
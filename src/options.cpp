@@ -1092,6 +1092,48 @@ void options_manager::init()
                                  _("Set the level of skill rust. Vanilla: Vanilla Cataclysm - Capped: Capped at skill levels 2 - Int: Intelligence dependent - IntCap: Intelligence dependent, capped - Off: None at all."),
                                  "vanilla,capped,int,intcap,off", "int"
                                 );
+
+    mOptionsSort["debug"]++;
+
+    OPTIONS["PARALLEL_LIGHTMAP"] = cOpt("debug", _("Parallel lighting"),
+                                        _("If true, light sources are cast on all processor cores. Lighting looks exactly the same, but is calculated faster when there are many lights."),
+                                        false
+                                       );
+
+    mOptionsSort["debug"]++;
+
+    OPTIONS["PARALLEL_MONSTER_PLANNING"] = cOpt("debug", _("Parallel monster planning"),
+                                        _("If true, monsters choose their targets on all processor cores at the start of each turn, instead of one after another. Results are the same on every computer, but differ slightly from the default because monsters don't react to what others did earlier in the same turn."),
+                                        false
+                                       );
+
+    mOptionsSort["debug"]++;
+
+    OPTIONS["BACKGROUND_SAVING"] = cOpt("debug", _("Background saving"),
+                                        _("If true, saved maps and overmaps are written to disk on a background thread, so the game continues as soon as they are collected in memory. Quitting still waits until everything is written."),
+                                        false
+                                       );
+
+    mOptionsSort["debug"]++;
+
+    OPTIONS["PREFETCH_MAPS"] = cOpt("debug", _("Prefetch maps"),
+                                        _("If true, saved maps ahead of where the player or their vehicle is heading are read from disk on a background thread, before the map moves there."),
+                                        false
+                                       );
+
+    mOptionsSort["debug"]++;
+
+    OPTIONS["PARALLEL_DATA_LOADING"] = cOpt("debug", _("Parallel data loading"),
+                                        _("If true, the json files of the game and its mods are read and parsed on all processor cores. They are still loaded in the same order, so the game data is exactly the same."),
+                                        false
+                                       );
+
+    mOptionsSort["debug"]++;
+
+    OPTIONS["DATA_CACHE"] = cOpt("debug", _("Cache game data"),
+                                        _("If true, game data that is slow to prepare is kept in the config directory and reused as long as the game version, its data files and the active mods don't change."),
+                                        false
+                                       );
 /*
     // Disabled for now
     mOptionsSort["debug"]++;
@@ -1223,6 +1265,18 @@ void options_manager::init()
                                _("If true, experimental z-level maps will be enabled. This feature is not finished yet and turning it on will only slow the game down."),
                                false );
 
+    mOptionsSort["world_default"]++;
+
+    OPTIONS["BINARY_MAPS"] = cOpt( "world_default", _("Binary map files"),
+                                   _("If true, the map is saved in a compact binary format that loads faster than the JSON one. Saves in either format can still be loaded."),
+                                   false );
+
+    mOptionsSort["world_default"]++;
+
+    OPTIONS["PACK_MAPS"] = cOpt( "world_default", _("Pack map files"),
+                                 _("If true, the map is saved in one file per 32x32 overmap tiles instead of one file per overmap tile. Maps saved either way can still be loaded."),
+                                 false );
+
     for (unsigned i = 0; i < vPages.size(); ++i) {
         mPageItems[i].resize(mOptionsSort[vPages[i].first]);
     }
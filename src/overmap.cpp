@@ -35,6 +35,7 @@
 #include "weather.h"
 #include "ui.h"
 #include "mapbuffer.h"
+#include "background_writer.h"
 
 #define dbg(x) DebugLog((DebugLevel)(x),D_MAP_GEN) << __FILE__ << ":" << __LINE__ << ": "
 
@@ -847,7 +848,7 @@ void apply_region_overlay(JsonObject &jo, regional_settings &region)
 
 // *** BEGIN overmap FUNCTIONS ***
 
-overmap::overmap(int const x, int const y): loc(x, y), nullret(""), nullbool(false)
+overmap::overmap(int const x, int const y): loc(x, y), nullret("")
 {
     const std::string rsettings_id = ACTIVE_WORLD_OPTIONS["DEFAULT_REGION"].getValue();
     t_regional_settings_map_citr rsit = region_settings_map.find( rsettings_id );
@@ -865,7 +866,7 @@ overmap::overmap(int const x, int const y): loc(x, y), nullret(""), nullbool(fal
     }
 }
 
-overmap::overmap(): loc(0, 0), nullret(""), nullbool(false)
+overmap::overmap(): loc(0, 0), nullret("")
 {
     t_regional_settings_map_citr rsit = region_settings_map.find( "default" );
 
@@ -888,10 +889,11 @@ void overmap::init_layers()
         for(int i = 0; i < OMAPX; ++i) {
             for(int j = 0; j < OMAPY; ++j) {
                 layer[z].terrain[i][j] = default_type;
-                layer[z].visible[i][j] = false;
-                layer[z].explored[i][j] = false;
             }
         }
+        layer[z].visible.reset();
+        layer[z].explored.reset();
+        packed_layers[z].clear();
     }
 }
 
@@ -901,6 +903,9 @@ oter_id &overmap::ter(const int x, const int y, const int z)
         nullret = "";
         return nullret;
     }
+    if( !packed_layers[z + OVERMAP_DEPTH].empty() ) {
+        unpack_layer( z + OVERMAP_DEPTH );
+    }
 
     return layer[z + OVERMAP_DEPTH].terrain[x][y];
 }
@@ -911,26 +916,35 @@ const oter_id overmap::get_ter(const int x, const int y, const int z) const
     if (x < 0 || x >= OMAPX || y < 0 || y >= OMAPY || z < -OVERMAP_DEPTH || z > OVERMAP_HEIGHT) {
         return nullret;
     }
+    if( !packed_layers[z + OVERMAP_DEPTH].empty() ) {
+        const_cast<overmap *>( this )->unpack_layer( z + OVERMAP_DEPTH );
+    }
 
     return layer[z + OVERMAP_DEPTH].terrain[x][y];
 }
 
-bool &overmap::seen(int x, int y, int z)
+bool overmap::seen( int x, int y, int z ) const
 {
     if (x < 0 || x >= OMAPX || y < 0 || y >= OMAPY || z < -OVERMAP_DEPTH || z > OVERMAP_HEIGHT) {
-        nullbool = false;
-        return nullbool;
+        return false;
     }
-    return layer[z + OVERMAP_DEPTH].visible[x][y];
+    return layer[z + OVERMAP_DEPTH].visible[map_layer::index( x, y )];
 }
 
-bool &overmap::explored(int x, int y, int z)
+void overmap::set_seen( int x, int y, int z, bool seen )
 {
     if (x < 0 || x >= OMAPX || y < 0 || y >= OMAPY || z < -OVERMAP_DEPTH || z > OVERMAP_HEIGHT) {
-        nullbool = false;
-        return nullbool;
+        return;
     }
-    return layer[z + OVERMAP_DEPTH].explored[x][y];
+    layer[z + OVERMAP_DEPTH].visible[map_layer::index( x, y )] = seen;
+}
+
+void overmap::set_explored( int x, int y, int z, bool explored )
+{
+    if (x < 0 || x >= OMAPX || y < 0 || y >= OMAPY || z < -OVERMAP_DEPTH || z > OVERMAP_HEIGHT) {
+        return;
+    }
+    layer[z + OVERMAP_DEPTH].explored[map_layer::index( x, y )] = explored;
 }
 
 bool overmap::is_explored(int const x, int const y, int const z) const
@@ -938,7 +952,7 @@ bool overmap::is_explored(int const x, int const y, int const z) const
     if (x < 0 || x >= OMAPX || y < 0 || y >= OMAPY || z < -OVERMAP_DEPTH || z > OVERMAP_HEIGHT) {
         return false;
     }
-    return layer[z + OVERMAP_DEPTH].explored[x][y];
+    return layer[z + OVERMAP_DEPTH].explored[map_layer::index( x, y )];
 }
 
 bool overmap::mongroup_check(const mongroup &candidate) const
@@ -978,6 +992,11 @@ int overmap::num_monsters() const
     return monster_map.size();
 }
 
+bool overmap::is_layer_unpacked( int z ) const
+{
+    return packed_layers[z + OVERMAP_DEPTH].empty();
+}
+
 bool overmap::has_note(int const x, int const y, int const z) const
 {
     if (z < -OVERMAP_DEPTH || z > OVERMAP_HEIGHT) {
@@ -4264,25 +4283,27 @@ void overmap::open()
     }
 }
 
-// Note: this may throw io errors from std::ofstream
+// Note: this may throw io errors, from the background_writer if it runs the job right away
 void overmap::save() const
 {
-    std::ofstream fout;
-    fout.exceptions(std::ios::badbit | std::ios::failbit);
     std::string const plrfilename = overmapbuffer::player_filename(loc.x, loc.y);
     std::string const terfilename = overmapbuffer::terrain_filename(loc.x, loc.y);
 
-    // Player specific data
-    fout.open(plrfilename.c_str());
-    serialize_view( fout );
-    fout.close();
-    // World terrain data
-    fopen_exclusive(fout, terfilename.c_str(), std::ios_base::trunc);
-    if(!fout.is_open()) {
-        return;
-    }
-    serialize( fout );
-    fclose_exclusive(fout, terfilename.c_str());
+    // Serialized right away, the overmap keeps changing while the files are written.
+    std::ostringstream view;
+    serialize_view( view );
+    std::ostringstream terrain;
+    serialize( terrain );
+    const std::string view_data = view.str();
+    const std::string terrain_data = terrain.str();
+    background_writer::get().queue( [plrfilename, terfilename, view_data, terrain_data]() {
+        // Player specific data
+        if( !write_file_replacing( plrfilename, view_data ) ) {
+            throw std::ios::failure( "failed to write " + plrfilename );
+        }
+        // World terrain data, skipped if another player holds the lock.
+        write_file_replacing( terfilename, terrain_data );
+    } );
 }
 
 
@@ -10,6 +10,7 @@
 #include <iosfwd>
 #include <string>
 #include <array>
+#include <bitset>
 #include <map>
 #include <unordered_map>
 
@@ -17,6 +18,7 @@ class overmapbuffer;
 class npc;
 struct mongroup;
 class JsonObject;
+class JsonIn;
 class input_context;
 
 // base oters: exactly what's defined in json before things are split up into blah_east or roadtype_ns, etc
@@ -176,9 +178,14 @@ radio_tower(int X = -1, int Y = -1, int S = -1, std::string M = "",
 
 struct map_layer {
     oter_id terrain[OMAPX][OMAPY];
-    bool visible[OMAPX][OMAPY];
-    bool explored[OMAPX][OMAPY];
+    /** One bit per overmap terrain, see @ref index. */
+    std::bitset<OMAPX * OMAPY> visible;
+    std::bitset<OMAPX * OMAPY> explored;
     std::vector<om_note> notes;
+
+    static size_t index( int x, int y ) {
+        return x + y * OMAPX;
+    }
 };
 
 struct node
@@ -224,8 +231,9 @@ class overmap
 
     oter_id& ter(const int x, const int y, const int z);
     const oter_id get_ter(const int x, const int y, const int z) const;
-    bool&   seen(int x, int y, int z);
-    bool&   explored(int x, int y, int z);
+    bool seen( int x, int y, int z ) const;
+    void set_seen( int x, int y, int z, bool seen );
+    void set_explored( int x, int y, int z, bool explored );
     bool is_road_or_highway(int x, int y, int z);
     bool is_explored(int const x, int const y, int const z) const;
 
@@ -315,6 +323,8 @@ public:
     int num_mongroups() const;
     bool monster_check(const std::pair<tripoint, monster> &candidate) const;
     int num_monsters() const;
+    /** Whether the terrain of z-level z was used since the overmap was loaded. */
+    bool is_layer_unpacked( int z ) const;
     // TODO: make private
   std::vector<radio_tower> radios;
   std::vector<npc *> npcs;
@@ -327,9 +337,15 @@ public:
   point loc;
 
     std::array<map_layer, OVERMAP_LAYERS> layer;
+    /**
+     * Terrain of the layers that were not used since they were loaded from a binary terrain
+     * file, still packed as runs of indexes into @ref packed_terrain. Empty once a layer
+     * is unpacked (see @ref unpack_layer) or when it was generated or read from json.
+     */
+    std::array<std::string, OVERMAP_LAYERS> packed_layers;
+    std::vector<oter_id> packed_terrain;
 
   oter_id nullret;
-  bool nullbool;
 
     /**
      * When monsters despawn during map-shifting they will be added here.
@@ -342,6 +358,11 @@ public:
 
   // Initialise
   void init_layers();
+    /** Fills the terrain of a layer (0 to OVERMAP_LAYERS - 1) from @ref packed_layers. */
+    void unpack_layer( int z );
+    /** Reads everything but the terrain, in the json format. */
+    void unserialize_objects( JsonIn &jsin );
+    void unserialize_binary( const std::string &data );
   // open existing overmap, or generate a new one
   void open();
  public:
@@ -350,9 +371,9 @@ public:
   // Parse per-player overmap view data.
   void unserialize_view(std::ifstream &fin);
   // Save data in an opened overmap file
-  void serialize(std::ofstream &fin) const;
+  void serialize(std::ostream &fin) const;
   // Save per-player overmap view data.
-  void serialize_view(std::ofstream &fin) const;
+  void serialize_view(std::ostream &fin) const;
   // parse data in an old overmap file
   void unserialize_legacy(std::ifstream &fin);
   void unserialize_view_legacy(std::ifstream &fin);
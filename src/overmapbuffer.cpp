@@ -11,6 +11,7 @@
 #include "catacharset.h"
 #include "npc.h"
 #include "vehicle.h"
+#include "background_writer.h"
 
 #include <fstream>
 #include <sstream>
@@ -109,13 +110,15 @@ void overmapbuffer::fix_mongroups(overmap &new_overmap)
 void overmapbuffer::save()
 {
     for( auto &omp : overmaps ) {
-        // Note: this may throw io errors from std::ofstream
+        // Note: this may throw io errors, unless the background_writer saves the overmaps
         omp.second->save();
     }
 }
 
 void overmapbuffer::clear()
 {
+    // Overmaps loaded after this would read files that may still be written.
+    background_writer::get().wait();
     overmaps.clear();
     known_non_existing.clear();
     last_requested_overmap = NULL;
@@ -229,7 +232,7 @@ bool overmapbuffer::is_explored(int x, int y, int z)
 void overmapbuffer::toggle_explored(int x, int y, int z)
 {
     overmap &om = get_om_global(x, y);
-    om.explored(x, y, z) = !om.explored(x, y, z);
+    om.set_explored( x, y, z, !om.is_explored( x, y, z ) );
 }
 
 bool overmapbuffer::has_horde(int const x, int const y, int const z) {
@@ -415,13 +418,13 @@ void overmapbuffer::add_vehicle( vehicle *veh )
 bool overmapbuffer::seen(int x, int y, int z)
 {
     const overmap *om = get_existing_om_global(x, y);
-    return (om != NULL) && const_cast<overmap*>(om)->seen(x, y, z);
+    return (om != NULL) && om->seen(x, y, z);
 }
 
 void overmapbuffer::set_seen(int x, int y, int z, bool seen)
 {
     overmap &om = get_om_global(x, y);
-    om.seen(x, y, z) = seen;
+    om.set_seen( x, y, z, seen );
 }
 
 overmap &overmapbuffer::get_om_global(const point& p)
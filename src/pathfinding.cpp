@@ -1,3 +1,4 @@
+#include "calendar.h"
 #include "coordinates.h"
 #include "debug.h"
 #include "enums.h"
@@ -11,97 +12,114 @@
 #include "submap.h"
 #include "mapdata.h"
 #include "cata_utility.h"
+#include "pathfinding.h"
 
 #include <algorithm>
+#include <climits>
 #include <queue>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "messages.h"
 
-enum astar_state {
-    ASL_NONE,
-    ASL_OPEN,
-    ASL_CLOSED
-};
+namespace
+{
+
+// Routes shorter than this are cheap enough for a plain A* search
+constexpr int HIERARCHICAL_ROUTE_MIN_DIST = 2 * SEEX;
+// A cluster border is 12 tiles long, so it can't have more than 6 portals per side
+constexpr int MAX_CLUSTER_PORTALS = 32;
 
-// Turns two indexed to a 2D array into an index to equivalent 1D array
-constexpr int flat_index( const int x, const int y )
+// Scores are stored in 16 bits, anything above that is "too far" anyway
+uint16_t clamp_score( const int score )
 {
-    return ( x * MAPSIZE * SEEY ) + y;
-};
-
-// Flattened 2D array representing a single z-level worth of pathfinding data
-struct path_data_layer {
-    // State is accessed way more often than all other values here
-    std::array< astar_state, SEEX *MAPSIZE *SEEY *MAPSIZE > state;
-    std::array< int, SEEX *MAPSIZE *SEEY *MAPSIZE > score;
-    std::array< int, SEEX *MAPSIZE *SEEY *MAPSIZE > gscore;
-    std::array< tripoint, SEEX *MAPSIZE *SEEY *MAPSIZE > parent;
-
-    void init( const int minx, const int miny, const int maxx, const int maxy ) {
-        for( int x = minx; x <= maxx; x++ ) {
-            for( int y = miny; y <= maxy; y++ ) {
-                const int ind = flat_index( x, y );
-                state[ind] = ASL_NONE; // Mark as unvisited
-            }
-        }
-    };
-};
+    return uint16_t( std::max( 0, std::min<int>( score, UINT16_MAX ) ) );
+}
 
-struct pathfinder {
-    int minx;
-    int miny;
-    int maxx;
-    int maxy;
-    pathfinder( int _minx, int _miny, int _maxx, int _maxy ) :
-        minx( _minx ), miny( _miny ), maxx( _maxx ), maxy( _maxy ) {
-    }
+// Compares scores only, like pair_greater_cmp, so ties are resolved like in a priority_queue
+bool open_greater_cmp( const std::pair<int, uint32_t> &a, const std::pair<int, uint32_t> &b )
+{
+    return a.first > b.first;
+}
 
-    std::priority_queue< std::pair<int, tripoint>, std::vector< std::pair<int, tripoint> >, pair_greater_cmp >
-    open;
-    std::array< std::unique_ptr< path_data_layer >, OVERMAP_LAYERS > path_data;
+}
 
-    path_data_layer &get_layer( const int z ) {
-        auto &ptr = path_data[z + OVERMAP_DEPTH];
-        if( ptr != nullptr ) {
-            return *ptr;
+void pathfinder::reset( const int _minx, const int _miny, const int _maxx, const int _maxy )
+{
+    minx = _minx;
+    miny = _miny;
+    maxx = _maxx;
+    maxy = _maxy;
+    open.clear();
+
+    // Each search uses two fresh stamps, so everything from the previous one reads as ASL_NONE
+    if( closed_stamp >= UINT32_MAX - 2 ) {
+        for( auto &ptr : path_data ) {
+            if( ptr != nullptr ) {
+                ptr->state.fill( 0 );
+            }
         }
+        closed_stamp = 0;
+    }
+    open_stamp = closed_stamp + 1;
+    closed_stamp = open_stamp + 1;
+}
 
+path_data_layer &pathfinder::get_layer( const int z )
+{
+    auto &ptr = path_data[z + OVERMAP_DEPTH];
+    if( ptr == nullptr ) {
+        // Value-initialized, so all states are 0, which is never a valid stamp
         ptr = std::unique_ptr<path_data_layer>( new path_data_layer() );
-        ptr->init( minx, miny, maxx, maxy );
-        return *ptr;
+        allocations++;
     }
 
-    bool empty() const {
-        return open.empty();
+    return *ptr;
+}
+
+tripoint pathfinder::get_next()
+{
+    std::pop_heap( open.begin(), open.end(), open_greater_cmp );
+    const uint32_t packed = open.back().second;
+    open.pop_back();
+    return unpack( packed );
+}
+
+void pathfinder::add_point( const int gscore, const int score, const tripoint &from,
+                            const tripoint &to )
+{
+    auto &layer = get_layer( to.z );
+    const int index = flat_index( to.x, to.y );
+    const astar_state st = get_state( layer, index );
+    if( ( st == ASL_OPEN && gscore >= layer.gscore[index] ) || st == ASL_CLOSED ) {
+        return;
     }
 
-    tripoint get_next() {
-        auto pt = open.top();
-        open.pop();
-        return pt.second;
+    layer.state [index] = open_stamp;
+    layer.gscore[index] = clamp_score( gscore );
+    layer.parent[index] = pack( from );
+    layer.score [index] = clamp_score( score );
+    if( open.size() == open.capacity() ) {
+        allocations++;
     }
+    open.emplace_back( score, pack( to ) );
+    std::push_heap( open.begin(), open.end(), open_greater_cmp );
+}
 
-    void add_point( const int gscore, const int score, const tripoint &from, const tripoint &to ) {
-        auto &layer = get_layer( to.z );
-        const int index = flat_index( to.x, to.y );
-        if( ( layer.state[index] == ASL_OPEN && gscore >= layer.gscore[index] ) ||
-            layer.state[index] == ASL_CLOSED ) {
-            return;
-        }
+void pathfinder::close_point( const tripoint &p )
+{
+    auto &layer = get_layer( p.z );
+    set_closed( layer, flat_index( p.x, p.y ) );
+}
 
-        layer.state [index] = ASL_OPEN;
-        layer.gscore[index] = gscore;
-        layer.parent[index] = from;
-        layer.score [index] = score;
-        open.push( std::make_pair( score, to ) );
+pathfinder &map::get_pathfinder() const
+{
+    if( pathfinder_arena == nullptr ) {
+        pathfinder_arena = std::unique_ptr<pathfinder>( new pathfinder() );
     }
 
-    void close_point( const tripoint &p ) {
-        auto &layer = get_layer( p.z );
-        const int index = flat_index( p.x, p.y );
-        layer.state[index] = ASL_CLOSED;
-    }
-};
+    return *pathfinder_arena;
+}
 
 // Returns a tile with `flag` in the overmap tile that `t` is on
 template<ter_bitflags flag>
@@ -148,6 +166,23 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
         clip_to_bounds( clipped );
         return route( f, clipped, bash, maxdist );
     }
+
+    // Long routes go through the submap graph first, unless a straight line will do
+    if( f.z == t.z && square_dist( f, t ) > HIERARCHICAL_ROUTE_MIN_DIST &&
+        !clear_path( f, t, -1, 2, 2 ) ) {
+        ret = route_hierarchical( f, t, bash, maxdist );
+        if( !ret.empty() ) {
+            return ret;
+        }
+    }
+
+    return route_local( f, t, bash, maxdist );
+}
+
+std::vector<tripoint> map::route_local( const tripoint &f, const tripoint &t,
+                                        const int bash, const int maxdist ) const
+{
+    std::vector<tripoint> ret;
     // First, check for a simple straight line on flat ground
     // Except when the player is on the line - we need to do regular pathing then
     const tripoint &pl_pos = g->u.pos();
@@ -173,11 +208,12 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
     clip_to_bounds( minx, miny, minz );
     clip_to_bounds( maxx, maxy, maxz );
 
-    pathfinder pf( minx, miny, maxx, maxy );
+    pathfinder &pf = get_pathfinder();
+    pf.reset( minx, miny, maxx, maxy );
     pf.add_point( 0, 0, f, f );
     // Make NPCs not want to path through player
     // But don't make player pathing stop working
-    if( f != pl_pos && t != pl_pos ) {
+    if( f != pl_pos && t != pl_pos && inbounds( pl_pos ) ) {
         pf.close_point( pl_pos );
     }
 
@@ -188,8 +224,7 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
 
         const int parent_index = flat_index( cur.x, cur.y );
         auto &layer = pf.get_layer( cur.z );
-        auto &cur_state = layer.state[parent_index];
-        if( cur_state == ASL_CLOSED ) {
+        if( pf.get_state( layer, parent_index ) == ASL_CLOSED ) {
             continue;
         }
 
@@ -203,7 +238,9 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
             break;
         }
 
-        cur_state = ASL_CLOSED;
+        pf.set_closed( layer, parent_index );
+        const int parent_gscore = layer.gscore[parent_index];
+        const int parent_score = layer.score[parent_index];
 
         // 7 3 5
         // 1 . 2
@@ -219,7 +256,8 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
                 continue;
             }
 
-            if( layer.state[index] == ASL_CLOSED ) {
+            const astar_state st = pf.get_state( layer, index );
+            if( st == ASL_CLOSED ) {
                 continue;
             }
 
@@ -235,11 +273,11 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
                                bash_rating_internal( bash, furniture, terrain, false, veh, part );
 
             if( cost == 0 && rating <= 0 && terrain.open.empty() && veh == nullptr ) {
-                layer.state[index] = ASL_CLOSED; // Close it so that next time we won't try to calc costs
+                pf.set_closed( layer, index ); // Close it so that next time we won't try to calc costs
                 continue;
             }
 
-            int newg = layer.gscore[parent_index] + cost + ( ( cur.x != p.x && cur.y != p.y ) ? 1 : 0 );
+            int newg = parent_gscore + cost + ( ( cur.x != p.x && cur.y != p.y ) ? 1 : 0 );
             if( cost == 0 ) {
                 // Handle all kinds of doors
                 // Only try to open INSIDE doors from the inside
@@ -291,15 +329,14 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
                         tripoint below( p.x, p.y, p.z - 1 );
                         if( !has_flag( TFLAG_NO_FLOOR, below ) ) {
                             // Otherwise this would have been a huge fall
-                            auto &layer = pf.get_layer( p.z - 1 );
                             // From cur, not p, because we won't be walking on air
-                            pf.add_point( layer.gscore[parent_index] + 10,
-                                          layer.score[parent_index] + 10 + 2 * rl_dist( below, t ),
+                            pf.add_point( parent_gscore + 10,
+                                          parent_score + 10 + 2 * rl_dist( below, t ),
                                           cur, below );
                         }
 
                         // Close p, because we won't be walking on it
-                        layer.state[index] = ASL_CLOSED;
+                        pf.set_closed( layer, index );
                         continue;
                     }
                     // Otherwise it's walkable
@@ -310,7 +347,7 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
 
             // If not visited, add as open
             // If visited, add it only if we can do so with better score
-            if( layer.state[index] == ASL_NONE || newg < layer.gscore[index] ) {
+            if( st == ASL_NONE || newg < layer.gscore[index] ) {
                 pf.add_point( newg, newg + 2 * rl_dist( p, t ), cur, p );
             }
         }
@@ -326,9 +363,8 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
             tripoint dest( cur.x, cur.y, cur.z - 1 );
             dest = vertical_move_destination<TFLAG_GOES_UP>( *this, dest );
             if( inbounds( dest ) ) {
-                auto &layer = pf.get_layer( dest.z );
-                pf.add_point( layer.gscore[parent_index] + 2,
-                              layer.score[parent_index] + 2 * rl_dist( dest, t ),
+                pf.add_point( parent_gscore + 2,
+                              parent_score + 2 * rl_dist( dest, t ),
                               cur, dest );
             }
         }
@@ -336,19 +372,17 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
             tripoint dest( cur.x, cur.y, cur.z + 1 );
             dest = vertical_move_destination<TFLAG_GOES_DOWN>( *this, dest );
             if( inbounds( dest ) ) {
-                auto &layer = pf.get_layer( dest.z );
-                pf.add_point( layer.gscore[parent_index] + 2,
-                              layer.score[parent_index] + 2 * rl_dist( dest, t ),
+                pf.add_point( parent_gscore + 2,
+                              parent_score + 2 * rl_dist( dest, t ),
                               cur, dest );
             }
         }
         if( cur.z < maxz && parent_terrain.has_flag( TFLAG_RAMP ) &&
             valid_move( cur, tripoint( cur.x, cur.y, cur.z + 1 ), false, true ) ) {
-            auto &layer = pf.get_layer( cur.z + 1 );
             for( size_t it = 0; it < 8; it++ ) {
                 const tripoint above( cur.x + x_offset[it], cur.y + y_offset[it], cur.z + 1 );
-                pf.add_point( layer.gscore[parent_index] + 4,
-                              layer.score[parent_index] + 4 + 2 * rl_dist( above, t ),
+                pf.add_point( parent_gscore + 4,
+                              parent_score + 4 + 2 * rl_dist( above, t ),
                               cur, above );
             }
         }
@@ -361,7 +395,7 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
         for( int fdist = maxdist; fdist != 0; fdist-- ) {
             const int cur_index = flat_index( cur.x, cur.y );
             const auto &layer = pf.get_layer( cur.z );
-            const tripoint &par = layer.parent[cur_index];
+            const tripoint par = pathfinder::unpack( layer.parent[cur_index] );
             if( cur == f ) {
                 break;
             }
@@ -383,3 +417,521 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
 
     return ret;
 }
+
+namespace
+{
+
+const std::array<point, 4> cluster_offsets{{ point( 0, -1 ), point( 1, 0 ), point( 0, 1 ), point( -1, 0 ) }};
+
+constexpr int cluster_index( const int x, const int y )
+{
+    return x * SEEY + y;
+}
+
+path_cluster::portal_direction opposite( const path_cluster::portal_direction dir )
+{
+    return static_cast<path_cluster::portal_direction>( ( dir + 2 ) % 4 );
+}
+
+// The i-th tile along the border of a cluster facing `dir`
+point border_tile( const path_cluster::portal_direction dir, const int i )
+{
+    switch( dir ) {
+        case path_cluster::NORTH:
+            return point( i, 0 );
+        case path_cluster::EAST:
+            return point( SEEX - 1, i );
+        case path_cluster::SOUTH:
+            return point( i, SEEY - 1 );
+        case path_cluster::WEST:
+        default:
+            return point( 0, i );
+    }
+}
+
+// The tile of the neighbouring cluster right across the border from `p`
+point across_border( const point &p, const path_cluster::portal_direction dir )
+{
+    const point &offset = cluster_offsets[dir];
+    return point( ( p.x + offset.x + SEEX ) % SEEX, ( p.y + offset.y + SEEY ) % SEEY );
+}
+
+// Costs of the cheapest paths from `from` to every tile of the cluster without leaving it.
+// Mirrors the costs of the A* in map::route_local, including the diagonal penalty.
+void cluster_distances( const path_cluster &cluster, const point &from,
+                        std::array<int, SEEX * SEEY> &dist )
+{
+    dist.fill( INT_MAX );
+    std::priority_queue< std::pair<int, int>, std::vector< std::pair<int, int> >,
+        std::greater< std::pair<int, int> > > open;
+    dist[cluster_index( from.x, from.y )] = 0;
+    open.emplace( 0, cluster_index( from.x, from.y ) );
+    while( !open.empty() ) {
+        const auto cur = open.top();
+        open.pop();
+        if( cur.first > dist[cur.second] ) {
+            continue;
+        }
+
+        const int x = cur.second / SEEY;
+        const int y = cur.second % SEEY;
+        for( int dx = -1; dx <= 1; dx++ ) {
+            for( int dy = -1; dy <= 1; dy++ ) {
+                const int nx = x + dx;
+                const int ny = y + dy;
+                if( ( dx == 0 && dy == 0 ) || nx < 0 || nx >= SEEX || ny < 0 || ny >= SEEY ) {
+                    continue;
+                }
+
+                const int index = cluster_index( nx, ny );
+                const int cost = cluster.cost[index];
+                if( cost == 0 ) {
+                    continue;
+                }
+
+                const int newd = cur.first + cost + ( ( dx != 0 && dy != 0 ) ? 1 : 0 );
+                if( newd < dist[index] ) {
+                    dist[index] = newd;
+                    open.emplace( newd, index );
+                }
+            }
+        }
+    }
+}
+
+// Places a portal in the middle of every passable stretch of each border, then connects
+// the portals that can reach each other inside the cluster.
+void build_portals( path_cluster &cluster,
+                    const std::array<const path_cluster *, 4> &neighbours )
+{
+    cluster.portals.clear();
+    for( int d = 0; d < 4; d++ ) {
+        const auto dir = static_cast<path_cluster::portal_direction>( d );
+        const path_cluster *neighbour = neighbours[d];
+        cluster.neighbours_built_for[d] = neighbour != nullptr ? neighbour->built_for : nullptr;
+        if( neighbour == nullptr ) {
+            continue;
+        }
+
+        const int length = ( dir == path_cluster::NORTH || dir == path_cluster::SOUTH ) ? SEEX : SEEY;
+        int run_start = -1;
+        for( int i = 0; i <= length; i++ ) {
+            bool passable = false;
+            if( i < length ) {
+                const point own = border_tile( dir, i );
+                const point other = across_border( own, dir );
+                passable = cluster.cost[cluster_index( own.x, own.y )] > 0 &&
+                           neighbour->cost[cluster_index( other.x, other.y )] > 0;
+            }
+            if( passable && run_start < 0 ) {
+                run_start = i;
+            } else if( !passable && run_start >= 0 ) {
+                cluster.portals.push_back( { border_tile( dir, ( run_start + i - 1 ) / 2 ), dir } );
+                run_start = -1;
+            }
+        }
+    }
+
+    cluster.edges.clear();
+    cluster.edges.resize( cluster.portals.size() );
+    std::array<int, SEEX * SEEY> dist;
+    for( size_t i = 0; i < cluster.portals.size(); i++ ) {
+        cluster_distances( cluster, cluster.portals[i].pos, dist );
+        for( size_t j = 0; j < cluster.portals.size(); j++ ) {
+            const point &other = cluster.portals[j].pos;
+            const int d = dist[cluster_index( other.x, other.y )];
+            if( i != j && d != INT_MAX ) {
+                cluster.edges[i].emplace_back( j, d );
+            }
+        }
+    }
+
+    cluster.portals_dirty = false;
+}
+
+}
+
+portal_graph::portal_graph( const int size ) : mapsize( size )
+{
+}
+
+path_cluster &portal_graph::get_cluster( const tripoint &gridp )
+{
+    auto &level = levels[gridp.z + OVERMAP_DEPTH];
+    if( level.empty() ) {
+        level.resize( mapsize * mapsize );
+    }
+
+    return level[gridp.x * mapsize + gridp.y];
+}
+
+void portal_graph::set_dirty( const tripoint &p )
+{
+    auto &level = levels[p.z + OVERMAP_DEPTH];
+    if( level.empty() ) {
+        return;
+    }
+
+    const int gx = p.x / SEEX;
+    const int gy = p.y / SEEY;
+    level[gx * mapsize + gy].costs_dirty = true;
+    // Portals on a shared border depend on the tiles at both sides of it
+    const int lx = p.x % SEEX;
+    const int ly = p.y % SEEY;
+    if( lx == 0 && gx > 0 ) {
+        level[( gx - 1 ) * mapsize + gy].portals_dirty = true;
+    } else if( lx == SEEX - 1 && gx + 1 < mapsize ) {
+        level[( gx + 1 ) * mapsize + gy].portals_dirty = true;
+    }
+    if( ly == 0 && gy > 0 ) {
+        level[gx * mapsize + gy - 1].portals_dirty = true;
+    } else if( ly == SEEY - 1 && gy + 1 < mapsize ) {
+        level[gx * mapsize + gy + 1].portals_dirty = true;
+    }
+}
+
+void portal_graph::set_all_dirty()
+{
+    for( auto &level : levels ) {
+        level.clear();
+    }
+}
+
+void portal_graph::shift( const int sx, const int sy )
+{
+    for( auto &level : levels ) {
+        if( level.empty() ) {
+            continue;
+        }
+
+        // Clusters that scrolled in start out dirty
+        std::vector<path_cluster> shifted( mapsize * mapsize );
+        for( int gx = 0; gx < mapsize; gx++ ) {
+            for( int gy = 0; gy < mapsize; gy++ ) {
+                const int ox = gx + sx;
+                const int oy = gy + sy;
+                if( ox >= 0 && ox < mapsize && oy >= 0 && oy < mapsize ) {
+                    shifted[gx * mapsize + gy] = std::move( level[ox * mapsize + oy] );
+                }
+            }
+        }
+        level = std::move( shifted );
+    }
+}
+
+portal_graph &map::get_portal_graph() const
+{
+    if( portal_graph_cache == nullptr ) {
+        portal_graph_cache = std::unique_ptr<portal_graph>( new portal_graph( my_MAPSIZE ) );
+    }
+
+    return *portal_graph_cache;
+}
+
+void map::set_pathfinding_cache_dirty( const tripoint &p )
+{
+    if( portal_graph_cache != nullptr && inbounds( p ) ) {
+        portal_graph_cache->set_dirty( p );
+    }
+    for( auto &field : flow_fields ) {
+        if( field->target.z == p.z ) {
+            field->dirty = true;
+        }
+    }
+}
+
+path_cluster &map::get_path_cluster_costs( const tripoint &gridp ) const
+{
+    path_cluster &cluster = get_portal_graph().get_cluster( gridp );
+    const submap *sm = get_submap_at_grid( gridp );
+    if( !cluster.costs_dirty && cluster.built_for == sm ) {
+        return cluster;
+    }
+
+    for( int x = 0; x < SEEX; x++ ) {
+        for( int y = 0; y < SEEY; y++ ) {
+            const tripoint p( gridp.x * SEEX + x, gridp.y * SEEY + y, gridp.z );
+            int part = -1;
+            const maptile &tile = maptile_at_internal( p );
+            const auto &terrain = tile.get_ter_t();
+            const vehicle *veh = veh_at_internal( p, part );
+            int cost = move_cost_internal( tile.get_furn_t(), terrain, veh, part );
+            if( cost == 0 && !terrain.open.empty() ) {
+                // Doors: moving through them costs 2, plus 4 for opening them
+                // The exact rules are applied when refining the route
+                cost = 2 + 4;
+            }
+            cluster.cost[cluster_index( x, y )] = cost;
+        }
+    }
+    cluster.built_for = sm;
+    cluster.costs_dirty = false;
+    cluster.portals_dirty = true;
+    return cluster;
+}
+
+const path_cluster &map::get_path_cluster( const tripoint &gridp ) const
+{
+    path_cluster &cluster = get_path_cluster_costs( gridp );
+    std::array<const path_cluster *, 4> neighbours;
+    bool neighbours_changed = false;
+    for( int d = 0; d < 4; d++ ) {
+        const tripoint np( gridp.x + cluster_offsets[d].x, gridp.y + cluster_offsets[d].y, gridp.z );
+        if( np.x < 0 || np.x >= my_MAPSIZE || np.y < 0 || np.y >= my_MAPSIZE ) {
+            neighbours[d] = nullptr;
+        } else {
+            neighbours[d] = &get_path_cluster_costs( np );
+        }
+        const submap *nsm = neighbours[d] != nullptr ? neighbours[d]->built_for : nullptr;
+        neighbours_changed |= cluster.neighbours_built_for[d] != nsm;
+    }
+
+    if( cluster.portals_dirty || neighbours_changed ) {
+        build_portals( cluster, neighbours );
+    }
+
+    return cluster;
+}
+
+std::vector<tripoint> map::route_hierarchical( const tripoint &f, const tripoint &t,
+        const int bash, const int maxdist ) const
+{
+    std::vector<tripoint> ret;
+    const tripoint start_grid( f.x / SEEX, f.y / SEEY, f.z );
+    const tripoint goal_grid( t.x / SEEX, t.y / SEEY, t.z );
+    if( start_grid == goal_grid ) {
+        return ret;
+    }
+
+    // Abstract nodes are portals, keyed by their cluster and index
+    const int mapsize = my_MAPSIZE;
+    const auto node_key = [mapsize]( const tripoint & gp, const size_t portal ) {
+        return ( gp.x * mapsize + gp.y ) * MAX_CLUSTER_PORTALS + int( portal );
+    };
+    const auto node_grid = [mapsize, &f]( const int key ) {
+        const int cluster = key / MAX_CLUSTER_PORTALS;
+        return tripoint( cluster / mapsize, cluster % mapsize, f.z );
+    };
+    const auto node_pos = [this, &node_grid]( const int key ) {
+        const tripoint gp = node_grid( key );
+        const point &p = get_path_cluster( gp ).portals[key % MAX_CLUSTER_PORTALS].pos;
+        return tripoint( gp.x * SEEX + p.x, gp.y * SEEY + p.y, gp.z );
+    };
+    constexpr int start_key = -2;
+    constexpr int goal_key = -1;
+
+    std::priority_queue< std::pair<int, int>, std::vector< std::pair<int, int> >,
+        std::greater< std::pair<int, int> > > open;
+    std::unordered_map<int, int> gscore;
+    std::unordered_map<int, int> parent;
+    std::unordered_set<int> closed;
+    const auto add_node = [&]( const int key, const int g, const int from, const tripoint & pos ) {
+        const auto iter = gscore.find( key );
+        if( closed.count( key ) > 0 || ( iter != gscore.end() && iter->second <= g ) ) {
+            return;
+        }
+        gscore[key] = g;
+        parent[key] = from;
+        open.emplace( g + 2 * rl_dist( pos, t ), key );
+    };
+
+    std::array<int, SEEX * SEEY> start_dist;
+    std::array<int, SEEX * SEEY> goal_dist;
+    const path_cluster &start_cluster = get_path_cluster( start_grid );
+    cluster_distances( start_cluster, point( f.x % SEEX, f.y % SEEY ), start_dist );
+    cluster_distances( get_path_cluster( goal_grid ), point( t.x % SEEX, t.y % SEEY ), goal_dist );
+    for( size_t i = 0; i < start_cluster.portals.size(); i++ ) {
+        const point &p = start_cluster.portals[i].pos;
+        const int d = start_dist[cluster_index( p.x, p.y )];
+        if( d != INT_MAX ) {
+            add_node( node_key( start_grid, i ), d, start_key, node_pos( node_key( start_grid, i ) ) );
+        }
+    }
+
+    bool done = false;
+    while( !open.empty() ) {
+        const int key = open.top().second;
+        open.pop();
+        if( key == goal_key ) {
+            done = true;
+            break;
+        }
+        if( !closed.insert( key ).second ) {
+            continue;
+        }
+
+        const int g = gscore[key];
+        if( g > maxdist ) {
+            break;
+        }
+
+        const tripoint gp = node_grid( key );
+        const size_t index = key % MAX_CLUSTER_PORTALS;
+        const path_cluster &cluster = get_path_cluster( gp );
+        const path_cluster::portal &portal = cluster.portals[index];
+        if( gp == goal_grid ) {
+            const int d = goal_dist[cluster_index( portal.pos.x, portal.pos.y )];
+            if( d != INT_MAX ) {
+                add_node( goal_key, g + d, key, t );
+            }
+        }
+
+        for( const auto &edge : cluster.edges[index] ) {
+            const int other = node_key( gp, edge.first );
+            add_node( other, g + edge.second, key, node_pos( other ) );
+        }
+
+        const point &offset = cluster_offsets[portal.dir];
+        const tripoint np( gp.x + offset.x, gp.y + offset.y, gp.z );
+        const path_cluster &neighbour = get_path_cluster( np );
+        const point target = across_border( portal.pos, portal.dir );
+        for( size_t i = 0; i < neighbour.portals.size(); i++ ) {
+            const auto &other = neighbour.portals[i];
+            if( other.pos == target && other.dir == opposite( portal.dir ) ) {
+                const int other_key = node_key( np, i );
+                add_node( other_key, g + neighbour.cost[cluster_index( target.x, target.y )], key,
+                          node_pos( other_key ) );
+                break;
+            }
+        }
+    }
+
+    if( !done ) {
+        return ret;
+    }
+
+    std::vector<tripoint> waypoints;
+    waypoints.push_back( t );
+    for( int key = parent[goal_key]; key != start_key; key = parent[key] ) {
+        waypoints.push_back( node_pos( key ) );
+    }
+    std::reverse( waypoints.begin(), waypoints.end() );
+
+    // Refine the abstract path one short leg at a time
+    tripoint cur = f;
+    for( const tripoint &wp : waypoints ) {
+        if( wp == cur ) {
+            continue;
+        }
+        const auto leg = route_local( cur, wp, bash, maxdist );
+        if( leg.empty() ) {
+            return std::vector<tripoint>();
+        }
+        ret.insert( ret.end(), leg.begin(), leg.end() );
+        cur = wp;
+    }
+
+    return ret;
+}
+
+constexpr uint16_t flow_field::unreachable;
+
+const flow_field &map::get_flow_field( const tripoint &target ) const
+{
+    const int turn = calendar::turn;
+    flow_field *field = nullptr;
+    flow_field *unused = nullptr;
+    for( auto &f : flow_fields ) {
+        if( f->target == target ) {
+            field = f.get();
+            break;
+        } else if( unused == nullptr && f->last_used != turn ) {
+            unused = f.get();
+        }
+    }
+
+    if( field == nullptr ) {
+        // Recycle a field nobody asked for this turn, usually the one of a target that moved
+        if( unused == nullptr ) {
+            flow_fields.emplace_back( new flow_field() );
+            unused = flow_fields.back().get();
+        }
+        field = unused;
+        field->target = target;
+        field->dirty = true;
+    }
+
+    field->last_used = turn;
+    if( field->dirty ) {
+        build_flow_field( *field );
+    }
+
+    return *field;
+}
+
+void map::build_flow_field( flow_field &field ) const
+{
+    const tripoint &target = field.target;
+    const int size = SEEX * my_MAPSIZE;
+    field.size = size;
+    field.dirty = false;
+    field.dist.fill( flow_field::unreachable );
+    if( !inbounds( target ) ) {
+        return;
+    }
+
+    // The move costs come from the clusters, which are only rescanned when their submap changed
+    std::vector<const path_cluster *> clusters( my_MAPSIZE * my_MAPSIZE );
+    int max_cost = 0;
+    for( int gx = 0; gx < my_MAPSIZE; gx++ ) {
+        for( int gy = 0; gy < my_MAPSIZE; gy++ ) {
+            const path_cluster &cluster = get_path_cluster_costs( tripoint( gx, gy, target.z ) );
+            clusters[gx * my_MAPSIZE + gy] = &cluster;
+            max_cost = std::max( max_cost, *std::max_element( cluster.cost.begin(), cluster.cost.end() ) );
+        }
+    }
+
+    // Steps cost small integers, so the open list is a ring of buckets indexed by distance
+    // (Dial's algorithm) instead of a heap. A step never reaches further than the ring is long.
+    auto &buckets = field.buckets;
+    const int num_buckets = max_cost + 2;
+    if( int( buckets.size() ) < num_buckets ) {
+        buckets.resize( num_buckets );
+    }
+    for( auto &bucket : buckets ) {
+        bucket.clear();
+    }
+
+    field.dist[flat_index( target.x, target.y )] = 0;
+    buckets[0].push_back( flat_index( target.x, target.y ) );
+    int pending = 1;
+    for( int d = 0; pending > 0; d++ ) {
+        auto &bucket = buckets[d % num_buckets];
+        for( size_t i = 0; i < bucket.size(); i++ ) {
+            const int cur = bucket[i];
+            pending--;
+            if( field.dist[cur] != d ) {
+                // Already reached by a cheaper path
+                continue;
+            }
+
+            const int x = cur / ( MAPSIZE * SEEY );
+            const int y = cur % ( MAPSIZE * SEEY );
+            for( int dx = -1; dx <= 1; dx++ ) {
+                for( int dy = -1; dy <= 1; dy++ ) {
+                    const int nx = x + dx;
+                    const int ny = y + dy;
+                    if( ( dx == 0 && dy == 0 ) || nx < 0 || nx >= size || ny < 0 || ny >= size ) {
+                        continue;
+                    }
+
+                    const path_cluster &cluster = *clusters[( nx / SEEX ) * my_MAPSIZE + ny / SEEY];
+                    const int cost = cluster.cost[cluster_index( nx % SEEX, ny % SEEY )];
+                    if( cost == 0 ) {
+                        continue;
+                    }
+
+                    // Same costs as the A* in map::route_local, including the diagonal penalty
+                    const int newd = d + cost + ( ( dx != 0 && dy != 0 ) ? 1 : 0 );
+                    const int index = flat_index( nx, ny );
+                    if( newd < field.dist[index] ) {
+                        field.dist[index] = uint16_t( newd );
+                        buckets[newd % num_buckets].push_back( index );
+                        pending++;
+                    }
+                }
+            }
+        }
+        bucket.clear();
+    }
+}
@@ -0,0 +1,216 @@
+#ifndef PATHFINDING_H
+#define PATHFINDING_H
+
+#include "enums.h"
+#include "game_constants.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class submap;
+
+enum astar_state {
+    ASL_NONE,
+    ASL_OPEN,
+    ASL_CLOSED
+};
+
+// Turns two indexed to a 2D array into an index to equivalent 1D array
+constexpr int flat_index( const int x, const int y )
+{
+    return ( x * MAPSIZE * SEEY ) + y;
+}
+
+constexpr int PATH_LAYER_SIZE = SEEX * MAPSIZE * SEEY * MAPSIZE;
+
+// Flattened 2D array representing a single z-level worth of pathfinding data
+struct path_data_layer {
+    // State is accessed way more often than all other values here.
+    // A cell is open/closed only if its stamp matches the current search,
+    // so stale data from earlier searches never has to be cleared.
+    std::array< uint32_t, PATH_LAYER_SIZE > state;
+    std::array< uint16_t, PATH_LAYER_SIZE > score;
+    std::array< uint16_t, PATH_LAYER_SIZE > gscore;
+    // Packed with @ref pathfinder::pack
+    std::array< uint32_t, PATH_LAYER_SIZE > parent;
+};
+
+/**
+ * Working set of the A* search in @ref map::route.
+ *
+ * One instance is owned by each map and reused by every search on it. Layers are allocated
+ * the first time a z-level is searched and kept afterwards, the open list keeps its capacity,
+ * so a warmed up pathfinder does not allocate at all.
+ */
+class pathfinder
+{
+    public:
+        pathfinder() = default;
+        pathfinder( const pathfinder & ) = delete;
+        pathfinder &operator=( const pathfinder & ) = delete;
+
+        /** Starts a new search limited to the given rectangle (inclusive min, exclusive max). */
+        void reset( int minx, int miny, int maxx, int maxy );
+
+        int minx = 0;
+        int miny = 0;
+        int maxx = 0;
+        int maxy = 0;
+
+        path_data_layer &get_layer( int z );
+
+        astar_state get_state( const path_data_layer &layer, const int index ) const {
+            const uint32_t st = layer.state[index];
+            if( st == open_stamp ) {
+                return ASL_OPEN;
+            } else if( st == closed_stamp ) {
+                return ASL_CLOSED;
+            }
+            return ASL_NONE;
+        }
+
+        void set_closed( path_data_layer &layer, const int index ) {
+            layer.state[index] = closed_stamp;
+        }
+
+        bool empty() const {
+            return open.empty();
+        }
+
+        tripoint get_next();
+
+        void add_point( int gscore, int score, const tripoint &from, const tripoint &to );
+
+        void close_point( const tripoint &p );
+
+        /** Number of heap allocations done by this pathfinder since its creation. */
+        size_t allocation_count() const {
+            return allocations;
+        }
+
+        /** Packs an in-bounds point into a single integer, see @ref unpack */
+        static uint32_t pack( const tripoint &p ) {
+            return uint32_t( flat_index( p.x, p.y ) * OVERMAP_LAYERS + p.z + OVERMAP_DEPTH );
+        }
+        static tripoint unpack( const uint32_t packed ) {
+            const int index = packed / OVERMAP_LAYERS;
+            return tripoint( index / ( MAPSIZE * SEEY ), index % ( MAPSIZE * SEEY ),
+                             int( packed % OVERMAP_LAYERS ) - OVERMAP_DEPTH );
+        }
+
+    private:
+        // Binary min-heap of (score, packed point)
+        std::vector< std::pair<int, uint32_t> > open;
+        std::array< std::unique_ptr< path_data_layer >, OVERMAP_LAYERS > path_data;
+
+        uint32_t open_stamp = 0;
+        uint32_t closed_stamp = 0;
+        size_t allocations = 0;
+};
+
+/** Pathfinding data of one submap, the cluster of the hierarchical search in @ref map::route. */
+struct path_cluster {
+    /** Direction of the neighbouring cluster a portal leads to. */
+    enum portal_direction : int {
+        NORTH, EAST, SOUTH, WEST
+    };
+
+    struct portal {
+        /** In submap coordinates. */
+        point pos;
+        portal_direction dir;
+    };
+
+    /** Move cost of each tile (indexed x * SEEY + y), 0 if it can't be entered at all. */
+    std::array<int, SEEX * SEEY> cost;
+    /** Middle tiles of the passable stretches along the borders to the neighbouring clusters. */
+    std::vector<portal> portals;
+    /** For each portal: the portals reachable without leaving the cluster and the cost to get there. */
+    std::vector< std::vector< std::pair<size_t, int> > > edges;
+
+    /** Terrain, furniture or vehicles in this cluster changed. */
+    bool costs_dirty = true;
+    /** The border of a neighbouring cluster changed. */
+    bool portals_dirty = true;
+    /**
+     * Submaps the data was built from. Loading or generating a submap swaps the pointer,
+     * which invalidates the data without having to hook every place that does so.
+     */
+    const submap *built_for = nullptr;
+    std::array<const submap *, 4> neighbours_built_for = {{ nullptr, nullptr, nullptr, nullptr }};
+};
+
+/**
+ * Cache of the submap-level abstract graph used for long routes.
+ *
+ * Clusters are indexed by their grid position and rebuilt lazily, only when a search
+ * reaches them after they were marked dirty.
+ */
+class portal_graph
+{
+    public:
+        explicit portal_graph( int mapsize );
+
+        path_cluster &get_cluster( const tripoint &gridp );
+
+        /** Marks the cluster containing the tile (in map coordinates) as changed. */
+        void set_dirty( const tripoint &p );
+        void set_all_dirty();
+        /** Moves the cached clusters along with the map, see @ref map::shift. */
+        void shift( int sx, int sy );
+
+        int get_mapsize() const {
+            return mapsize;
+        }
+
+    private:
+        int mapsize;
+        std::array< std::vector<path_cluster>, OVERMAP_LAYERS > levels;
+};
+
+/**
+ * Distances from every tile of one z-level to a single target, usually the player or an NPC.
+ *
+ * Built by one Dijkstra search over the whole level, after which any number of monsters
+ * can walk toward the target by stepping to the neighbour with the lowest distance.
+ * See @ref map::get_flow_field for how fields are cached and invalidated.
+ */
+class flow_field
+{
+    public:
+        static constexpr uint16_t unreachable = UINT16_MAX;
+
+        flow_field() = default;
+        flow_field( const flow_field & ) = delete;
+        flow_field &operator=( const flow_field & ) = delete;
+
+        const tripoint &get_target() const {
+            return target;
+        }
+
+        /** Cost of the cheapest path from p to the target, @ref unreachable if there is none. */
+        uint16_t distance( const tripoint &p ) const {
+            if( p.z != target.z || p.x < 0 || p.y < 0 || p.x >= size || p.y >= size ) {
+                return unreachable;
+            }
+            return dist[flat_index( p.x, p.y )];
+        }
+
+    private:
+        friend class map;
+
+        tripoint target = tripoint_min;
+        /** Width and height of the map the field was built for, in tiles. */
+        int size = 0;
+        /** Terrain, furniture or vehicles changed since the field was built. */
+        bool dirty = true;
+        /** Turn the field was last requested on, fields unused this turn can be recycled. */
+        int last_used = -1;
+        std::array< uint16_t, PATH_LAYER_SIZE > dist;
+        // Open list of the search, flat indices bucketed by distance, kept to reuse their capacity
+        std::vector< std::vector<int> > buckets;
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include "json.h"
 #include "bodypart.h"
 #include "string_id.h"
+#include "interned_id.h"
 #include <map>
 #include <string>
 
@@ -18,6 +19,15 @@ using matec_id = string_id<ma_technique>;
 
 typedef std::string efftype_id;
 
+class effect_type;
+using effect_id = interned_id<effect_type>;
+
+struct mutation_branch;
+using trait_id = interned_id<mutation_branch>;
+
+struct bionic_data;
+using bionic_id = interned_id<bionic_data>;
+
 typedef std::string dis_type;
 
 enum character_type : int {
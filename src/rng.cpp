@@ -2,18 +2,45 @@
 #include "rng.h"
 #include <stdlib.h>
 
+namespace
+{
+
+thread_local rng_stream *current_stream = nullptr;
+
+int random_int()
+{
+    return current_stream != nullptr ? current_stream->next() : rand();
+}
+
+}
+
+rng_stream::rng_stream( const unsigned int seed ) : engine( seed ), previous( current_stream )
+{
+    current_stream = this;
+}
+
+rng_stream::~rng_stream()
+{
+    current_stream = previous;
+}
+
+int rng_stream::next()
+{
+    return int( ( engine() - engine.min() ) % ( unsigned( RAND_MAX ) + 1 ) );
+}
+
 long rng(long val1, long val2)
 {
     long minVal = (val1 < val2) ? val1 : val2;
     long maxVal = (val1 < val2) ? val2 : val1;
-    return minVal + long((maxVal - minVal + 1) * double(rand() / double(RAND_MAX + 1.0)));
+    return minVal + long((maxVal - minVal + 1) * double(random_int() / double(RAND_MAX + 1.0)));
 }
 
 double rng_float(double val1, double val2)
 {
     double minVal = (val1 < val2) ? val1 : val2;
     double maxVal = (val1 < val2) ? val2 : val1;
-    return minVal + (maxVal - minVal) * double(rand()) / double(RAND_MAX + 1.0);
+    return minVal + (maxVal - minVal) * double(random_int()) / double(RAND_MAX + 1.0);
 }
 
 bool one_in(int chance)
@@ -29,7 +56,7 @@ bool one_in_improved(double chance)
 
 bool x_in_y(double x, double y)
 {
-    return ((double)rand() / RAND_MAX) <= ((double)x / y);
+    return ((double)random_int() / RAND_MAX) <= ((double)x / y);
 }
 
 int dice(int number, int sides)
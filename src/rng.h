@@ -4,6 +4,7 @@
 #include "compatibility.h"
 
 #include <functional>
+#include <random>
 
 long rng( long val1, long val2 );
 double rng_float( double val1, double val2 );
@@ -17,6 +18,28 @@ int divide_roll_remainder( double dividend, double divisor );
 
 int djb2_hash( const unsigned char *input );
 
+/**
+ * While it exists, the random functions above called on the same thread draw from this
+ * stream instead of the shared one. Work handed to other threads can use one stream per
+ * item of work, so that the results don't depend on which thread ran it, or when.
+ * Streams can be nested, the innermost one is used.
+ */
+class rng_stream
+{
+    public:
+        explicit rng_stream( unsigned int seed );
+        ~rng_stream();
+        rng_stream( const rng_stream & ) = delete;
+        rng_stream &operator=( const rng_stream & ) = delete;
+
+        /** Next number in [0, RAND_MAX], same as rand(). */
+        int next();
+
+    private:
+        std::minstd_rand engine;
+        rng_stream *previous;
+};
+
 /**
  * Returns a random entry in the container.
  * The container must have a `size()` function and must support iterators as usual.
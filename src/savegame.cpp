@@ -19,6 +19,7 @@
 #include "mapdata.h"
 #include "translations.h"
 #include "mongroup.h"
+#include "scent_map.h"
 #include <map>
 #include <set>
 #include <algorithm>
@@ -27,6 +28,8 @@
 #include <sstream>
 #include <math.h>
 #include <vector>
+#include <iterator>
+#include <stdexcept>
 #include "debug.h"
 #include "weather.h"
 #include "mapsharing.h"
@@ -82,26 +85,7 @@ void game::serialize(std::ofstream & fout) {
         json.member( "om_y", pos_om.y );
 
         // Next, the scent map.
-        std::stringstream rle_out;
-        int rle_lastval = -1;
-        int rle_count = 0;
-        for( auto &elem : grscent ) {
-            for( auto val : elem ) {
-
-               if (val == rle_lastval) {
-                   rle_count++;
-               } else {
-                   if ( rle_count ) {
-                       rle_out << rle_count << " ";
-                   }
-                   rle_out << val << " ";
-                   rle_lastval = val;
-                   rle_count = 1;
-               }
-            }
-        }
-        rle_out << rle_count;
-        json.member( "grscent", rle_out.str() );
+        json.member( "grscent", scent.serialize() );
 
         // Then each monster
         json.member( "active_monsters", critter_tracker->list() );
@@ -205,20 +189,7 @@ void game::unserialize(std::ifstream & fin)
 
         linebuf="";
         if ( data.read("grscent",linebuf) ) {
-            linein.clear();
-            linein.str(linebuf);
-
-            int stmp;
-            int count = 0;
-            for( auto &elem : grscent ) {
-                for( auto &elem_j : elem ) {
-                    if (count == 0) {
-                        linein >> stmp >> count;
-                    }
-                    count--;
-                    elem_j = stmp;
-                }
-            }
+            scent.deserialize( linebuf );
         }
 
         JsonArray vdata = data.get_array("active_monsters");
@@ -356,8 +327,229 @@ void overmap::convert_terrain( std::unordered_map<tripoint, std::string> &needs_
     }
 }
 
+/*
+ * Terrain files are binary since savegame version 25, the json format of version 25 is still
+ * read. Numbers are little endian:
+ *  "CDOT" and the format version (uint32)
+ *  the number of terrain ids used (uint32), each as its length (uint16) and characters
+ *  the offset and size (uint32 each) of every layer, from the lowest one up
+ *  the offset and size of a json object with everything else
+ * Each layer is a list of runs, each a terrain index and a count (uint16 each), in the same
+ * order as the json format. Offsets are from the start of the file. Layers are only unpacked
+ * when they are used, which is rarely more than a few of them.
+ */
+namespace
+{
+
+const std::string overmap_terrain_magic = "CDOT";
+const uint32_t overmap_terrain_version = 1;
+
+void write_u16( std::string &out, uint16_t value )
+{
+    out += static_cast<char>( value & 0xff );
+    out += static_cast<char>( value >> 8 );
+}
+
+void write_u32( std::string &out, uint32_t value )
+{
+    write_u16( out, value & 0xffff );
+    write_u16( out, value >> 16 );
+}
+
+// Reads the numbers back, throws if the data is cut short.
+class terrain_reader
+{
+    public:
+        terrain_reader( const std::string &data, size_t pos ) : data( data ), pos( pos ) {
+        }
+        bool done() const {
+            return pos >= data.size();
+        }
+        uint16_t u16() {
+            need( 2 );
+            const uint16_t value = static_cast<unsigned char>( data[pos] ) |
+                                   static_cast<unsigned char>( data[pos + 1] ) << 8;
+            pos += 2;
+            return value;
+        }
+        uint32_t u32() {
+            const uint32_t low = u16();
+            return low | static_cast<uint32_t>( u16() ) << 16;
+        }
+        std::string str( size_t size ) {
+            need( size );
+            pos += size;
+            return data.substr( pos - size, size );
+        }
+    private:
+        void need( size_t size ) const {
+            if( data.size() - pos < size ) {
+                throw std::runtime_error( "overmap terrain data is cut short" );
+            }
+        }
+        const std::string &data;
+        size_t pos;
+};
+
+// Numbers the terrain ids as they come and packs each layer into runs.
+class terrain_writer
+{
+    public:
+        std::vector<std::string> names;
+
+        void add( const oter_id &ter, uint16_t count ) {
+            if( run_count == 0 || static_cast<int>( ter ) != run_ter ) {
+                end_run();
+                run_ter = ter;
+                run_index = index_of( ter );
+            }
+            run_count += count;
+        }
+        std::string finish_layer() {
+            end_run();
+            std::string result;
+            result.swap( runs );
+            return result;
+        }
+    private:
+        size_t index_of( const oter_id &ter ) {
+            const auto iter = indexes.find( ter );
+            if( iter != indexes.end() ) {
+                return iter->second;
+            }
+            indexes[ter] = names.size();
+            names.push_back( static_cast<const std::string &>( ter ) );
+            return names.size() - 1;
+        }
+        void end_run() {
+            if( run_count > 0 ) {
+                write_u16( runs, run_index );
+                write_u16( runs, run_count );
+            }
+            run_count = 0;
+        }
+        std::unordered_map<int, size_t> indexes;
+        std::string runs;
+        int run_ter = 0;
+        size_t run_index = 0;
+        size_t run_count = 0;
+};
+
+// A layer has to cover the whole overmap with known terrain indexes.
+void check_layer_runs( const std::string &runs, size_t terrain_count )
+{
+    terrain_reader reader( runs, 0 );
+    size_t total = 0;
+    while( !reader.done() ) {
+        if( reader.u16() >= terrain_count ) {
+            throw std::runtime_error( "overmap terrain index out of range" );
+        }
+        total += reader.u16();
+    }
+    if( total != OMAPX * OMAPY ) {
+        throw std::runtime_error( "overmap terrain layer has the wrong size" );
+    }
+}
+
+}
+
+void overmap::unpack_layer( int z )
+{
+    std::string runs;
+    runs.swap( packed_layers[z] );
+    terrain_reader reader( runs, 0 );
+    int i = 0;
+    int j = 0;
+    while( !reader.done() ) {
+        const oter_id ter = packed_terrain[reader.u16()];
+        for( int count = reader.u16(); count > 0; count-- ) {
+            layer[z].terrain[i][j] = ter;
+            if( ++i == OMAPX ) {
+                i = 0;
+                j++;
+            }
+        }
+    }
+}
+
+// throws std::exception
+void overmap::unserialize_binary( const std::string &data )
+{
+    terrain_reader header( data, 0 );
+    if( header.str( overmap_terrain_magic.size() ) != overmap_terrain_magic ) {
+        throw std::runtime_error( "not an overmap terrain file" );
+    }
+    const uint32_t version = header.u32();
+    if( version != overmap_terrain_version ) {
+        throw std::runtime_error( string_format( "unknown overmap terrain format %d", int( version ) ) );
+    }
+    const uint32_t terrain_count = header.u32();
+    packed_terrain.clear();
+    // Names of terrain that has to be converted after everything was unpacked, by index.
+    std::vector<std::string> obsolete( terrain_count );
+    bool has_obsolete = false;
+    for( uint32_t t = 0; t < terrain_count; t++ ) {
+        const std::string name = header.str( header.u16() );
+        if( obsolete_terrain( name ) ) {
+            obsolete[t] = name;
+            has_obsolete = true;
+            packed_terrain.push_back( 0 );
+        } else if( otermap.find( name ) != otermap.end() ) {
+            packed_terrain.push_back( name );
+        } else {
+            debugmsg( "Loaded bad ter! ter %s", name.c_str() );
+            packed_terrain.push_back( 0 );
+        }
+    }
+    for( int z = 0; z < OVERMAP_LAYERS; ++z ) {
+        const uint32_t offset = header.u32();
+        const uint32_t size = header.u32();
+        if( offset > data.size() || size > data.size() - offset ) {
+            throw std::runtime_error( "overmap terrain layer is outside of the file" );
+        }
+        packed_layers[z] = data.substr( offset, size );
+        check_layer_runs( packed_layers[z], terrain_count );
+    }
+    const uint32_t objects_offset = header.u32();
+    const uint32_t objects_size = header.u32();
+    if( objects_offset > data.size() || objects_size > data.size() - objects_offset ) {
+        throw std::runtime_error( "overmap objects are outside of the file" );
+    }
+
+    if( has_obsolete ) {
+        std::unordered_map<tripoint, std::string> needs_conversion;
+        for( int z = 0; z < OVERMAP_LAYERS; ++z ) {
+            terrain_reader reader( packed_layers[z], 0 );
+            size_t pos = 0;
+            while( !reader.done() ) {
+                const std::string &name = obsolete[reader.u16()];
+                const size_t count = reader.u16();
+                for( size_t p = pos; !name.empty() && p < pos + count; p++ ) {
+                    needs_conversion.emplace( tripoint( p % OMAPX, p / OMAPX, z - OVERMAP_DEPTH ), name );
+                }
+                pos += count;
+            }
+            unpack_layer( z );
+        }
+        convert_terrain( needs_conversion );
+    }
+
+    JsonIn jsin( data.data() + objects_offset, objects_size );
+    unserialize_objects( jsin );
+}
+
 // throws std::exception
 void overmap::unserialize( std::ifstream &fin ) {
+    for( auto &packed : packed_layers ) {
+        packed.clear();
+    }
+
+    if( fin.peek() == overmap_terrain_magic[0] ) {
+        const std::string data( ( std::istreambuf_iterator<char>( fin ) ),
+                                std::istreambuf_iterator<char>() );
+        unserialize_binary( data );
+        return;
+    }
 
     if ( fin.peek() == '#' ) {
         // This was the last savegame version that produced the old format.
@@ -375,6 +567,11 @@ void overmap::unserialize( std::ifstream &fin ) {
     }
 
     JsonIn jsin( fin );
+    unserialize_objects( jsin );
+}
+
+void overmap::unserialize_objects( JsonIn &jsin )
+{
     jsin.start_object();
     while( !jsin.end_object() ) {
         const std::string name = jsin.get_member_name();
@@ -537,7 +734,8 @@ void overmap::unserialize( std::ifstream &fin ) {
     }
 }
 
-static void unserialize_array_from_compacted_sequence( JsonIn &jsin, bool (&array)[OMAPX][OMAPY] )
+static void unserialize_array_from_compacted_sequence( JsonIn &jsin,
+        std::bitset<OMAPX * OMAPY> &array )
 {
     int count = 0;
     bool value = false;
@@ -550,7 +748,7 @@ static void unserialize_array_from_compacted_sequence( JsonIn &jsin, bool (&arra
                 jsin.end_array();
             }
             count--;
-            array[i][j] = value;
+            array[map_layer::index( i, j )] = value;
         }
     }
 }
@@ -614,12 +812,13 @@ void overmap::unserialize_view(std::ifstream &fin)
     }
 }
 
-static void serialize_array_to_compacted_sequence( JsonOut &json, const bool (&array)[OMAPX][OMAPY] ) {
+static void serialize_array_to_compacted_sequence( JsonOut &json,
+        const std::bitset<OMAPX * OMAPY> &array ) {
     int count = 0;
     int lastval = -1;
     for( int j = 0; j < OMAPY; j++ ) {
         for( int i = 0; i < OMAPX; i++ ) {
-            int value = array[i][j];
+            int value = array[map_layer::index( i, j )];
             if( value != lastval ) {
                 if (count) {
                     json.write(count);
@@ -638,7 +837,7 @@ static void serialize_array_to_compacted_sequence( JsonOut &json, const bool (&a
     json.end_array();
 }
 
-void overmap::serialize_view( std::ofstream &fout ) const
+void overmap::serialize_view( std::ostream &fout ) const
 {
     static const int first_overmap_view_json_version = 25;
     fout << "# version " << first_overmap_view_json_version << std::endl;
@@ -685,50 +884,35 @@ void overmap::serialize_view( std::ofstream &fout ) const
     json.end_object();
 }
 
-void overmap::serialize( std::ofstream &fout ) const
+void overmap::serialize( std::ostream &fout ) const
 {
-    static const int first_overmap_json_version = 25;
-    fout << "# version " << first_overmap_json_version << std::endl;
-
-    JsonOut json(fout, false);
-    json.start_object();
-
-    json.member("layers");
-    json.start_array();
-    for (int z = 0; z < OVERMAP_LAYERS; ++z) {
-        int count = 0;
-        oter_id last_tertype(-1);
-        json.start_array();
-        for (int j = 0; j < OMAPY; j++) {
-            for (int i = 0; i < OMAPX; i++) {
-                oter_id t = layer[z].terrain[i][j];
-                if (t != last_tertype) {
-                    if (count) {
-                        json.write(count);
-                        json.end_array();
-                    }
-                    last_tertype = t;
-                    json.start_array();
-                    json.write( (std::string)t );
-                    count = 1;
-                } else {
-                    count++;
+    terrain_writer writer;
+    std::array<std::string, OVERMAP_LAYERS> layers;
+    for( int z = 0; z < OVERMAP_LAYERS; ++z ) {
+        if( !packed_layers[z].empty() ) {
+            // Not used since it was loaded, the runs stay the same.
+            terrain_reader reader( packed_layers[z], 0 );
+            while( !reader.done() ) {
+                const oter_id &ter = packed_terrain[reader.u16()];
+                writer.add( ter, reader.u16() );
+            }
+        } else {
+            for( int j = 0; j < OMAPY; j++ ) {
+                for( int i = 0; i < OMAPX; i++ ) {
+                    writer.add( layer[z].terrain[i][j], 1 );
                 }
             }
         }
-        json.write(count);
-        // End the last entry for a z-level.
-        json.end_array();
-        // End the z-level
-        json.end_array();
-        // Insert a newline occasionally so the file isn't totally unreadable.
-        fout << std::endl;
+        layers[z] = writer.finish_layer();
     }
-    json.end_array();
+
+    std::ostringstream objects;
+    JsonOut json( objects, false );
+    json.start_object();
 
     // temporary, to allow user to manually switch regions during play until regionmap is done.
     json.member("region_id", settings.id);
-    fout << std::endl;
+    objects << std::endl;
 
     json.member("mongroups");
     json.start_array();
@@ -736,7 +920,7 @@ void overmap::serialize( std::ofstream &fout ) const
         json.write(group.second);
     }
     json.end_array();
-    fout << std::endl;
+    objects << std::endl;
 
     json.member("cities");
     json.start_array();
@@ -749,7 +933,7 @@ void overmap::serialize( std::ofstream &fout ) const
         json.end_object();
     }
     json.end_array();
-    fout << std::endl;
+    objects << std::endl;
 
     json.member("roads_out");
     json.start_array();
@@ -760,7 +944,7 @@ void overmap::serialize( std::ofstream &fout ) const
         json.end_object();
     }
     json.end_array();
-    fout << std::endl;
+    objects << std::endl;
 
     json.member("radios");
     json.start_array();
@@ -774,7 +958,7 @@ void overmap::serialize( std::ofstream &fout ) const
         json.end_object();
     }
     json.end_array();
-    fout << std::endl;
+    objects << std::endl;
 
     json.member("monster_map");
     json.start_array();
@@ -783,7 +967,7 @@ void overmap::serialize( std::ofstream &fout ) const
         i.second.serialize(json);
     }
     json.end_array();
-    fout << std::endl;
+    objects << std::endl;
 
     json.member("tracked_vehicles");
     json.start_array();
@@ -796,7 +980,7 @@ void overmap::serialize( std::ofstream &fout ) const
         json.end_object();
     }
     json.end_array();
-    fout << std::endl;
+    objects << std::endl;
 
     json.member("npcs");
     json.start_array();
@@ -804,10 +988,34 @@ void overmap::serialize( std::ofstream &fout ) const
         json.write( *i );
     }
     json.end_array();
-    fout << std::endl;
+    objects << std::endl;
 
     json.end_object();
-    fout << std::endl;
+    objects << std::endl;
+    const std::string objects_data = objects.str();
+
+    std::string header = overmap_terrain_magic;
+    write_u32( header, overmap_terrain_version );
+    write_u32( header, writer.names.size() );
+    for( auto &name : writer.names ) {
+        write_u16( header, name.size() );
+        header += name;
+    }
+    // The offsets follow, the data comes after them.
+    size_t offset = header.size() + ( OVERMAP_LAYERS + 1 ) * 8;
+    for( auto &runs : layers ) {
+        write_u32( header, offset );
+        write_u32( header, runs.size() );
+        offset += runs.size();
+    }
+    write_u32( header, offset );
+    write_u32( header, objects_data.size() );
+
+    fout << header;
+    for( auto &runs : layers ) {
+        fout << runs;
+    }
+    fout << objects_data;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////
@@ -218,8 +218,16 @@ void Character::load(JsonObject &data)
             my_mutations.erase( it++ );
         }
     }
+    trait_ids.clear();
+    for( auto &mut : my_mutations ) {
+        trait_ids.set( trait_id( mut.first ) );
+    }
 
     data.read( "my_bionics", my_bionics );
+    bionic_ids.clear();
+    for( auto &bio : my_bionics ) {
+        bionic_ids.set( bionic_id( bio.id ) );
+    }
 
     worn.clear();
     data.read( "worn", worn );
@@ -1790,6 +1798,7 @@ void Creature::load( JsonObject &jsin )
                     }
                     effects[maps.first][(body_part)key_num] = i.second;
                 }
+                effect_ids.set( effect_id( maps.first ) );
             }
         }
     }
@@ -0,0 +1,388 @@
+#include "scent_map.h"
+#include "map.h"
+#include "debug.h"
+
+#include <algorithm>
+#include <sstream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define dbg(x) DebugLog((DebugLevel)(x),D_GAME) << __FILE__ << ":" << __LINE__ << ": "
+
+namespace
+{
+
+constexpr int SCENT_RADIUS = 40;
+// Decrease this to reduce gas spread. Keep it under 125 for stability.
+// This is essentially a decimal number * 1000.
+constexpr int DIFFUSIVITY = 100;
+// Less air movement on REDUCE_SCENT tiles.
+constexpr int REDUCED_DIFFUSIVITY = DIFFUSIVITY / 5;
+
+/**
+ * Weighted sum of the scent of each tile and its two neighbours along y: walls don't
+ * count, REDUCE_SCENT tiles count twice, other tiles ten times (so only 20% of the scent
+ * diffuses through REDUCE_SCENT tiles). All arrays are indexed from the first tile, the
+ * scent and masks have to be valid one tile before and after the row.
+ */
+void sum_3_scent( const int *scent, const int *pass, const int *full, int *sum, int *used,
+                  const int count )
+{
+    int i = 0;
+#if defined(__AVX2__)
+    const __m256i two = _mm256_set1_epi32( 2 );
+    const __m256i eight = _mm256_set1_epi32( 8 );
+    for( ; i + 8 <= count; i += 8 ) {
+        __m256i s = _mm256_setzero_si256();
+        __m256i u = _mm256_setzero_si256();
+        for( int j = i - 1; j <= i + 1; ++j ) {
+            const __m256i sc = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( scent + j ) );
+            const __m256i p = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( pass + j ) );
+            const __m256i f = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( full + j ) );
+            s = _mm256_add_epi32( s, _mm256_and_si256( _mm256_slli_epi32( sc, 1 ), p ) );
+            s = _mm256_add_epi32( s, _mm256_and_si256( _mm256_slli_epi32( sc, 3 ), f ) );
+            u = _mm256_add_epi32( u, _mm256_and_si256( two, p ) );
+            u = _mm256_add_epi32( u, _mm256_and_si256( eight, f ) );
+        }
+        _mm256_storeu_si256( reinterpret_cast<__m256i *>( sum + i ), s );
+        _mm256_storeu_si256( reinterpret_cast<__m256i *>( used + i ), u );
+    }
+#elif defined(__SSE2__)
+    const __m128i two = _mm_set1_epi32( 2 );
+    const __m128i eight = _mm_set1_epi32( 8 );
+    for( ; i + 4 <= count; i += 4 ) {
+        __m128i s = _mm_setzero_si128();
+        __m128i u = _mm_setzero_si128();
+        for( int j = i - 1; j <= i + 1; ++j ) {
+            const __m128i sc = _mm_loadu_si128( reinterpret_cast<const __m128i *>( scent + j ) );
+            const __m128i p = _mm_loadu_si128( reinterpret_cast<const __m128i *>( pass + j ) );
+            const __m128i f = _mm_loadu_si128( reinterpret_cast<const __m128i *>( full + j ) );
+            s = _mm_add_epi32( s, _mm_and_si128( _mm_slli_epi32( sc, 1 ), p ) );
+            s = _mm_add_epi32( s, _mm_and_si128( _mm_slli_epi32( sc, 3 ), f ) );
+            u = _mm_add_epi32( u, _mm_and_si128( two, p ) );
+            u = _mm_add_epi32( u, _mm_and_si128( eight, f ) );
+        }
+        _mm_storeu_si128( reinterpret_cast<__m128i *>( sum + i ), s );
+        _mm_storeu_si128( reinterpret_cast<__m128i *>( used + i ), u );
+    }
+#endif
+    for( ; i < count; ++i ) {
+        int s = 0;
+        int u = 0;
+        for( int j = i - 1; j <= i + 1; ++j ) {
+            s += ( ( 2 * scent[j] ) & pass[j] ) + ( ( 8 * scent[j] ) & full[j] );
+            u += ( 2 & pass[j] ) + ( 8 & full[j] );
+        }
+        sum[i] = s;
+        used[i] = u;
+    }
+}
+
+#if defined(__AVX2__)
+/**
+ * The vector version of the scalar formula in @ref diffuse. Done in double, because there is no
+ * integer division (and no 32 bit multiplication in SSE2). All the intermediate values are far
+ * below 2^53, so the products and sums are exact in any order, and truncating the correctly
+ * rounded quotients gives exactly what the integer division does. That holds with -ffast-math
+ * too: 0.2 and 0.0001 round up as doubles, so multiplying by them never drops below an integer.
+ */
+inline __m128i diffuse_4( const __m128i scent, const __m128i used, const __m128i sum,
+                          const __m128i diff )
+{
+    const __m256d s = _mm256_cvtepi32_pd( scent );
+    const __m256d u = _mm256_cvtepi32_pd( used );
+    const __m256d d = _mm256_cvtepi32_pd( diff );
+    const __m256d sm = _mm256_cvtepi32_pd( sum );
+    __m256d temp = _mm256_mul_pd( s, _mm256_sub_pd( _mm256_set1_pd( 10 * 1000 ),
+                                  _mm256_mul_pd( u, d ) ) );
+    const __m256d absorbed = _mm256_div_pd( _mm256_mul_pd( _mm256_mul_pd( s, d ),
+                                            _mm256_sub_pd( _mm256_set1_pd( 90 ), u ) ), _mm256_set1_pd( 5 ) );
+    temp = _mm256_sub_pd( temp, _mm256_round_pd( absorbed, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC ) );
+    temp = _mm256_add_pd( temp, _mm256_mul_pd( d, sm ) );
+    return _mm256_cvttpd_epi32( _mm256_div_pd( temp, _mm256_set1_pd( 1000 * 10 ) ) );
+}
+#elif defined(__SSE2__)
+/** See the AVX2 version, this does the two halves separately. */
+inline __m128i diffuse_2( const __m128d s, const __m128d u, const __m128d d, const __m128d sm )
+{
+    __m128d temp = _mm_mul_pd( s, _mm_sub_pd( _mm_set1_pd( 10 * 1000 ), _mm_mul_pd( u, d ) ) );
+    const __m128d absorbed = _mm_div_pd( _mm_mul_pd( _mm_mul_pd( s, d ),
+                                         _mm_sub_pd( _mm_set1_pd( 90 ), u ) ), _mm_set1_pd( 5 ) );
+    temp = _mm_sub_pd( temp, _mm_cvtepi32_pd( _mm_cvttpd_epi32( absorbed ) ) );
+    temp = _mm_add_pd( temp, _mm_mul_pd( d, sm ) );
+    return _mm_cvttpd_epi32( _mm_div_pd( temp, _mm_set1_pd( 1000 * 10 ) ) );
+}
+
+inline __m128i high_half( const __m128i v )
+{
+    return _mm_shuffle_epi32( v, _MM_SHUFFLE( 1, 0, 3, 2 ) );
+}
+
+inline __m128i diffuse_4( const __m128i scent, const __m128i used, const __m128i sum,
+                          const __m128i diff )
+{
+    const __m128i lo = diffuse_2( _mm_cvtepi32_pd( scent ), _mm_cvtepi32_pd( used ),
+                                  _mm_cvtepi32_pd( diff ), _mm_cvtepi32_pd( sum ) );
+    const __m128i hi = diffuse_2( _mm_cvtepi32_pd( high_half( scent ) ),
+                                  _mm_cvtepi32_pd( high_half( used ) ),
+                                  _mm_cvtepi32_pd( high_half( diff ) ),
+                                  _mm_cvtepi32_pd( high_half( sum ) ) );
+    return _mm_unpacklo_epi64( lo, hi );
+}
+#endif
+
+/**
+ * Diffuses a row of scent along x, using the y sums of the rows before (l), at (c)
+ * and after (r) it. Tiles that block scent end up with none.
+ */
+void diffuse( int *scent, const int *sum_l, const int *sum_c, const int *sum_r,
+              const int *used_l, const int *used_c, const int *used_r,
+              const int *pass, const int *full, const int count )
+{
+    int i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+    const __m128i reduced = _mm_set1_epi32( REDUCED_DIFFUSIVITY );
+    const __m128i extra = _mm_set1_epi32( DIFFUSIVITY - REDUCED_DIFFUSIVITY );
+    for( ; i + 4 <= count; i += 4 ) {
+#define LOAD4(a) _mm_loadu_si128( reinterpret_cast<const __m128i *>( (a) + i ) )
+        const __m128i used = _mm_add_epi32( _mm_add_epi32( LOAD4( used_l ), LOAD4( used_c ) ),
+                                            LOAD4( used_r ) );
+        const __m128i sum = _mm_add_epi32( _mm_add_epi32( LOAD4( sum_l ), LOAD4( sum_c ) ),
+                                           LOAD4( sum_r ) );
+        const __m128i diff = _mm_add_epi32( reduced, _mm_and_si128( extra, LOAD4( full ) ) );
+        const __m128i result = diffuse_4( LOAD4( scent ), used, sum, diff );
+        _mm_storeu_si128( reinterpret_cast<__m128i *>( scent + i ),
+                          _mm_and_si128( result, LOAD4( pass ) ) );
+#undef LOAD4
+    }
+#endif
+    for( ; i < count; ++i ) {
+        // To how many neighboring squares do we diffuse out? (include our own square
+        // since we also include our own square when diffusing in)
+        const int squares_used = used_l[i] + used_c[i] + used_r[i];
+        const int this_diffusivity = REDUCED_DIFFUSIVITY +
+                                     ( ( DIFFUSIVITY - REDUCED_DIFFUSIVITY ) & full[i] );
+        // take the old scent and subtract what diffuses out
+        int temp_scent = scent[i] * ( 10 * 1000 - squares_used * this_diffusivity );
+        // neighboring walls and reduce_scent squares absorb some scent
+        temp_scent -= scent[i] * this_diffusivity * ( 90 - squares_used ) / 5;
+        // what diffuses into our current square
+        scent[i] = ( ( temp_scent + this_diffusivity * ( sum_l[i] + sum_c[i] + sum_r[i] ) ) /
+                     ( 1000 * 10 ) ) & pass[i];
+    }
+}
+
+} // namespace
+
+scent_map::scent_map()
+{
+    reset();
+}
+
+// TODO: Unify this and scent area used in update() to fix "scent pocket" bug
+bool scent_map::inbounds( const tripoint &p )
+{
+    return p.x >= ( SEEX * MAPSIZE / 2 ) - SCENT_RADIUS && p.x < ( SEEX * MAPSIZE / 2 ) + SCENT_RADIUS &&
+           p.y >= ( SEEY * MAPSIZE / 2 ) - SCENT_RADIUS && p.y < ( SEEY * MAPSIZE / 2 ) + SCENT_RADIUS;
+}
+
+int scent_map::get( const tripoint &p ) const
+{
+    if( !inbounds( p ) ) {
+        return 0;
+    }
+    return grscent[p.x][p.y];
+}
+
+void scent_map::set( const tripoint &p, const int value )
+{
+    if( !inbounds( p ) ) {
+        return;
+    }
+    grscent[p.x][p.y] = value;
+    if( value != 0 ) {
+        grow_bounds( p.x, p.y );
+    }
+}
+
+void scent_map::reset()
+{
+    std::fill_n( &grscent[0][0], SEEX * MAPSIZE * SEEY * MAPSIZE, 0 );
+    minx = SEEX * MAPSIZE;
+    miny = SEEY * MAPSIZE;
+    maxx = -1;
+    maxy = -1;
+}
+
+void scent_map::grow_bounds( const int x, const int y )
+{
+    minx = std::min( minx, x );
+    miny = std::min( miny, y );
+    maxx = std::max( maxx, x );
+    maxy = std::max( maxy, y );
+}
+
+void scent_map::update_bounds()
+{
+    const int old_minx = minx;
+    const int old_miny = miny;
+    const int old_maxx = maxx;
+    const int old_maxy = maxy;
+    minx = SEEX * MAPSIZE;
+    miny = SEEY * MAPSIZE;
+    maxx = -1;
+    maxy = -1;
+    for( int x = old_minx; x <= old_maxx; ++x ) {
+        for( int y = old_miny; y <= old_maxy; ++y ) {
+            if( grscent[x][y] != 0 ) {
+                grow_bounds( x, y );
+            }
+        }
+    }
+}
+
+void scent_map::decay()
+{
+    for( int x = minx; x <= maxx; ++x ) {
+        for( int y = miny; y <= maxy; ++y ) {
+            if( grscent[x][y] > 0 && inbounds( tripoint( x, y, 0 ) ) ) {
+                grscent[x][y]--;
+            }
+        }
+    }
+    update_bounds();
+}
+
+void scent_map::shift( const int sm_shift_x, const int sm_shift_y )
+{
+    const int shift_x = sm_shift_x * SEEX;
+    const int shift_y = sm_shift_y * SEEY;
+    // The scratch space isn't used between updates.
+    auto &newscent = sum_3_scent_y;
+    tripoint tmp( 0, 0, 0 );
+    for( tmp.x = 0; tmp.x < SEEX * MAPSIZE; tmp.x++ ) {
+        for( tmp.y = 0; tmp.y < SEEY * MAPSIZE; tmp.y++ ) {
+            newscent[tmp.x][tmp.y] = get( tripoint( tmp.x + shift_x, tmp.y + shift_y, 0 ) );
+        }
+    }
+    for( tmp.x = 0; tmp.x < SEEX * MAPSIZE; tmp.x++ ) {
+        for( tmp.y = 0; tmp.y < SEEY * MAPSIZE; tmp.y++ ) {
+            if( inbounds( tmp ) ) {
+                grscent[tmp.x][tmp.y] = newscent[tmp.x][tmp.y];
+            }
+        }
+    }
+    minx = 0;
+    miny = 0;
+    maxx = SEEX * MAPSIZE - 1;
+    maxy = SEEY * MAPSIZE - 1;
+    update_bounds();
+}
+
+void scent_map::update( const tripoint &center, map &m )
+{
+    // The window has to stay one tile away from the edges, as the diffusion reads the neighbours.
+    // Within it, only the tiles with scent and their neighbours can change.
+    const int scentmap_minx = std::max( { center.x - SCENT_RADIUS, minx - 1, 1 } );
+    const int scentmap_maxx = std::min( { center.x + SCENT_RADIUS, maxx + 1, SEEX * MAPSIZE - 2 } );
+    const int scentmap_miny = std::max( { center.y - SCENT_RADIUS, miny - 1, 1 } );
+    const int scentmap_maxy = std::min( { center.y + SCENT_RADIUS, maxy + 1, SEEY * MAPSIZE - 2 } );
+    if( scentmap_minx > scentmap_maxx || scentmap_miny > scentmap_maxy ) {
+        return;
+    }
+
+    // The diffusion reads the flags one tile beyond the updated area.
+    for( int x = scentmap_minx - 1; x <= scentmap_maxx + 1; ++x ) {
+        std::fill_n( &blocks_scent[x][scentmap_miny - 1], scentmap_maxy - scentmap_miny + 3, false );
+        std::fill_n( &reduces_scent[x][scentmap_miny - 1], scentmap_maxy - scentmap_miny + 3, false );
+    }
+    m.scent_blockers( blocks_scent, reduces_scent, scentmap_minx - 1, scentmap_miny - 1,
+                      scentmap_maxx + 1, scentmap_maxy + 1 );
+    for( int x = scentmap_minx - 1; x <= scentmap_maxx + 1; ++x ) {
+        for( int y = scentmap_miny - 1; y <= scentmap_maxy + 1; ++y ) {
+            pass_mask[x][y] = blocks_scent[x][y] ? 0 : -1;
+            full_mask[x][y] = ( blocks_scent[x][y] || reduces_scent[x][y] ) ? 0 : -1;
+        }
+    }
+
+    // Sum neighbors in the y direction. This way, each square gets called 3 times instead of 9
+    // times. This needs the sums one square beyond the updated area in the x direction.
+    const int count = scentmap_maxy - scentmap_miny + 1;
+    for( int x = scentmap_minx - 1; x <= scentmap_maxx + 1; ++x ) {
+        sum_3_scent( &grscent[x][scentmap_miny], &pass_mask[x][scentmap_miny],
+                     &full_mask[x][scentmap_miny], &sum_3_scent_y[x][scentmap_miny],
+                     &squares_used_y[x][scentmap_miny], count );
+    }
+
+    // Now do it for the x direction. All the sums are done by now, so the scent can be
+    // updated in place.
+    for( int x = scentmap_minx; x <= scentmap_maxx; ++x ) {
+        const int y = scentmap_miny;
+        diffuse( &grscent[x][y], &sum_3_scent_y[x - 1][y], &sum_3_scent_y[x][y],
+                 &sum_3_scent_y[x + 1][y], &squares_used_y[x - 1][y], &squares_used_y[x][y],
+                 &squares_used_y[x + 1][y], &pass_mask[x][y], &full_mask[x][y], count );
+    }
+
+    for( int x = scentmap_minx; x <= scentmap_maxx; ++x ) {
+        for( int y = scentmap_miny; y <= scentmap_maxy; ++y ) {
+            if( grscent[x][y] > 10000 ) {
+                dbg( D_ERROR ) << "scent_map::update: Wacky scent at " << x << ","
+                               << y << " (" << grscent[x][y] << ")";
+                debugmsg( "Wacky scent at %d, %d (%d)", x, y, grscent[x][y] );
+                grscent[x][y] = 0; // Scent should never be higher
+            }
+        }
+    }
+    grow_bounds( scentmap_minx, scentmap_miny );
+    grow_bounds( scentmap_maxx, scentmap_maxy );
+    update_bounds();
+}
+
+std::string scent_map::serialize() const
+{
+    std::stringstream rle_out;
+    int rle_lastval = -1;
+    int rle_count = 0;
+    for( auto &elem : grscent ) {
+        for( auto val : elem ) {
+            if( val == rle_lastval ) {
+                rle_count++;
+            } else {
+                if( rle_count ) {
+                    rle_out << rle_count << " ";
+                }
+                rle_out << val << " ";
+                rle_lastval = val;
+                rle_count = 1;
+            }
+        }
+    }
+    rle_out << rle_count;
+
+    return rle_out.str();
+}
+
+void scent_map::deserialize( const std::string &data )
+{
+    std::istringstream buffer( data );
+    int stmp;
+    int count = 0;
+    for( auto &elem : grscent ) {
+        for( auto &elem_j : elem ) {
+            if( count == 0 ) {
+                buffer >> stmp >> count;
+            }
+            count--;
+            elem_j = stmp;
+        }
+    }
+    minx = 0;
+    miny = 0;
+    maxx = SEEX * MAPSIZE - 1;
+    maxy = SEEY * MAPSIZE - 1;
+    update_bounds();
+}
@@ -0,0 +1,70 @@
+#ifndef SCENT_MAP_H
+#define SCENT_MAP_H
+
+#include "enums.h"
+#include "game_constants.h"
+
+#include <string>
+
+class map;
+
+/**
+ * The scent left behind by the player, one value per tile of the reality bubble.
+ *
+ * Only the area within a fixed radius of the bubble center can be read or written from outside,
+ * see @ref get and @ref set. Diffusion (@ref update) runs on a window around the player and only
+ * over the part of it that actually holds scent, tracked as a bounding box of nonzero values.
+ */
+class scent_map
+{
+    public:
+        scent_map();
+        scent_map( const scent_map & ) = delete;
+        scent_map &operator=( const scent_map & ) = delete;
+
+        /** Scent at the given point, 0 if it's outside the scent radius. */
+        int get( const tripoint &p ) const;
+        /** Sets the scent at the given point, does nothing if it's outside the scent radius. */
+        void set( const tripoint &p, int value );
+        /** Removes all scent. */
+        void reset();
+        /** Decrements every positive value within the scent radius. */
+        void decay();
+        /** Moves the scent along with the map, see @ref game::update_map. In submaps. */
+        void shift( int sm_shift_x, int sm_shift_y );
+        /** Diffuses the scent within SCENT_RADIUS of center, walls block it, REDUCE_SCENT tiles slow it. */
+        void update( const tripoint &center, map &m );
+
+        /** Run length encoded, as stored in the save file. */
+        std::string serialize() const;
+        void deserialize( const std::string &data );
+
+        static bool inbounds( const tripoint &p );
+
+    private:
+        /** Extends the bounding box of nonzero scent to include the given tile. */
+        void grow_bounds( int x, int y );
+        /** Recomputes the bounding box from scratch. */
+        void update_bounds();
+
+        int grscent[SEEX * MAPSIZE][SEEY * MAPSIZE];
+
+        // Bounding box of the nonzero scent (inclusive), empty if min > max.
+        int minx;
+        int miny;
+        int maxx;
+        int maxy;
+
+        // Scratch space of update(), kept around so the diffusion doesn't need
+        // several big temporaries on the stack every turn.
+        bool blocks_scent[SEEX * MAPSIZE][SEEY * MAPSIZE];
+        bool reduces_scent[SEEX * MAPSIZE][SEEY * MAPSIZE];
+        // -1 where scent can diffuse at all / at full rate (neither blocked nor reduced), else 0.
+        int pass_mask[SEEX * MAPSIZE][SEEY * MAPSIZE];
+        int full_mask[SEEX * MAPSIZE][SEEY * MAPSIZE];
+        // Weighted scent and weights of each tile and its two neighbours along y.
+        int sum_3_scent_y[SEEX * MAPSIZE][SEEY * MAPSIZE];
+        int squares_used_y[SEEX * MAPSIZE][SEEY * MAPSIZE];
+};
+
+#endif
@@ -7,6 +7,7 @@
 #include "translations.h"
 #include "messages.h"
 #include "monster.h"
+#include "creature_tracker.h"
 #include "line.h"
 #include "mtype.h"
 #include "weather.h"
@@ -174,13 +175,11 @@ void sounds::process_sounds()
             overmap_buffer.signal_hordes( target, sig_power );
         }
         // Alert all monsters (that can hear) to the sound.
-        for (int i = 0, numz = g->num_zombies(); i < numz; i++) {
-            monster &critter = g->zombie(i);
+        // Exclude monsters that certainly won't hear the sound
+        for( const int i : g->critter_tracker->in_radius( source, vol * 2 - 1 ) ) {
+            monster &critter = g->zombie( i );
             const int dist = rl_dist( source, critter.pos() );
-            if( vol * 2 > dist ) {
-                // Exclude monsters that certainly won't hear the sound
-                critter.hear_sound( source, vol, dist );
-            }
+            critter.hear_sound( source, vol, dist );
         }
     }
     recent_sounds.clear();
@@ -25,12 +25,25 @@ submap::~submap()
 
 void submap::delete_vehicles()
 {
+    set_modified();
     for( vehicle *veh : vehicles ) {
         delete veh;
     }
     vehicles.clear();
 }
 
+void submap::update_field_squares()
+{
+    field_squares.reset();
+    for( int x = 0; x < SEEX; x++ ) {
+        for( int y = 0; y < SEEY; y++ ) {
+            if( fld[x][y].fieldCount() > 0 ) {
+                note_field( x, y );
+            }
+        }
+    }
+}
+
 static const std::string COSMETICS_GRAFFITI( "GRAFFITI" );
 
 bool submap::has_graffiti( int x, int y ) const
@@ -51,11 +64,13 @@ const std::string &submap::get_graffiti( int x, int y ) const
 void submap::set_graffiti( int x, int y, const std::string &new_graffiti )
 {
     is_uniform = false;
+    set_modified();
     cosmetics[x][y][COSMETICS_GRAFFITI] = new_graffiti;
 }
 
 void submap::delete_graffiti( int x, int y )
 {
     is_uniform = false;
+    set_modified();
     cosmetics[x][y].erase( COSMETICS_GRAFFITI );
 }
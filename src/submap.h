@@ -11,6 +11,7 @@
 #include "string_id.h"
 #include "active_item_cache.h"
 
+#include <bitset>
 #include <vector>
 #include <list>
 #include <map>
@@ -53,6 +54,7 @@ struct submap {
 
     void set_trap( const int x, const int y, trap_id trap ) {
         is_uniform = false;
+        set_modified();
         trp[x][y] = trap;
     }
 
@@ -62,6 +64,7 @@ struct submap {
 
     void set_furn( const int x, const int y, furn_id furn ) {
         is_uniform = false;
+        set_modified();
         frn[x][y] = furn;
     }
 
@@ -71,6 +74,7 @@ struct submap {
 
     void set_ter( const int x, const int y, ter_id terr ) {
         is_uniform = false;
+        set_modified();
         ter[x][y] = terr;
     }
 
@@ -80,11 +84,13 @@ struct submap {
 
     void set_radiation( const int x, const int y, const int radiation ) {
         is_uniform = false;
+        set_modified();
         rad[x][y] = radiation;
     }
 
     void update_lum_add( item const &i, int const x, int const y ) {
         is_uniform = false;
+        set_modified();
         if (i.is_emissive() && lum[x][y] < 255) {
             lum[x][y]++;
         }
@@ -92,6 +98,7 @@ struct submap {
 
     void update_lum_rem( item const &i, int const x, int const y ) {
         is_uniform = false;
+        set_modified();
         if (!i.is_emissive()) {
             return;
         } else if (lum[x][y] && lum[x][y] < 255) {
@@ -113,6 +120,26 @@ struct submap {
         }
     }
 
+    /**
+     * Counts a change to anything that gets saved. Everything that writes to the public
+     * members directly has to call this too.
+     */
+    void set_modified() {
+        generation++;
+    }
+    /**
+     * Whether the submap changed since it was last loaded or saved, mapbuffer::save skips
+     * quads that didn't. Vehicles change without telling their submap, so submaps with
+     * vehicles always count as modified.
+     */
+    bool is_modified() const {
+        return generation != saved_generation || !vehicles.empty();
+    }
+    /** Called once the current state is what the save files hold. */
+    void set_saved() {
+        saved_generation = generation;
+    }
+
     bool has_graffiti( int x, int y ) const;
     const std::string &get_graffiti( int x, int y ) const;
     void set_graffiti( int x, int y, const std::string &new_graffiti );
@@ -142,11 +169,13 @@ struct submap {
     // Can be used anytime (prevents code from needing to place sign first.)
     void set_signage( const int x, const int y, std::string s) {
         is_uniform = false;
+        set_modified();
         cosmetics[x][y]["SIGNAGE"] = s;
     }
     // Can be used anytime (prevents code from needing to place sign first.)
     void delete_signage( const int x, const int y) {
         is_uniform = false;
+        set_modified();
         cosmetics[x][y].erase("SIGNAGE");
     }
 
@@ -168,6 +197,18 @@ struct submap {
     active_item_cache active_items;
 
     int field_count = 0;
+    /**
+     * Squares that may have fields, the bit of x, y is x * SEEY + y. Set by everything that
+     * adds a field, cleared by map::process_fields_in_submap when it finds the square empty,
+     * so it only has to look at these squares. Code that writes @ref fld directly has to call
+     * @ref update_field_squares.
+     */
+    std::bitset<SEEX * SEEY> field_squares;
+    void note_field( const int x, const int y ) {
+        field_squares.set( x * SEEY + y );
+    }
+    /** Sets @ref field_squares from the fields of all squares. */
+    void update_field_squares();
     int turn_last_touched = 0;
     int temperature = 0;
     std::vector<spawn_point> spawns;
@@ -181,6 +222,10 @@ struct submap {
     computer comp;
     basecamp camp;  // only allowing one basecamp per submap
 
+    // Bumped by set_modified, new submaps start out modified.
+    unsigned generation = 1;
+    unsigned saved_generation = 0;
+
     submap();
     ~submap();
     // delete vehicles and clear the vehicles vector
@@ -247,6 +292,8 @@ public:
         const bool ret = sm->fld[x][y].addField( field_to_add, new_density, new_age );
         if( ret ) {
             sm->field_count++;
+            sm->note_field( x, y );
+            sm->set_modified();
         }
 
         return ret;
@@ -0,0 +1,54 @@
+#include "timing_histogram.h"
+#include "output.h"
+#include "translations.h"
+
+#include <algorithm>
+#include <sstream>
+
+int timing_histogram::bucket_of( const long long microseconds )
+{
+    int bucket = 0;
+    for( long long limit = 1000; bucket < buckets - 1 && microseconds >= limit; limit *= 2 ) {
+        bucket++;
+    }
+    return bucket;
+}
+
+void timing_histogram::add( const long long microseconds )
+{
+    counts[bucket_of( microseconds )]++;
+    total_count++;
+    total_us += microseconds;
+    max_us = std::max( max_us, microseconds );
+}
+
+void timing_histogram::clear()
+{
+    counts.fill( 0 );
+    total_count = 0;
+    total_us = 0;
+    max_us = 0;
+}
+
+std::string timing_histogram::to_string() const
+{
+    std::ostringstream result;
+    for( int bucket = 0; bucket < buckets; bucket++ ) {
+        if( counts[bucket] == 0 ) {
+            continue;
+        }
+        if( bucket == 0 ) {
+            result << string_format( _( "below 1 ms: %d" ), counts[bucket] );
+        } else if( bucket == buckets - 1 ) {
+            result << string_format( _( "%d ms and more: %d" ), 1 << ( bucket - 1 ), counts[bucket] );
+        } else {
+            result << string_format( _( "%d-%d ms: %d" ), 1 << ( bucket - 1 ), 1 << bucket,
+                                     counts[bucket] );
+        }
+        result << "\n";
+    }
+    const long long average_us = total_count > 0 ? total_us / total_count : 0;
+    result << string_format( _( "%d in total, %lld us on average, %lld us at most" ), total_count,
+                             average_us, max_us );
+    return result.str();
+}
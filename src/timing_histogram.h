@@ -0,0 +1,38 @@
+#ifndef TIMING_HISTOGRAM_H
+#define TIMING_HISTOGRAM_H
+
+#include <array>
+#include <string>
+
+/**
+ * Counts how long something took, in buckets that double in size from one millisecond up.
+ * Shows the occasional hitch that an average would hide.
+ */
+class timing_histogram
+{
+    public:
+        /** Bucket 0 is below 1 ms, bucket n from 2^(n-1) ms up, the last one is open ended. */
+        static const int buckets = 12;
+
+        void add( long long microseconds );
+        void clear();
+
+        int count() const {
+            return total_count;
+        }
+        int bucket_count( int bucket ) const {
+            return counts[bucket];
+        }
+        /** The bucket a duration ends up in. */
+        static int bucket_of( long long microseconds );
+        /** One line per non-empty bucket followed by a summary, for popups and the log. */
+        std::string to_string() const;
+
+    private:
+        std::array<int, buckets> counts = {{}};
+        int total_count = 0;
+        long long total_us = 0;
+        long long max_us = 0;
+};
+
+#endif
@@ -9,6 +9,7 @@
 #include "profession.h"
 #include "overmap.h"
 #include "trap.h"
+#include "scent_map.h"
 
 const mtype_id mon_zombie( "mon_zombie" );
 
@@ -24,7 +25,7 @@ bool tutorial_game::init()
 // Set the scent map to 0
  for (int i = 0; i < SEEX * MAPSIZE; i++) {
   for (int j = 0; j < SEEX * MAPSIZE; j++)
-   g->scent( { i, j, g->get_levz() } ) = 0;
+   g->scent.set( { i, j, g->get_levz() }, 0 );
  }
  g->temperature = 65;
 // We use a Z-factor of 10 so that we don't plop down tutorial rooms in the
@@ -48,7 +49,7 @@ bool tutorial_game::init()
         for (int j = 0; j < OMAPY; j++) {
             starting_om.ter( i, j, -1 ) = "rock";
             // Start with the overmap revealed
-            starting_om.seen( i, j, 0 ) = true;
+            starting_om.set_seen( i, j, 0, true );
         }
     }
     starting_om.ter(lx, ly, 0) = "tutorial";
@@ -8,9 +8,11 @@
 #include "color.h"
 #include "itype.h"
 #include "vehicle_group.h"
+#include "data_cache.h"
 
 #include <unordered_map>
 #include <unordered_set>
+#include <sstream>
 
 std::unordered_map<vproto_id, vehicle_prototype> vtypes;
 
@@ -387,36 +389,98 @@ void vehicle_prototype::reset()
 /**
  *Works through cached vehicle definitions and creates vehicle objects from them.
  */
-void vehicle_prototype::finalize()
+// Blueprints built from their parts are kept in the data cache as the json of the vehicles.
+static const std::string blueprint_section = "vehicle_blueprints";
+
+static bool load_cached_blueprints( const data_cache &cache )
+{
+    const std::string *data = cache.find( blueprint_section );
+    if( data == nullptr ) {
+        return false;
+    }
+    // The blueprints were saved by this very version, don't upgrade them like old saves.
+    const int loading_version = savegame_loading_version;
+    savegame_loading_version = savegame_version;
+    try {
+        JsonIn jsin( data->data(), data->size() );
+        jsin.start_object();
+        while( !jsin.end_object() ) {
+            const auto proto = vtypes.find( vproto_id( jsin.get_member_name() ) );
+            std::unique_ptr<vehicle> blueprint( new vehicle() );
+            blueprint->deserialize( jsin );
+            if( proto != vtypes.end() ) {
+                proto->second.blueprint = std::move( blueprint );
+            }
+        }
+    } catch( const JsonError &err ) {
+        debugmsg( "cached vehicle blueprints are broken: %s", err.what() );
+        savegame_loading_version = loading_version;
+        return false;
+    }
+    savegame_loading_version = loading_version;
+    for( auto &vp : vtypes ) {
+        if( !vp.second.blueprint ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void vehicle_prototype::save_blueprints( data_cache &cache )
 {
+    std::ostringstream data;
+    JsonOut json( data );
+    json.start_object();
+    for( auto &vp : vtypes ) {
+        json.member( vp.first.str() );
+        vp.second.blueprint->serialize( json );
+    }
+    json.end_object();
+    cache.store( blueprint_section, data.str() );
+}
+
+void vehicle_prototype::finalize( data_cache &cache )
+{
+    const bool cached = load_cached_blueprints( cache );
     for( auto &vp : vtypes ) {
         std::unordered_set<point> cargo_spots;
         vehicle_prototype &proto = vp.second;
         const vproto_id &id = vp.first;
 
-        // Calls the default constructor to create an empty vehicle. Calling the constructor with
-        // the type as parameter would make it look up the type in the map and copy the
-        // (non-existing) blueprint.
-        proto.blueprint.reset( new vehicle() );
-        vehicle &blueprint = *proto.blueprint;
-        blueprint.type = id;
-        blueprint.name = _(proto.name.c_str());
-
-        for( auto &part : proto.parts ) {
-            const point &p = part.first;
-            const vpart_str_id &part_id = part.second;
-            if( !part_id.is_valid() ) {
-                debugmsg("unknown vehicle part %s in %s", part_id.c_str(), id.c_str());
-                continue;
+        if( cached ) {
+            vehicle &blueprint = *proto.blueprint;
+            blueprint.type = id;
+            blueprint.name = _(proto.name.c_str());
+            for( auto &part : blueprint.parts ) {
+                if( part.info().has_flag("CARGO") ) {
+                    cargo_spots.insert( part.mount );
+                }
             }
+        } else {
+            // Calls the default constructor to create an empty vehicle. Calling the constructor with
+            // the type as parameter would make it look up the type in the map and copy the
+            // (non-existing) blueprint.
+            proto.blueprint.reset( new vehicle() );
+            vehicle &blueprint = *proto.blueprint;
+            blueprint.type = id;
+            blueprint.name = _(proto.name.c_str());
+
+            for( auto &part : proto.parts ) {
+                const point &p = part.first;
+                const vpart_str_id &part_id = part.second;
+                if( !part_id.is_valid() ) {
+                    debugmsg("unknown vehicle part %s in %s", part_id.c_str(), id.c_str());
+                    continue;
+                }
 
-            if(blueprint.install_part(p.x, p.y, part_id) < 0) {
-                debugmsg("init_vehicles: '%s' part '%s'(%d) can't be installed to %d,%d",
-                         blueprint.name.c_str(), part_id.c_str(),
-                         blueprint.parts.size(), p.x, p.y);
-            }
-            if( part_id.obj().has_flag("CARGO") ) {
-                cargo_spots.insert( p );
+                if(blueprint.install_part(p.x, p.y, part_id) < 0) {
+                    debugmsg("init_vehicles: '%s' part '%s'(%d) can't be installed to %d,%d",
+                             blueprint.name.c_str(), part_id.c_str(),
+                             blueprint.parts.size(), p.x, p.y);
+                }
+                if( part_id.obj().has_flag("CARGO") ) {
+                    cargo_spots.insert( p );
+                }
             }
         }
 
@@ -440,6 +504,9 @@ void vehicle_prototype::finalize()
         // memory of the vector is really freed (instead of simply marking the vector as empty).
         std::remove_reference<decltype(proto.parts)>::type().swap( proto.parts );
     }
+    if( !cached && cache.in_use() ) {
+        save_blueprints( cache );
+    }
 }
 
 std::vector<vproto_id> vehicle_prototype::get_all()
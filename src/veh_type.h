@@ -17,6 +17,7 @@ struct vehicle_prototype;
 using vproto_id = string_id<vehicle_prototype>;
 class vehicle;
 class JsonObject;
+class data_cache;
 struct vehicle_item_spawn;
 typedef int nc_color;
 
@@ -127,6 +128,8 @@ struct vehicle_item_spawn
 /**
  * Prototype of a vehicle. The blueprint member is filled in during the finalizing, before that it
  * is a nullptr. Creating a new vehicle copies the blueprint vehicle.
+ * Installing the parts of all blueprints one by one is slow, so the finished blueprints are
+ * kept in the @ref data_cache.
  */
 struct vehicle_prototype
 {
@@ -138,7 +141,10 @@ struct vehicle_prototype
 
     static void load( JsonObject &jo );
     static void reset();
-    static void finalize();
+    /** Builds the blueprints, or takes them from the cache if it has them. */
+    static void finalize( data_cache &cache );
+    /** Stores the finalized blueprints in the cache, @ref finalize does it after building them. */
+    static void save_blueprints( data_cache &cache );
 
     static std::vector<vproto_id> get_all();
 };
@@ -35,6 +35,7 @@
 #include <queue>
 #include <math.h>
 #include <array>
+#include <cassert>
 
 /*
  * Speed up all those if ( blarg == "structure" ) statements that are used everywhere;
@@ -571,6 +572,7 @@ void vehicle::init_state(int init_veh_fuel, int init_veh_status)
  * was the collision point.
  */
 void vehicle::smash() {
+    invalidate_physics();
     for (size_t part_index = 0; part_index < parts.size(); part_index++) {
         //Skip any parts already mashed up or removed.
         if(parts[part_index].hp == 0 || parts[part_index].removed) {
@@ -2187,6 +2189,7 @@ bool vehicle::remove_part (int p)
 
     parts[p].removed = true;
     removed_part_count++;
+    invalidate_physics();
 
     // If the player is currently working on the removed part, stop them as it's futile now.
     const player_activity &act = g->u.activity;
@@ -2942,23 +2945,112 @@ void vehicle::set_submap_moved( int x, int y )
     overmap_buffer.move_vehicle( this, old_msp );
 }
 
-int vehicle::total_mass() const
+void vehicle::invalidate_physics()
+{
+    physics.valid = false;
+}
+
+vehicle::physics_cache vehicle::compute_physics() const
 {
+    physics_cache result;
+    result.valid = true;
+    result.part_masses.resize( parts.size(), 0 );
     int m = 0;
+    float xf = 0, yf = 0;
     for (size_t i = 0; i < parts.size(); i++)
     {
         if (parts[i].removed) {
           continue;
         }
-        m += item::find_type( part_info(i).item )->weight;
+        int m_part = 0;
+        m_part += item::find_type( part_info(i).item )->weight;
         for( auto &j : get_items(i) ) {
-            m += j.type->weight;
+            m_part += j.type->weight;
         }
         if (part_flag(i,VPFLAG_BOARDABLE) && parts[i].has_flag(vehicle_part::passenger_flag)) {
-            m += 81500; // TODO: get real weight
+            m_part += 81500; // TODO: get real weight
         }
+        result.part_masses[i] = m_part;
+        m += m_part;
+        xf += parts[i].mount.x * m_part / 1000;
+        yf += parts[i].mount.y * m_part / 1000;
+    }
+    result.mass = m / 1000;
+    xf /= result.mass;
+    yf /= result.mass;
+    result.center_of_mass = point( round( xf ), round( yf ) );
+
+    int total_area = 0;
+    for( int p : wheelcache ) {
+        int width = part_info(p).wheel_width;
+        int bigness = parts[p].bigness;
+        // 9 inches, for reference, is about normal for cars.
+        total_area += ((float)width / 9) * bigness;
     }
-    return m/1000;
+    result.wheel_count = wheelcache.size();
+    if (all_parts_with_feature("FLOATS").size() > 0) {
+        result.wheels_area = 13;
+    } else {
+        result.wheels_area = total_area;
+    }
+
+    const int max_obst = 13;
+    int obst[max_obst];
+    for( auto &elem : obst ) {
+        elem = 0;
+    }
+    std::vector<int> structure_indices = all_parts_at_location(part_location_structure);
+    for( auto &structure_indice : structure_indices ) {
+        int p = structure_indice;
+        int frame_size = part_with_feature(p, VPFLAG_OBSTACLE) ? 30 : 10;
+        int pos = parts[p].mount.y + max_obst / 2;
+        if (pos < 0) {
+            pos = 0;
+        }
+        if (pos >= max_obst) {
+            pos = max_obst -1;
+        }
+        if (obst[pos] < frame_size) {
+            obst[pos] = frame_size;
+        }
+    }
+    int frame_obst = 0;
+    for( auto &elem : obst ) {
+        frame_obst += elem;
+    }
+    float ae0 = 200.0;
+    // calculate aerodynamic coefficient
+    result.k_aerodynamics = ( ae0 / (ae0 + frame_obst) );
+
+    for( int p : fuel ) {
+        result.fuel_capacities[part_info(p).fuel_type] += part_info(p).size;
+    }
+    return result;
+}
+
+bool vehicle::physics_cache::operator==( const physics_cache &rhs ) const
+{
+    return valid == rhs.valid && mass == rhs.mass && part_masses == rhs.part_masses &&
+           center_of_mass == rhs.center_of_mass && wheels_area == rhs.wheels_area &&
+           wheel_count == rhs.wheel_count && k_aerodynamics == rhs.k_aerodynamics &&
+           fuel_capacities == rhs.fuel_capacities;
+}
+
+const vehicle::physics_cache &vehicle::get_physics() const
+{
+    if( !physics.valid ) {
+        physics = compute_physics();
+    }
+#if (defined(DEBUG) || defined(_DEBUG)) && !defined(NDEBUG)
+    // Something changed the vehicle without calling invalidate_physics.
+    assert( physics == compute_physics() );
+#endif
+    return physics;
+}
+
+int vehicle::total_mass() const
+{
+    return get_physics().mass;
 }
 
 int vehicle::total_folded_volume() const
@@ -2975,31 +3067,20 @@ int vehicle::total_folded_volume() const
 
 void vehicle::center_of_mass(int &x, int &y, bool use_precalc) const
 {
+    const physics_cache &phys = get_physics();
+    if( !use_precalc ) {
+        x = phys.center_of_mass.x;
+        y = phys.center_of_mass.y;
+        return;
+    }
     float xf = 0, yf = 0;
-    int m_total = total_mass();
     for (size_t i = 0; i < parts.size(); i++)
     {
-        if (parts[i].removed) {
-          continue;
-        }
-        int m_part = 0;
-        m_part += item::find_type( part_info(i).item )->weight;
-        for( auto &j : get_items(i) ) {
-            m_part += j.type->weight;
-        }
-        if (part_flag(i,VPFLAG_BOARDABLE) && parts[i].has_flag(vehicle_part::passenger_flag)) {
-            m_part += 81500; // TODO: get real weight
-        }
-        if (use_precalc) {
-            xf += parts[i].precalc[0].x * m_part / 1000;
-            yf += parts[i].precalc[0].y * m_part / 1000;
-        } else {
-            xf += parts[i].mount.x * m_part / 1000;
-            yf += parts[i].mount.y * m_part / 1000;
-        }
+        xf += parts[i].precalc[0].x * phys.part_masses[i] / 1000;
+        yf += parts[i].precalc[0].y * phys.part_masses[i] / 1000;
     }
-    xf /= m_total;
-    yf /= m_total;
+    xf /= phys.mass;
+    yf /= phys.mass;
     x = round(xf);
     y = round(yf);
 }
@@ -3067,13 +3148,9 @@ int vehicle::fuel_left (const itype_id & ftype, bool recurse) const
 
 int vehicle::fuel_capacity (const itype_id &ftype) const
 {
-    int cap = 0;
-    for(auto &p : fuel) {
-        if(ftype == part_info(p).fuel_type) {
-            cap += part_info(p).size;
-        }
-    }
-    return cap;
+    const auto &capacities = get_physics().fuel_capacities;
+    const auto it = capacities.find( ftype );
+    return it == capacities.end() ? 0 : it->second;
 }
 
 int vehicle::refill (const itype_id & ftype, int amount)
@@ -3361,26 +3438,11 @@ void vehicle::noise_and_smoke( double load, double time )
 
 float vehicle::wheels_area (int *const cnt) const
 {
-    int count = 0;
-    int total_area = 0;
-    const auto &wheel_indices = wheelcache;
-    for( auto &wheel_indice : wheel_indices ) {
-        int p = wheel_indice;
-        int width = part_info(p).wheel_width;
-        int bigness = parts[p].bigness;
-        // 9 inches, for reference, is about normal for cars.
-        total_area += ((float)width / 9) * bigness;
-        count++;
-    }
+    const physics_cache &phys = get_physics();
     if (cnt) {
-        *cnt = count;
-    }
-
-    if (all_parts_with_feature("FLOATS").size() > 0) {
-        return 13;
+        *cnt = phys.wheel_count;
     }
-
-    return total_area;
+    return phys.wheels_area;
 }
 
 float vehicle::k_friction() const
@@ -3393,35 +3455,7 @@ float vehicle::k_friction() const
 
 float vehicle::k_aerodynamics() const
 {
-    const int max_obst = 13;
-    int obst[max_obst];
-    for( auto &elem : obst ) {
-        elem = 0;
-    }
-    std::vector<int> structure_indices = all_parts_at_location(part_location_structure);
-    for( auto &structure_indice : structure_indices ) {
-        int p = structure_indice;
-        int frame_size = part_with_feature(p, VPFLAG_OBSTACLE) ? 30 : 10;
-        int pos = parts[p].mount.y + max_obst / 2;
-        if (pos < 0) {
-            pos = 0;
-        }
-        if (pos >= max_obst) {
-            pos = max_obst -1;
-        }
-        if (obst[pos] < frame_size) {
-            obst[pos] = frame_size;
-        }
-    }
-    int frame_obst = 0;
-    for( auto &elem : obst ) {
-        frame_obst += elem;
-    }
-    float ae0 = 200.0;
-
-    // calculate aerodynamic coefficient
-    float ka = ( ae0 / (ae0 + frame_obst) );
-    return ka;
+    return get_physics().k_aerodynamics;
 }
 
 float vehicle::k_dynamics() const
@@ -3911,6 +3945,21 @@ void vehicle::idle(bool on_map) {
     }
 }
 
+bool vehicle::is_powered_down() const
+{
+    return !engine_on && !reactor_on && !lights_on && !overhead_lights_on && !tracking_on &&
+           !fridge_on && !recharger_on && !is_alarm_on && !camera_on && !dome_lights_on &&
+           !aisle_lights_on && !scoop_on && !stereo_on && !chimes_on;
+}
+
+void vehicle::idle_off_map( int turns )
+{
+    for( int i = 0; i < turns && !is_powered_down(); i++ ) {
+        power_parts();
+        idle( false );
+    }
+}
+
 void vehicle::on_move(){
     if(scoop_on){
         operate_scoop();
@@ -4927,6 +4976,7 @@ bool vehicle::add_item (int part, item itm)
 bool vehicle::add_item_at(int part, std::list<item>::iterator index, item itm)
 {
     const auto new_pos = parts[part].items.insert( index, itm );
+    invalidate_physics();
     if( itm.needs_processing() ) {
         active_items.add( new_pos, parts[part].mount );
     }
@@ -4968,6 +5018,7 @@ std::list<item>::iterator vehicle::remove_item( int part, std::list<item>::itera
         active_items.remove( it, parts[part].mount );
     }
 
+    invalidate_physics();
     return veh_items.erase(it);
 }
 
@@ -5093,6 +5144,7 @@ void vehicle::gain_moves()
  */
 void vehicle::refresh()
 {
+    invalidate_physics();
     lights.clear();
     alternators.clear();
     fuel.clear();
@@ -5461,6 +5513,8 @@ bool vehicle::shift_if_needed() {
 
 int vehicle::damage_direct( int p, int dmg, damage_type type )
 {
+    // Broken parts neither block the wind nor keep the vehicle afloat.
+    invalidate_physics();
     if (parts[p].hp <= 0) {
         /* Already-destroyed part - chance it could be torn off into pieces.
          * Chance increases with damage, and decreases with part max durability
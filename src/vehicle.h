@@ -306,6 +306,28 @@ private:
     //Refresh all caches and re-locate all parts
     void refresh();
 
+    /**
+     * What the physics of the vehicle are derived from that only changes with its parts,
+     * their cargo and the passengers. Computed on first use after @ref invalidate_physics.
+     */
+    struct physics_cache {
+        bool valid = false;
+        int mass = 0;
+        // Mass of each part with its cargo and passenger in grams, 0 for removed parts.
+        std::vector<int> part_masses;
+        // Center of mass in mount coordinates.
+        point center_of_mass;
+        float wheels_area = 0;
+        int wheel_count = 0;
+        float k_aerodynamics = 0;
+        std::map<itype_id, int> fuel_capacities;
+
+        bool operator==( const physics_cache &rhs ) const;
+    };
+    mutable physics_cache physics;
+    physics_cache compute_physics() const;
+    const physics_cache &get_physics() const;
+
     // Do stuff like clean up blood and produce smoke from broken parts. Returns false if nothing needs doing.
     bool do_environmental_effects();
 
@@ -570,6 +592,14 @@ public:
      */
     int discharge_battery (int amount, bool recurse = true);
 
+    /**
+     * Drops the cached mass, center of mass, wheel area, aerodynamics and fuel capacity.
+     * Needed when parts are added, removed or damaged, or cargo or passengers change. This
+     * is done by the functions of this class, other code that changes @ref parts directly
+     * has to call it.
+     */
+    void invalidate_physics();
+
     // get the total mass of vehicle, including cargo and passengers
     int total_mass () const;
 
@@ -635,6 +665,16 @@ public:
 
     // idle fuel consumption
     void idle(bool on_map = true);
+    /**
+     * Whether no engine, reactor or power consumer is running, so that @ref power_parts
+     * and @ref idle have nothing to do while the vehicle is outside of the reality bubble.
+     */
+    bool is_powered_down() const;
+    /**
+     * Catches up on @ref power_parts and @ref idle for turns spent outside of the reality
+     * bubble, stopping early once the vehicle is powered down.
+     */
+    void idle_off_map( int turns );
     // continuous processing for running vehicle alarms
     void alarm();
     // leak from broken tanks
@@ -0,0 +1,73 @@
+#include "vehicle_scheduler.h"
+#include "vehicle.h"
+
+void vehicle_scheduler::invalidate()
+{
+    vehicles.clear();
+    orders.clear();
+    queue = std::priority_queue<entry>();
+    last_picked = nullptr;
+    valid = false;
+}
+
+void vehicle_scheduler::start( const std::vector<vehicle *> &vehs )
+{
+    invalidate();
+    vehicles = vehs;
+    for( size_t i = 0; i < vehicles.size(); i++ ) {
+        orders[vehicles[i]] = i;
+        push( vehicles[i], i );
+    }
+    valid = true;
+}
+
+void vehicle_scheduler::restart()
+{
+    std::vector<vehicle *> vehs;
+    vehs.swap( vehicles );
+    start( vehs );
+}
+
+void vehicle_scheduler::push( vehicle *veh, size_t order )
+{
+    // Vehicles without turn left are never picked, until they get some.
+    if( veh->of_turn > 0 ) {
+        queue.push( { veh->of_turn, order, veh } );
+    }
+}
+
+void vehicle_scheduler::update( vehicle *veh )
+{
+    const auto it = orders.find( veh );
+    if( it != orders.end() ) {
+        push( veh, it->second );
+    }
+}
+
+vehicle *vehicle_scheduler::next()
+{
+    if( last_picked != nullptr ) {
+        update( last_picked );
+        last_picked = nullptr;
+    }
+    while( !queue.empty() ) {
+        const entry &top = queue.top();
+        if( top.of_turn != top.veh->of_turn || top.veh->of_turn <= 0 ) {
+            queue.pop();
+            continue;
+        }
+        last_picked = top.veh;
+        return last_picked;
+    }
+    return nullptr;
+}
+
+vehicle *vehicle_scheduler::next_falling() const
+{
+    for( vehicle *veh : vehicles ) {
+        if( veh->falling ) {
+            return veh;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,72 @@
+#ifndef VEHICLE_SCHEDULER_H
+#define VEHICLE_SCHEDULER_H
+
+#include <cstddef>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+class vehicle;
+
+/**
+ * Picks the vehicle that moves next during map::vehmove: the one with the most of its
+ * turn left (vehicle::of_turn), ties going to the one listed first. This is what
+ * map::vehproceed used to find by listing all vehicles of the reality bubble on every call.
+ *
+ * The vehicles are listed once, at the start of the turn. The map drops the list when
+ * vehicles are added, removed or moved to another submap, it is listed again on the next
+ * pick. Changes to of_turn are picked up without listing the vehicles again: the vehicle
+ * that was picked last is queued again with its new of_turn on the next pick, changes to any
+ * other vehicle have to be passed to @ref update.
+ */
+class vehicle_scheduler
+{
+    public:
+        /** Whether the vehicles have been listed since the last @ref invalidate. */
+        bool is_valid() const {
+            return valid;
+        }
+        /** Forgets the vehicles, they may not be accessed anymore. */
+        void invalidate();
+        /** Starts with these vehicles, in the order map::get_vehicles lists them. */
+        void start( const std::vector<vehicle *> &vehicles );
+        /** Queues the same vehicles again, after they got the moves of a new turn. */
+        void restart();
+
+        /** The vehicles given to @ref start. */
+        const std::vector<vehicle *> &get_vehicles() const {
+            return vehicles;
+        }
+
+        /** Notes that the of_turn of the vehicle changed. */
+        void update( vehicle *veh );
+        /** @return nullptr if no vehicle has any of its turn left. */
+        vehicle *next();
+        /** The first falling vehicle, for when @ref next found none. */
+        vehicle *next_falling() const;
+
+    private:
+        struct entry {
+            float of_turn;
+            size_t order;
+            vehicle *veh;
+
+            bool operator<( const entry &rhs ) const {
+                // The top of the queue is the largest, so earlier orders are larger.
+                return of_turn < rhs.of_turn || ( of_turn == rhs.of_turn && order > rhs.order );
+            }
+        };
+        void push( vehicle *veh, size_t order );
+
+        std::vector<vehicle *> vehicles;
+        std::unordered_map<const vehicle *, size_t> orders;
+        /**
+         * May hold outdated entries of vehicles whose of_turn changed since, those are
+         * skipped as they come up.
+         */
+        std::priority_queue<entry> queue;
+        vehicle *last_picked = nullptr;
+        bool valid = false;
+};
+
+#endif
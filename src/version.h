@@ -0,0 +1 @@
+#define VERSION "cae7cff-dirty"
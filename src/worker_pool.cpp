@@ -0,0 +1,93 @@
+#include "worker_pool.h"
+
+#if (defined _WIN32 || defined WINDOWS)
+#   include "mingw.thread.h"
+#endif
+
+#include <algorithm>
+
+worker_pool &worker_pool::get()
+{
+    static worker_pool pool( std::max( 1u, std::thread::hardware_concurrency() ) );
+    return pool;
+}
+
+worker_pool::worker_pool( const size_t workers ) : next_job( 0 )
+{
+    for( size_t i = 1; i < workers; ++i ) {
+        threads.emplace_back( &worker_pool::work, this, i );
+    }
+}
+
+worker_pool::~worker_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        stopping = true;
+    }
+    wake.notify_all();
+    for( auto &t : threads ) {
+        t.join();
+    }
+}
+
+void worker_pool::run( const size_t count, const std::function<void( size_t, size_t )> &job )
+{
+    if( threads.empty() || count <= 1 ) {
+        for( size_t i = 0; i < count; ++i ) {
+            job( i, 0 );
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> serial( run_mutex );
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        current_job = &job;
+        job_count = count;
+        next_job = 0;
+        busy_threads = threads.size();
+        batch++;
+    }
+    wake.notify_all();
+    // The calling thread is the last worker.
+    run_jobs( threads.size() );
+
+    std::unique_lock<std::mutex> lock( mutex );
+    done.wait( lock, [this] {
+        return busy_threads == 0;
+    } );
+    current_job = nullptr;
+}
+
+void worker_pool::work( const size_t worker )
+{
+    unsigned int last_batch = 0;
+    while( true ) {
+        {
+            std::unique_lock<std::mutex> lock( mutex );
+            wake.wait( lock, [this, last_batch] {
+                return stopping || batch != last_batch;
+            } );
+            if( stopping ) {
+                return;
+            }
+            last_batch = batch;
+        }
+        run_jobs( worker - 1 );
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            if( --busy_threads == 0 ) {
+                done.notify_one();
+            }
+        }
+    }
+}
+
+void worker_pool::run_jobs( const size_t worker )
+{
+    // current_job and job_count were set under the mutex before the batch started.
+    for( size_t i = next_job++; i < job_count; i = next_job++ ) {
+        ( *current_job )( i, worker );
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of threads that run batches of independent jobs, see @ref run.
+ *
+ * The threads are started once and sleep between batches, so handing out work is cheap
+ * enough to do several times per turn.
+ */
+class worker_pool
+{
+    public:
+        /** The shared pool, sized to the hardware and started on first use. */
+        static worker_pool &get();
+
+        /** Starts workers - 1 threads, the thread calling @ref run is the last worker. */
+        explicit worker_pool( size_t workers );
+        ~worker_pool();
+        worker_pool( const worker_pool & ) = delete;
+        worker_pool &operator=( const worker_pool & ) = delete;
+
+        /** Number of workers, including the thread calling @ref run. */
+        size_t size() const {
+            return threads.size() + 1;
+        }
+
+        /**
+         * Calls job( index, worker ) for every index in [0, count) and returns once all of them
+         * are done. worker is in [0, size()) and never used by two jobs at the same time, so it
+         * can select per-thread scratch space.
+         *
+         * Which worker runs which index, and in what order, differs between runs. Results have to
+         * be combined in a way that doesn't depend on it (e.g. taking the maximum) to stay
+         * deterministic. Jobs must not call run themselves and must not throw.
+         */
+        void run( size_t count, const std::function<void( size_t, size_t )> &job );
+
+    private:
+        void work( size_t worker );
+        void run_jobs( size_t worker );
+
+        std::vector<std::thread> threads;
+        // Only one batch at a time.
+        std::mutex run_mutex;
+        // Guards everything below, except next_job.
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        const std::function<void( size_t, size_t )> *current_job = nullptr;
+        size_t job_count = 0;
+        std::atomic<size_t> next_job;
+        size_t busy_threads = 0;
+        unsigned int batch = 0;
+        bool stopping = false;
+};
+
+#endif
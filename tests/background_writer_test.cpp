@@ -0,0 +1,118 @@
+#include "catch/catch.hpp"
+
+#include "background_writer.h"
+#include "game.h"
+#include "map.h"
+#include "map_storage.h"
+#include "mapbuffer.h"
+#include "options.h"
+#include "overmapbuffer.h"
+#include "submap.h"
+#include "worldfactory.h"
+
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static std::string read_quad( map_storage &storage, const tripoint &om_addr )
+{
+    const std::unique_ptr<quad_data> data = storage.read( om_addr, false );
+    if( !data ) {
+        return "<missing>";
+    }
+    return std::string( data->data(), data->size() );
+}
+
+TEST_CASE("background_writer_runs_jobs_in_order") {
+    background_writer &writer = background_writer::get();
+    OPTIONS["BACKGROUND_SAVING"].setValue( "true" );
+    std::vector<int> order;
+    for( int i = 0; i < 100; i++ ) {
+        writer.queue( [&order, i]() {
+            order.push_back( i );
+        } );
+    }
+    writer.queue( []() {
+        throw std::runtime_error( "first" );
+    } );
+    writer.queue( []() {
+        throw std::runtime_error( "second" );
+    } );
+    writer.wait();
+    OPTIONS["BACKGROUND_SAVING"].setValue( "false" );
+
+    REQUIRE( order.size() == 100 );
+    for( int i = 0; i < 100; i++ ) {
+        CHECK( order[i] == i );
+    }
+    CHECK( writer.take_error() == "first" );
+    CHECK( writer.take_error() == "" );
+}
+
+TEST_CASE("background_saving_writes_the_same_files") {
+    // Uniform submaps are never saved.
+    tripoint sm_addr;
+    for( auto &elem : MAPBUFFER ) {
+        if( elem.second != nullptr && !elem.second->is_uniform ) {
+            sm_addr = elem.first;
+            break;
+        }
+    }
+    const tripoint om_addr = overmapbuffer::sm_to_omt_copy( sm_addr );
+    file_map_storage files( world_generator->active_world->world_path + "/maps" );
+    MAPBUFFER.save();
+    const std::string saved = read_quad( files, om_addr );
+    REQUIRE( saved != "<missing>" );
+
+    background_writer &writer = background_writer::get();
+    OPTIONS["BACKGROUND_SAVING"].setValue( "true" );
+    {
+        mapbuffer buffer;
+        submap *const sm = buffer.lookup_submap( sm_addr );
+        REQUIRE( sm != nullptr );
+        // Unmodified quads aren't saved again.
+        sm->set_modified();
+        // Keeps the writer busy, so nothing the buffer saves is written yet.
+        std::promise<void> release;
+        std::shared_future<void> released = release.get_future().share();
+        writer.queue( [released]() {
+            released.wait();
+        } );
+        buffer.save( true );
+        CHECK( buffer.lookup_submap( sm_addr ) != nullptr );
+        release.set_value();
+        writer.wait();
+    }
+    OPTIONS["BACKGROUND_SAVING"].setValue( "false" );
+
+    CHECK( writer.take_error() == "" );
+    CHECK( read_quad( files, om_addr ) == saved );
+}
+
+static void time_save( const char *name, bool background )
+{
+    OPTIONS["BACKGROUND_SAVING"].setValue( background ? "true" : "false" );
+    auto start = std::chrono::high_resolution_clock::now();
+    MAPBUFFER.save();
+    overmap_buffer.save();
+    auto end = std::chrono::high_resolution_clock::now();
+    background_writer::get().wait();
+    auto written = std::chrono::high_resolution_clock::now();
+    OPTIONS["BACKGROUND_SAVING"].setValue( "false" );
+
+    const long long stall_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+    const long long total_us = std::chrono::duration_cast<std::chrono::microseconds>( written - start ).count();
+    printf( "%s: game stalled %lld us, files written after %lld us\n", name, stall_us, total_us );
+}
+
+TEST_CASE("background_saving_performance", "[.]") {
+    // Warm up the map directory and the page cache.
+    time_save( "warm up", false );
+    time_save( "saving on the main thread", false );
+    time_save( "saving in the background", true );
+    CHECK( background_writer::get().take_error() == "" );
+}
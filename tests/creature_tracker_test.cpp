@@ -0,0 +1,141 @@
+#include "catch/catch.hpp"
+
+#include "creature_tracker.h"
+#include "game_constants.h"
+#include "line.h"
+#include "monster.h"
+#include "rng.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+static tripoint random_free_point( const Creature_tracker &tracker, int lo, int hi )
+{
+    tripoint p;
+    do {
+        p = tripoint( rng( lo, hi ), rng( lo, hi ), rng( -1, 1 ) );
+    } while( tracker.mon_at( p ) != -1 );
+    return p;
+}
+
+static void fill_tracker( Creature_tracker &tracker, int count, int lo, int hi )
+{
+    for( int i = 0; i < count; ++i ) {
+        monster mon( mtype_id( "mon_zombie" ), random_free_point( tracker, lo, hi ) );
+        tracker.add( mon );
+    }
+}
+
+static std::vector<int> brute_force_radius( const Creature_tracker &tracker,
+        const tripoint &center, int radius )
+{
+    std::vector<int> found;
+    for( size_t i = 0; i < tracker.size(); ++i ) {
+        if( rl_dist( center, tracker.find( i ).pos() ) <= radius ) {
+            found.push_back( i );
+        }
+    }
+    return found;
+}
+
+static std::vector<int> brute_force_rect( const Creature_tracker &tracker,
+        const tripoint &min, const tripoint &max )
+{
+    std::vector<int> found;
+    for( size_t i = 0; i < tracker.size(); ++i ) {
+        const tripoint &p = tracker.find( i ).pos();
+        if( p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y &&
+            p.z >= min.z && p.z <= max.z ) {
+            found.push_back( i );
+        }
+    }
+    return found;
+}
+
+static void check_queries( const Creature_tracker &tracker, int size )
+{
+    for( int i = 0; i < 50; ++i ) {
+        const tripoint center( rng( -size, size ), rng( -size, size ), rng( -1, 1 ) );
+        const int radius = rng( 0, size );
+        CHECK( tracker.in_radius( center, radius ) == brute_force_radius( tracker, center, radius ) );
+
+        const tripoint corner( rng( -size, size ), rng( -size, size ), rng( -1, 1 ) );
+        const tripoint min( std::min( center.x, corner.x ), std::min( center.y, corner.y ),
+                            std::min( center.z, corner.z ) );
+        const tripoint max( std::max( center.x, corner.x ), std::max( center.y, corner.y ),
+                            std::max( center.z, corner.z ) );
+        CHECK( tracker.in_rect( min, max ) == brute_force_rect( tracker, min, max ) );
+    }
+}
+
+TEST_CASE("creature_tracker_range_queries_match_brute_force") {
+    const int size = 60;
+    Creature_tracker tracker;
+    // Negative coordinates too, to check rounding to submaps.
+    fill_tracker( tracker, 200, -size, size );
+    check_queries( tracker, size );
+
+    SECTION( "after moving monsters" ) {
+        for( int i = 0; i < 300; ++i ) {
+            monster &mon = tracker.find( rng( 0, tracker.size() - 1 ) );
+            const tripoint dest = random_free_point( tracker, -size, size );
+            REQUIRE( tracker.update_pos( mon, dest ) );
+            mon.spawn( dest );
+        }
+        check_queries( tracker, size );
+    }
+    SECTION( "after swapping monsters" ) {
+        for( int i = 0; i < 100; ++i ) {
+            monster &first = tracker.find( rng( 0, tracker.size() - 1 ) );
+            monster &second = tracker.find( rng( 0, tracker.size() - 1 ) );
+            if( &first != &second ) {
+                tracker.swap_positions( first, second );
+            }
+        }
+        check_queries( tracker, size );
+    }
+    SECTION( "after removing monsters" ) {
+        for( int i = 0; i < 100; ++i ) {
+            tracker.remove( rng( 0, tracker.size() - 1 ) );
+        }
+        check_queries( tracker, size );
+    }
+    SECTION( "after rebuilding the cache" ) {
+        tracker.rebuild_cache();
+        check_queries( tracker, size );
+    }
+}
+
+TEST_CASE("creature_tracker_range_query_performance", "[.]") {
+    // A horde filling the reality bubble.
+    const int size = MAPSIZE * SEEX;
+    Creature_tracker tracker;
+    fill_tracker( tracker, 2000, 0, size - 1 );
+
+    const int queries = 2000;
+    std::vector<tripoint> centers;
+    for( int i = 0; i < queries; ++i ) {
+        centers.emplace_back( rng( 0, size - 1 ), rng( 0, size - 1 ), 0 );
+    }
+
+    size_t grid_found = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for( const tripoint &center : centers ) {
+        grid_found += tracker.in_radius( center, 12 ).size();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    const long long grid_ns = std::chrono::duration_cast<std::chrono::nanoseconds>( end - start ).count();
+
+    size_t brute_found = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for( const tripoint &center : centers ) {
+        brute_found += brute_force_radius( tracker, center, 12 ).size();
+    }
+    end = std::chrono::high_resolution_clock::now();
+    const long long brute_ns = std::chrono::duration_cast<std::chrono::nanoseconds>( end - start ).count();
+
+    CHECK( grid_found == brute_found );
+    printf( "%d radius queries over %d monsters: grid %lld us, full scan %lld us\n",
+            queries, int( tracker.size() ), grid_ns / 1000, brute_ns / 1000 );
+}
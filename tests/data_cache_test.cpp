@@ -0,0 +1,121 @@
+#include "catch/catch.hpp"
+
+#include "data_cache.h"
+#include "filesystem.h"
+#include "json.h"
+#include "veh_type.h"
+#include "vehicle.h"
+#include "worldfactory.h"
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <sstream>
+#include <string>
+
+static std::string cache_path()
+{
+    return world_generator->active_world->world_path + "/data_cache_test.bin";
+}
+
+TEST_CASE("data_cache_is_keyed_by_the_loaded_files") {
+    const std::string path = cache_path();
+    remove_file( path );
+    {
+        data_cache cache;
+        cache.add_file( "a.json", "[]" );
+        CHECK_FALSE( cache.load( path ) );
+        cache.store( "section", std::string( "binary\0data", 11 ) );
+        REQUIRE( cache.save( path ) );
+    }
+    {
+        data_cache cache;
+        cache.add_file( "a.json", "[]" );
+        REQUIRE( cache.load( path ) );
+        const std::string *section = cache.find( "section" );
+        REQUIRE( section != nullptr );
+        CHECK( *section == std::string( "binary\0data", 11 ) );
+        CHECK( cache.find( "other" ) == nullptr );
+        // More data loaded after the cache was read makes it stale.
+        cache.add_file( "b.json", "[]" );
+        CHECK( cache.find( "section" ) == nullptr );
+    }
+    {
+        data_cache cache;
+        cache.add_file( "a.json", "[ ]" );
+        CHECK_FALSE( cache.load( path ) );
+        CHECK( cache.find( "section" ) == nullptr );
+    }
+    {
+        data_cache unused;
+        unused.store( "section", "data" );
+        CHECK( unused.find( "section" ) == nullptr );
+    }
+    remove_file( path );
+}
+
+static std::map<std::string, std::string> serialized_blueprints()
+{
+    std::map<std::string, std::string> result;
+    for( auto &id : vehicle_prototype::get_all() ) {
+        std::ostringstream data;
+        JsonOut json( data );
+        id.obj().blueprint->serialize( json );
+        result[id.str()] = data.str();
+    }
+    return result;
+}
+
+TEST_CASE("cached_vehicle_blueprints_match_the_built_ones") {
+    const std::string path = cache_path();
+    remove_file( path );
+    const auto built = serialized_blueprints();
+    REQUIRE( !built.empty() );
+    {
+        data_cache cache;
+        CHECK_FALSE( cache.load( path ) );
+        vehicle_prototype::save_blueprints( cache );
+        REQUIRE( cache.save( path ) );
+    }
+    data_cache cache;
+    REQUIRE( cache.load( path ) );
+    vehicle_prototype::finalize( cache );
+    const auto cached = serialized_blueprints();
+    REQUIRE( cached.size() == built.size() );
+    for( auto &blueprint : built ) {
+        INFO( blueprint.first );
+        CHECK( cached.at( blueprint.first ) == blueprint.second );
+    }
+    remove_file( path );
+}
+
+TEST_CASE("data_cache_performance", "[.]") {
+    const std::string path = cache_path();
+    remove_file( path );
+    {
+        data_cache cache;
+        cache.load( path );
+        vehicle_prototype::save_blueprints( cache );
+        cache.save( path );
+    }
+    // Installing the parts one by one, like finalizing without the cache does.
+    auto start = std::chrono::high_resolution_clock::now();
+    for( auto &id : vehicle_prototype::get_all() ) {
+        vehicle rebuilt;
+        for( auto &part : id.obj().blueprint->parts ) {
+            rebuilt.install_part( part.mount.x, part.mount.y, part.get_id() );
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    const long long built_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    data_cache cache;
+    cache.load( path );
+    vehicle_prototype::finalize( cache );
+    end = std::chrono::high_resolution_clock::now();
+    const long long cached_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+    printf( "%d vehicle blueprints: built in %lld us, read from the cache in %lld us\n",
+            int( vehicle_prototype::get_all().size() ), built_us, cached_us );
+    remove_file( path );
+}
@@ -0,0 +1,246 @@
+#include "catch/catch.hpp"
+
+#include "field.h"
+#include "game.h"
+#include "map.h"
+#include "mapbuffer.h"
+#include "rng.h"
+#include "submap.h"
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+static std::vector<field_id> field_types( const field &fld )
+{
+    std::vector<field_id> result;
+    for( auto &entry : fld ) {
+        result.push_back( entry.first );
+    }
+    return result;
+}
+
+TEST_CASE("field_entries_are_ordered_and_stay_in_place") {
+    field fld;
+    CHECK( fld.begin() == fld.end() );
+    CHECK( fld.fieldCount() == 0 );
+
+    REQUIRE( fld.addField( fd_smoke, 2, 5 ) );
+    REQUIRE( fld.addField( fd_blood ) );
+    field_entry *smoke = fld.findField( fd_smoke );
+    REQUIRE( smoke != nullptr );
+    // More than fit into the field itself.
+    REQUIRE( fld.addField( fd_fire, 1, 3 ) );
+    REQUIRE( fld.addField( fd_acid ) );
+    CHECK_FALSE( fld.addField( fd_smoke ) );
+    CHECK( fld.findField( fd_smoke ) == smoke );
+    CHECK( smoke->getFieldDensity() == 3 );
+    CHECK( smoke->getFieldAge() == 5 );
+    CHECK( fld.fieldCount() == 4 );
+    CHECK( field_types( fld ) == std::vector<field_id>( { fd_blood, fd_acid, fd_fire, fd_smoke } ) );
+    CHECK( fld.fieldSymbol() != fd_null );
+
+    CHECK( fld.removeField( fd_blood ) );
+    CHECK_FALSE( fld.removeField( fd_blood ) );
+    CHECK( fld.findField( fd_smoke ) == smoke );
+    CHECK( fld.fieldCount() == 3 );
+
+    // Like the field processing: removing the current entry and adding others on the way.
+    std::vector<field_id> visited;
+    for( auto it = fld.begin(); it != fld.end(); ) {
+        visited.push_back( it->first );
+        if( it->first == fd_acid ) {
+            fld.addField( fd_blood );
+            fld.addField( fd_web );
+            fld.removeField( it++ );
+        } else {
+            ++it;
+        }
+    }
+    // Entries with a smaller field_id than the current one are not visited, like in a std::map.
+    CHECK( visited == std::vector<field_id>( { fd_acid, fd_fire, fd_smoke } ) );
+    CHECK( field_types( fld ) == std::vector<field_id>( { fd_blood, fd_web, fd_fire, fd_smoke } ) );
+    CHECK( fld.fieldCount() == 4 );
+
+    const field copy = fld;
+    CHECK( field_types( copy ) == field_types( fld ) );
+    CHECK( copy.findField( fd_smoke )->getFieldDensity() == 3 );
+    CHECK( copy.move_cost() == fld.move_cost() );
+}
+
+TEST_CASE("fields_are_processed_where_there_are_some") {
+    const tripoint pos( SEEX * 2 + 3, SEEY * 2 + 4, g->get_levz() );
+    const tripoint sm_addr = g->m.get_abs_sub() + tripoint( pos.x / SEEX, pos.y / SEEY, 0 );
+    submap *const sm = MAPBUFFER.lookup_submap( sm_addr );
+    REQUIRE( sm != nullptr );
+    const size_t square = ( pos.x % SEEX ) * SEEY + pos.y % SEEY;
+
+    REQUIRE( g->m.add_field( pos, fd_blood, 1, 0 ) );
+    CHECK( sm->field_squares.test( square ) );
+    g->m.process_fields();
+    CHECK( sm->field_squares.test( square ) );
+    CHECK( g->m.get_field( pos, fd_blood ) != nullptr );
+    CHECK( g->m.get_field( pos, fd_blood )->getFieldAge() == 1 );
+
+    g->m.remove_field( pos, fd_blood );
+    CHECK_FALSE( sm->field_squares.test( square ) );
+
+    sm->fld[pos.x % SEEX][pos.y % SEEY].addField( fd_blood );
+    sm->field_count++;
+    sm->update_field_squares();
+    CHECK( sm->field_squares.test( square ) );
+    g->m.remove_field( pos, fd_blood );
+}
+
+TEST_CASE("field_storage_performance", "[.]") {
+    const int squares = SEEX * SEEY;
+    const int rounds = 2000;
+    const std::vector<field_id> types = { fd_blood, fd_smoke };
+    std::vector<std::map<field_id, field_entry>> maps( squares );
+    std::vector<field> fields( squares );
+    for( int i = 0; i < squares; i++ ) {
+        // Like a cloud of smoke over some blood.
+        for( size_t t = 0; t < types.size(); t++ ) {
+            if( ( i + t ) % 3 != 0 ) {
+                maps[i][types[t]] = field_entry( types[t], 2, 10 );
+                fields[i].addField( types[t], 2, 10 );
+            }
+        }
+    }
+
+    // Finding the smoke on each square and its neighbours, like spreading gas does.
+    long found = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for( int r = 0; r < rounds; r++ ) {
+        for( int i = 0; i < squares; i++ ) {
+            for( int n = -1; n <= 1; n++ ) {
+                const auto &m = maps[( i + n + squares ) % squares];
+                found += m.find( fd_smoke ) != m.end();
+            }
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    const long long map_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    for( int r = 0; r < rounds; r++ ) {
+        for( int i = 0; i < squares; i++ ) {
+            for( int n = -1; n <= 1; n++ ) {
+                found += fields[( i + n + squares ) % squares].findField( fd_smoke ) != nullptr;
+            }
+        }
+    }
+    end = std::chrono::high_resolution_clock::now();
+    const long long field_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+
+    // Whole turns over a smoke cloud on the map.
+    const int turns = 20;
+    start = std::chrono::high_resolution_clock::now();
+    for( int turn = 0; turn < turns; turn++ ) {
+        for( int x = 0; x < SEEX * 4; x++ ) {
+            for( int y = 0; y < SEEY * 4; y++ ) {
+                g->m.add_field( tripoint( SEEX * 4 + x, SEEY * 4 + y, g->get_levz() ), fd_smoke, 3, 1 );
+            }
+        }
+        g->m.process_fields();
+    }
+    end = std::chrono::high_resolution_clock::now();
+    const long long process_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+    for( int x = 0; x < SEEX * 8; x++ ) {
+        for( int y = 0; y < SEEY * 8; y++ ) {
+            g->m.remove_field( tripoint( SEEX * 2 + x, SEEY * 2 + y, g->get_levz() ), fd_smoke );
+        }
+    }
+
+    printf( "%d rounds of %d squares: std::map %lld us, field %lld us (%ld found); %d turns of smoke %lld us\n",
+            rounds, squares, map_us, field_us, found, turns, process_us );
+}
+
+struct gas_spread_stats {
+    double density = 0;
+    double squares = 0;
+    double distance = 0;
+};
+
+static void remove_smoke( const tripoint &center, const int radius )
+{
+    for( int x = center.x - radius; x <= center.x + radius; x++ ) {
+        for( int y = center.y - radius; y <= center.y + radius; y++ ) {
+            g->m.remove_field( tripoint( x, y, center.z ), fd_smoke );
+        }
+    }
+}
+
+// Averages over many runs of a cloud of smoke spreading for some turns.
+static gas_spread_stats spread_smoke( const bool batched, const int runs, const int turns )
+{
+    const tripoint center( SEEX * MAPSIZE / 2, SEEY * MAPSIZE / 2, g->get_levz() );
+    const int radius = 2 * turns + 2;
+    gas_spread_stats result;
+    for( int run = 0; run < runs; run++ ) {
+        rng_stream stream( 1000 + run );
+        remove_smoke( center, radius );
+        for( int x = -1; x <= 1; x++ ) {
+            for( int y = -1; y <= 1; y++ ) {
+                g->m.add_field( center + tripoint( x, y, 0 ), fd_smoke, 3, 1 );
+            }
+        }
+        for( int turn = 0; turn < turns; turn++ ) {
+            g->m.process_fields( batched );
+        }
+        for( int x = -radius; x <= radius; x++ ) {
+            for( int y = -radius; y <= radius; y++ ) {
+                const field_entry *smoke = g->m.get_field( center + tripoint( x, y, 0 ), fd_smoke );
+                if( smoke != nullptr ) {
+                    result.density += smoke->getFieldDensity();
+                    result.squares++;
+                    result.distance += smoke->getFieldDensity() * ( x * x + y * y );
+                }
+            }
+        }
+    }
+    remove_smoke( center, radius );
+    result.distance /= result.density;
+    result.density /= runs;
+    result.squares /= runs;
+    return result;
+}
+
+TEST_CASE("batched_gas_spreads_like_square_by_square") {
+    const int runs = 100;
+    const int turns = 8;
+    const gas_spread_stats square_by_square = spread_smoke( false, runs, turns );
+    const gas_spread_stats batched = spread_smoke( true, runs, turns );
+    INFO( "density " << square_by_square.density << " / " << batched.density );
+    INFO( "squares " << square_by_square.squares << " / " << batched.squares );
+    INFO( "mean squared distance " << square_by_square.distance << " / " << batched.distance );
+    REQUIRE( square_by_square.squares > 9 );
+    CHECK( batched.density == Approx( square_by_square.density ).epsilon( 0.1 ) );
+    CHECK( batched.squares == Approx( square_by_square.squares ).epsilon( 0.1 ) );
+    CHECK( batched.distance == Approx( square_by_square.distance ).epsilon( 0.15 ) );
+}
+
+TEST_CASE("gas_field_performance", "[.]") {
+    const tripoint center( SEEX * MAPSIZE / 2, SEEY * MAPSIZE / 2, g->get_levz() );
+    const int radius = 30;
+    const int turns = 20;
+    long long times[2];
+    for( int batched = 0; batched < 2; batched++ ) {
+        rng_stream stream( 42 );
+        for( int x = -radius; x <= radius; x++ ) {
+            for( int y = -radius; y <= radius; y++ ) {
+                g->m.add_field( center + tripoint( x, y, 0 ), fd_smoke, 3, 1 );
+            }
+        }
+        const auto start = std::chrono::high_resolution_clock::now();
+        for( int turn = 0; turn < turns; turn++ ) {
+            g->m.process_fields( batched != 0 );
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+        times[batched] = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+        remove_smoke( center, radius + turns * 2 );
+    }
+    printf( "%d turns of a smoke cloud of %d squares: square by square %lld us, batched %lld us\n",
+            turns, ( 2 * radius + 1 ) * ( 2 * radius + 1 ), times[0], times[1] );
+}
@@ -0,0 +1,63 @@
+#include "catch/catch.hpp"
+
+#include "filesystem.h"
+#include "init.h"
+#include "options.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+static std::vector<std::unique_ptr<parsed_json_file>> parse_data( bool parallel )
+{
+    OPTIONS["PARALLEL_DATA_LOADING"].setValue( parallel ? "true" : "false" );
+    auto parsed = parse_json_files( get_files_from_path( ".json", "data/json", true, true ) );
+    OPTIONS["PARALLEL_DATA_LOADING"].setValue( "false" );
+    return parsed;
+}
+
+TEST_CASE("parallel_parsing_keeps_the_file_order") {
+    const auto serial = parse_data( false );
+    const auto parallel = parse_data( true );
+    REQUIRE( !serial.empty() );
+    REQUIRE( serial.size() == parallel.size() );
+    for( size_t i = 0; i < serial.size(); i++ ) {
+        const parsed_json_file &expected = *serial[i];
+        const parsed_json_file &actual = *parallel[i];
+        INFO( expected.path );
+        CHECK( actual.path == expected.path );
+        CHECK( actual.error == "" );
+        REQUIRE( actual.objects.size() == expected.objects.size() );
+        for( size_t j = 0; j < expected.objects.size(); j++ ) {
+            JsonObject expected_object = expected.objects[j];
+            JsonObject actual_object = actual.objects[j];
+            CHECK( actual_object.str() == expected_object.str() );
+        }
+    }
+}
+
+TEST_CASE("parsing_errors_are_kept_for_loading") {
+    const auto parsed = parse_json_files( { "data/json/no_such_file.json" } );
+    REQUIRE( parsed.size() == 1 );
+    CHECK( parsed[0]->objects.empty() );
+    CHECK( parsed[0]->error.find( "expected object or array" ) != std::string::npos );
+}
+
+static void time_parsing( const char *name, bool parallel )
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    const auto parsed = parse_data( parallel );
+    auto end = std::chrono::high_resolution_clock::now();
+    const long long parse_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+    printf( "%s: %d files parsed in %lld us\n", name, int( parsed.size() ), parse_us );
+}
+
+TEST_CASE("data_loading_performance", "[.]") {
+    printf( "Loading the test data took %s\n",
+            DynamicDataLoader::get_instance().loading_times.to_string().c_str() );
+    time_parsing( "warm up", false );
+    time_parsing( "one file after another", false );
+    time_parsing( "on all cores", true );
+}
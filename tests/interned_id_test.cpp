@@ -0,0 +1,116 @@
+#include "catch/catch.hpp"
+
+#include "item.h"
+#include "item_factory.h"
+#include "itype.h"
+#include "monster.h"
+#include "player.h"
+
+#include <chrono>
+#include <cstdio>
+
+TEST_CASE("interned_ids_are_shared_by_equal_strings") {
+    const effect_id stunned( "stunned" );
+    CHECK( effect_id( std::string( "stun" ) + "ned" ) == stunned );
+    CHECK( stunned.str() == "stunned" );
+    CHECK( effect_id( "downed" ) != stunned );
+    CHECK( effect_id().to_i() == 0 );
+    CHECK( effect_id().str() == "" );
+    CHECK( size_t( stunned.to_i() ) < effect_id::count() );
+
+    interned_set<effect_type> set;
+    CHECK( set.empty() );
+    set.set( stunned );
+    CHECK( set.test( stunned ) );
+    CHECK_FALSE( set.test( effect_id( "downed" ) ) );
+    // Not seen before the set was filled, so it can't be in it.
+    CHECK_FALSE( set.test( effect_id( "interned_id_test_new_effect" ) ) );
+    set.reset( stunned );
+    CHECK( set.empty() );
+}
+
+TEST_CASE("effect_ids_follow_the_effects") {
+    monster zombie( mtype_id( "mon_zombie" ) );
+    const effect_id downed( "downed" );
+    zombie.add_effect( "downed", 5 );
+    CHECK( zombie.has_effect( downed ) );
+    CHECK( zombie.has_effect( "downed" ) );
+    CHECK_FALSE( zombie.has_effect( effect_id( "stunned" ) ) );
+    zombie.remove_effect( "downed" );
+    CHECK_FALSE( zombie.has_effect( downed ) );
+
+    player dummy;
+    dummy.add_effect( "bite", 10, bp_arm_l );
+    CHECK( dummy.has_effect( effect_id( "bite" ) ) );
+    CHECK( dummy.has_effect( effect_id( "bite" ), bp_arm_l ) );
+    CHECK_FALSE( dummy.has_effect( effect_id( "bite" ), bp_arm_r ) );
+    dummy.remove_effect( "bite", bp_arm_l );
+    CHECK_FALSE( dummy.has_effect( effect_id( "bite" ) ) );
+    dummy.add_effect( "bite", 10, bp_arm_l );
+    dummy.clear_effects();
+    CHECK_FALSE( dummy.has_effect( effect_id( "bite" ) ) );
+}
+
+TEST_CASE("trait_and_bionic_ids_follow_the_character") {
+    player dummy;
+    const trait_id pretty( "PRETTY" );
+    CHECK_FALSE( dummy.has_trait( pretty ) );
+    dummy.set_mutation( "PRETTY" );
+    CHECK( dummy.has_trait( pretty ) );
+    CHECK( dummy.has_trait( "PRETTY" ) );
+    dummy.unset_mutation( "PRETTY" );
+    CHECK_FALSE( dummy.has_trait( pretty ) );
+
+    const bionic_id alarm( "bio_alarm" );
+    CHECK_FALSE( dummy.has_bionic( alarm ) );
+    dummy.add_bionic( "bio_alarm" );
+    CHECK( dummy.has_bionic( alarm ) );
+    CHECK_FALSE( dummy.has_active_bionic( alarm ) );
+    dummy.my_bionics.back().powered = true;
+    CHECK( dummy.has_active_bionic( alarm ) );
+    CHECK( dummy.has_active_bionic( "bio_alarm" ) );
+    dummy.remove_bionic( "bio_alarm" );
+    CHECK_FALSE( dummy.has_bionic( alarm ) );
+    CHECK_FALSE( dummy.has_active_bionic( alarm ) );
+}
+
+TEST_CASE("item_type_flag_ids_match_the_item_tags") {
+    for( auto &type : item_controller->get_all_itypes() ) {
+        INFO( type.first );
+        for( auto &tag : type.second->item_tags ) {
+            CHECK( type.second->flag_ids.test( item_flag_id( tag ) ) );
+        }
+    }
+    item knife( "knife_combat", 0 );
+    REQUIRE( knife.type->item_tags.count( "STAB" ) > 0 );
+    CHECK( knife.has_flag( item_flag_id( "STAB" ) ) );
+    CHECK_FALSE( knife.has_flag( item_flag_id( "FIT" ) ) );
+    knife.item_tags.insert( "FIT" );
+    CHECK( knife.has_flag( item_flag_id( "FIT" ) ) );
+    CHECK( knife.has_flag( "FIT" ) );
+}
+
+TEST_CASE("interned_id_performance", "[.]") {
+    monster zombie( mtype_id( "mon_zombie" ) );
+    zombie.add_effect( "downed", 5 );
+    zombie.add_effect( "onfire", 5 );
+    const effect_id controlled( "controlled" );
+    const int checks = 1000000;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    int found = 0;
+    for( int i = 0; i < checks; i++ ) {
+        found += zombie.has_effect( "controlled" ) ? 1 : 0;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    const long long string_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    for( int i = 0; i < checks; i++ ) {
+        found += zombie.has_effect( controlled ) ? 1 : 0;
+    }
+    end = std::chrono::high_resolution_clock::now();
+    const long long id_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+    CHECK( found == 0 );
+    printf( "%d has_effect checks: by string %lld us, by interned id %lld us\n", checks, string_us, id_us );
+}
@@ -0,0 +1,144 @@
+#include "catch/catch.hpp"
+
+#include "filesystem.h"
+#include "json.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static const std::string sample =
+    "[\n"
+    "  { \"id\": \"first\", \"name\": \"tab\\there \\\"quoted\\\" \\u00e9\", \"count\": 12,\n"
+    "    \"weight\": -1.5e2, \"flags\": [ \"A\", \"B\" ], \"on\": true, \"off\": false,\n"
+    "    \"none\": null, \"//\": \"comment\", \"//\": \"another one\",\n"
+    "    \"inner\": { \"x\": 3, \"y\": [ 1, 2, 3 ] } },\n"
+    "  { \"id\": \"second\" }\n"
+    "]\n";
+
+static void check_sample( JsonIn &jsin )
+{
+    JsonArray ja = jsin.get_array();
+    REQUIRE( ja.size() == 2 );
+    JsonObject first = ja.next_object();
+    CHECK( first.size() == 10 );
+    CHECK( first.get_string( "id" ) == "first" );
+    CHECK( first.get_string( "name" ) == "tab\there \"quoted\" \xc3\xa9" );
+    CHECK( first.get_int( "count" ) == 12 );
+    CHECK( first.get_float( "weight" ) == Approx( -150.0 ) );
+    CHECK( first.get_tags( "flags" ).size() == 2 );
+    CHECK( first.get_bool( "on" ) );
+    CHECK_FALSE( first.get_bool( "off" ) );
+    CHECK( first.has_null( "none" ) );
+    CHECK_FALSE( first.has_member( "missing" ) );
+    CHECK( first.get_int( "missing", 7 ) == 7 );
+    // Looking a member up must not add it.
+    CHECK( first.size() == 10 );
+    JsonObject inner = first.get_object( "inner" );
+    CHECK( inner.get_int( "x" ) == 3 );
+    CHECK( inner.get_int_array( "y" ) == std::vector<int>( { 1, 2, 3 } ) );
+    JsonObject second = ja.next_object();
+    CHECK( second.get_string( "id" ) == "second" );
+}
+
+static std::string parse_error( JsonIn &jsin )
+{
+    try {
+        JsonArray ja = jsin.get_array();
+        while( ja.has_more() ) {
+            JsonObject jo = ja.next_object();
+            jo.get_string( "id" );
+        }
+    } catch( const JsonError &err ) {
+        return err.what();
+    }
+    return "";
+}
+
+TEST_CASE("json_buffer_reads_like_a_stream") {
+    std::istringstream stream( sample );
+    JsonIn from_stream( stream );
+    check_sample( from_stream );
+    JsonIn from_buffer( sample.data(), sample.size() );
+    check_sample( from_buffer );
+
+    const std::string broken = "[\n  { \"id\": \"one\" },\n  { \"id\": \"two\"\n    \"name\": 1 }\n]\n";
+    std::istringstream broken_stream( broken );
+    JsonIn broken_from_stream( broken_stream );
+    JsonIn broken_from_buffer( broken.data(), broken.size() );
+    const std::string stream_error = parse_error( broken_from_stream );
+    CHECK( stream_error.find( "line 3" ) != std::string::npos );
+    CHECK( parse_error( broken_from_buffer ) == stream_error );
+
+    const std::string unterminated = "\"open";
+    JsonIn unterminated_from_buffer( unterminated.data(), unterminated.size() );
+    try {
+        unterminated_from_buffer.get_string();
+        FAIL( "unterminated string was read" );
+    } catch( const JsonError &err ) {
+        CHECK( std::string( err.what() ).find( "couldn't find end of string" ) != std::string::npos );
+    }
+}
+
+TEST_CASE("json_object_rejects_duplicate_members") {
+    const std::string duplicate = "{ \"id\": 1, \"id\": 2 }";
+    JsonIn jsin( duplicate.data(), duplicate.size() );
+    CHECK_THROWS_AS( jsin.get_object(), JsonError );
+}
+
+// Indexes every object in the file and reads its type, like the data loader does.
+static size_t index_objects( JsonIn &jsin )
+{
+    size_t objects = 0;
+    jsin.eat_whitespace();
+    if( jsin.peek() != '[' ) {
+        jsin.skip_value();
+        return objects;
+    }
+    jsin.start_array();
+    while( !jsin.end_array() ) {
+        JsonObject jo = jsin.get_object();
+        jo.get_string( "type", "" );
+        if( jo.has_string( "id" ) ) {
+            jo.get_string( "id" );
+        }
+        objects++;
+    }
+    return objects;
+}
+
+TEST_CASE("json_loading_performance", "[.]") {
+    std::vector<std::string> contents;
+    for( auto &file : get_files_from_path( ".json", "data/json", true, true ) ) {
+        std::ifstream fin( file.c_str(), std::ios::binary );
+        contents.emplace_back( ( std::istreambuf_iterator<char>( fin ) ),
+                               std::istreambuf_iterator<char>() );
+    }
+    REQUIRE( !contents.empty() );
+
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t stream_objects = 0;
+    for( auto &data : contents ) {
+        std::istringstream stream( data );
+        JsonIn jsin( stream );
+        stream_objects += index_objects( jsin );
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    const long long stream_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    size_t buffer_objects = 0;
+    for( auto &data : contents ) {
+        JsonIn jsin( data.data(), data.size() );
+        buffer_objects += index_objects( jsin );
+    }
+    end = std::chrono::high_resolution_clock::now();
+    const long long buffer_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+
+    CHECK( stream_objects == buffer_objects );
+    printf( "%d files, %d objects: from streams %lld us, from buffers %lld us\n",
+            int( contents.size() ), int( buffer_objects ), stream_us, buffer_us );
+}
@@ -0,0 +1,205 @@
+#include "catch/catch.hpp"
+
+#include "calendar.h"
+#include "creature_tracker.h"
+#include "field.h"
+#include "game.h"
+#include "map.h"
+#include "mapdata.h"
+#include "monster.h"
+#include "options.h"
+#include "player.h"
+#include "worker_pool.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+struct lightmap_snapshot {
+    float lm[MAPSIZE * SEEX][MAPSIZE * SEEY];
+    float sm[MAPSIZE * SEEX][MAPSIZE * SEEY];
+};
+
+// A room with a door to the outside, lit by a lamp and a few fires at midnight.
+static void build_lit_room()
+{
+    const int mapsize = g->m.getmapsize() * SEEX;
+    for( int x = 0; x < mapsize; ++x ) {
+        for( int y = 0; y < mapsize; ++y ) {
+            g->m.set( x, y, t_grass, f_null );
+            g->m.remove_field( tripoint( x, y, 0 ), fd_fire );
+        }
+    }
+    while( g->num_zombies() ) {
+        g->remove_zombie( 0 );
+    }
+    for( int x = 50; x <= 80; ++x ) {
+        for( int y = 50; y <= 80; ++y ) {
+            if( x == 50 || x == 80 || y == 50 || y == 80 ) {
+                g->m.ter_set( x, y, t_wall );
+            } else {
+                g->m.ter_set( x, y, t_floor );
+            }
+        }
+    }
+    g->m.ter_set( 65, 50, t_door_o );
+    g->m.ter_set( 60, 60, t_utility_light );
+    for( int x = 20; x < 24; ++x ) {
+        for( int y = 30; y < 33; ++y ) {
+            g->m.add_field( tripoint( x, y, 0 ), fd_fire, 1 + ( x + y ) % 3, 0 );
+        }
+    }
+    g->u.setpos( { 66, 66, 0 } );
+}
+
+static void take_snapshot( lightmap_snapshot &snapshot )
+{
+    const level_cache &cache = g->m.get_cache_ref( 0 );
+    std::memcpy( snapshot.lm, cache.lm, sizeof( snapshot.lm ) );
+    std::memcpy( snapshot.sm, cache.sm, sizeof( snapshot.sm ) );
+}
+
+// Builds the lightmap as usual, then from scratch, the two have to be identical.
+static void check_incremental_lightmap()
+{
+    std::unique_ptr<lightmap_snapshot> incremental( new lightmap_snapshot() );
+    g->m.build_map_cache( 0 );
+    take_snapshot( *incremental );
+    g->m.set_lightmap_dirty( 0 );
+    g->m.build_map_cache( 0 );
+    const level_cache &cache = g->m.get_cache_ref( 0 );
+    int mismatches = 0;
+    for( int x = 0; x < MAPSIZE * SEEX; ++x ) {
+        for( int y = 0; y < MAPSIZE * SEEY; ++y ) {
+            if( incremental->lm[x][y] != cache.lm[x][y] || incremental->sm[x][y] != cache.sm[x][y] ) {
+                mismatches++;
+            }
+        }
+    }
+    CHECK( mismatches == 0 );
+}
+
+TEST_CASE("incremental_lightmap_matches_full_rebuild") {
+    const int old_turn = calendar::turn;
+    calendar::turn = DAYS( 1 );
+    build_lit_room();
+    g->m.set_lightmap_dirty( 0 );
+    g->m.build_map_cache( 0 );
+    CHECK( g->m.light_at( tripoint( 60, 61, 0 ) ) >= LL_LIT );
+    check_incremental_lightmap();
+
+    SECTION( "moving a lamp" ) {
+        g->m.ter_set( 60, 60, t_floor );
+        g->m.ter_set( 70, 72, t_utility_light );
+        check_incremental_lightmap();
+    }
+    SECTION( "fires starting and dying down" ) {
+        g->m.add_field( tripoint( 24, 31, 0 ), fd_fire, 3, 0 );
+        check_incremental_lightmap();
+        g->m.remove_field( tripoint( 21, 31, 0 ), fd_fire );
+        g->m.remove_field( tripoint( 24, 31, 0 ), fd_fire );
+        check_incremental_lightmap();
+    }
+    SECTION( "a burning monster walking by" ) {
+        monster zombie( mtype_id( "mon_zombie" ), tripoint( 30, 30, 0 ) );
+        g->critter_tracker->add( zombie );
+        g->zombie( 0 ).add_effect( "onfire", 100 );
+        check_incremental_lightmap();
+        for( int i = 0; i < 5; ++i ) {
+            g->zombie( 0 ).setpos( tripoint( 30 + i, 30 + i, 0 ) );
+            check_incremental_lightmap();
+        }
+        g->remove_zombie( 0 );
+        check_incremental_lightmap();
+    }
+    SECTION( "opening a wall next to the lamp" ) {
+        g->m.ter_set( 50, 60, t_floor );
+        check_incremental_lightmap();
+    }
+    SECTION( "the player moving away" ) {
+        g->u.setpos( { 100, 100, 0 } );
+        check_incremental_lightmap();
+    }
+    calendar::turn = old_turn;
+}
+
+TEST_CASE("parallel_lightmap_matches_serial") {
+    const int old_turn = calendar::turn;
+    calendar::turn = DAYS( 1 );
+    build_lit_room();
+    for( int x = 52; x < 80; x += 4 ) {
+        for( int y = 52; y < 80; y += 4 ) {
+            g->m.ter_set( x, y, t_utility_light );
+        }
+    }
+    std::unique_ptr<lightmap_snapshot> serial( new lightmap_snapshot() );
+    g->m.set_lightmap_dirty( 0 );
+    g->m.build_map_cache( 0 );
+    take_snapshot( *serial );
+
+    OPTIONS["PARALLEL_LIGHTMAP"].setValue( "true" );
+    // Twice, to check the worker buffers are cleaned up after merging.
+    for( int i = 0; i < 2; ++i ) {
+        g->m.set_lightmap_dirty( 0 );
+        g->m.build_map_cache( 0 );
+        const level_cache &cache = g->m.get_cache_ref( 0 );
+        int mismatches = 0;
+        for( int x = 0; x < MAPSIZE * SEEX; ++x ) {
+            for( int y = 0; y < MAPSIZE * SEEY; ++y ) {
+                if( serial->lm[x][y] != cache.lm[x][y] || serial->sm[x][y] != cache.sm[x][y] ) {
+                    mismatches++;
+                }
+            }
+        }
+        CHECK( mismatches == 0 );
+    }
+    OPTIONS["PARALLEL_LIGHTMAP"].setValue( "false" );
+    calendar::turn = old_turn;
+}
+
+TEST_CASE("incremental_lightmap_performance", "[.]") {
+    const int old_turn = calendar::turn;
+    calendar::turn = DAYS( 1 );
+    build_lit_room();
+    // Lots of static light and a single monster moving around.
+    for( int x = 52; x < 80; x += 3 ) {
+        for( int y = 52; y < 80; y += 3 ) {
+            g->m.ter_set( x, y, t_utility_light );
+        }
+    }
+    monster zombie( mtype_id( "mon_zombie" ), tripoint( 10, 10, 0 ) );
+    g->critter_tracker->add( zombie );
+    g->zombie( 0 ).add_effect( "onfire", 100000 );
+    const int iterations = 100;
+    for( int full = 0; full < 2; ++full ) {
+        g->m.set_lightmap_dirty( 0 );
+        g->m.build_map_cache( 0 );
+        auto start = std::chrono::high_resolution_clock::now();
+        for( int i = 0; i < iterations; ++i ) {
+            g->zombie( 0 ).setpos( tripoint( 10 + i % 20, 10, 0 ) );
+            if( full ) {
+                g->m.set_lightmap_dirty( 0 );
+            }
+            g->m.build_map_cache( 0 );
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        long diff = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+        printf( "%s map caches built %d times in %ld microseconds.\n",
+                full ? "Fully rebuilt" : "Incrementally lit", iterations, diff );
+    }
+    OPTIONS["PARALLEL_LIGHTMAP"].setValue( "true" );
+    auto start = std::chrono::high_resolution_clock::now();
+    for( int i = 0; i < iterations; ++i ) {
+        g->zombie( 0 ).setpos( tripoint( 10 + i % 20, 10, 0 ) );
+        g->m.set_lightmap_dirty( 0 );
+        g->m.build_map_cache( 0 );
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    long diff = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+    printf( "Fully rebuilt map caches built %d times in %ld microseconds on %d threads.\n",
+            iterations, diff, int( worker_pool::get().size() ) );
+    OPTIONS["PARALLEL_LIGHTMAP"].setValue( "false" );
+    g->remove_zombie( 0 );
+    calendar::turn = old_turn;
+}
@@ -0,0 +1,92 @@
+#include "catch/catch.hpp"
+
+#include "calendar.h"
+#include "field.h"
+#include "game.h"
+#include "map.h"
+#include "mapdata.h"
+
+#include <cstring>
+#include <memory>
+
+struct map_caches_snapshot {
+    bool outside_cache[MAPSIZE * SEEX][MAPSIZE * SEEY];
+    float transparency_cache[MAPSIZE * SEEX][MAPSIZE * SEEY];
+};
+
+static void clear_map_for_caches()
+{
+    const int mapsize = g->m.getmapsize() * SEEX;
+    for( int x = 0; x < mapsize; ++x ) {
+        for( int y = 0; y < mapsize; ++y ) {
+            g->m.set( x, y, t_grass, f_null );
+            g->m.remove_field( tripoint( x, y, 0 ), fd_fire );
+        }
+    }
+    g->m.build_map_cache( 0, true );
+}
+
+// Rebuilds the caches as usual, then from scratch, the two have to be identical.
+// Returns the number of submaps that were rebuilt the first time.
+static cache_rebuild_stats check_incremental_caches()
+{
+    calendar::turn += 1;
+    g->m.build_map_cache( 0, true );
+    const cache_rebuild_stats stats = g->m.get_cache_ref( 0 ).rebuild_stats;
+
+    std::unique_ptr<map_caches_snapshot> incremental( new map_caches_snapshot() );
+    const level_cache &cache = g->m.get_cache_ref( 0 );
+    std::memcpy( incremental->outside_cache, cache.outside_cache, sizeof( cache.outside_cache ) );
+    std::memcpy( incremental->transparency_cache, cache.transparency_cache,
+                 sizeof( cache.transparency_cache ) );
+    g->m.set_outside_cache_dirty( 0 );
+    g->m.set_transparency_cache_dirty( 0 );
+    g->m.build_map_cache( 0, true );
+
+    int mismatches = 0;
+    for( int x = 0; x < MAPSIZE * SEEX; ++x ) {
+        for( int y = 0; y < MAPSIZE * SEEY; ++y ) {
+            if( incremental->outside_cache[x][y] != cache.outside_cache[x][y] ||
+                incremental->transparency_cache[x][y] != cache.transparency_cache[x][y] ) {
+                mismatches++;
+            }
+        }
+    }
+    CHECK( mismatches == 0 );
+    return stats;
+}
+
+TEST_CASE("map_caches_rebuild_only_changed_submaps") {
+    const int old_turn = calendar::turn;
+    clear_map_for_caches();
+
+    SECTION( "closing a door" ) {
+        g->m.ter_set( 66, 66, t_door_o );
+        check_incremental_caches();
+        g->m.ter_set( 66, 66, t_door_c );
+        const cache_rebuild_stats stats = check_incremental_caches();
+        CHECK( stats.transparency_submaps == 1 );
+        CHECK( stats.outside_submaps == 0 );
+    }
+    SECTION( "a roof at the corner of four submaps" ) {
+        // The bottom right tile of a submap, its neighbours are in three other submaps.
+        g->m.ter_set( SEEX * 5 - 1, SEEY * 5 - 1, t_floor );
+        const cache_rebuild_stats stats = check_incremental_caches();
+        CHECK( stats.outside_submaps == 4 );
+        CHECK_FALSE( g->m.get_cache_ref( 0 ).outside_cache[SEEX * 5][SEEY * 5] );
+        CHECK( g->m.get_cache_ref( 0 ).outside_cache[SEEX * 5 + 1][SEEY * 5 + 1] );
+    }
+    SECTION( "a fire starting" ) {
+        g->m.add_field( tripoint( 30, 40, 0 ), fd_fire, 2, 0 );
+        const cache_rebuild_stats stats = check_incremental_caches();
+        CHECK( stats.transparency_submaps == 1 );
+        g->m.remove_field( tripoint( 30, 40, 0 ), fd_fire );
+        check_incremental_caches();
+    }
+    SECTION( "nothing changing" ) {
+        const cache_rebuild_stats stats = check_incremental_caches();
+        CHECK( stats.transparency_submaps == 0 );
+        CHECK( stats.outside_submaps == 0 );
+    }
+    calendar::turn = old_turn;
+}
@@ -0,0 +1,169 @@
+#include "catch/catch.hpp"
+
+#include "filesystem.h"
+#include "game.h"
+#include "map.h"
+#include "map_storage.h"
+#include "mapbuffer.h"
+#include "options.h"
+#include "overmapbuffer.h"
+#include "submap.h"
+#include "worldfactory.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+
+static std::string test_directory( const std::string &name )
+{
+    const std::string path = world_generator->active_world->world_path + "/" + name;
+    assure_dir_exist( path );
+    return path;
+}
+
+static std::string read_quad( map_storage &storage, const tripoint &om_addr, bool binary )
+{
+    const std::unique_ptr<quad_data> data = storage.read( om_addr, binary );
+    if( !data ) {
+        return "<missing>";
+    }
+    return std::string( data->data(), data->size() );
+}
+
+TEST_CASE("pack_map_storage_keeps_the_latest_records") {
+    const std::string directory = test_directory( "pack_storage_test" );
+    const tripoint first( 1, 2, 0 );
+    const tripoint second( 3, 2, 0 );
+    const tripoint segment_addr = overmapbuffer::omt_to_seg_copy( first );
+    {
+        pack_map_storage storage( directory );
+        REQUIRE( storage.write( first, false, "old" ) );
+        REQUIRE( storage.write( second, true, std::string( "bin\0ary", 7 ) ) );
+        REQUIRE( storage.write( first, false, "new" ) );
+        REQUIRE( storage.write( first, true, "other format" ) );
+        storage.remove( first, true );
+        CHECK( read_quad( storage, first, false ) == "new" );
+        CHECK( read_quad( storage, first, true ) == "<missing>" );
+    }
+    {
+        pack_map_storage storage( directory );
+        CHECK( read_quad( storage, first, false ) == "new" );
+        CHECK( read_quad( storage, first, true ) == "<missing>" );
+        CHECK( read_quad( storage, second, true ) == std::string( "bin\0ary", 7 ) );
+        CHECK( storage.stored_quads().size() == 2 );
+        CHECK( storage.file_count() == 1 );
+    }
+
+    SECTION( "a record cut short is ignored" ) {
+        {
+            std::ofstream fout( ( directory + "/0.0.0.pack" ).c_str(),
+                                std::ios::binary | std::ios::app );
+            fout << "torn";
+        }
+        pack_map_storage storage( directory );
+        CHECK( read_quad( storage, first, false ) == "new" );
+        REQUIRE( storage.write( first, false, "after" ) );
+        pack_map_storage reopened( directory );
+        CHECK( read_quad( reopened, first, false ) == "after" );
+        CHECK( read_quad( reopened, second, true ) == std::string( "bin\0ary", 7 ) );
+    }
+    SECTION( "compaction drops dead records" ) {
+        pack_map_storage storage( directory );
+        const std::string big( 10000, 'x' );
+        for( int i = 0; i < 20; i++ ) {
+            REQUIRE( storage.write( second, false, big + std::to_string( i ) ) );
+        }
+        const uint64_t before = storage.pack_size( segment_addr );
+        storage.flush();
+        CHECK( storage.pack_size( segment_addr ) < before / 10 );
+        CHECK( read_quad( storage, second, false ) == big + "19" );
+        pack_map_storage reopened( directory );
+        CHECK( read_quad( reopened, first, false ) == "new" );
+        CHECK( read_quad( reopened, second, false ) == big + "19" );
+        CHECK( read_quad( reopened, second, true ) == std::string( "bin\0ary", 7 ) );
+    }
+    remove_file( directory + "/0.0.0.pack" );
+}
+
+TEST_CASE("mapbuffer_moves_quads_between_storages") {
+    // Uniform submaps are never saved.
+    tripoint sm_addr;
+    for( auto &elem : MAPBUFFER ) {
+        if( elem.second != nullptr && !elem.second->is_uniform ) {
+            sm_addr = elem.first;
+            break;
+        }
+    }
+    const tripoint om_addr = overmapbuffer::sm_to_omt_copy( sm_addr );
+    const std::string map_directory = world_generator->active_world->world_path + "/maps";
+    file_map_storage files( map_directory );
+
+    ACTIVE_WORLD_OPTIONS["PACK_MAPS"].setValue( "true" );
+    MAPBUFFER.save();
+    CHECK( read_quad( files, om_addr, false ) == "<missing>" );
+    {
+        pack_map_storage packs( map_directory );
+        CHECK( read_quad( packs, om_addr, false ) != "<missing>" );
+    }
+    {
+        mapbuffer loaded;
+        CHECK( loaded.lookup_submap( sm_addr ) != nullptr );
+    }
+
+    ACTIVE_WORLD_OPTIONS["PACK_MAPS"].setValue( "false" );
+    {
+        mapbuffer converted;
+        CHECK( converted.convert_saved_quads( false ) > 0 );
+    }
+    CHECK( read_quad( files, om_addr, false ) != "<missing>" );
+    pack_map_storage packs( map_directory );
+    CHECK( packs.stored_quads().empty() );
+}
+
+// Writes and reads a real quad under many addresses, like a world played for a long time.
+static void benchmark_storage( const char *name, map_storage &storage, const std::string &quad )
+{
+    const int quads = 32 * 32 * 2;
+    auto start = std::chrono::high_resolution_clock::now();
+    for( int i = 0; i < quads; i++ ) {
+        storage.write( tripoint( i % 64, i / 64, 0 ), false, quad );
+    }
+    storage.flush();
+    auto end = std::chrono::high_resolution_clock::now();
+    const long long save_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    size_t loaded = 0;
+    for( int i = 0; i < quads; i++ ) {
+        loaded += read_quad( storage, tripoint( i % 64, i / 64, 0 ), false ).size();
+    }
+    end = std::chrono::high_resolution_clock::now();
+    const long long load_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+
+    CHECK( loaded == quads * quad.size() );
+    printf( "%s: %d quads in %d files, save %lld us, load %lld us\n", name, quads,
+            storage.file_count(), save_us, load_us );
+    for( int i = 0; i < quads; i++ ) {
+        storage.remove( tripoint( i % 64, i / 64, 0 ), false );
+    }
+}
+
+TEST_CASE("map_storage_performance", "[.]") {
+    MAPBUFFER.save();
+    file_map_storage world_files( world_generator->active_world->world_path + "/maps" );
+    const auto saved = world_files.stored_quads();
+    REQUIRE( !saved.empty() );
+    const std::string quad = read_quad( world_files, saved.front().first, saved.front().second );
+
+    file_map_storage files( test_directory( "file_storage_benchmark" ) );
+    benchmark_storage( "one file per quad", files, quad );
+    const std::string pack_directory = test_directory( "pack_storage_benchmark" );
+    {
+        pack_map_storage packs( pack_directory );
+        benchmark_storage( "one pack per segment", packs, quad );
+    }
+    remove_file( pack_directory + "/0.0.0.pack" );
+    remove_file( pack_directory + "/1.0.0.pack" );
+}
@@ -0,0 +1,386 @@
+#include "catch/catch.hpp"
+
+#include "field.h"
+#include "filesystem.h"
+#include "game.h"
+#include "map.h"
+#include "mapbuffer.h"
+#include "mapdata.h"
+#include "options.h"
+#include "overmapbuffer.h"
+#include "rng.h"
+#include "submap.h"
+#include "trap.h"
+#include "vehicle.h"
+#include "worldfactory.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+static std::string quad_file_name( const tripoint &om_addr, const std::string &extension )
+{
+    const tripoint segment_addr = overmapbuffer::omt_to_seg_copy( om_addr );
+    std::ostringstream path;
+    path << world_generator->active_world->world_path << "/maps/" << segment_addr.x << "." <<
+         segment_addr.y << "." << segment_addr.z << "/" << om_addr.x << "." << om_addr.y << "." <<
+         om_addr.z << extension;
+    return path.str();
+}
+
+static std::string read_file( const std::string &path )
+{
+    std::ifstream fin( path.c_str(), std::ios::binary );
+    std::ostringstream contents;
+    contents << fin.rdbuf();
+    return contents.str();
+}
+
+// Saves the submaps the game has loaded as JSON, returns the quads that got a file
+// along with one submap stored in each. Uniform submaps are never written.
+static std::map<tripoint, tripoint> save_quads_as_json()
+{
+    const bool binary_maps = ACTIVE_WORLD_OPTIONS["BINARY_MAPS"];
+    ACTIVE_WORLD_OPTIONS["BINARY_MAPS"].setValue( "false" );
+    MAPBUFFER.save();
+    ACTIVE_WORLD_OPTIONS["BINARY_MAPS"].setValue( binary_maps ? "true" : "false" );
+    std::map<tripoint, tripoint> quads;
+    for( auto &elem : MAPBUFFER ) {
+        const tripoint om_addr = overmapbuffer::sm_to_omt_copy( elem.first );
+        if( elem.second != nullptr && !elem.second->is_uniform &&
+            file_exist( quad_file_name( om_addr, ".map" ) ) ) {
+            quads[om_addr] = elem.first;
+        }
+    }
+    return quads;
+}
+
+TEST_CASE("binary_map_format_round_trips_json_saves") {
+    const tripoint pos( 30, 30, 0 );
+    const ter_id old_ter = g->m.ter( pos );
+    const furn_id old_furn = g->m.furn( pos );
+    g->m.ter_set( pos, t_floor );
+    g->m.furn_set( pos, f_chair );
+    g->m.trap_set( pos + tripoint( 1, 0, 0 ), tr_bubblewrap );
+    g->m.set_radiation( pos, 20 );
+    g->m.add_field( pos + tripoint( 0, 1, 0 ), fd_blood, 2, 5 );
+    g->m.add_item( pos, item( "rock", 0 ) );
+    g->m.add_item( pos, item( "water_clean", 0 ) );
+
+    const tripoint sm_addr = g->m.get_abs_sub() + tripoint( pos.x / SEEX, pos.y / SEEY, 0 );
+    const tripoint om_addr = overmapbuffer::sm_to_omt_copy( sm_addr );
+    const std::map<tripoint, tripoint> quads = save_quads_as_json();
+    REQUIRE( quads.count( om_addr ) != 0 );
+    const std::string json = read_file( quad_file_name( om_addr, ".map" ) );
+
+    int converted = 0;
+    {
+        mapbuffer binary;
+        converted = binary.convert_saved_quads( true );
+    }
+    // Earlier tests may have left more quads on disk.
+    CHECK( converted >= int( quads.size() ) );
+    CHECK( file_exist( quad_file_name( om_addr, ".bmap" ) ) );
+    CHECK_FALSE( file_exist( quad_file_name( om_addr, ".map" ) ) );
+
+    {
+        mapbuffer loaded;
+        const submap *sm = loaded.lookup_submap( sm_addr );
+        REQUIRE( sm != nullptr );
+        const int i = pos.x % SEEX;
+        const int j = pos.y % SEEY;
+        CHECK( sm->ter[i][j] == t_floor );
+        CHECK( sm->get_furn( i, j ) == f_chair );
+        CHECK( sm->get_trap( i + 1, j ) == tr_bubblewrap );
+        CHECK( sm->get_radiation( i, j ) == 20 );
+        CHECK( sm->itm[i][j].size() == 2 );
+        CHECK( sm->fld[i][j + 1].findField( fd_blood ) != nullptr );
+    }
+
+    {
+        mapbuffer json_again;
+        CHECK( json_again.convert_saved_quads( false ) == converted );
+    }
+    CHECK_FALSE( file_exist( quad_file_name( om_addr, ".bmap" ) ) );
+    CHECK( read_file( quad_file_name( om_addr, ".map" ) ) == json );
+
+    g->m.ter_set( pos, old_ter );
+    g->m.furn_set( pos, old_furn );
+    g->m.remove_trap( pos + tripoint( 1, 0, 0 ) );
+    g->m.set_radiation( pos, 0 );
+    g->m.remove_field( pos + tripoint( 0, 1, 0 ), fd_blood );
+    g->m.i_clear( pos );
+}
+
+TEST_CASE("mapbuffer_only_saves_modified_quads") {
+    const tripoint pos( 30, 30, 0 );
+    const tripoint sm_addr = g->m.get_abs_sub() + tripoint( pos.x / SEEX, pos.y / SEEY, 0 );
+    const tripoint om_addr = overmapbuffer::sm_to_omt_copy( sm_addr );
+    const std::string path = quad_file_name( om_addr, ".map" );
+    const ter_id old_ter = g->m.ter( pos );
+    // Uniform submaps are never saved.
+    g->m.ter_set( pos, t_floor );
+    save_quads_as_json();
+    REQUIRE( file_exist( path ) );
+    submap *const sm = MAPBUFFER.lookup_submap( sm_addr );
+    REQUIRE( sm != nullptr );
+    REQUIRE( sm->vehicles.empty() );
+    CHECK_FALSE( sm->is_modified() );
+
+    {
+        mapbuffer loaded;
+        const submap *loaded_sm = loaded.lookup_submap( sm_addr );
+        REQUIRE( loaded_sm != nullptr );
+        CHECK_FALSE( loaded_sm->is_modified() );
+    }
+
+    // A save that finds nothing changed doesn't touch the file.
+    remove_file( path );
+    save_quads_as_json();
+    CHECK_FALSE( file_exist( path ) );
+
+    g->m.ter_set( pos, t_dirt );
+    CHECK( sm->is_modified() );
+    save_quads_as_json();
+    CHECK( file_exist( path ) );
+    CHECK_FALSE( sm->is_modified() );
+
+    g->m.i_at( pos );
+    CHECK( sm->is_modified() );
+    g->m.ter_set( pos, old_ter );
+    save_quads_as_json();
+    CHECK_FALSE( sm->is_modified() );
+}
+
+TEST_CASE("mapbuffer_prefetches_saved_quads") {
+    MAPBUFFER.save();
+    tripoint sm_addr;
+    for( auto &elem : MAPBUFFER ) {
+        if( elem.second != nullptr && !elem.second->is_uniform ) {
+            sm_addr = elem.first;
+            break;
+        }
+    }
+    {
+        mapbuffer buffer;
+        buffer.prefetch( { sm_addr } );
+        buffer.wait_for_prefetch();
+        CHECK( buffer.lookup_submap( sm_addr ) != nullptr );
+        CHECK( buffer.prefetch_hits == 1 );
+    }
+
+    SECTION( "a quad saved after it was read ahead is read again" ) {
+        // Far away from anything the tests generate.
+        const tripoint far_addr( 1000, 1000, 0 );
+        mapbuffer buffer;
+        buffer.prefetch( { far_addr } );
+        buffer.wait_for_prefetch();
+        submap *sm = new submap();
+        sm->set_ter( 0, 0, t_floor );
+        REQUIRE( buffer.add_submap( far_addr, sm ) );
+        buffer.save( true );
+        CHECK( buffer.lookup_submap( far_addr ) != nullptr );
+        CHECK( buffer.prefetch_hits == 0 );
+        remove_file( quad_file_name( overmapbuffer::sm_to_omt_copy( far_addr ), ".map" ) );
+    }
+}
+
+static long long lookup_us( const std::vector<tripoint> &submap_addrs, bool prefetch )
+{
+    mapbuffer buffer;
+    if( prefetch ) {
+        buffer.prefetch( submap_addrs );
+        buffer.wait_for_prefetch();
+    }
+    const auto start = std::chrono::high_resolution_clock::now();
+    for( const tripoint &submap_addr : submap_addrs ) {
+        CHECK( buffer.lookup_submap( submap_addr ) != nullptr );
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+}
+
+TEST_CASE("mapbuffer_prefetch_performance", "[.]") {
+    const std::map<tripoint, tripoint> quads = save_quads_as_json();
+    std::vector<tripoint> submap_addrs;
+    for( auto &quad : quads ) {
+        submap_addrs.push_back( quad.second );
+    }
+    // Reads from the page cache, disks that have to seek gain more.
+    lookup_us( submap_addrs, false );
+    const long long read_us = lookup_us( submap_addrs, false );
+    const long long prefetched_us = lookup_us( submap_addrs, true );
+    printf( "looking up %d quads: read on lookup %lld us, read ahead %lld us\n",
+            int( submap_addrs.size() ), read_us, prefetched_us );
+}
+
+static long long save_us()
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    MAPBUFFER.save();
+    const auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+}
+
+TEST_CASE("modified_quad_save_performance", "[.]") {
+    for( auto &elem : MAPBUFFER ) {
+        if( elem.second != nullptr ) {
+            elem.second->set_modified();
+        }
+    }
+    const long long all_us = save_us();
+    const long long unchanged_us = save_us();
+    printf( "saving %d submaps: all modified %lld us, none modified %lld us\n",
+            int( std::distance( MAPBUFFER.begin(), MAPBUFFER.end() ) ), all_us, unchanged_us );
+}
+
+static long long load_quads_us( const std::map<tripoint, tripoint> &quads, int repeats )
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    for( int n = 0; n < repeats; n++ ) {
+        mapbuffer buffer;
+        for( auto &quad : quads ) {
+            CHECK( buffer.lookup_submap( quad.second ) != nullptr );
+        }
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+}
+
+TEST_CASE("binary_map_load_performance", "[.]") {
+    const std::map<tripoint, tripoint> quads = save_quads_as_json();
+    const int repeats = 5;
+    const long long json_us = load_quads_us( quads, repeats );
+    {
+        mapbuffer binary;
+        binary.convert_saved_quads( true );
+    }
+    const long long binary_us = load_quads_us( quads, repeats );
+    {
+        mapbuffer json_again;
+        json_again.convert_saved_quads( false );
+    }
+
+    const int loads = quads.size() * repeats;
+    printf( "%d quad loads: json %lld us (%.0f quads/s), binary %lld us (%.0f quads/s)\n",
+            loads, json_us, loads * 1e6 / std::max( json_us, 1LL ), binary_us,
+            loads * 1e6 / std::max( binary_us, 1LL ) );
+}
+
+static bool lists_vehicle( mapbuffer &buffer, const tripoint &sm_addr, const vehicle *veh )
+{
+    for( auto &elem : buffer.get_vehicles() ) {
+        if( elem.first == sm_addr && elem.second == veh ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TEST_CASE("mapbuffer_lists_the_vehicles_of_its_submaps") {
+    // Far away from anything the tests generate, nothing is saved.
+    const tripoint with_vehicle( 1000, 1000, 0 );
+    const tripoint without_vehicle( 1001, 1000, 0 );
+    mapbuffer buffer;
+    submap *sm = new submap();
+    vehicle *veh = new vehicle( vproto_id( "car" ), 0, 0 );
+    sm->vehicles.push_back( veh );
+    REQUIRE( buffer.add_submap( with_vehicle, sm ) );
+    submap *empty_sm = new submap();
+    REQUIRE( buffer.add_submap( without_vehicle, empty_sm ) );
+    CHECK( buffer.get_vehicles().size() == 1 );
+    CHECK( lists_vehicle( buffer, with_vehicle, veh ) );
+
+    sm->vehicles.clear();
+    empty_sm->vehicles.push_back( veh );
+    CHECK( buffer.get_vehicles().empty() );
+    buffer.note_vehicles( without_vehicle );
+    CHECK( lists_vehicle( buffer, without_vehicle, veh ) );
+    // Not in the buffer, noted when it is added.
+    buffer.note_vehicles( tripoint( 1002, 1000, 0 ) );
+    CHECK( buffer.get_vehicles().size() == 1 );
+}
+
+TEST_CASE("vehicles_on_the_map_are_listed_by_the_mapbuffer") {
+    const tripoint abs_sub = g->m.get_abs_sub();
+    const tripoint pos( SEEX * 4 + 5, SEEY * 4 + 5, g->get_levz() );
+    vehicle *veh = g->m.add_vehicle( vproto_id( "car" ), pos, 0, 0, 0 );
+    REQUIRE( veh != nullptr );
+    CHECK( lists_vehicle( MAPBUFFER, tripoint( abs_sub.x + veh->smx, abs_sub.y + veh->smy, veh->smz ),
+                          veh ) );
+
+    tripoint veh_pos = veh->global_pos3();
+    g->m.displace_vehicle( veh_pos, tripoint( SEEX, 0, 0 ) );
+    const tripoint moved_to( abs_sub.x + veh->smx, abs_sub.y + veh->smy, veh->smz );
+    CHECK( lists_vehicle( MAPBUFFER, moved_to, veh ) );
+    CHECK_FALSE( lists_vehicle( MAPBUFFER, tripoint( moved_to.x - 1, moved_to.y, moved_to.z ), veh ) );
+
+    g->m.destroy_vehicle( veh );
+    CHECK_FALSE( lists_vehicle( MAPBUFFER, moved_to, veh ) );
+}
+
+TEST_CASE("vehicles_outside_the_reality_bubble_are_caught_up") {
+    const itype_id battery( "battery" );
+    vehicle batched( vproto_id( "car" ), 100, 0 );
+    batched.lights_on = true;
+    REQUIRE_FALSE( batched.is_powered_down() );
+    vehicle stepped = batched;
+    // Power is converted with random rounding, both draw the same numbers.
+    {
+        rng_stream stream( 1234 );
+        batched.idle_off_map( 10 );
+    }
+    {
+        rng_stream stream( 1234 );
+        for( int i = 0; i < 10; i++ ) {
+            stepped.power_parts();
+            stepped.idle( false );
+        }
+    }
+    CHECK( batched.fuel_left( battery ) < stepped.fuel_capacity( battery ) );
+    CHECK( batched.fuel_left( battery ) == stepped.fuel_left( battery ) );
+
+    vehicle drained( vproto_id( "car" ), 0, 0 );
+    drained.lights_on = true;
+    drained.idle_off_map( 100 );
+    CHECK_FALSE( drained.lights_on );
+    CHECK( drained.is_powered_down() );
+}
+
+TEST_CASE("vehicle_listing_performance", "[.]") {
+    // Mostly submaps without vehicles, like a world that has been explored for a while.
+    const int submap_count = 4000;
+    const int vehicle_count = 40;
+    mapbuffer buffer;
+    for( int i = 0; i < submap_count; i++ ) {
+        submap *sm = new submap();
+        if( i % ( submap_count / vehicle_count ) == 0 ) {
+            sm->vehicles.push_back( new vehicle( vproto_id( "car" ), 0, 0 ) );
+        }
+        buffer.add_submap( tripoint( 1000 + i % 100, 1000 + i / 100, 0 ), sm );
+    }
+    const int turns = 1000;
+    int found = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for( int turn = 0; turn < turns; turn++ ) {
+        for( auto &elem : buffer ) {
+            found += elem.second->vehicles.size();
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    const long long scan_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    for( int turn = 0; turn < turns; turn++ ) {
+        found += buffer.get_vehicles().size();
+    }
+    end = std::chrono::high_resolution_clock::now();
+    const long long listed_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+    CHECK( found == 2 * turns * vehicle_count );
+    printf( "finding %d vehicles in %d submaps %d times: scanning %lld us, listed %lld us\n",
+            vehicle_count, submap_count, turns, scan_us, listed_us );
+}
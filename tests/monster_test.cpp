@@ -1,14 +1,20 @@
 #include "catch/catch.hpp"
 
+#include "calendar.h"
 #include "creature.h"
 #include "creature_tracker.h"
 #include "game.h"
 #include "map.h"
 #include "mapdata.h"
+#include "monfaction.h"
 #include "monster.h"
 #include "mtype.h"
 #include "options.h"
+#include "rng.h"
+#include "worker_pool.h"
 
+#include <chrono>
+#include <cstdio>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -373,3 +379,181 @@ TEST_CASE("monster_speed_trig") {
     trigdist = true;
     monster_check();
 }
+
+// A wall the monster can't break, with a single gap far from the straight line.
+static void build_wall_with_gap( const int wall_x, const int gap_y )
+{
+    const int mapsize = g->m.getmapsize() * SEEX;
+    for( int y = 0; y < mapsize; ++y ) {
+        if( y != gap_y ) {
+            g->m.ter_set( wall_x, y, t_wall_metal );
+        }
+    }
+}
+
+TEST_CASE("monster_walks_around_wall_to_player") {
+    clear_map();
+    build_wall_with_gap( 66, 90 );
+    g->u.setpos( { 72, 66, 0 } );
+    // Zombies are too weak to bash through a wall on their own.
+    monster &zombie = spawn_test_monster( "mon_zombie", { 60, 66, 0 } );
+    zombie.anger = 100;
+    zombie.set_moves( 0 );
+    for( int turn = 0; turn < 200 && rl_dist( zombie.pos(), g->u.pos() ) > 1; ++turn ) {
+        zombie.set_dest( g->u.pos() );
+        zombie.mod_moves( zombie.get_speed() );
+        while( zombie.moves >= 0 && rl_dist( zombie.pos(), g->u.pos() ) > 1 ) {
+            zombie.move();
+        }
+    }
+    CHECK( rl_dist( zombie.pos(), g->u.pos() ) <= 1 );
+    clear_map();
+}
+
+// A horde behind a wall with two gaps, chasing a player who keeps shuffling around,
+// so the flow field has to be rebuilt every turn.
+TEST_CASE("zombie_horde_performance", "[.]") {
+    clear_map();
+    build_wall_with_gap( 66, 20 );
+    g->m.ter_set( 66, 110, t_grass );
+    for( int x = 10; x < 50; x += 2 ) {
+        for( int y = 40; y < 60; y += 2 ) {
+            monster &zombie = spawn_test_monster( "mon_zombie", { x, y, 0 } );
+            zombie.anger = 100;
+            zombie.set_moves( 0 );
+        }
+    }
+    REQUIRE( g->num_zombies() == 200 );
+
+    const int turns = 200;
+    std::vector<bool> reached( g->num_zombies(), false );
+    int num_reached = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for( int turn = 0; turn < turns; ++turn ) {
+        calendar::turn.increment();
+        g->u.setpos( { 80, 66 + turn % 2, 0 } );
+        for( size_t i = 0; i < g->num_zombies(); ++i ) {
+            if( reached[i] ) {
+                continue;
+            }
+            monster &zombie = g->zombie( i );
+            // Same as game::monmove, with set_dest() in place of plan().
+            zombie.process_turn();
+            while( zombie.moves > 0 && !reached[i] ) {
+                zombie.set_dest( g->u.pos() );
+                zombie.move();
+                if( rl_dist( zombie.pos(), g->u.pos() ) <= 1 ) {
+                    reached[i] = true;
+                    num_reached++;
+                }
+            }
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    long diff = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+    int num_through = 0;
+    for( size_t i = 0; i < g->num_zombies(); ++i ) {
+        if( g->zombie( i ).posx() > 66 ) {
+            num_through++;
+        }
+    }
+    printf( "%d zombies moved for %d turns in %ld microseconds, %d got past the wall, %d reached the player.\n",
+            int( reached.size() ), turns, diff, num_through, num_reached );
+    clear_map();
+}
+
+TEST_CASE("monster_targets_snapshot_matches_live_rating") {
+    clear_map();
+    const std::vector<std::string> types = {
+        "mon_zombie", "mon_dog", "mon_cat", "mon_wolf", "mon_bee", "mon_ant", "mon_manhack"
+    };
+    for( int x = 30; x < 50; x += 2 ) {
+        for( int y = 30; y < 50; y += 2 ) {
+            monster temp_monster( mtype_id( random_entry( types ) ), { x, y, 0 } );
+            REQUIRE( g->critter_tracker->add( temp_monster ) );
+            monster &critter = g->zombie( g->num_zombies() - 1 );
+            critter.friendly = one_in( 4 ) ? -1 : 0;
+            critter.anger = rng( -10, 20 );
+            critter.morale = rng( -10, 20 );
+        }
+    }
+
+    monster_targets targets;
+    targets.build();
+    REQUIRE( targets.candidates.size() == g->num_zombies() );
+    REQUIRE( targets.members.size() == g->num_zombies() );
+    for( size_t t = 0; t < targets.teams.size(); t++ ) {
+        const auto &team = targets.teams[t];
+        for( size_t m = team.begin; m < team.end; m++ ) {
+            const monster &member = g->zombie( targets.members[m] );
+            CHECK( targets.candidates[targets.members[m]].team == t );
+            CHECK( ( member.friendly == 0 ? member.faction : mfaction_str_id( "player" ).id() ) ==
+                   team.faction );
+        }
+    }
+
+    for( size_t i = 0; i < g->num_zombies(); i++ ) {
+        const monster &planner = g->zombie( i );
+        for( size_t j = 0; j < g->num_zombies(); j++ ) {
+            monster &target = g->zombie( j );
+            CHECK( planner.rate_target( target, targets.candidates[j], 1000, true ) ==
+                   planner.rate_target( target, 1000, true ) );
+        }
+    }
+    clear_map();
+}
+
+static bool same_plan( const monster::plan_result &a, const monster::plan_result &b )
+{
+    return a.goal == b.goal && a.wander_pos == b.wander_pos && a.wandf == b.wandf &&
+           a.anger == b.anger && a.morale == b.morale && a.friendly == b.friendly;
+}
+
+TEST_CASE("monster_plans_decided_ahead_are_repeatable") {
+    clear_map();
+    g->u.setpos( { 60, 60, 0 } );
+    for( int x = 40; x < 80; x += 3 ) {
+        for( int y = 40; y < 80; y += 3 ) {
+            monster temp_monster( mtype_id( one_in( 3 ) ? "mon_dog" : "mon_zombie" ), { x, y, 0 } );
+            temp_monster.friendly = one_in( 5 ) ? -1 : 0;
+            temp_monster.anger = rng( 0, 100 );
+            g->critter_tracker->add( temp_monster );
+        }
+    }
+    g->m.build_map_cache( 0 );
+    monster_targets targets;
+    targets.build();
+    const size_t count = g->num_zombies();
+
+    std::vector<monster::plan_result> serial( count );
+    for( size_t i = 0; i < count; i++ ) {
+        rng_stream stream( 1234 + i );
+        serial[i] = g->zombie( i ).decide_plan( targets );
+    }
+
+    // Other threads, other order, same plans.
+    std::vector<monster::plan_result> parallel( count );
+    worker_pool pool( 4 );
+    pool.run( count, [&]( const size_t n, size_t ) {
+        const size_t i = count - 1 - n;
+        rng_stream stream( 1234 + i );
+        parallel[i] = g->zombie( i ).decide_plan( targets );
+    } );
+
+    for( size_t i = 0; i < count; i++ ) {
+        CHECK( same_plan( serial[i], parallel[i] ) );
+        // And the same as planning right away.
+        monster &critter = g->zombie( i );
+        rng_stream stream( 1234 + i );
+        critter.plan( targets );
+        monster::plan_result direct;
+        direct.goal = critter.move_target();
+        direct.wander_pos = critter.wander_pos;
+        direct.wandf = critter.wandf;
+        direct.anger = critter.anger;
+        direct.morale = critter.morale;
+        direct.friendly = critter.friendly;
+        CHECK( same_plan( serial[i], direct ) );
+    }
+    clear_map();
+}
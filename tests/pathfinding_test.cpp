@@ -0,0 +1,163 @@
+#include "catch/catch.hpp"
+
+#include "game.h"
+#include "line.h"
+#include "map.h"
+#include "map_iterator.h"
+#include "mapdata.h"
+#include "pathfinding.h"
+#include "player.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+// A wall with a single gap, so routes across it can't take the straight line shortcut.
+static void build_wall_with_gap( const int wall_x, const int gap_y )
+{
+    const int mapsize = g->m.getmapsize() * SEEX;
+    for( int x = 0; x < mapsize; ++x ) {
+        for( int y = 0; y < mapsize; ++y ) {
+            g->m.set( x, y, t_grass, f_null );
+        }
+    }
+    for( int y = 0; y < mapsize; ++y ) {
+        if( y != gap_y ) {
+            g->m.ter_set( wall_x, y, t_wall );
+        }
+    }
+    // Keep the player out of the way.
+    g->u.setpos( { 0, 0, -2 } );
+}
+
+static void check_route( const std::vector<tripoint> &route, const tripoint &from,
+                         const tripoint &to )
+{
+    REQUIRE( !route.empty() );
+    CHECK( route.back() == to );
+    tripoint prev = from;
+    for( const tripoint &p : route ) {
+        CHECK( rl_dist( prev, p ) == 1 );
+        CHECK( g->m.move_cost( p ) > 0 );
+        prev = p;
+    }
+}
+
+static void pathfinding_benchmark( const int iterations )
+{
+    build_wall_with_gap( 66, 70 );
+    const tripoint from( 60, 66, 0 );
+    const tripoint to( 72, 66, 0 );
+
+    // The first search may allocate the layers and grow the open list.
+    const auto first = g->m.route( from, to, 0, 1000 );
+    check_route( first, from, to );
+
+    const size_t allocations_before = g->m.get_pathfinder().allocation_count();
+    auto start = std::chrono::high_resolution_clock::now();
+    for( int i = 0; i < iterations; ++i ) {
+        const auto route = g->m.route( from, to, 0, 1000 );
+        REQUIRE( route == first );
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    CHECK( g->m.get_pathfinder().allocation_count() == allocations_before );
+
+    if( iterations > 1 ) {
+        long diff = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+        printf( "map::route() executed %d times in %ld microseconds.\n", iterations, diff );
+    }
+}
+
+TEST_CASE("pathfinding_routes_around_wall") {
+    build_wall_with_gap( 66, 70 );
+    const tripoint from( 60, 66, 0 );
+    const tripoint to( 72, 66, 0 );
+    const auto route = g->m.route( from, to, 0, 1000 );
+    check_route( route, from, to );
+    CHECK( std::find( route.begin(), route.end(), tripoint( 66, 70, 0 ) ) != route.end() );
+
+    // Unreachable within maxdist.
+    CHECK( g->m.route( from, to, 0, 20 ).empty() );
+    // Stale data from the failed search must not leak into the next one.
+    CHECK( g->m.route( from, to, 0, 1000 ) == route );
+}
+
+// Long routes go through the submap graph, which must notice terrain changes.
+TEST_CASE("pathfinding_long_route_follows_terrain_changes") {
+    build_wall_with_gap( 66, 10 );
+    const tripoint from( 20, 60, 0 );
+    const tripoint to( 110, 72, 0 );
+    const auto around = g->m.route( from, to, 0, 1000 );
+    check_route( around, from, to );
+    CHECK( std::find( around.begin(), around.end(), tripoint( 66, 10, 0 ) ) != around.end() );
+
+    g->m.ter_set( 66, 100, t_grass );
+    const auto shortcut = g->m.route( from, to, 0, 1000 );
+    check_route( shortcut, from, to );
+    CHECK( std::find( shortcut.begin(), shortcut.end(), tripoint( 66, 100, 0 ) ) != shortcut.end() );
+    CHECK( shortcut.size() < around.size() );
+
+    g->m.ter_set( 66, 100, t_wall );
+    CHECK( g->m.route( from, to, 0, 1000 ) == around );
+}
+
+TEST_CASE("pathfinding_packed_points") {
+    for( const tripoint &p : {
+             tripoint( 0, 0, -OVERMAP_DEPTH ), tripoint( 5, 7, 0 ),
+             tripoint( SEEX * MAPSIZE - 1, SEEY * MAPSIZE - 1, OVERMAP_HEIGHT )
+         } ) {
+        CHECK( pathfinder::unpack( pathfinder::pack( p ) ) == p );
+    }
+}
+
+TEST_CASE("pathfinding_reuses_arena") {
+    pathfinding_benchmark( 10 );
+}
+
+TEST_CASE("pathfinding_performance", "[.]") {
+    pathfinding_benchmark( 10000 );
+}
+
+TEST_CASE("pathfinding_long_route_performance", "[.]") {
+    build_wall_with_gap( 66, 10 );
+    const tripoint from( 20, 60, 0 );
+    const tripoint to( 110, 72, 0 );
+    const int iterations = 1000;
+    auto start = std::chrono::high_resolution_clock::now();
+    for( int i = 0; i < iterations; ++i ) {
+        check_route( g->m.route( from, to, 0, 1000 ), from, to );
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    long diff = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+    printf( "Long map::route() executed %d times in %ld microseconds.\n", iterations, diff );
+}
+
+TEST_CASE("flow_field_leads_around_wall") {
+    build_wall_with_gap( 66, 70 );
+    const tripoint target( 72, 66, 0 );
+    const flow_field &field = g->m.get_flow_field( target );
+    CHECK( field.distance( target ) == 0 );
+    CHECK( field.distance( tripoint( 66, 66, 0 ) ) == flow_field::unreachable );
+    CHECK( field.distance( tripoint( 72, 66, 1 ) ) == flow_field::unreachable );
+
+    // Descending the field from the other side of the wall has to pass the gap.
+    tripoint cur( 60, 66, 0 );
+    std::vector<tripoint> path;
+    while( cur != target && path.size() < 100 ) {
+        tripoint next = cur;
+        for( const tripoint &p : g->m.points_in_radius( cur, 1 ) ) {
+            if( field.distance( p ) < field.distance( next ) ) {
+                next = p;
+            }
+        }
+        REQUIRE( next != cur );
+        cur = next;
+        path.push_back( cur );
+    }
+    check_route( path, tripoint( 60, 66, 0 ), target );
+    CHECK( std::find( path.begin(), path.end(), tripoint( 66, 70, 0 ) ) != path.end() );
+
+    // Closing the gap cuts the far side off.
+    g->m.ter_set( 66, 70, t_wall );
+    CHECK( g->m.get_flow_field( target ).distance( tripoint( 60, 66, 0 ) ) == flow_field::unreachable );
+}
@@ -1,12 +1,18 @@
 #include "catch/catch.hpp"
 
 #include "filesystem.h"
+#include "json.h"
 #include "mongroup.h"
 #include "npc.h"
 #include "overmap.h"
 
+#include <chrono>
+#include <cstdio>
 #include <fstream>
+#include <memory>
 #include <ostream>
+#include <sstream>
+#include <string>
 
 // Intentionally ignoring the name member.
 bool operator==(const city &a, const city &b) {
@@ -231,3 +237,174 @@ TEST_CASE("Reading a legacy overmap save.") {
     // Now clean up.
     remove_file( new_save_name.c_str() );
 }
+
+static void load_legacy_test_overmap( overmap &test_map )
+{
+    std::ifstream fin( "tests/data/legacy_0.C_overmap.sav", std::ifstream::binary );
+    REQUIRE( fin.is_open() );
+    test_map.unserialize( fin );
+}
+
+// Only the terrain of the legacy save, which unlike the monsters is written the same every time.
+// On the heap, as overmaps are too big to keep more than a few of them on the stack.
+static std::unique_ptr<overmap> legacy_test_terrain()
+{
+    std::unique_ptr<overmap> legacy_map( new overmap() );
+    load_legacy_test_overmap( *legacy_map );
+    std::unique_ptr<overmap> test_map( new overmap() );
+    for( int z = -OVERMAP_DEPTH; z <= OVERMAP_HEIGHT; z++ ) {
+        for( int x = 0; x < OMAPX; x++ ) {
+            for( int y = 0; y < OMAPY; y++ ) {
+                test_map->ter( x, y, z ) = legacy_map->get_ter( x, y, z );
+            }
+        }
+    }
+    return test_map;
+}
+
+static std::string serialized( const overmap &test_map )
+{
+    std::ostringstream out;
+    test_map.serialize( out );
+    return out.str();
+}
+
+static void write_and_read( const std::string &file_name, const std::string &data, overmap &test_map )
+{
+    {
+        std::ofstream fout( file_name.c_str(), std::ofstream::binary );
+        REQUIRE( fout.is_open() );
+        fout << data;
+    }
+    std::ifstream fin( file_name.c_str(), std::ifstream::binary );
+    REQUIRE( fin.is_open() );
+    test_map.unserialize( fin );
+}
+
+TEST_CASE("overmap_terrain_layers_are_unpacked_when_used") {
+    const std::string save_name = "tests/data/binary_overmap.sav";
+    const std::unique_ptr<overmap> test_map = legacy_test_terrain();
+    const std::string data = serialized( *test_map );
+
+    std::unique_ptr<overmap> loaded( new overmap() );
+    write_and_read( save_name, data, *loaded );
+    remove_file( save_name );
+    for( int z = -OVERMAP_DEPTH; z <= OVERMAP_HEIGHT; z++ ) {
+        CHECK_FALSE( loaded->is_layer_unpacked( z ) );
+    }
+    // Layers that were never used are written as they were read.
+    CHECK( serialized( *loaded ) == data );
+
+    CHECK( std::string( loaded->get_ter( 48, 4, -10 ) ) == "slimepit" );
+    CHECK( loaded->is_layer_unpacked( -10 ) );
+    CHECK_FALSE( loaded->is_layer_unpacked( -9 ) );
+    CHECK( serialized( *loaded ) == data );
+
+    for( int z = -OVERMAP_DEPTH; z <= OVERMAP_HEIGHT; z++ ) {
+        for( int x = 0; x < OMAPX; x++ ) {
+            for( int y = 0; y < OMAPY; y++ ) {
+                REQUIRE( loaded->get_ter( x, y, z ) == test_map->get_ter( x, y, z ) );
+            }
+        }
+    }
+}
+
+TEST_CASE("overmap_view_is_kept_as_bits") {
+    overmap test_map;
+    test_map.set_seen( 0, 0, 0, true );
+    test_map.set_seen( OMAPX - 1, 5, -2, true );
+    test_map.set_explored( 7, OMAPY - 1, 0, true );
+    test_map.set_seen( OMAPX, 0, 0, true );
+    CHECK_FALSE( test_map.seen( OMAPX, 0, 0 ) );
+
+    const std::string save_name = "tests/data/overmap_view.sav";
+    {
+        std::ofstream fout( save_name.c_str(), std::ofstream::binary );
+        REQUIRE( fout.is_open() );
+        test_map.serialize_view( fout );
+    }
+    overmap loaded;
+    std::ifstream fin( save_name.c_str(), std::ifstream::binary );
+    REQUIRE( fin.is_open() );
+    loaded.unserialize_view( fin );
+    fin.close();
+    for( int z = -OVERMAP_DEPTH; z <= OVERMAP_HEIGHT; z++ ) {
+        for( int x = 0; x < OMAPX; x++ ) {
+            for( int y = 0; y < OMAPY; y++ ) {
+                REQUIRE( loaded.seen( x, y, z ) == test_map.seen( x, y, z ) );
+                REQUIRE( loaded.is_explored( x, y, z ) == test_map.is_explored( x, y, z ) );
+            }
+        }
+    }
+    CHECK( loaded.seen( OMAPX - 1, 5, -2 ) );
+    CHECK( loaded.is_explored( 7, OMAPY - 1, 0 ) );
+    remove_file( save_name );
+}
+
+// The terrain in the json format of savegame version 25.
+static std::string json_terrain( const overmap &test_map )
+{
+    std::ostringstream out;
+    out << "# version 25" << std::endl;
+    JsonOut json( out, false );
+    json.start_object();
+    json.member( "layers" );
+    json.start_array();
+    for( int z = -OVERMAP_DEPTH; z <= OVERMAP_HEIGHT; z++ ) {
+        json.start_array();
+        int count = 0;
+        std::string last;
+        for( int y = 0; y < OMAPY; y++ ) {
+            for( int x = 0; x < OMAPX; x++ ) {
+                const std::string ter = test_map.get_ter( x, y, z );
+                if( count > 0 && ter == last ) {
+                    count++;
+                    continue;
+                }
+                if( count > 0 ) {
+                    json.write( count );
+                    json.end_array();
+                }
+                json.start_array();
+                json.write( ter );
+                last = ter;
+                count = 1;
+            }
+        }
+        json.write( count );
+        json.end_array();
+        json.end_array();
+    }
+    json.end_array();
+    json.end_object();
+    return out.str();
+}
+
+static long long time_loading( const std::string &file_name, const std::string &data, bool use_layer )
+{
+    const int loads = 20;
+    auto start = std::chrono::high_resolution_clock::now();
+    for( int i = 0; i < loads; i++ ) {
+        overmap test_map;
+        write_and_read( file_name, data, test_map );
+        if( use_layer ) {
+            test_map.get_ter( 0, 0, 0 );
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count() / loads;
+}
+
+TEST_CASE("overmap_loading_performance", "[.]") {
+    const std::string save_name = "tests/data/overmap_performance.sav";
+    std::unique_ptr<overmap> test_map = legacy_test_terrain();
+    const std::string json_data = json_terrain( *test_map );
+    const std::string binary_data = serialized( *test_map );
+    test_map.reset();
+    printf( "overmap terrain as json: %d bytes, loaded in %lld us\n", int( json_data.size() ),
+            time_loading( save_name, json_data, false ) );
+    printf( "overmap terrain as binary: %d bytes, loaded in %lld us, with one layer used %lld us\n",
+            int( binary_data.size() ), time_loading( save_name, binary_data, false ),
+            time_loading( save_name, binary_data, true ) );
+    remove_file( save_name );
+}
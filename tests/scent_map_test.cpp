@@ -0,0 +1,204 @@
+#include "catch/catch.hpp"
+
+#include "game.h"
+#include "map.h"
+#include "mapdata.h"
+#include "player.h"
+#include "rng.h"
+#include "scent_map.h"
+
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+typedef int scent_array[SEEX * MAPSIZE][SEEY * MAPSIZE];
+
+// The diffusion as it was done by game::update_scent before it had its own class.
+static void reference_update( scent_array &grscent, const tripoint &center )
+{
+    static int sum_3_scent_y[SEEY * MAPSIZE][SEEX * MAPSIZE];
+    static int squares_used_y[SEEY * MAPSIZE][SEEX * MAPSIZE];
+    static bool blocks_scent[SEEX * MAPSIZE][SEEY * MAPSIZE];
+    static bool reduces_scent[SEEX * MAPSIZE][SEEY * MAPSIZE];
+
+    const int scentmap_minx = center.x - 40;
+    const int scentmap_maxx = center.x + 40;
+    const int scentmap_miny = center.y - 40;
+    const int scentmap_maxy = center.y + 40;
+    const int diffusivity = 100;
+
+    std::fill_n( &blocks_scent[0][0], SEEX * MAPSIZE * SEEY * MAPSIZE, false );
+    std::fill_n( &reduces_scent[0][0], SEEX * MAPSIZE * SEEY * MAPSIZE, false );
+    g->m.scent_blockers( blocks_scent, reduces_scent,
+                         scentmap_minx - 1, scentmap_miny - 1, scentmap_maxx + 1, scentmap_maxy + 1 );
+    for( int x = scentmap_minx - 1; x <= scentmap_maxx + 1; ++x ) {
+        for( int y = scentmap_miny; y <= scentmap_maxy; ++y ) {
+            sum_3_scent_y[y][x] = 0;
+            squares_used_y[y][x] = 0;
+            for( int i = y - 1; i <= y + 1; ++i ) {
+                if( !blocks_scent[x][i] ) {
+                    if( reduces_scent[x][i] ) {
+                        sum_3_scent_y[y][x] += 2 * grscent[x][i];
+                        squares_used_y[y][x] += 2;
+                    } else {
+                        sum_3_scent_y[y][x] += 10 * grscent[x][i];
+                        squares_used_y[y][x] += 10;
+                    }
+                }
+            }
+        }
+    }
+    for( int x = scentmap_minx; x <= scentmap_maxx; ++x ) {
+        for( int y = scentmap_miny; y <= scentmap_maxy; ++y ) {
+            if( !blocks_scent[x][y] ) {
+                int squares_used = squares_used_y[y][x - 1]
+                                   + squares_used_y[y][x]
+                                   + squares_used_y[y][x + 1];
+                int this_diffusivity;
+                if( !reduces_scent[x][y] ) {
+                    this_diffusivity = diffusivity;
+                } else {
+                    this_diffusivity = diffusivity / 5;
+                }
+                int temp_scent;
+                temp_scent = grscent[x][y] * ( 10 * 1000 - squares_used * this_diffusivity );
+                temp_scent -= grscent[x][y] * this_diffusivity * ( 90 - squares_used ) / 5;
+                grscent[x][y] =
+                    ( temp_scent
+                      + this_diffusivity * ( sum_3_scent_y[y][x - 1]
+                                             + sum_3_scent_y[y][x]
+                                             + sum_3_scent_y[y][x + 1] )
+                    ) / ( 1000 * 10 );
+            } else {
+                grscent[x][y] = 0;
+            }
+        }
+    }
+}
+
+static void reference_set( scent_array &grscent, const tripoint &p, const int value )
+{
+    if( scent_map::inbounds( p ) ) {
+        grscent[p.x][p.y] = value;
+    }
+}
+
+static void reference_decay( scent_array &grscent )
+{
+    for( int x = 0; x < SEEX * MAPSIZE; ++x ) {
+        for( int y = 0; y < SEEY * MAPSIZE; ++y ) {
+            if( grscent[x][y] > 0 && scent_map::inbounds( tripoint( x, y, 0 ) ) ) {
+                grscent[x][y]--;
+            }
+        }
+    }
+}
+
+// Walls, REDUCE_SCENT half walls and open ground in random places.
+static void build_scent_test_map()
+{
+    const int mapsize = g->m.getmapsize() * SEEX;
+    for( int x = 0; x < mapsize; ++x ) {
+        for( int y = 0; y < mapsize; ++y ) {
+            const int roll = rng( 0, 9 );
+            if( roll == 0 ) {
+                g->m.set( x, y, t_wall, f_null );
+            } else if( roll == 1 ) {
+                g->m.set( x, y, t_grass, f_null );
+                g->m.ter_set( x, y, "t_wall_log_half" );
+            } else {
+                g->m.set( x, y, t_grass, f_null );
+            }
+        }
+    }
+}
+
+static tripoint random_scent_point()
+{
+    return tripoint( rng( 26, 105 ), rng( 26, 105 ), 0 );
+}
+
+TEST_CASE("scent_map_matches_reference") {
+    build_scent_test_map();
+    static scent_array reference;
+    std::fill_n( &reference[0][0], SEEX * MAPSIZE * SEEY * MAPSIZE, 0 );
+    std::unique_ptr<scent_map> scent( new scent_map() );
+
+    for( int turn = 0; turn < 200; ++turn ) {
+        // The player wanders around a bit, the window moves along.
+        const tripoint center( 60 + turn % 11, 70 - turn % 7, 0 );
+        if( turn % 20 == 0 ) {
+            // A scattered cloud of scent, e.g. slime.
+            for( int i = 0; i < 50; ++i ) {
+                const tripoint p = random_scent_point();
+                const int value = rng( 1, 1000 );
+                scent->set( p, value );
+                reference_set( reference, p, value );
+            }
+        }
+        scent->set( center, 500 );
+        reference_set( reference, center, 500 );
+        scent->update( center, g->m );
+        reference_update( reference, center );
+        if( turn % 10 == 0 ) {
+            scent->decay();
+            reference_decay( reference );
+        }
+
+        int mismatches = 0;
+        for( int x = 0; x < SEEX * MAPSIZE; ++x ) {
+            for( int y = 0; y < SEEY * MAPSIZE; ++y ) {
+                const tripoint p( x, y, 0 );
+                if( scent_map::inbounds( p ) && scent->get( p ) != reference[x][y] ) {
+                    mismatches++;
+                }
+            }
+        }
+        INFO( "turn " << turn );
+        REQUIRE( mismatches == 0 );
+    }
+}
+
+TEST_CASE("scent_map_serialization") {
+    std::unique_ptr<scent_map> scent_in( new scent_map() );
+    std::unique_ptr<scent_map> scent_out( new scent_map() );
+    for( int i = 0; i < 100; ++i ) {
+        scent_in->set( random_scent_point(), rng( 0, 1000 ) );
+    }
+    scent_out->deserialize( scent_in->serialize() );
+    for( int x = 0; x < SEEX * MAPSIZE; ++x ) {
+        for( int y = 0; y < SEEY * MAPSIZE; ++y ) {
+            const tripoint p( x, y, 0 );
+            if( scent_in->get( p ) != scent_out->get( p ) ) {
+                FAIL( "scent differs at " << x << "," << y );
+            }
+        }
+    }
+}
+
+TEST_CASE("scent_map_performance", "[.]") {
+    build_scent_test_map();
+    std::unique_ptr<scent_map> scent( new scent_map() );
+    const tripoint center( 66, 66, 0 );
+    const int iterations = 1000;
+    auto start = std::chrono::high_resolution_clock::now();
+    for( int i = 0; i < iterations; ++i ) {
+        scent->set( center, 500 );
+        scent->update( center, g->m );
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    long diff = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+    printf( "scent_map::update() executed %d times in %ld microseconds.\n", iterations, diff );
+
+    static scent_array reference;
+    std::fill_n( &reference[0][0], SEEX * MAPSIZE * SEEY * MAPSIZE, 0 );
+    start = std::chrono::high_resolution_clock::now();
+    for( int i = 0; i < iterations; ++i ) {
+        reference_set( reference, center, 500 );
+        reference_update( reference, center );
+    }
+    end = std::chrono::high_resolution_clock::now();
+    diff = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+    printf( "Reference scent update executed %d times in %ld microseconds.\n", iterations, diff );
+}
@@ -0,0 +1,111 @@
+#include "catch/catch.hpp"
+
+#include "game.h"
+#include "map.h"
+#include "veh_type.h"
+#include "vehicle.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// Compares the cached physics of the vehicle with those of a copy that computes them again.
+static void check_physics( const vehicle &veh )
+{
+    vehicle fresh = veh;
+    fresh.invalidate_physics();
+    CHECK( veh.total_mass() == fresh.total_mass() );
+    int x = 0, y = 0, fresh_x = 0, fresh_y = 0;
+    veh.center_of_mass( x, y, false );
+    fresh.center_of_mass( fresh_x, fresh_y, false );
+    CHECK( x == fresh_x );
+    CHECK( y == fresh_y );
+    veh.center_of_mass( x, y );
+    fresh.center_of_mass( fresh_x, fresh_y );
+    CHECK( x == fresh_x );
+    CHECK( y == fresh_y );
+    int wheels = 0, fresh_wheels = 0;
+    CHECK( veh.wheels_area( &wheels ) == fresh.wheels_area( &fresh_wheels ) );
+    CHECK( wheels == fresh_wheels );
+    CHECK( veh.k_aerodynamics() == fresh.k_aerodynamics() );
+    CHECK( veh.k_mass() == fresh.k_mass() );
+    CHECK( veh.fuel_capacity( "gasoline" ) == fresh.fuel_capacity( "gasoline" ) );
+    CHECK( veh.fuel_capacity( "battery" ) == fresh.fuel_capacity( "battery" ) );
+}
+
+TEST_CASE("vehicle_physics_follow_parts_and_cargo") {
+    // On the map, so damaged parts have somewhere to fall.
+    vehicle *placed = nullptr;
+    for( int i = 0; i < 50 && placed == nullptr; i++ ) {
+        const tripoint pos( SEEX * 2 + ( i % 10 ) * 8, SEEY * 2 + ( i / 10 ) * 8, g->get_levz() );
+        placed = g->m.add_vehicle( vproto_id( "car" ), pos, 0, 100, 0, false );
+    }
+    REQUIRE( placed != nullptr );
+    vehicle &veh = *placed;
+    check_physics( veh );
+    CHECK( veh.fuel_capacity( "gasoline" ) > 0 );
+
+    const std::vector<int> cargo = veh.all_parts_with_feature( VPFLAG_CARGO, true );
+    REQUIRE_FALSE( cargo.empty() );
+    const int empty_mass = veh.total_mass();
+    for( int i = 0; i < 10; i++ ) {
+        REQUIRE( veh.add_item( cargo[0], item( "rock", 0 ) ) );
+    }
+    CHECK( veh.total_mass() > empty_mass );
+    check_physics( veh );
+    auto items = veh.get_items( cargo[0] );
+    items.erase( items.begin() );
+    check_physics( veh );
+
+    for( size_t p = 0; p < veh.parts.size(); p++ ) {
+        if( veh.part_flag( p, VPFLAG_OBSTACLE ) ) {
+            veh.damage( p, 100000, DT_TRUE, false );
+        }
+    }
+    check_physics( veh );
+
+    const std::vector<int> wheels = veh.all_parts_with_feature( VPFLAG_WHEEL, false );
+    REQUIRE_FALSE( wheels.empty() );
+    const float wheels_area = veh.wheels_area();
+    veh.remove_part( wheels[0] );
+    veh.part_removal_cleanup();
+    CHECK( veh.wheels_area() < wheels_area );
+    check_physics( veh );
+
+    g->m.destroy_vehicle( placed );
+}
+
+TEST_CASE("vehicle_physics_performance", "[.]") {
+    vehicle veh( vproto_id( "car" ), 100, 0 );
+    const int calls = 10000;
+    float sum = 0;
+
+    // Everything computed again for every call, like before the physics were cached.
+    auto start = std::chrono::high_resolution_clock::now();
+    for( int i = 0; i < calls; i++ ) {
+        veh.invalidate_physics();
+        sum += veh.k_dynamics();
+        veh.invalidate_physics();
+        sum += veh.k_mass();
+        int x = 0, y = 0;
+        veh.invalidate_physics();
+        veh.center_of_mass( x, y );
+        sum += x + y;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    const long long computed_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    for( int i = 0; i < calls; i++ ) {
+        sum += veh.k_dynamics();
+        sum += veh.k_mass();
+        int x = 0, y = 0;
+        veh.center_of_mass( x, y );
+        sum += x + y;
+    }
+    end = std::chrono::high_resolution_clock::now();
+    const long long cached_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+
+    printf( "%d calls of k_dynamics, k_mass and center_of_mass: computed %lld us, cached %lld us (%g)\n",
+            calls, computed_us, cached_us, sum );
+}
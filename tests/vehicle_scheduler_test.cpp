@@ -0,0 +1,145 @@
+#include "catch/catch.hpp"
+
+#include "game.h"
+#include "map.h"
+#include "vehicle.h"
+#include "vehicle_scheduler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <set>
+#include <vector>
+
+TEST_CASE("vehicle_scheduler_picks_the_most_turn_left") {
+    std::vector<vehicle> vehs( 4 );
+    std::vector<vehicle *> listed;
+    for( auto &veh : vehs ) {
+        veh.of_turn = 0.5f;
+        veh.falling = false;
+        listed.push_back( &veh );
+    }
+    vehs[2].of_turn = 0.8f;
+    vehs[3].of_turn = 0;
+
+    vehicle_scheduler schedule;
+    CHECK_FALSE( schedule.is_valid() );
+    schedule.start( listed );
+    REQUIRE( schedule.is_valid() );
+    CHECK( schedule.next() == &vehs[2] );
+    // The one picked last is queued again with what it has left.
+    vehs[2].of_turn = 0.1f;
+    // Ties go to the one listed first.
+    CHECK( schedule.next() == &vehs[0] );
+    vehs[0].of_turn = 0.5f;
+    CHECK( schedule.next() == &vehs[0] );
+    vehs[0].of_turn = 0;
+    CHECK( schedule.next() == &vehs[1] );
+    // Others have to be updated, like a vehicle that was hit.
+    vehs[3].of_turn = 0.9f;
+    schedule.update( &vehs[3] );
+    CHECK( schedule.next() == &vehs[3] );
+    vehs[3].of_turn = 0;
+    vehs[1].of_turn = 0;
+    CHECK( schedule.next() == &vehs[2] );
+    vehs[2].of_turn = 0;
+    CHECK( schedule.next() == nullptr );
+
+    CHECK( schedule.next_falling() == nullptr );
+    vehs[3].falling = true;
+    CHECK( schedule.next_falling() == &vehs[3] );
+
+    for( auto &veh : vehs ) {
+        veh.of_turn = 1;
+    }
+    schedule.restart();
+    CHECK( schedule.next() == &vehs[0] );
+    schedule.invalidate();
+    CHECK_FALSE( schedule.is_valid() );
+    CHECK( schedule.get_vehicles().empty() );
+}
+
+// The vehicles the test placed, wherever they moved.
+static std::vector<vehicle *> placed_vehicles( const std::set<vehicle *> &placed )
+{
+    std::vector<vehicle *> result;
+    for( auto &vehs_v : g->m.get_vehicles() ) {
+        if( placed.count( vehs_v.v ) > 0 ) {
+            result.push_back( vehs_v.v );
+        }
+    }
+    return result;
+}
+
+TEST_CASE("vehicle_movement_performance", "[.]") {
+    const int vehicle_count = 50;
+    std::set<vehicle *> placed;
+    for( int i = 0; i < vehicle_count; i++ ) {
+        const tripoint pos( SEEX * 2 + ( i % 10 ) * 8, SEEY * 2 + ( i / 10 ) * 8, g->get_levz() );
+        vehicle *veh = g->m.add_vehicle( vproto_id( "car" ), pos, 0, 100, 0, false );
+        if( veh != nullptr ) {
+            placed.insert( veh );
+        }
+    }
+    const int turns = 10;
+    const int picks = 100;
+
+    // Picking by listing all vehicles for every pick, like map::vehproceed used to.
+    auto start = std::chrono::high_resolution_clock::now();
+    for( int turn = 0; turn < turns; turn++ ) {
+        for( vehicle *veh : placed ) {
+            veh->of_turn = 1;
+        }
+        for( int pick = 0; pick < picks; pick++ ) {
+            vehicle *picked = nullptr;
+            for( auto &vehs_v : g->m.get_vehicles() ) {
+                if( vehs_v.v->of_turn > 0 && ( picked == nullptr || vehs_v.v->of_turn > picked->of_turn ) ) {
+                    picked = vehs_v.v;
+                }
+            }
+            if( picked != nullptr ) {
+                picked->of_turn -= 0.5f;
+            }
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    const long long listing_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+
+    vehicle_scheduler schedule;
+    start = std::chrono::high_resolution_clock::now();
+    for( int turn = 0; turn < turns; turn++ ) {
+        for( vehicle *veh : placed ) {
+            veh->of_turn = 1;
+        }
+        std::vector<vehicle *> listed;
+        for( auto &vehs_v : g->m.get_vehicles() ) {
+            listed.push_back( vehs_v.v );
+        }
+        schedule.start( listed );
+        for( int pick = 0; pick < picks; pick++ ) {
+            vehicle *picked = schedule.next();
+            if( picked != nullptr ) {
+                picked->of_turn -= 0.5f;
+            }
+        }
+    }
+    end = std::chrono::high_resolution_clock::now();
+    const long long scheduled_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+    schedule.invalidate();
+
+    // Whole turns with the vehicles driving.
+    start = std::chrono::high_resolution_clock::now();
+    for( int turn = 0; turn < turns; turn++ ) {
+        for( vehicle *veh : placed_vehicles( placed ) ) {
+            veh->velocity = 1000;
+        }
+        g->m.vehmove();
+    }
+    end = std::chrono::high_resolution_clock::now();
+    const long long vehmove_us = std::chrono::duration_cast<std::chrono::microseconds>( end - start ).count();
+
+    for( vehicle *veh : placed_vehicles( placed ) ) {
+        g->m.destroy_vehicle( veh );
+    }
+    printf( "%d vehicles, %d turns of %d picks: by listing %lld us, scheduled %lld us; vehmove %lld us\n",
+            int( placed.size() ), turns, picks, listing_us, scheduled_us, vehmove_us );
+}
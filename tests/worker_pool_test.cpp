@@ -0,0 +1,36 @@
+#include "catch/catch.hpp"
+
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+TEST_CASE("worker_pool_runs_every_job_once") {
+    worker_pool pool( 4 );
+    REQUIRE( pool.size() == 4 );
+    for( size_t count : { 0, 1, 3, 1000 } ) {
+        std::vector<int> runs( count, 0 );
+        std::vector<std::atomic<int>> busy( pool.size() );
+        for( auto &b : busy ) {
+            b = 0;
+        }
+        std::atomic<bool> worker_shared( false );
+        std::atomic<bool> worker_out_of_range( false );
+        pool.run( count, [&]( size_t index, size_t worker ) {
+            if( worker >= pool.size() ) {
+                worker_out_of_range = true;
+                return;
+            }
+            if( busy[worker]++ != 0 ) {
+                worker_shared = true;
+            }
+            runs[index]++;
+            busy[worker]--;
+        } );
+        INFO( count << " jobs" );
+        CHECK_FALSE( worker_out_of_range );
+        CHECK_FALSE( worker_shared );
+        CHECK( std::count( runs.begin(), runs.end(), 1 ) == int( count ) );
+    }
+}